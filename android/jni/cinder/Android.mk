@@ -48,7 +48,12 @@ LOCAL_SRC_FILES  := $(CINDER_SRC)/app/App.cpp \
                     $(CINDER_SRC)/ip/Trim.cpp \
                     $(CINDER_SRC)/ip/YUVConvert.cpp \
                     $(CINDER_SRC)/svg/Svg.cpp \
+                    $(CINDER_SRC)/svg/SvgSurface.cpp \
+                    $(CINDER_SRC)/svg/SvgRenderList.cpp \
+                    $(CINDER_SRC)/svg/SvgNodeIndex.cpp \
                     $(CINDER_SRC)/Area.cpp \
+                    $(CINDER_SRC)/AssetCache.cpp \
+                    $(CINDER_SRC)/AssetPack.cpp \
                     $(CINDER_SRC)/AxisAlignedBox.cpp \
                     $(CINDER_SRC)/BandedMatrix.cpp \
                     $(CINDER_SRC)/Base64.cpp \
@@ -68,6 +73,9 @@ LOCAL_SRC_FILES  := $(CINDER_SRC)/app/App.cpp \
                     $(CINDER_SRC)/Frustum.cpp \
                     $(CINDER_SRC)/ImageIo.cpp \
                     $(CINDER_SRC)/Json.cpp \
+                    $(CINDER_SRC)/JsonDoc.cpp \
+                    $(CINDER_SRC)/JsonReader.cpp \
+                    $(CINDER_SRC)/JsonWriter.cpp \
                     $(CINDER_SRC)/Matrix.cpp \
                     $(CINDER_SRC)/Path2d.cpp \
                     $(CINDER_SRC)/Perlin.cpp \
@@ -81,6 +89,7 @@ LOCAL_SRC_FILES  := $(CINDER_SRC)/app/App.cpp \
                     $(CINDER_SRC)/Stream.cpp \
                     $(CINDER_SRC)/Surface.cpp \
                     $(CINDER_SRC)/System.cpp \
+                    $(CINDER_SRC)/TaskPool.cpp \
                     $(CINDER_SRC)/Text.cpp \
                     $(CINDER_SRC)/TextEngine.cpp \
                     $(CINDER_SRC)/TextEngineFreeType.cpp \
@@ -88,10 +97,16 @@ LOCAL_SRC_FILES  := $(CINDER_SRC)/app/App.cpp \
                     $(CINDER_SRC)/TimelineItem.cpp \
                     $(CINDER_SRC)/Timer.cpp \
                     $(CINDER_SRC)/Triangulate.cpp \
+                    $(CINDER_SRC)/Delaunay.cpp \
+                    $(CINDER_SRC)/Rasterizer.cpp \
                     $(CINDER_SRC)/TriMesh.cpp \
+                    $(CINDER_SRC)/TriMeshBvh.cpp \
+                    $(CINDER_SRC)/SpatialHash.cpp \
                     $(CINDER_SRC)/Tween.cpp \
                     $(CINDER_SRC)/Utilities.cpp \
                     $(CINDER_SRC)/Xml.cpp \
+                    $(CINDER_SRC)/XmlDoc.cpp \
+                    $(CINDER_SRC)/XmlReader.cpp \
                     $(TESS_SRC)/bucketalloc.c \
                     $(TESS_SRC)/dict.c \
                     $(TESS_SRC)/geom.c \
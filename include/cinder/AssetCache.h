@@ -0,0 +1,93 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/DataSource.h"
+#include "cinder/Stream.h"
+#include "cinder/Surface.h"
+#include "cinder/TriMesh.h"
+#include "cinder/Exception.h"
+
+#include <boost/logic/tribool.hpp>
+#include <string>
+
+namespace cinder {
+
+typedef std::shared_ptr<class AssetCache>	AssetCacheRef;
+
+/** \brief Content-addressed on-disk cache of decoded assets
+ *
+ * Entries are keyed by a hash of the source data and the options used to load it, so a modified source simply misses the cache.
+ * The first load decodes the asset and stores the result; subsequent loads memory-map the stored entry.
+ * Entries are written in native byte order and are intended to live in a per-machine cache directory.
+ * \n Example usage:
+ * \code
+ * AssetCacheRef cache = AssetCache::create( getHomeDirectory() / "MyApp" / "cache" );
+ * gl::Texture tex( cache->loadSurface( loadAsset( "image.png" ) ) );
+ * TriMesh mesh = cache->loadObj( loadAsset( "model.obj" ) );
+ * \endcode
+**/
+class AssetCache {
+ public:
+	//! Creates a cache which stores its entries in \a directory, creating the directory if necessary
+	static AssetCacheRef	create( const fs::path &directory );
+
+	//! Returns the directory in which cache entries are stored
+	const fs::path&		getDirectory() const { return mDirectory; }
+
+	//! Returns the image in \a source as a Surface8u. The Surface of a cache hit refers directly to the mapped entry, copied only as its pages are modified.
+	Surface8u	loadSurface( DataSourceRef source );
+	//! Returns the result of ObjLoader::load() on \a source. Only the data serialized by TriMesh::write() is preserved.
+	TriMesh		loadObj( DataSourceRef source, boost::tribool loadNormals = boost::logic::indeterminate, boost::tribool loadTexCoords = boost::logic::indeterminate, bool optimizeVertices = true );
+	//! Returns the filled shapes of the SVG document in \a source tessellated into a single TriMesh2d, in document coordinates
+	TriMesh2d	loadSvgMesh( DataSourceRef source, float approximationScale = 1.0f );
+
+	//! Returns the cache entry for \a key as a stream over its mapped payload, or a null IStreamRef if the cache does not contain \a key
+	IStreamRef	find( uint64_t key );
+	//! Stores \a size bytes of \a data as the entry for \a key, replacing any existing entry. Failure to write the entry is not an error.
+	void		store( uint64_t key, const void *data, size_t size );
+	//! Removes every entry from the cache
+	void		clear();
+
+	//! Returns the key for the contents of \a source as loaded with \a options
+	static uint64_t		calcKey( DataSourceRef source, const std::string &options );
+	//! Returns the key for \a size bytes of \a data as loaded with \a options
+	static uint64_t		calcKey( const void *data, size_t size, const std::string &options );
+
+ protected:
+	AssetCache( const fs::path &directory );
+
+	enum EntryType { ENTRY_RAW, ENTRY_SURFACE, ENTRY_TRIMESH, ENTRY_TRIMESH2D };
+
+	MappedFileRef	findEntry( uint64_t key, uint32_t type, uint32_t params[8] );
+	void			storeEntry( uint64_t key, uint32_t type, const uint32_t params[8], const void *data, size_t size );
+	fs::path		getEntryPath( uint64_t key ) const;
+
+	fs::path		mDirectory;
+};
+
+class AssetCacheExc : public Exception {
+};
+
+} // namespace cinder
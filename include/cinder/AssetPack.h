@@ -0,0 +1,172 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/DataSource.h"
+#include "cinder/Stream.h"
+#include "cinder/Buffer.h"
+#include "cinder/Exception.h"
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace cinder {
+
+typedef std::shared_ptr<class AssetPack>	AssetPackRef;
+
+/** \brief Read access to an asset pack: many assets stored in a single indexed file
+ *
+ * A pack begins with a 64 byte header followed by a fixed-size entry table, a hash table of the entry names and the names themselves.
+ * Entries are stored either uncompressed, aligned to 64 bytes, or zlib-compressed. Packs are written with AssetPackWriter or the AssetPacker tool.
+ * \n Example usage:
+ * \code
+ * AssetPackRef pack = AssetPack::create( getAssetPath( "assets.pack" ) );
+ * gl::Texture tex( loadImage( DataSourcePack::create( pack, "images/logo.png" ) ) );
+ * \endcode
+**/
+class AssetPack : public std::enable_shared_from_this<AssetPack> {
+ public:
+	//! Opens the pack at \a path. When \a memoryMap is true the pack is mapped into memory and uncompressed entries are read in place; otherwise each entry stream opens the file separately.
+	static AssetPackRef		create( const fs::path &path, bool memoryMap = true );
+	//! Opens a pack read through \a stream, such as an IStreamAsset. Entry streams share \a stream and so must not be read from concurrently.
+	static AssetPackRef		create( IStreamRef stream );
+
+	//! Returns the number of entries in the pack
+	size_t			getNumEntries() const { return mNumEntries; }
+	//! Returns the index of the entry named \a name, or -1 if the pack does not contain it
+	int				findEntry( const std::string &name ) const;
+	//! Returns whether the pack contains an entry named \a name
+	bool			contains( const std::string &name ) const { return findEntry( name ) >= 0; }
+
+	//! Returns the name of entry \a index
+	std::string		getEntryName( size_t index ) const;
+	//! Returns the uncompressed size of entry \a index in bytes
+	uint64_t		getEntrySize( size_t index ) const;
+	//! Returns whether entry \a index is stored compressed
+	bool			isEntryCompressed( size_t index ) const;
+
+	//! Returns an IStream over the contents of entry \a name. Throws AssetPackExcEntryNotFound if the pack does not contain it.
+	IStreamRef		createStream( const std::string &name );
+	//! Returns an IStream over the contents of entry \a index
+	IStreamRef		createStream( size_t index );
+	//! Returns the contents of entry \a index. For an uncompressed entry of a memory-mapped pack the Buffer refers to the mapping, which must outlive it.
+	Buffer			loadBuffer( size_t index );
+
+	enum { FORMAT_VERSION = 1, ENTRY_ALIGNMENT = 64 };
+	enum Compression { COMPRESSION_NONE, COMPRESSION_ZLIB };
+
+ protected:
+	AssetPack( const fs::path &path, bool memoryMap );
+	AssetPack( IStreamRef stream );
+
+	struct IndexEntry;
+	friend class AssetPackWriter;
+
+	void			readIndex( IStreamRef stream, uint64_t fileSize );
+	void			parseIndex( const uint8_t *index, size_t indexSize, uint64_t fileSize );
+	const IndexEntry&	getEntry( size_t index ) const;
+	IStreamRef		createRawStream( uint64_t offset, uint64_t size );
+
+	fs::path			mFilePath;
+	MappedFileRef		mMappedFile;
+	IStreamRef			mStream;
+	std::vector<uint8_t>	mIndexStorage; // holds the index when the pack is not memory mapped
+
+	size_t				mNumEntries, mNumBuckets;
+	const uint8_t		*mEntries;
+	const uint32_t		*mBuckets;
+	const char			*mNames;
+	size_t				mNamesSize;
+};
+
+typedef std::shared_ptr<class DataSourcePack>	DataSourcePackRef;
+
+//! A DataSource for an entry of an AssetPack
+class DataSourcePack : public DataSource {
+  public:
+	//! Returns a DataSource for the entry \a name of \a pack. Throws AssetPackExcEntryNotFound if the pack does not contain it.
+	static DataSourcePackRef	create( AssetPackRef pack, const std::string &name );
+
+	virtual bool	isFilePath() { return false; }
+	virtual bool	isUrl() { return false; }
+
+	virtual IStreamRef	createStream();
+
+	const AssetPackRef&	getPack() const { return mPack; }
+
+  protected:
+	DataSourcePack( AssetPackRef pack, size_t entryIndex );
+
+	virtual	void	createBuffer();
+
+	AssetPackRef	mPack;
+	size_t			mEntryIndex;
+};
+
+//! Builds an AssetPack file from files and buffers
+class AssetPackWriter {
+  public:
+	AssetPackWriter() {}
+
+	//! Adds the file at \a path as the entry \a name, replacing any existing entry with that name. The file is not read until write() is called.
+	void	addFile( const std::string &name, const fs::path &path, bool compress = false );
+	//! Adds \a data as the entry \a name, replacing any existing entry with that name
+	void	addBuffer( const std::string &name, const Buffer &data, bool compress = false );
+
+	size_t	getNumEntries() const { return mEntries.size(); }
+
+	//! Writes the pack to \a path. Entries requested as compressed are stored uncompressed when compression would not make them smaller.
+	void	write( const fs::path &path ) const;
+
+  private:
+	struct Entry {
+		std::string		mName;
+		fs::path		mPath;
+		Buffer			mData;
+		bool			mCompress;
+	};
+
+	void	addEntry( const Entry &entry );
+
+	std::vector<Entry>				mEntries;
+	std::map<std::string,size_t>	mEntryIndices;
+};
+
+class AssetPackExc : public Exception {
+};
+
+class AssetPackExcInvalidFile : public AssetPackExc {
+};
+
+class AssetPackExcEntryNotFound : public AssetPackExc {
+  public:
+	AssetPackExcEntryNotFound( const std::string &name ) throw();
+	virtual const char* what() const throw() { return mMessage; }
+	
+  private:
+	char	mMessage[256];
+};
+
+} // namespace cinder
@@ -25,6 +25,7 @@
 
 #include "cinder/Cinder.h"
 #include "cinder/Buffer.h"
+#include "cinder/Stream.h"
 
 #include <string>
 
@@ -44,4 +45,18 @@ Buffer fromBase64( const Buffer &input );
 //! Converts Base64-encoded data \a input into unencoded data.
 Buffer fromBase64( const void *input, size_t inputSize );
 
+//! Reads \a input until its end and writes it Base64-encoded to \a output in fixed-size chunks, so that neither the source nor the result is ever held in memory in its entirety. \a charsPerLine behaves as in toBase64().
+void toBase64( const IStreamRef &input, const OStreamRef &output, int charsPerLine = 0 );
+//! Reads Base64-encoded data from \a input until its end and writes the unencoded data to \a output in fixed-size chunks.
+void fromBase64( const IStreamRef &input, const OStreamRef &output );
+
+//! Returns the exact number of characters encodeBase64() produces for \a inputSize bytes of input, excluding any null terminator.
+size_t calcBase64EncodedSize( size_t inputSize, int charsPerLine = 0 );
+//! Returns an upper bound on the number of bytes decodeBase64() produces for \a inputSize characters of input.
+size_t calcBase64DecodedMaxSize( size_t inputSize );
+//! Encodes \a inputSize bytes of \a input into the caller-provided \a output, which must hold at least calcBase64EncodedSize() characters. No null terminator is written. Returns the number of characters written.
+size_t encodeBase64( const void *input, size_t inputSize, char *output, int charsPerLine = 0 );
+//! Decodes \a inputSize characters of Base64-encoded \a input into the caller-provided \a output, which must hold at least calcBase64DecodedMaxSize() bytes. Characters outside the Base64 alphabet are skipped. Returns the number of bytes written.
+size_t decodeBase64( const void *input, size_t inputSize, void *output );
+
 } // namespace cinder
\ No newline at end of file
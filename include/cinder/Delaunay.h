@@ -0,0 +1,85 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Triangulate.h"
+
+#include <vector>
+
+namespace cinder {
+
+/** \brief Computes the Delaunay triangulation of a set of points, or the constrained Delaunay triangulation of Shape2d outlines, as a TriMesh2d.
+ *
+ * Unlike Triangulator, which avoids adding vertices but may produce long slivers, the result maximizes the smallest angle
+ * of its triangles, and may include points inside the outlines as well as on them. Points are inserted one at a time in
+ * an order which follows a Hilbert curve in rounds of increasing size, so each insertion only needs to look near the last,
+ * and the geometric tests are exact, so nearly collinear or cocircular points can not corrupt the result.
+ * Outlines are added as edges of the triangulation afterwards, with a point added wherever two of them cross, and
+ * triangles are kept according to their winding number as with Triangulator. Without outlines every triangle of the
+ * convex hull of the points is kept.
+ * \code
+ * DelaunayTriangulator delaunay( shape );
+ * delaunay.addPoints( interiorPoints );
+ * mMesh = delaunay.calcMesh();
+ * \endcode
+**/
+class DelaunayTriangulator {
+  public:
+	//! Default constructor
+	DelaunayTriangulator() {}
+	//! Constructs using a set of points
+	explicit DelaunayTriangulator( const std::vector<Vec2f> &points );
+	//! Constructs using the outlines of a Shape2d. \a approximationScale represents how smooth the tesselation is, with 1.0 corresponding to 1:1 with screen space
+	DelaunayTriangulator( const Shape2d &shape, float approximationScale = 1.0f );
+	//! Constructs using the outline of a Path2d. \a approximationScale represents how smooth the tesselation is, with 1.0 corresponding to 1:1 with screen space
+	DelaunayTriangulator( const Path2d &path, float approximationScale = 1.0f );
+	//! Constructs using the outline of a PolyLine2f
+	DelaunayTriangulator( const PolyLine2f &polyLine );
+
+	//! Adds a point to the triangulation
+	void		addPoint( const Vec2f &point ) { mPoints.push_back( point ); }
+	//! Adds points to the triangulation
+	void		addPoints( const std::vector<Vec2f> &points );
+	//! Adds the outlines of a Shape2d to the triangulation. \a approximationScale represents how smooth the tesselation is, with 1.0 corresponding to 1:1 with screen space
+	void		addShape( const Shape2d &shape, float approximationScale = 1.0f );
+	//! Adds the outline of a Path2d to the triangulation, closing it if it is open. \a approximationScale represents how smooth the tesselation is, with 1.0 corresponding to 1:1 with screen space
+	void		addPath( const Path2d &path, float approximationScale = 1.0f );
+	//! Adds the outline of a PolyLine2f to the triangulation, closing it if it is open
+	void		addPolyLine( const PolyLine2f &polyLine );
+
+	/*! Performs the triangulation, returning a TriMesh2d whose vertices are the points and outline points in the order they were added,
+		followed by any points added where outlines cross. Only the triangles inside the outlines according to \a winding are kept. */
+	TriMesh2d	calcMesh( Triangulator::Winding winding = Triangulator::WINDING_ODD ) const;
+
+  private:
+	void		addOutline( const std::vector<Vec2f> &points );
+
+	std::vector<Vec2f>		mPoints;
+	//! Pairs of indices into \a mPoints for each outline edge, directed along its outline
+	std::vector<uint32_t>	mOutlineEdges;
+};
+
+} // namespace cinder
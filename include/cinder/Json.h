@@ -30,6 +30,7 @@
 #include "cinder/Utilities.h"
 
 #include <string>
+#include <vector>
 #include <boost/container/list.hpp>
 
 namespace Json {
@@ -68,6 +69,40 @@ class JsonTree {
 
   public:
 
+	/** \brief A child path compiled once for repeated lookups
+		The path is split, array indices parsed and keys case-folded when the Query is constructed, so lookups do no string processing. Lookups through a Query
+		on a node with many children build a hashed index of the node's children on first use, which later lookups probe instead of scanning.
+		The index is rebuilt after the children change. Building it modifies the node, so the first Query lookup on a node must not race with another.
+		<br><tt>JsonTree::Query titleQuery( "library.albums[0].title" );</tt> **/
+	class Query {
+	  public:
+		//! Creates an empty Query, which matches the node it is applied to
+		Query() : mCaseSensitive( false ) {}
+		//! Compiles \a path, whose components are separated by \a separator. Numeric components and bracketed indices select array elements.
+		explicit Query( const std::string &path, bool caseSensitive = false, char separator = '.' );
+
+		//! Returns the path the Query was compiled from
+		const std::string&	getPath() const { return mPath; }
+		bool				isCaseSensitive() const { return mCaseSensitive; }
+
+		//! \cond
+		struct Component {
+			bool			mIsIndex;
+			size_t			mIndex;
+			std::string		mKey, mLowerKey;
+		};
+		//! \endcond
+
+	  private:
+		//! \cond
+		std::string										mPath;
+		bool											mCaseSensitive;
+		std::shared_ptr<const std::vector<Component> >	mComponents;
+		//! \endcond
+
+		friend class JsonTree;
+	};
+
 	//! Options for JSON parsing. Passed to the JsonTree constructor.
 	class ParseOptions {
 	  public:
@@ -178,6 +213,10 @@ class JsonTree {
 	/**! Returns the child at \a relativePath. Throws ExcChildNotFound if none matches. 
 		<br><tt>JsonTree node = myNode.getChild( "path.to.child" );</tt> **/
 	const JsonTree&					getChild( const std::string &relativePath, bool caseSensitive = false, char separator = '.' ) const;
+	//! Returns the child matching \a query. Throws ExcChildNotFound if none matches.
+	JsonTree&						getChild( const Query &query );
+	//! Returns the child matching \a query. Throws ExcChildNotFound if none matches.
+	const JsonTree&					getChild( const Query &query ) const;
 	//! Returns the child at \a index. Throws ExcChildNotFound if none matches.
 	JsonTree&						getChild( size_t index );
 	//! Returns the child at \a index. Throws ExcChildNotFound if none matches.
@@ -188,6 +227,8 @@ class JsonTree {
 	/**! Returns whether the child at \a relativePath exists. 
 		<br><tt>bool nodeExists = myNode.hasChild( "path.to.child" );</tt> **/
 	bool							hasChild( const std::string &relativePath, bool caseSensitive = false, char separator = '.' ) const;
+	//! Returns whether the child matching \a query exists
+	bool							hasChild( const Query &query ) const { return getNodePtr( query ) != 0; }
 	//! Returns whether this node has a parent node.
 	bool							hasChildren() const;
 
@@ -250,22 +291,28 @@ private:
 	//! \cond
 	explicit JsonTree( const std::string &key, const Json::Value &value );
 
-	Json::Value						createNativeDoc( WriteOptions writeOptions = WriteOptions() ) const;
 	static Json::Value				deserializeNative( const std::string &jsonString, ParseOptions parseOptions );
-	static std::string				serializeNative( const Json::Value &value );
    
 	void							init( const std::string &key, const Json::Value &value, bool setType = false, 
 		NodeType nodeType = NODE_VALUE, ValueType valueType = VALUE_STRING );
 	
 	JsonTree*						getNodePtr( const std::string &relativePath, bool caseSensitive, char separator ) const;
+	JsonTree*						getNodePtr( const Query &query ) const;
+	JsonTree*						findChild( const Query::Component &component, bool caseSensitive ) const;
 	static bool						isIndex( const std::string &key );
 	
+	friend class JsonWriter;
+
 	Container						mChildren;
 	std::string						mKey;
 	JsonTree						*mParent;
 	NodeType						mNodeType;
 	std::string						mValue;
 	ValueType						mValueType;
+
+	//! hashed index of mChildren by case-folded key, built by the first Query lookup on a node with many children
+	struct ChildIndex;
+	mutable std::shared_ptr<ChildIndex>	mChildIndex;
 	//! \endcond
 
   public:
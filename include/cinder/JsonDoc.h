@@ -0,0 +1,188 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/DataSource.h"
+#include "cinder/Exception.h"
+#include "cinder/Json.h"
+
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <vector>
+
+namespace cinder {
+
+typedef std::shared_ptr<class JsonDoc>	JsonDocRef;
+
+/** \brief Read-only JSON document stored in a single arena
+ *
+ * A lighter-weight alternative to JsonTree for large documents. Nodes are allocated from a bump allocator owned by the document,
+ * scalars are stored typed rather than as strings, arrays are contiguous so that indexed access is O(1),
+ * and the members of large objects are indexed by key hash. Values are lightweight handles which remain valid as long as their JsonDoc.
+ * \n Example usage:
+ * \code
+ * JsonDocRef doc = JsonDoc::create( loadAsset( "data.json" ) );
+ * JsonDoc::Value points = doc->getRoot()["points"];
+ * for( size_t i = 0; i < points.size(); ++i )
+ *     console() << points[i]["x"].getDouble() << std::endl;
+ * \endcode
+**/
+class JsonDoc : private boost::noncopyable {
+  public:
+	typedef enum { TYPE_NULL, TYPE_BOOL, TYPE_INT, TYPE_DOUBLE, TYPE_STRING, TYPE_ARRAY, TYPE_OBJECT } Type;
+
+	//! \cond
+	struct Node;
+	struct Member;
+	//! \endcond
+
+	//! A handle to a node of a JsonDoc
+	class Value {
+	  public:
+		//! Creates an invalid Value, as returned by find() when no member matches
+		Value() : mNode( 0 ) {}
+
+		//! Returns whether the Value refers to a node. Only Values returned by find() may be invalid.
+		bool			isValid() const { return mNode != 0; }
+		Type			getType() const;
+		bool			isNull() const { return getType() == TYPE_NULL; }
+		bool			isBool() const { return getType() == TYPE_BOOL; }
+		//! Returns whether the node is an integer or a double
+		bool			isNumber() const { return getType() == TYPE_INT || getType() == TYPE_DOUBLE; }
+		bool			isInt() const { return getType() == TYPE_INT; }
+		bool			isDouble() const { return getType() == TYPE_DOUBLE; }
+		bool			isString() const { return getType() == TYPE_STRING; }
+		bool			isArray() const { return getType() == TYPE_ARRAY; }
+		bool			isObject() const { return getType() == TYPE_OBJECT; }
+
+		//! Returns the value of a boolean node. Throws ExcNonConvertible for any other type.
+		bool			getBool() const;
+		//! Returns the value of an integer node, or of a double node which holds an integer. Throws ExcNonConvertible for any other value.
+		int64_t			getInt() const;
+		//! Returns the value of a numeric node as a double. Throws ExcNonConvertible for any other type.
+		double			getDouble() const;
+		//! Returns a pointer to the null-terminated UTF-8 contents of a string node. Throws ExcNonConvertible for any other type.
+		const char*		getCString() const;
+		//! Returns the length in bytes of a string node, which may contain embedded nulls. Throws ExcNonConvertible for any other type.
+		size_t			getStringLength() const;
+		//! Returns a copy of the contents of a string node. Throws ExcNonConvertible for any other type.
+		std::string		getString() const { return std::string( getCString(), getStringLength() ); }
+
+		//! Returns the number of elements of an array or members of an object, and 0 for any other type
+		size_t			size() const;
+		//! Returns the element at \a index of an array or the value of the member at \a index of an object in O(1). Throws ExcChildNotFound if \a index is out of range.
+		Value			operator[]( size_t index ) const;
+		//! Returns the element at \a index as operator[]( size_t ) does, so that integer literals are not ambiguous with a null key. Throws ExcChildNotFound if \a index is negative.
+		Value			operator[]( int index ) const { return operator[]( static_cast<size_t>( index ) ); }
+		//! Returns the value of the member \a key of an object. Throws ExcChildNotFound if the object has no such member.
+		Value			operator[]( const std::string &key ) const;
+		//! Returns the value of the member \a key of an object. Throws ExcChildNotFound if the object has no such member.
+		Value			operator[]( const char *key ) const;
+		//! Returns the value of the member \a key of \a keyLength bytes of an object, or an invalid Value if there is no such member or the node is not an object
+		Value			find( const char *key, size_t keyLength ) const;
+		//! Returns the value of the member \a key of an object, or an invalid Value if there is no such member or the node is not an object
+		Value			find( const std::string &key ) const { return find( key.c_str(), key.size() ); }
+		//! Returns whether the node is an object with a member \a key
+		bool			hasChild( const std::string &key ) const { return find( key ).isValid(); }
+		//! Returns the null-terminated key of the member at \a index of an object. Throws ExcChildNotFound if \a index is out of range or the node is not an object.
+		const char*		getKey( size_t index ) const;
+		//! Returns the length in bytes of the key of the member at \a index of an object, which may contain embedded nulls. Throws ExcChildNotFound if \a index is out of range or the node is not an object.
+		size_t			getKeyLength( size_t index ) const;
+
+		//! Returns a deep copy of the node as a JsonTree with key \a key
+		JsonTree		toJsonTree( const std::string &key = "" ) const;
+
+	  private:
+		explicit Value( const Node *node ) : mNode( node ) {}
+
+		const Node	*mNode;
+
+		friend class JsonDoc;
+	};
+
+	//! Parses the JSON contained in \a dataSource
+	static JsonDocRef	create( DataSourceRef dataSource );
+	//! Parses the JSON contained in \a jsonString
+	static JsonDocRef	create( const std::string &jsonString );
+	//! Parses \a size bytes of JSON pointed to by \a data
+	static JsonDocRef	create( const void *data, size_t size );
+	~JsonDoc();
+
+	//! Returns the root value of the document
+	Value			getRoot() const { return Value( mRoot ); }
+	//! Returns a deep copy of the document as a JsonTree
+	JsonTree		toJsonTree() const { return getRoot().toJsonTree(); }
+
+	//! Returns the number of bytes allocated by the document's arena
+	size_t			getArenaSize() const { return mArenaSize; }
+
+	//! Base class for JsonDoc exceptions.
+	class Exception : public cinder::Exception {
+	};
+
+	//! Exception expressing a syntax error in the source JSON.
+	class ExcParse : public JsonDoc::Exception {
+	  public:
+		ExcParse( const char *message, size_t line, size_t column ) throw();
+		virtual const char* what() const throw() { return mMessage; }
+
+	  private:
+		char mMessage[256];
+	};
+
+	//! Exception expressing the absence of an expected child node.
+	class ExcChildNotFound : public JsonDoc::Exception {
+	  public:
+		ExcChildNotFound( const std::string &key ) throw();
+		virtual const char* what() const throw() { return mMessage; }
+
+	  private:
+		char mMessage[2048];
+	};
+
+	//! Exception expressing the inability to convert a node's value to a requested type.
+	class ExcNonConvertible : public JsonDoc::Exception {
+	  public:
+		ExcNonConvertible( Type actualType ) throw();
+		virtual const char* what() const throw() { return mMessage; }
+
+	  private:
+		char mMessage[256];
+	};
+
+  private:
+	JsonDoc();
+
+	void*				allocate( size_t size );
+	void				parse( const char *data, size_t size );
+
+	std::vector<char*>	mBlocks;
+	char				*mBlockPos, *mBlockEnd;
+	size_t				mArenaSize;
+	Node				*mRoot;
+
+	friend class JsonDocParser;
+};
+
+} // namespace cinder
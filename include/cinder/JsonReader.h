@@ -0,0 +1,152 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Stream.h"
+#include "cinder/Exception.h"
+
+#include <string>
+#include <vector>
+
+namespace cinder {
+
+/** \brief Streaming JSON reader for documents too large to hold in memory
+ *
+ * Reads JSON from an IStream through a fixed-size buffer, either as a pull parser by calling next() for each token,
+ * or event-driven by passing a Handler to parse(). Memory use is bounded by the buffer, the nesting depth and the longest single string.
+ * \n Example usage:
+ * \code
+ * JsonReader reader( loadFileStream( "log.json" ) );
+ * reader.next(); // TOKEN_START_ARRAY
+ * while( reader.next() == JsonReader::TOKEN_START_OBJECT ) {
+ *     while( reader.next() == JsonReader::TOKEN_KEY ) {
+ *         if( reader.getString() == "time" ) { reader.next(); console() << reader.getDouble() << std::endl; }
+ *         else reader.skip(); // skips the value without parsing it
+ *     }
+ * }
+ * \endcode
+**/
+class JsonReader {
+  public:
+	typedef enum {
+		TOKEN_NONE, TOKEN_START_OBJECT, TOKEN_END_OBJECT, TOKEN_START_ARRAY, TOKEN_END_ARRAY, TOKEN_KEY,
+		TOKEN_NULL, TOKEN_BOOL, TOKEN_INT, TOKEN_DOUBLE, TOKEN_STRING, TOKEN_END_OF_DOCUMENT
+	} Token;
+
+	//! Receives the events of parse(). Returning \c false from any callback stops parsing.
+	class Handler {
+	  public:
+		virtual ~Handler() {}
+
+		virtual bool	startObject() { return true; }
+		virtual bool	endObject() { return true; }
+		virtual bool	startArray() { return true; }
+		virtual bool	endArray() { return true; }
+		//! Called with each object member's key, before its value
+		virtual bool	key( const std::string &/*key*/ ) { return true; }
+		virtual bool	nullValue() { return true; }
+		virtual bool	boolValue( bool /*value*/ ) { return true; }
+		//! Called for integers which fit in an int64_t; other numbers are passed to doubleValue()
+		virtual bool	intValue( int64_t /*value*/ ) { return true; }
+		virtual bool	doubleValue( double /*value*/ ) { return true; }
+		virtual bool	stringValue( const std::string &/*value*/ ) { return true; }
+	};
+
+	/** Creates a reader of \a stream which reads \a bufferSize bytes at a time.
+		If \a multipleRoots is true the stream may hold several whitespace-separated values, as in newline-delimited JSON. **/
+	explicit JsonReader( IStreamRef stream, size_t bufferSize = 64 * 1024, bool multipleRoots = false );
+
+	//! Advances to and returns the next token. Throws ExcParse on malformed input.
+	Token				next();
+	//! Returns the current token
+	Token				getToken() const { return mToken; }
+	/** Skips the value of the current token without decoding it. After TOKEN_START_OBJECT or TOKEN_START_ARRAY the reader advances past the matching end token,
+		and after TOKEN_KEY past the member's value. Skipped containers are only checked for balanced brackets. **/
+	void				skip();
+	//! Returns the number of containers enclosing the current position
+	size_t				getDepth() const { return mStack.size(); }
+	//! Returns the number of bytes consumed from the stream
+	uint64_t			getOffset() const { return mBufferOffset + ( mPos - mBufferBegin ); }
+
+	//! Returns the value of a TOKEN_BOOL
+	bool				getBool() const;
+	//! Returns the value of a TOKEN_INT
+	int64_t				getInt() const;
+	//! Returns the value of a TOKEN_DOUBLE or TOKEN_INT as a double
+	double				getDouble() const;
+	//! Returns the unescaped contents of a TOKEN_STRING or TOKEN_KEY
+	const std::string&	getString() const;
+
+	//! Passes every remaining token to \a handler. Returns \c false if a callback stopped parsing, \c true at the end of the document.
+	bool				parse( Handler &handler );
+
+	//! Base class for JsonReader exceptions.
+	class Exception : public cinder::Exception {
+	};
+
+	//! Exception expressing malformed JSON.
+	class ExcParse : public JsonReader::Exception {
+	  public:
+		ExcParse( const char *message, uint64_t offset ) throw();
+		virtual const char* what() const throw() { return mMessage; }
+
+	  private:
+		char mMessage[256];
+	};
+
+	//! Exception expressing a request for a value which the current token does not hold.
+	class ExcNonConvertible : public JsonReader::Exception {
+	};
+
+  private:
+	typedef enum { EXPECT_ROOT, EXPECT_VALUE, EXPECT_VALUE_OR_END, EXPECT_KEY, EXPECT_KEY_OR_END, EXPECT_COMMA_OR_END, EXPECT_NOTHING } Expect;
+
+	bool		fill();
+	bool		skipWhitespace();
+	void		error( const char *message ) const;
+
+	Token		readValue();
+	Token		endContainer( char closing );
+	void		readString();
+	void		readLiteral( const char *literal, size_t length );
+	void		readNumber();
+	uint32_t	readHex4();
+	void		afterValue();
+
+	IStreamRef			mStream;
+	std::vector<char>	mBuffer;
+	const char			*mBufferBegin, *mPos, *mEnd;
+	uint64_t			mBufferOffset;
+	bool				mMultipleRoots;
+
+	std::vector<char>	mStack;		// '{' or '[' for each open container
+	Expect				mExpect;
+	Token				mToken;
+	std::string			mString;
+	bool				mBool;
+	int64_t				mInt;
+	double				mDouble;
+};
+
+} // namespace cinder
@@ -0,0 +1,126 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Stream.h"
+#include "cinder/Exception.h"
+#include "cinder/JsonDoc.h"
+
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <vector>
+
+namespace cinder {
+
+/** \brief Streaming JSON writer
+ *
+ * Writes JSON to an OStream as it is produced, either from calls to the builder methods or by walking a JsonTree or JsonDoc::Value,
+ * without building an intermediate document. Output is buffered and flushed when the buffer fills, on flush() and on destruction.
+ * \n Example usage:
+ * \code
+ * JsonWriter writer( writeFileStream( "points.json" ) );
+ * writer.startArray();
+ * for( size_t i = 0; i < points.size(); ++i )
+ *     writer.startObject().key( "x" ).value( points[i].x ).key( "y" ).value( points[i].y ).endObject();
+ * writer.endArray();
+ * \endcode
+**/
+class JsonWriter : private boost::noncopyable {
+  public:
+	//! Creates a writer to \a stream. If \a indented is true containers are broken across lines and indented by three spaces, otherwise output is compact.
+	explicit JsonWriter( OStreamRef stream, bool indented = true );
+	//! Flushes any buffered output
+	~JsonWriter();
+
+	JsonWriter&		startObject();
+	JsonWriter&		endObject();
+	JsonWriter&		startArray();
+	JsonWriter&		endArray();
+	//! Writes the key of the next object member. Must be followed by a value.
+	JsonWriter&		key( const std::string &key );
+	//! Writes the key of the next object member. Must be followed by a value.
+	JsonWriter&		key( const char *key );
+	//! Writes the key of the next object member. Must be followed by a value.
+	JsonWriter&		key( const char *key, size_t length );
+
+	JsonWriter&		nullValue();
+	JsonWriter&		value( bool value );
+	JsonWriter&		value( int32_t number ) { return value( static_cast<int64_t>( number ) ); }
+	JsonWriter&		value( uint32_t number ) { return value( static_cast<uint64_t>( number ) ); }
+	JsonWriter&		value( int64_t value );
+	JsonWriter&		value( uint64_t value );
+	//! Writes \a value as the shortest decimal which round-trips to a float. Infinities and NaN are written as \c null.
+	JsonWriter&		value( float value );
+	//! Writes \a value as the shortest decimal which round-trips to a double. Infinities and NaN are written as \c null.
+	JsonWriter&		value( double value );
+	JsonWriter&		value( const std::string &value );
+	JsonWriter&		value( const char *value );
+	JsonWriter&		value( const char *value, size_t length );
+
+	/** Writes \a tree and its children. Inside an object with no pending key() the member's key is taken from \a tree.
+		If \a createDocument is true at the root, \a tree is wrapped in an object under its own key, as with JsonTree::WriteOptions::createDocument(). **/
+	JsonWriter&		write( const JsonTree &tree, bool createDocument = false );
+	//! Writes \a value and its children
+	JsonWriter&		write( const JsonDoc::Value &value );
+
+	//! Writes any buffered output to the stream
+	void			flush();
+	//! Returns the number of containers which have been started but not ended
+	size_t			getDepth() const { return mStack.size(); }
+
+	//! Base class for JsonWriter exceptions.
+	class Exception : public cinder::Exception {
+	};
+
+	//! Exception expressing a call which would produce invalid JSON, such as a value in an object without a key or an unbalanced end.
+	class ExcInvalidState : public JsonWriter::Exception {
+	  public:
+		ExcInvalidState( const char *message ) throw();
+		virtual const char* what() const throw() { return mMessage; }
+
+	  private:
+		char mMessage[256];
+	};
+
+  private:
+	void		beginValue();
+	void		endValue();
+	void		newLine();
+	void		writeString( const char *str, size_t length );
+	void		writeReal( const char *formatted, size_t length );
+
+	void		put( char c ) { if( mBuffer.size() == mBuffer.capacity() ) flush(); mBuffer.push_back( c ); }
+	void		put( const char *data, size_t length );
+
+	OStreamRef			mStream;
+	bool				mIndented;
+	std::vector<char>	mBuffer;
+	//! '{' or '[' for each open container
+	std::vector<char>	mStack;
+	//! whether the innermost open container (or the document, when none is open) has had a value written to it
+	bool				mHasValue;
+	bool				mKeyPending;
+};
+
+} // namespace cinder
@@ -24,6 +24,7 @@
 
 #include "cinder/Cinder.h"
 #include "cinder/Vector.h"
+#include "cinder/TaskPool.h"
 
 #include <vector>
 #include <float.h>
@@ -76,15 +77,73 @@ public:
 	void recursiveBuild( uint32_t nodeNum, uint32_t start, uint32_t end, std::vector<NodeDataIndex> &buildNodes );
 	void lookup( const NodeData &p, const LookupProc &process, float maxDist ) const;
 	void findNearest( float p[K], float result[K], uint32_t *resultIndex ) const;
+	//! Replaces the contents of \a resultIndices with the indices of the \a k points nearest to \a p, nearest first, and optionally \a resultDistSqrd with their squared distances
+	void findKNearest( const NodeData &p, size_t k, std::vector<uint32_t> *resultIndices, std::vector<float> *resultDistSqrd = 0 ) const;
+	/*! Finds the \a k nearest points to each of \a points, as findKNearest() does, spread across the default TaskPool. The results for \c points[i]
+		are at \c i * \a k in \a resultIndices and \a resultDistSqrd, with \a k clamped to the number of points in the tree. */
+	void findKNearest( const std::vector<NodeData> &points, size_t k, std::vector<uint32_t> *resultIndices, std::vector<float> *resultDistSqrd = 0 ) const;
 	
 private:
+	typedef std::pair<float, uint32_t> DistanceIndex;
+
+	// Ranges larger than this are split before building subtrees in parallel
+	enum { MIN_PARALLEL_BUILD_NODES = 4096, FIND_K_NEAREST_GRAIN_SIZE = 256 };
+
+	struct Subtree {
+		uint32_t nodeNum, start, end;
+	};
+
+	struct BuildSubtreesFn {
+		BuildSubtreesFn( KdTree *tree, const std::vector<Subtree> &subtrees, std::vector<NodeDataIndex> &buildNodes )
+			: mTree( *tree ), mSubtrees( subtrees ), mBuildNodes( buildNodes ) {}
+
+		void operator()( size_t begin, size_t end ) const {
+			for( size_t s = begin; s < end; ++s )
+				mTree.recursiveBuild( mSubtrees[s].nodeNum, mSubtrees[s].start, mSubtrees[s].end, mBuildNodes );
+		}
+
+		KdTree							&mTree;
+		const std::vector<Subtree>		&mSubtrees;
+		std::vector<NodeDataIndex>		&mBuildNodes;
+	};
+
+	struct FindKNearestFn {
+		FindKNearestFn( const KdTree &tree, const std::vector<NodeData> &points, size_t k, std::vector<uint32_t> *resultIndices, std::vector<float> *resultDistSqrd )
+			: mTree( tree ), mPoints( points ), mK( k ), mResultIndices( *resultIndices ), mResultDistSqrd( resultDistSqrd ) {}
+
+		void operator()( size_t begin, size_t end ) const {
+			std::vector<DistanceIndex> heap;
+			heap.reserve( mK + 1 );
+			for( size_t i = begin; i < end; ++i ) {
+				heap.clear();
+				mTree.privateFindKNearest( mPoints[i], mK, heap );
+				for( size_t n = 0; n < mK; ++n ) {
+					mResultIndices[i * mK + n] = heap[n].second;
+					if( mResultDistSqrd )
+						(*mResultDistSqrd)[i * mK + n] = heap[n].first;
+				}
+			}
+		}
+
+		const KdTree					&mTree;
+		const std::vector<NodeData>		&mPoints;
+		size_t							mK;
+		std::vector<uint32_t>			&mResultIndices;
+		std::vector<float>				*mResultDistSqrd;
+	};
+
 	// KdTree Private Methods
+	uint32_t splitNode( uint32_t nodeNum, uint32_t start, uint32_t end, std::vector<NodeDataIndex> &buildNodes );
+	void buildTop( uint32_t nodeNum, uint32_t start, uint32_t end, std::vector<NodeDataIndex> &buildNodes, uint32_t maxSubtreeNodes, std::vector<Subtree> *subtrees );
 	void privateLookup(uint32_t nodeNum, float p[K], const LookupProc &process, float &maxDistSquared) const;
 	void privateFindNearest( uint32_t nodeNum, float p[K], float &maxDistSquared, float result[K], uint32_t *resultIndex ) const;
+	//! Fills \a heap with the \a k nearest points to \a p, nearest first
+	void privateFindKNearest( const NodeData &p, size_t k, std::vector<DistanceIndex> &heap ) const;
+	void privateFindKNearest( uint32_t nodeNum, const float p[K], size_t k, std::vector<DistanceIndex> &heap ) const;
 	// KdTree Private Data
 	KdNode<K> *nodes;
 	NodeDataIndex *mNodeData;
-	uint32_t nNodes, nextFreeNode;
+	uint32_t nNodes;
 };
 
 
@@ -155,15 +214,33 @@ template<typename NodeData, unsigned char K, typename LookupProc>
 void KdTree<NodeData, K, LookupProc>::initialize( const NodeDataVector &d )
 {
 	nNodes = NodeDataVectorTraits<NodeDataVector>::getSize( d );
-	nextFreeNode = 1;
 	nodes = (KdNode<K> *)malloc(nNodes * sizeof(KdNode<K>));
 	mNodeData = new NodeDataIndex[nNodes];
 	std::vector<NodeDataIndex> buildNodes;
 	buildNodes.reserve( nNodes );
 	for( uint32_t i = 0; i < nNodes; ++i )
 		buildNodes.push_back( std::make_pair( &d[i], i ) );
-	// Begin the KdTree building process
-	recursiveBuild( 0, 0, nNodes, buildNodes );
+	if( nNodes == 0 )
+		return;
+	// Split the top of the tree serially, then build the subtrees below in parallel. Each subtree has a node per point,
+	// so its nodes' numbers follow from its range of points regardless of the order the subtrees are built in.
+	std::vector<Subtree> subtrees;
+	const uint32_t maxSubtreeNodes = std::max<uint32_t>( MIN_PARALLEL_BUILD_NODES, nNodes / ( (uint32_t)TaskPool::getDefault().getNumThreads() * 4 ) );
+	buildTop( 0, 0, nNodes, buildNodes, maxSubtreeNodes, &subtrees );
+	TaskPool::getDefault().parallelFor( subtrees.size(), 1, BuildSubtreesFn( this, subtrees, buildNodes ) );
+}
+
+template<typename NodeData, unsigned char K, typename LookupProc>
+void KdTree<NodeData, K, LookupProc>::buildTop( uint32_t nodeNum, uint32_t start, uint32_t end, std::vector<NodeDataIndex> &buildNodes, uint32_t maxSubtreeNodes, std::vector<Subtree> *subtrees )
+{
+	if( end - start <= maxSubtreeNodes ) {
+		Subtree subtree = { nodeNum, start, end };
+		subtrees->push_back( subtree );
+		return;
+	}
+	uint32_t splitPos = splitNode( nodeNum, start, end, buildNodes );
+	buildTop( nodeNum + 1, start, splitPos, buildNodes, maxSubtreeNodes, subtrees );
+	buildTop( nodes[nodeNum].rightChild, splitPos + 1, end, buildNodes, maxSubtreeNodes, subtrees );
 }
 
 template<typename NodeData, unsigned char K, typename LookupProc>
@@ -175,12 +252,24 @@ void KdTree<NodeData, K, LookupProc>::recursiveBuild( uint32_t nodeNum, uint32_t
 		mNodeData[nodeNum] = buildNodes[start];
 		return;
 	}
+	uint32_t splitPos = splitNode( nodeNum, start, end, buildNodes );
+	if( start < splitPos )
+		recursiveBuild( nodeNum + 1, start, splitPos, buildNodes );
+	if( splitPos + 1 < end )
+		recursiveBuild( nodes[nodeNum].rightChild, splitPos + 1, end, buildNodes );
+}
+
+// Splits the points from start to end at their median along their widest axis into nodeNum, whose left subtree follows it
+// and whose right subtree follows the left one. Returns the position of the median.
+template<typename NodeData, unsigned char K, typename LookupProc>
+uint32_t KdTree<NodeData, K, LookupProc>::splitNode( uint32_t nodeNum, uint32_t start, uint32_t end, std::vector<NodeDataIndex> &buildNodes )
+{
 	// Choose split direction and partition data
 	// Compute bounds of data from _start_ to _end_
 	float boundMin[K], boundMax[K];
 	for( unsigned char k = 0; k < K; ++k ) {
 		boundMin[k] = FLT_MAX;
-		boundMax[k] = FLT_MIN;
+		boundMax[k] = -FLT_MAX;
 	}
 	
 	for( uint32_t i = start; i < end; ++i ) {
@@ -203,15 +292,11 @@ void KdTree<NodeData, K, LookupProc>::recursiveBuild( uint32_t nodeNum, uint32_t
 	// Allocate kd-tree node and continue recursively
 	nodes[nodeNum].init( NodeDataTraits<NodeData>::getAxis( *buildNodes[splitPos].first, splitAxis ), splitAxis );
 	mNodeData[nodeNum] = buildNodes[splitPos];
-	if( start < splitPos ) {
+	if( start < splitPos )
 		nodes[nodeNum].hasLeftChild = 1;
-		uint32_t childNum = nextFreeNode++;
-		recursiveBuild( childNum, start, splitPos, buildNodes );
-	}
-	if( splitPos + 1 < end ) {
-		nodes[nodeNum].rightChild = nextFreeNode++;
-		recursiveBuild( nodes[nodeNum].rightChild, splitPos + 1, end, buildNodes );
-	}
+	if( splitPos + 1 < end )
+		nodes[nodeNum].rightChild = nodeNum + 1 + ( splitPos - start );
+	return splitPos;
 }
 
 template<typename NodeData, unsigned char K, typename LookupProc>
@@ -301,4 +386,82 @@ void KdTree<NodeData, K, LookupProc>::privateFindNearest( uint32_t nodeNum, floa
 	}
 }
 
+// Find K Nearest
+template<typename NodeData, unsigned char K, typename LookupProc>
+void KdTree<NodeData, K, LookupProc>::findKNearest( const NodeData &p, size_t k, std::vector<uint32_t> *resultIndices, std::vector<float> *resultDistSqrd ) const
+{
+	k = std::min<size_t>( k, nNodes );
+	std::vector<DistanceIndex> heap;
+	heap.reserve( k + 1 );
+	privateFindKNearest( p, k, heap );
+	resultIndices->resize( k );
+	for( size_t n = 0; n < k; ++n )
+		(*resultIndices)[n] = heap[n].second;
+	if( resultDistSqrd ) {
+		resultDistSqrd->resize( k );
+		for( size_t n = 0; n < k; ++n )
+			(*resultDistSqrd)[n] = heap[n].first;
+	}
+}
+
+template<typename NodeData, unsigned char K, typename LookupProc>
+void KdTree<NodeData, K, LookupProc>::findKNearest( const std::vector<NodeData> &points, size_t k, std::vector<uint32_t> *resultIndices, std::vector<float> *resultDistSqrd ) const
+{
+	k = std::min<size_t>( k, nNodes );
+	resultIndices->resize( points.size() * k );
+	if( resultDistSqrd )
+		resultDistSqrd->resize( points.size() * k );
+	TaskPool::getDefault().parallelFor( points.size(), FIND_K_NEAREST_GRAIN_SIZE, FindKNearestFn( *this, points, k, resultIndices, resultDistSqrd ) );
+}
+
+template<typename NodeData, unsigned char K, typename LookupProc>
+void KdTree<NodeData, K, LookupProc>::privateFindKNearest( const NodeData &p, size_t k, std::vector<DistanceIndex> &heap ) const
+{
+	if( k == 0 )
+		return;
+	float pt[K];
+	for( unsigned char a = 0; a < K; ++a )
+		pt[a] = NodeDataTraits<NodeData>::getAxis( p, a );
+	privateFindKNearest( 0, pt, k, heap );
+	std::sort_heap( heap.begin(), heap.end() );
+}
+
+// Keeps the k nearest points found so far in a max-heap, so the farthest of them is on top to be replaced
+template<typename NodeData, unsigned char K, typename LookupProc>
+void KdTree<NodeData, K, LookupProc>::privateFindKNearest( uint32_t nodeNum, const float p[K], size_t k, std::vector<DistanceIndex> &heap ) const
+{
+	const KdNode<K> *node = &nodes[nodeNum];
+	// test the node's own point first, since it lies on the split nearest the query and so tightens the search early
+	float distSqr = 0.0f;
+	for( unsigned char a = 0; a < K; ++a ) {
+		float v = NodeDataTraits<NodeData>::getAxis( *mNodeData[nodeNum].first, a ) - p[a];
+		distSqr += v * v;
+	}
+	if( heap.size() < k || distSqr < heap.front().first ) {
+		heap.push_back( DistanceIndex( distSqr, mNodeData[nodeNum].second ) );
+		std::push_heap( heap.begin(), heap.end() );
+		if( heap.size() > k ) {
+			std::pop_heap( heap.begin(), heap.end() );
+			heap.pop_back();
+		}
+	}
+
+	int axis = node->splitAxis;
+	if( axis == K )
+		return;
+	float dist2 = ( p[axis] - node->splitPos ) * ( p[axis] - node->splitPos );
+	if( p[axis] <= node->splitPos ) {
+		if( node->hasLeftChild )
+			privateFindKNearest( nodeNum + 1, p, k, heap );
+		if( ( heap.size() < k || dist2 < heap.front().first ) && ( node->rightChild < nNodes ) )
+			privateFindKNearest( node->rightChild, p, k, heap );
+	}
+	else {
+		if( node->rightChild < nNodes )
+			privateFindKNearest( node->rightChild, p, k, heap );
+		if( ( heap.size() < k || dist2 < heap.front().first ) && node->hasLeftChild )
+			privateFindKNearest( nodeNum + 1, p, k, heap );
+	}
+}
+
 } // namespace ci
@@ -26,14 +26,15 @@
 #include "cinder/Stream.h"
 
 #include <boost/logic/tribool.hpp>
-#include <boost/tuple/tuple_comparison.hpp>
 #include <map>
 
 namespace cinder {
 
 /** \brief Loads Alias|Wavefront .OBJ file format
  *
- * Currently does not support anything but polygonal data
+ * Currently does not support anything but polygonal data. The file is read in one piece (memory-mapped when it is a
+ * file on disk) and parsed in line-aligned chunks on the default TaskPool; the chunks are then merged in file order.
+ * The constructors throw ObjLoaderExcInvalidIndex if a face references a vertex, texture coordinate or normal the file lacks.
  * \n Example usage:
  * \code
  * cinder::TriMesh myCube;
@@ -100,6 +101,8 @@ class ObjLoader {
 	};
 
 	struct Group {
+		Group() : mBaseVertexOffset( 0 ), mBaseTexCoordOffset( 0 ), mBaseNormalOffset( 0 ), mHasTexCoords( false ), mHasNormals( false ) {}
+
 		std::string				mName;
 		int						mBaseVertexOffset, mBaseTexCoordOffset, mBaseNormalOffset;
 		std::vector<Face>		mFaces;
@@ -117,24 +120,30 @@ class ObjLoader {
 	const std::vector<Group>&		getGroups() const { return mGroups; }
 	
  private:
-	typedef boost::tuple<int,int> VertexPair;
-	typedef boost::tuple<int,int,int> VertexTriple;
+	class VertexIndexMap;
 
-	void	parse( bool includeUVs );
+	void	parse( std::shared_ptr<IStream> stream, bool includeUVs );
+	void	parse( DataSourceRef dataSource, bool includeUVs );
+	void	parse( const char *begin, const char *end, bool includeUVs );
 
- 	void	parseFace( Group *group, const Material *material, const std::string &s, bool includeUVs );
     void    parseMaterial( std::shared_ptr<IStream> material );
 	void	loadInternalNoOptimize( const Group &group, TriMesh *destTriMesh, bool texCoords, bool normals );
-	void	loadInternalNormalsTextures( const Group &group, std::map<boost::tuple<int,int,int>,int> &uniqueVerts, TriMesh *destTriMesh );
-	void	loadInternalNormals( const Group &group, std::map<boost::tuple<int,int>,int> &uniqueVerts, TriMesh *destTriMesh );
-	void	loadInternalTextures( const Group &group, std::map<boost::tuple<int,int>,int> &uniqueVerts, TriMesh *destTriMesh );
-	void	loadInternal( const Group &group, std::map<int,int> &uniqueVerts, TriMesh *destTriMesh );	
+	void	loadInternalNormalsTextures( const Group &group, VertexIndexMap &uniqueVerts, TriMesh *destTriMesh );
+	void	loadInternalNormals( const Group &group, VertexIndexMap &uniqueVerts, TriMesh *destTriMesh );
+	void	loadInternalTextures( const Group &group, VertexIndexMap &uniqueVerts, TriMesh *destTriMesh );
+	void	loadInternal( const Group &group, std::vector<int> &uniqueVerts, TriMesh *destTriMesh );
  
-	std::shared_ptr<IStream>        mStream;
 	std::vector<Vec3f>			    mVertices, mNormals;
 	std::vector<Vec2f>			    mTexCoords;
 	std::vector<Group>			    mGroups;
 	std::map<std::string, Material> mMaterials;
 };
 
+class ObjLoaderExc : public Exception {
+};
+
+//! Exception expressing a face which references a vertex, texture coordinate or normal the file does not define
+class ObjLoaderExcInvalidIndex : public ObjLoaderExc {
+};
+
 } // namespace cinder
@@ -0,0 +1,110 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Shape2d.h"
+#include "cinder/Path2d.h"
+#include "cinder/PolyLine.h"
+#include "cinder/MatrixAffine2.h"
+#include "cinder/Surface.h"
+#include "cinder/Channel.h"
+#include "cinder/Area.h"
+#include "cinder/Color.h"
+#include "cinder/Triangulate.h"
+
+#include <vector>
+
+namespace cinder {
+
+/** \brief Antialiased scanline rasterizer for filling outlines on the CPU
+ *
+ * Outlines are accumulated with the add*() methods, in pixel coordinates after \a transform is applied, and are implicitly
+ * closed. Filling derives each pixel's coverage from the signed area of the edges crossing it, accumulated over only the
+ * touched span of each scanline. The winding rule, any of Triangulator::Winding, is applied to that summed area rather than
+ * to each point, so coverage is exact where a pixel is crossed by one outline's edges but not where several outlines
+ * partially cover the same pixel: under WINDING_NONZERO the overlapping antialiased edges of stroke pieces add up and come
+ * out too opaque at joins, and edges of opposing winding partially cancel. Outlines running counterclockwise on screen wind
+ * positively, whereas Triangulator orients windings by the first contour. Horizontal bands of the image are rasterized in
+ * parallel on the default TaskPool.
+ *
+ * \code
+ * Rasterizer rasterizer( surface.getWidth(), surface.getHeight() );
+ * rasterizer.addShape( shape, MatrixAffine2f::makeScale( Vec2f( 2, 2 ) ) );
+ * rasterizer.fill( &surface, ColorA( 1, 0.5f, 0, 1 ) );
+ * \endcode
+**/
+class Rasterizer {
+  public:
+	//! Called by rasterize() with \a count coverage values in [0,1] for the pixels starting at (\a x, \a y)
+	typedef std::function<void(int32_t x, int32_t y, int32_t count, const float *coverage)>	SpanFn;
+
+	Rasterizer( int32_t width, int32_t height );
+
+	int32_t		getWidth() const { return mWidth; }
+	int32_t		getHeight() const { return mHeight; }
+
+	//! Removes all outlines
+	void		clear();
+	//! Returns whether no outlines have been added since the last clear()
+	bool		isEmpty() const { return mEdges.empty(); }
+	//! Returns the pixels which may be covered by the outlines
+	Area		getBounds() const;
+
+	//! Adds the contours of \a shape. \a approximationScale represents how finely curves are subdivided, with 1.0 corresponding to 1:1 with pixels.
+	void		addShape( const Shape2d &shape, const MatrixAffine2f &transform = MatrixAffine2f::identity(), float approximationScale = 1.0f );
+	//! Adds \a path. \a approximationScale represents how finely curves are subdivided, with 1.0 corresponding to 1:1 with pixels.
+	void		addPath( const Path2d &path, const MatrixAffine2f &transform = MatrixAffine2f::identity(), float approximationScale = 1.0f );
+	//! Adds \a polyLine, which is treated as closed
+	void		addPolyLine( const PolyLine2f &polyLine, const MatrixAffine2f &transform = MatrixAffine2f::identity() );
+	//! Adds the closed polygon made of the \a numPoints points at \a points
+	void		addPolygon( const Vec2f *points, size_t numPoints, const MatrixAffine2f &transform = MatrixAffine2f::identity() );
+
+	//! Calls \a spanFn for every run of pixels touched by the outlines. Bands of rows run concurrently, so \a spanFn must be safe to call from several threads for different rows.
+	void		rasterize( const SpanFn &spanFn, Triangulator::Winding winding = Triangulator::WINDING_NONZERO ) const;
+	//! Composites \a color over \a surface wherever the outlines cover it. \a surface is treated as premultiplied.
+	void		fill( Surface8u *surface, const ColorA &color, Triangulator::Winding winding = Triangulator::WINDING_NONZERO ) const;
+	//! Composites the outlines' coverage over \a channel, treating it as an alpha mask
+	void		fill( Channel8u *channel, Triangulator::Winding winding = Triangulator::WINDING_NONZERO ) const;
+
+	//! Returns the scale \a transform applies to areas, for scaling a curve's \a approximationScale to pixels
+	static float	calcAreaScale( const MatrixAffine2f &transform );
+
+  private:
+	// a line segment clipped to the Rasterizer's bounds; y0 != y1
+	struct Edge {
+		float	x0, y0, x1, y1;
+	};
+
+	void		addLine( Vec2f p0, Vec2f p1 );
+	void		addClippedLine( const Vec2f &p0, const Vec2f &p1 );
+	void		rasterizeBands( size_t begin, size_t end, int32_t firstRow, const std::vector<uint32_t> &bandStarts, const std::vector<uint32_t> &bandEdges, const SpanFn &spanFn, Triangulator::Winding winding ) const;
+
+	friend struct RasterizeBandsFn;
+
+	int32_t				mWidth, mHeight;
+	std::vector<Edge>	mEdges;
+	float				mMinX, mMinY, mMaxX, mMaxY;
+};
+
+} // namespace cinder
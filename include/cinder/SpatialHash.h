@@ -0,0 +1,145 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Vector.h"
+#include "cinder/CinderMath.h"
+
+#include <vector>
+
+namespace cinder {
+
+/** \brief A uniform grid over a set of points, hashed into a table of buckets, for radius and nearest neighbor queries on points which move.
+ *
+ * Unlike KdTree, which is better suited to points which stay put, rebuilding takes linear time and reuses its storage, so a
+ * particle system can afford to rebuild every frame. The build is a counting sort of the points by bucket, spread across the
+ * default TaskPool: first by the high bits of the bucket over chunks of the points, then by bucket within each group. Queries visit only the cells they reach, so they are fastest when the cell size is close to the radius
+ * being searched. The grid is unbounded: cells are hashed rather than allocated, so points may wander anywhere.
+ * \code
+ * mHash.build( mPositions );
+ * std::vector<uint32_t> neighbors;
+ * for( size_t p = 0; p < mPositions.size(); ++p ) {
+ *	mHash.findInRadius( mPositions[p], mRadius, &neighbors );
+ *	...
+ * }
+ * \endcode
+**/
+class SpatialHash {
+  public:
+	//! Creates an empty hash with cubic cells whose sides are \a cellSize
+	explicit SpatialHash( float cellSize );
+	//! Creates a hash with cubic cells whose sides are \a cellSize over \a points
+	SpatialHash( const std::vector<Vec3f> &points, float cellSize );
+
+	//! Replaces the points in the hash with \a points. Query results refer to points by their index in \a points.
+	void	build( const std::vector<Vec3f> &points );
+	//! Replaces the points in the hash with the \a numPoints points at \a points
+	void	build( const Vec3f *points, size_t numPoints );
+
+	//! Sets the size of the sides of the cells, which takes effect at the next build()
+	void	setCellSize( float cellSize ) { mCellSize = cellSize; }
+	//! Returns the size of the sides of the cells
+	float	getCellSize() const { return mCellSize; }
+	//! Returns the number of points in the hash
+	size_t	getNumPoints() const { return mSortedPoints.size(); }
+
+	/*! Calls \a proc.process( index, distSqrd, maxDistSqrd ) for each point within \a radius of \a center, in no particular order, as KdTree::lookup() does.
+		\a proc may reduce \a maxDistSqrd to narrow the search. */
+	template<typename LookupProc>
+	void	lookup( const Vec3f &center, float radius, LookupProc &proc ) const;
+	//! Replaces the contents of \a result with the indices of the points within \a radius of \a center, in no particular order
+	void	findInRadius( const Vec3f &center, float radius, std::vector<uint32_t> *result ) const;
+	//! Replaces the contents of \a result with the indices of the \a k points nearest to \a point, nearest first, and optionally \a distancesSqrd with their squared distances
+	void	findKNearest( const Vec3f &point, size_t k, std::vector<uint32_t> *result, std::vector<float> *distancesSqrd = 0 ) const;
+
+  private:
+	struct HashPointsFn;
+	struct GroupPointsFn;
+	struct SortGroupsFn;
+
+	struct Cell {
+		int		x, y, z;
+	};
+
+	Cell		calcCell( const Vec3f &p ) const
+	{
+		Cell result = { (int)math<float>::floor( p.x * mInvCellSize ), (int)math<float>::floor( p.y * mInvCellSize ), (int)math<float>::floor( p.z * mInvCellSize ) };
+		return result;
+	}
+	uint32_t	calcBucket( int x, int y, int z ) const { return ( (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u ) & mBucketMask; }
+	//! Returns whether the point at \a sortedIndex lies in the cell at \a x, \a y, \a z, rather than in another cell which hashes to the same bucket
+	bool		isInCell( uint32_t sortedIndex, int x, int y, int z ) const
+	{
+		const Cell cell = calcCell( mSortedPoints[sortedIndex] );
+		return cell.x == x && cell.y == y && cell.z == z;
+	}
+
+	float					mCellSize, mInvCellSize;
+	uint32_t				mBucketMask;
+	//! The cells spanned by the points, which bound the search for nearest neighbors
+	Cell					mMinCell, mMaxCell;
+	//! The points sorted by bucket, with the range of bucket \c b from \c mBucketStarts[b] to \c mBucketStarts[b+1]
+	std::vector<Vec3f>		mSortedPoints;
+	//! The index of each of \a mSortedPoints among the points passed to build()
+	std::vector<uint32_t>	mSortedIndices;
+	std::vector<uint32_t>	mBucketStarts;
+	//! Scratch space for build(), kept to avoid reallocating each frame
+	std::vector<uint32_t>	mPointBuckets, mChunkCounts, mGroupedPoints;
+	std::vector<Cell>		mChunkMinCells, mChunkMaxCells;
+};
+
+template<typename LookupProc>
+void SpatialHash::lookup( const Vec3f &center, float radius, LookupProc &proc ) const
+{
+	float maxDistSqrd = radius * radius;
+	const Cell minCell = calcCell( center - Vec3f( radius, radius, radius ) ), maxCell = calcCell( center + Vec3f( radius, radius, radius ) );
+	const double numCells = ( maxCell.x - (double)minCell.x + 1 ) * ( maxCell.y - (double)minCell.y + 1 ) * ( maxCell.z - (double)minCell.z + 1 );
+
+	// a search wider than the table visits every bucket at most once instead
+	if( numCells > mBucketMask + 1.0 ) {
+		for( uint32_t s = 0; s < mSortedPoints.size(); ++s ) {
+			const float distSqrd = mSortedPoints[s].distanceSquared( center );
+			if( distSqrd < maxDistSqrd )
+				proc.process( mSortedIndices[s], distSqrd, maxDistSqrd );
+		}
+		return;
+	}
+
+	for( int z = minCell.z; z <= maxCell.z; ++z ) {
+		for( int y = minCell.y; y <= maxCell.y; ++y ) {
+			for( int x = minCell.x; x <= maxCell.x; ++x ) {
+				const uint32_t bucket = calcBucket( x, y, z );
+				for( uint32_t s = mBucketStarts[bucket]; s < mBucketStarts[bucket + 1]; ++s ) {
+					const float distSqrd = mSortedPoints[s].distanceSquared( center );
+					if( distSqrd < maxDistSqrd && isInCell( s, x, y, z ) )
+						proc.process( mSortedIndices[s], distSqrd, maxDistSqrd );
+				}
+			}
+		}
+	}
+}
+
+} // namespace cinder
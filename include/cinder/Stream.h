@@ -341,6 +341,40 @@ class OStreamMem : public OStream {
 };
 
 
+typedef std::shared_ptr<class MappedFile>		MappedFileRef;
+
+//! Maps the contents of a file into memory. With \a copyOnWrite the mapped pages may be modified privately without affecting the file.
+class MappedFile : public std::enable_shared_from_this<MappedFile>, private boost::noncopyable {
+ public:
+	//! Maps the file located at \a path. Throws StreamExc if the file cannot be opened or mapped.
+	static MappedFileRef	create( const fs::path &path, bool copyOnWrite = false );
+	~MappedFile();
+
+	//! Returns a pointer to the mapped contents of the file, or NULL for an empty file
+	const void*			getData() const { return mData; }
+	//! Returns a writable pointer to the mapped contents. Writing is only legal when the file was mapped with \a copyOnWrite.
+	void*				getData() { return mData; }
+	//! Returns the size of the mapping in bytes
+	size_t				getSize() const { return mSize; }
+	const fs::path&		getFilePath() const { return mFilePath; }
+	
+	//! Returns an IStream over \a size bytes of the mapping beginning at \a offset, which keeps the mapping alive for its lifetime
+	IStreamMemRef		createStream( size_t offset, size_t size );
+	//! Returns an IStream over the entire mapping
+	IStreamMemRef		createStream() { return createStream( 0, mSize ); }
+
+ protected:
+	MappedFile( const fs::path &path, bool copyOnWrite );
+
+	void			*mData;
+	size_t			mSize;
+	fs::path		mFilePath;
+#if defined( CINDER_MSW )
+	void			*mFileHandle, *mMappingHandle;
+#endif
+};
+
+
 // This class is a utility to save and restore a stream's state
 class IStreamStateRestore {
  public:
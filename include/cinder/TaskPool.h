@@ -0,0 +1,77 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Thread.h"
+
+#include <vector>
+#include <exception>
+#include <boost/noncopyable.hpp>
+
+namespace cinder {
+
+/** \brief Fixed set of worker threads for data-parallel loops
+ *
+ * parallelFor() splits an index range into chunks which the workers and the calling thread claim until none are left,
+ * and returns once every chunk has run. A parallelFor() issued while the pool is already busy, including one nested inside
+ * a running chunk, runs serially on the calling thread rather than waiting.
+ *
+ * \code
+ * TaskPool::getDefault().parallelFor( points.size(), 1024, [&]( size_t begin, size_t end ) {
+ *     for( size_t i = begin; i < end; ++i )
+ *         points[i] = transform * points[i];
+ * } );
+ * \endcode
+**/
+class TaskPool : private boost::noncopyable {
+  public:
+	//! Creates a pool which runs \a numThreads chunks at a time, counting the thread calling parallelFor(). \c 0 uses the number of hardware threads.
+	explicit TaskPool( size_t numThreads = 0 );
+	~TaskPool();
+
+	//! Returns a process-wide pool sized to the hardware, created on first use
+	static TaskPool&	getDefault();
+
+	//! Returns the number of chunks which can run at once, including the calling thread
+	size_t		getNumThreads() const { return mWorkers.size() + 1; }
+
+	/** Calls \a fn( begin, end ) over [0, \a count) in chunks of \a grainSize indices and blocks until all have run. The first
+		exception thrown by \a fn is rethrown on the calling thread once the remaining chunks have been abandoned. **/
+	void		parallelFor( size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &fn );
+
+  private:
+	struct Job;
+
+	void		workerLoop();
+	static void	runChunks( Job *job );
+
+	std::vector<std::shared_ptr<std::thread> >	mWorkers;
+	std::mutex					mMutex, mCallMutex;
+	std::condition_variable		mWakeCondition, mDoneCondition;
+	Job							*mJob;
+	uint64_t					mGeneration;
+	bool						mQuit;
+};
+
+} // namespace cinder
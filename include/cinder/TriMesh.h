@@ -23,6 +23,7 @@
 #pragma once
 
 #include <vector>
+#include <limits>
 #include "cinder/Vector.h"
 #include "cinder/AxisAlignedBox.h"
 #include "cinder/DataSource.h"
@@ -30,6 +31,7 @@
 #include "cinder/Matrix.h"
 #include "cinder/Color.h"
 #include "cinder/Rect.h"
+#include "cinder/Exception.h"
 
 namespace cinder {
 	
@@ -65,13 +67,38 @@ namespace cinder {
 	 
 class TriMesh {
  public:
-	
+	//! Options for write()
+	class WriteOptions {
+	  public:
+		WriteOptions() : mVersion( 1 ), mCompressIndices( false ) {}
+
+		//! Sets the file format version, either 1 or 2. Version 1 omits colors and can't be viewed by TriMeshView; version 2 can't be read by older releases. Default is \c 1.
+		WriteOptions&	version( uint8_t version ) { mVersion = version; return *this; }
+		//! Delta and varint encodes the indices of a version 2 file. Smaller on disk, but a TriMeshView has to decode them on load. Default is \c false.
+		WriteOptions&	compressIndices( bool compress = true ) { mCompressIndices = compress; return *this; }
+
+		uint8_t		getVersion() const { return mVersion; }
+		bool		getCompressIndices() const { return mCompressIndices; }
+
+	  private:
+		uint8_t		mVersion;
+		bool		mCompressIndices;
+	};
+
+	//! Determines how much each face contributes to the normals of its vertices in recalculateNormals()
+	enum NormalWeighting {
+		WEIGHT_UNIFORM,		//!< every face counts equally
+		WEIGHT_AREA,		//!< faces count in proportion to their area
+		WEIGHT_ANGLE		//!< faces count in proportion to their angle at the vertex, which is independent of how finely the surface is tessellated
+	};
+
 	void		clear();
 	
 	bool		hasNormals() const { return ! mNormals.empty(); }
 	bool		hasColorsRGB() const { return ! mColorsRGB.empty(); }
 	bool		hasColorsRGBA() const { return ! mColorsRGBA.empty(); }
 	bool		hasTexCoords() const { return ! mTexCoords.empty(); }
+	bool		hasTangents() const { return ! mTangents.empty(); }
 
 	/*! Creates a vertex which can be referred to with appendTriangle() or appendIndices() */
 	void		appendVertex( const Vec3f &v ) { mVertices.push_back( v ); }
@@ -137,6 +164,14 @@ class TriMesh {
 	std::vector<Vec2f>&				getTexCoords() { return mTexCoords; }	
 	//! Returns a std::vector of Texture coordinates as Vec2fs. There will be one texture coord for each vertex in the TriMesh
 	const std::vector<Vec2f>&		getTexCoords() const { return mTexCoords; }	
+	//! Returns the per-vertex tangents calculated by recalculateTangents()
+	std::vector<Vec3f>&				getTangents() { return mTangents; }
+	//! Returns the per-vertex tangents calculated by recalculateTangents()
+	const std::vector<Vec3f>&		getTangents() const { return mTangents; }
+	//! Returns the per-vertex bitangents calculated by recalculateTangents()
+	std::vector<Vec3f>&				getBitangents() { return mBitangents; }
+	//! Returns the per-vertex bitangents calculated by recalculateTangents()
+	const std::vector<Vec3f>&		getBitangents() const { return mBitangents; }
 	//! Trimesh indices are ordered such that the indices of triangle T are { indices[T*3+0], indices[T*3+1], indices[T*3+2] }
 	std::vector<uint32_t>&			getIndices() { return mIndices; }		
 	//! Trimesh indices are ordered such that the indices of triangle T are { indices[T*3+0], indices[T*3+1], indices[T*3+2] }
@@ -147,23 +182,122 @@ class TriMesh {
 	//! Calculates the bounding box of all vertices as transformed by \a transform
 	AxisAlignedBox3f	calcBoundingBox( const Matrix44f &transform ) const;
 
-	//! This reads a TriMesh in from a data file that was serialized using the write() function.
+	//! This reads a TriMesh in from a data file that was serialized using the write() function. Throws TriMeshExcInvalidFile if a version 2 file is malformed or fails its checksum.
 	void		read( DataSourceRef in );
-	//! This writes a TriMesh to a proprietary file format to be read using the read() function.
-	void		write( DataTargetRef out ) const;
+	//! This writes a TriMesh to a proprietary file format to be read using the read() function or, for version 2, mapped with TriMeshView. Writes version 1 unless \a options asks for version 2.
+	void		write( DataTargetRef out, const WriteOptions &options = WriteOptions() ) const;
+
+	//! Adds or replaces normals by calculating them from the vertices and faces, weighting each face by \a weighting. Runs in parallel on the default TaskPool.
+	void		recalculateNormals( NormalWeighting weighting = WEIGHT_UNIFORM );
+	/*! Adds or replaces tangents and bitangents for normal mapping, calculated from the vertices, faces, texture coordinates and normals.
+		The tangents are orthogonal to the normals and the bitangents complete a basis whose handedness follows the texture coordinates.
+		Normals are calculated first if there isn't one per vertex, and the tangents are cleared if there isn't a texture coordinate per vertex. Runs in parallel on the default TaskPool. */
+	void		recalculateTangents();
 
-	//! Adds or replaces normals by calculating them from the vertices and faces.
-	void		recalculateNormals();
+	/*! Reorders the triangles so that consecutive triangles share vertices, improving the hit rate of the GPU's post-transform vertex cache.
+		Uses Tom Forsyth's linear-speed vertex cache optimization, which simulates an LRU cache of \a cacheSize vertices and isn't sensitive to the exact size of the hardware's cache. */
+	void		optimizeIndexOrder( size_t cacheSize = 32 );
+	/*! Renumbers the vertices in the order the indices first use them, so that vertex fetches walk memory sequentially. Best run after optimizeIndexOrder().
+		Unused vertices are moved to the end. Every attribute with one element per vertex is reordered alongside the vertices. */
+	void		optimizeVertexOrder();
+	/*! Reorders clusters of triangles so that those most likely to hide others are drawn first, reducing overdraw from any viewpoint while keeping most of the vertex cache locality. Run after optimizeIndexOrder(), whose order is split into the clusters.
+		Clusters are sorted by how far they face outward from the mesh's centroid, following Sander, Nehab and Barczak's "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw".
+		\a threshold bounds how much higher than the cache-optimized order each cluster's cache miss ratio may be, so 1.05 allows 5%. Larger values give smaller clusters and less overdraw. */
+	void		optimizeOverdraw( float threshold = 1.05f );
+	//! Returns the average number of vertex cache misses per triangle (ACMR) when the indices are drawn through a FIFO cache of \a cacheSize vertices. Ranges from 0.5 for an ideal mesh to 3.
+	float		calcCacheMissRatio( size_t cacheSize = 16 ) const;
+
+	/*! Reduces the mesh to about \a targetTriangles triangles by collapsing edges into one of their vertices, cheapest first as measured by Garland and Heckbert's quadric error metric.
+		Stops early rather than let the surface deviate by more than \a maxError on average around any vertex, in the units of the vertices. Vertices on open boundaries only collapse along the boundary.
+		Vertices on UV or normal seams, which share their position with one other vertex, only collapse along the seam together with that copy, so the seam stays closed and both keep their attributes.
+		Vertices shared by more than two copies, or where a seam meets another boundary, are kept. Unused vertices are removed afterwards.
+		Large meshes are divided spatially and simplified in parallel on the default TaskPool, before a final pass across the divisions. */
+	void		simplify( size_t targetTriangles, float maxError = std::numeric_limits<float>::max() );
 	
  private:
+	//! Replaces every attribute with one element per vertex by the elements \a order lists, by their current index
+	void		remapVertices( const std::vector<uint32_t> &order );
+
 	std::vector<Vec3f>		mVertices;
 	std::vector<Vec3f>		mNormals;
+	std::vector<Vec3f>		mTangents;
+	std::vector<Vec3f>		mBitangents;
 	std::vector<Color>		mColorsRGB;
 	std::vector<ColorA>		mColorsRGBA;
 	std::vector<Vec2f>		mTexCoords;
 	std::vector<uint32_t>	mIndices;
 };
 
+typedef std::shared_ptr<class TriMeshView>	TriMeshViewRef;
+
+/** \brief Read-only view of a file written by TriMesh::write() in the version 2 format.
+ *
+ * The file is memory mapped rather than read, so opening it takes the same time regardless of the size of the mesh and
+ * processes viewing the same file share its pages. The attribute pointers remain valid for the lifetime of the view.
+ * Compressed indices are the exception to zero-copy, and are decoded into memory owned by the view.
+ *
+ * \code
+ * mesh.write( writeFile( cachePath ), TriMesh::WriteOptions().version( 2 ) );
+ * ...
+ * TriMeshViewRef view = TriMeshView::create( cachePath );
+ * glVertexPointer( 3, GL_FLOAT, 0, view->getVertices() );
+ * glDrawElements( GL_TRIANGLES, view->getNumIndices(), GL_UNSIGNED_INT, view->getIndices() );
+ * \endcode
+**/
+class TriMeshView {
+ public:
+	//! Maps the file at \a path. Verifying the checksum touches every page of the file, so it is off by default. Throws TriMeshExcInvalidFile.
+	static TriMeshViewRef	create( const fs::path &path, bool verifyChecksum = false );
+	//! Maps \a dataSource when it is a file, and otherwise loads it into memory owned by the view. Throws TriMeshExcInvalidFile.
+	static TriMeshViewRef	create( DataSourceRef dataSource, bool verifyChecksum = false );
+
+	bool		hasNormals() const { return mNumNormals != 0; }
+	bool		hasColorsRGB() const { return mNumColorsRGB != 0; }
+	bool		hasColorsRGBA() const { return mNumColorsRGBA != 0; }
+	bool		hasTexCoords() const { return mNumTexCoords != 0; }
+
+	size_t		getNumVertices() const { return mNumVertices; }
+	size_t		getNumNormals() const { return mNumNormals; }
+	size_t		getNumColorsRGB() const { return mNumColorsRGB; }
+	size_t		getNumColorsRGBA() const { return mNumColorsRGBA; }
+	size_t		getNumTexCoords() const { return mNumTexCoords; }
+	size_t		getNumIndices() const { return mNumIndices; }
+	size_t		getNumTriangles() const { return mNumIndices / 3; }
+
+	const Vec3f*	getVertices() const { return mVertices; }
+	const Vec3f*	getNormals() const { return mNormals; }
+	const Color*	getColorsRGB() const { return mColorsRGB; }
+	const ColorA*	getColorsRGBA() const { return mColorsRGBA; }
+	const Vec2f*	getTexCoords() const { return mTexCoords; }
+	const uint32_t*	getIndices() const { return mIndices; }
+
+	//! Calculates the bounding box of all vertices
+	AxisAlignedBox3f	calcBoundingBox() const;
+	//! Replaces the contents of \a mesh with a copy of the view's attributes
+	void				copyTo( TriMesh *mesh ) const;
+
+ protected:
+	TriMeshView();
+	void	parse( const uint8_t *data, size_t size, bool verifyChecksum );
+
+	MappedFileRef			mMappedFile;
+	Buffer					mBuffer;
+	std::vector<uint32_t>	mDecodedIndices;
+
+	const Vec3f				*mVertices, *mNormals;
+	const Color				*mColorsRGB;
+	const ColorA			*mColorsRGBA;
+	const Vec2f				*mTexCoords;
+	const uint32_t			*mIndices;
+	size_t					mNumVertices, mNumNormals, mNumColorsRGB, mNumColorsRGBA, mNumTexCoords, mNumIndices;
+};
+
+class TriMeshExc : public Exception {
+};
+
+class TriMeshExcInvalidFile : public TriMeshExc {
+};
+
 class TriMesh2d {
  public:
 	void		clear();
@@ -0,0 +1,123 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/TriMesh.h"
+#include "cinder/AxisAlignedBox.h"
+#include "cinder/Frustum.h"
+#include "cinder/Ray.h"
+#include "cinder/Sphere.h"
+
+#include <limits>
+#include <vector>
+
+namespace cinder {
+
+/** \brief A bounding volume hierarchy over the triangles of a TriMesh, for ray casts, picking and overlap queries.
+ *
+ * The hierarchy is built with the surface area heuristic, in parallel on the default TaskPool, and stored as a flat array
+ * of nodes alongside a copy of the triangles in the order its leaves reference them. Queries visit only the branches which
+ * the query reaches, so a ray cast costs roughly the logarithm of the number of triangles rather than a test against each.
+ * The hierarchy is a snapshot: rebuild it after modifying the mesh.
+ * \code
+ * TriMeshBvh bvh( mesh );
+ * TriMeshBvh::Hit hit;
+ * if( bvh.raycast( mCam.generateRay( u, v, mCam.getAspectRatio() ), &hit ) )
+ *	mPickedTriangle = hit.mTriangle;
+ * \endcode
+**/
+class TriMeshBvh {
+  public:
+	//! The nearest intersection of a ray with the mesh
+	struct Hit {
+		Hit() : mTriangle( NO_TRIANGLE ), mDistance( std::numeric_limits<float>::max() ), mU( 0 ), mV( 0 ) {}
+
+		//! Returns whether the ray hit a triangle
+		bool		isHit() const { return mTriangle != NO_TRIANGLE; }
+
+		//! Index of the triangle hit, as passed to TriMesh::getTriangleVertices(), or \c NO_TRIANGLE
+		uint32_t	mTriangle;
+		//! Distance to the hit along the ray, in units of the length of its direction
+		float		mDistance;
+		//! Barycentric coordinates of the hit, weighting the triangle's second and third vertices respectively
+		float		mU, mV;
+	};
+
+	enum { NO_TRIANGLE = 0xFFFFFFFF };
+
+	//! Builds a hierarchy over the triangles of \a mesh
+	explicit TriMeshBvh( const TriMesh &mesh );
+
+	//! Finds the nearest intersection of \a ray with the mesh in front of its origin and closer than \a maxDistance. Returns whether there was one, stored in \a result.
+	bool	raycast( const Ray &ray, Hit *result, float maxDistance = std::numeric_limits<float>::max() ) const;
+	//! Returns whether \a ray hits any triangle in front of its origin and closer than \a maxDistance. Faster than raycast() for occlusion and shadow tests, since it stops at the first hit.
+	bool	raycastAny( const Ray &ray, float maxDistance = std::numeric_limits<float>::max() ) const;
+	/*! Finds the nearest intersection of each of \a rays, as raycast() does, into the corresponding element of \a results. Returns the number of rays which hit.
+		Rays are traced in packets of consecutive rays which share a traversal of the hierarchy, and the packets are spread across the default TaskPool.
+		Packets work best when neighboring rays are coherent, like those from Camera::generateRay() for a small tile of pixels. */
+	size_t	raycast( const std::vector<Ray> &rays, std::vector<Hit> *results, float maxDistance = std::numeric_limits<float>::max() ) const;
+
+	//! Returns the indices of the triangles which intersect \a box, in ascending order
+	std::vector<uint32_t>	findTriangles( const AxisAlignedBox3f &box ) const;
+	//! Returns the indices of the triangles which intersect \a sphere, in ascending order
+	std::vector<uint32_t>	findTriangles( const Sphere &sphere ) const;
+	//! Returns the indices of the triangles whose bounding boxes intersect \a frustum, in ascending order. May include triangles just outside its corners.
+	std::vector<uint32_t>	findTriangles( const Frustumf &frustum ) const;
+
+	//! Returns the number of triangles in the hierarchy
+	size_t				getNumTriangles() const { return mTriangles.size(); }
+	//! Returns the number of nodes in the hierarchy
+	size_t				getNumNodes() const { return mBvhNodes.size(); }
+	//! Returns the bounding box of the mesh
+	AxisAlignedBox3f	getBoundingBox() const;
+
+  private:
+	//! A triangle as its first vertex and the edges to the other two, which is what ray intersection needs
+	struct Triangle {
+		Vec3f		mVert0, mEdge1, mEdge2;
+	};
+
+	//! A node of the hierarchy. Leaves reference \a mCount Triangles starting at \a mFirst; interior nodes have \a mCount of 0, with children at the next index and at \a mFirst.
+	struct BvhNode {
+		Vec3f		mMin;
+		uint32_t	mFirst;
+		Vec3f		mMax;
+		uint32_t	mCount;
+	};
+
+	struct Builder;
+	struct RaycastPacketsFn;
+
+	void	raycastPacket( const Ray *rays, size_t numRays, float maxDistance, Hit *results ) const;
+	template<typename Overlaps>
+	void	collectTriangles( const Overlaps &overlaps, std::vector<uint32_t> *result ) const;
+
+	std::vector<BvhNode>	mBvhNodes;
+	std::vector<Triangle>	mTriangles;
+	//! The index in the mesh of each of \a mTriangles
+	std::vector<uint32_t>	mTriangleIndices;
+};
+
+} // namespace cinder
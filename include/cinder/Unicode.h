@@ -12,6 +12,18 @@ uint32_t	nextCharUtf8( const char *str, size_t *inOutByte, size_t lengthInBytes
 //! Returns the index in bytes of the next character in \a str, advanced by \a numChars characters. Optimize operation by supplying a non-default \a lengthInBytes of \a str.
 size_t		advanceCharUtf8( const char *str, size_t numChars, size_t lengthInBytes = 0 );
 
+//! Returns whether \a str is well-formed UTF-8, rejecting overlong forms, surrogates and code points beyond U+10FFFF. Optimize operation by supplying a non-default \a lengthInBytes of \a str.
+bool		isValidUtf8( const char *str, size_t lengthInBytes = 0 );
+
+//! Converts \a lengthInBytes bytes of the UTF-8 string \a src into UTF-16 in \a dest, which must have room for \a lengthInBytes code units. Malformed sequences are replaced by U+FFFD. Returns the number of code units written.
+size_t		convertUtf8ToUtf16( const char *src, size_t lengthInBytes, uint16_t *dest );
+//! Converts \a lengthInBytes bytes of the UTF-8 string \a src into UTF-32 in \a dest, which must have room for \a lengthInBytes code points. Malformed sequences are replaced by U+FFFD. Returns the number of code points written.
+size_t		convertUtf8ToUtf32( const char *src, size_t lengthInBytes, uint32_t *dest );
+//! Converts \a length code units of the UTF-16 string \a src into UTF-8 in \a dest, which must have room for 3 * \a length bytes. Unpaired surrogates are replaced by U+FFFD. Returns the number of bytes written.
+size_t		convertUtf16ToUtf8( const uint16_t *src, size_t length, char *dest );
+//! Converts \a length code points of the UTF-32 string \a src into UTF-8 in \a dest, which must have room for 4 * \a length bytes. Invalid code points are replaced by U+FFFD. Returns the number of bytes written.
+size_t		convertUtf32ToUtf8( const uint32_t *src, size_t length, char *dest );
+
 void		lineBreakUtf8( const char *str, const std::function<bool(const char *, size_t)> &measureFn, std::function<void(const char *,size_t)> lineProcessFn );
 
 //! Values returned by calcBreaksUtf8 and calcBreaksUtf16
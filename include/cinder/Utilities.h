@@ -81,6 +81,28 @@ inline char getPathSeparator() { return '\\'; }
 inline char getPathSeparator() { return '/'; }
 #endif
 
+//! Parses a decimal integer from the start of [\a begin, \a end) into \a result without allocating. Accepts an optional sign; leading whitespace is not skipped. Returns a pointer past the last character consumed, or \a begin if no number could be parsed or it is out of range.
+const char*	parseNumber( const char *begin, const char *end, int32_t *result );
+//! Parses a decimal integer from the start of [\a begin, \a end) into \a result without allocating. Returns a pointer past the last character consumed, or \a begin if no number could be parsed or it is out of range.
+const char*	parseNumber( const char *begin, const char *end, uint32_t *result );
+//! Parses a decimal integer from the start of [\a begin, \a end) into \a result without allocating. Returns a pointer past the last character consumed, or \a begin if no number could be parsed or it is out of range.
+const char*	parseNumber( const char *begin, const char *end, int64_t *result );
+//! Parses a decimal integer from the start of [\a begin, \a end) into \a result without allocating. Returns a pointer past the last character consumed, or \a begin if no number could be parsed or it is out of range.
+const char*	parseNumber( const char *begin, const char *end, uint64_t *result );
+//! Parses a decimal floating-point number, including an optional fraction, exponent, \c "inf" or \c "nan", from the start of [\a begin, \a end) into \a result without allocating. Returns a pointer past the last character consumed, or \a begin if no number could be parsed.
+const char*	parseNumber( const char *begin, const char *end, float *result );
+//! Parses a decimal floating-point number, including an optional fraction, exponent, \c "inf" or \c "nan", from the start of [\a begin, \a end) into \a result without allocating. Returns a pointer past the last character consumed, or \a begin if no number could be parsed.
+const char*	parseNumber( const char *begin, const char *end, double *result );
+
+//! Writes \a value in decimal to \a buffer, which must hold at least 32 characters. Returns the number of characters written, excluding a null terminator.
+size_t		formatNumber( int64_t value, char *buffer );
+//! Writes \a value in decimal to \a buffer, which must hold at least 32 characters. Returns the number of characters written, excluding a null terminator.
+size_t		formatNumber( uint64_t value, char *buffer );
+//! Writes the shortest decimal representation that parses back to exactly \a value to \a buffer, which must hold at least 32 characters. Returns the number of characters written, excluding a null terminator.
+size_t		formatNumber( float value, char *buffer );
+//! Writes the shortest decimal representation that parses back to exactly \a value to \a buffer, which must hold at least 32 characters. Returns the number of characters written, excluding a null terminator.
+size_t		formatNumber( double value, char *buffer );
+
 template<typename T>
 inline std::string toString( const T &t ) { return boost::lexical_cast<std::string>( t ); }
 template<typename T>
@@ -88,6 +110,52 @@ inline T fromString( const std::string &s ) { return boost::lexical_cast<T>( s )
 // This specialization seems to only be necessary with more recent versions of Boost
 template<>
 inline Url fromString( const std::string &s ) { return Url( s ); }
+//! Parses \a s as a T into \a result, returning \c false rather than throwing if \a s is not a valid T. \a result is unchanged on failure.
+template<typename T>
+inline bool tryFromString( const std::string &s, T *result )
+{
+	try {
+		*result = fromString<T>( s );
+		return true;
+	}
+	catch( boost::bad_lexical_cast & ) {
+		return false;
+	}
+}
+
+// Arithmetic types bypass lexical_cast in favor of parseNumber() and formatNumber(); floating-point values are formatted as the shortest string which round-trips
+template<> std::string toString( const short &t );
+template<> std::string toString( const unsigned short &t );
+template<> std::string toString( const int &t );
+template<> std::string toString( const unsigned int &t );
+template<> std::string toString( const long &t );
+template<> std::string toString( const unsigned long &t );
+template<> std::string toString( const long long &t );
+template<> std::string toString( const unsigned long long &t );
+template<> std::string toString( const float &t );
+template<> std::string toString( const double &t );
+
+template<> short fromString( const std::string &s );
+template<> unsigned short fromString( const std::string &s );
+template<> int fromString( const std::string &s );
+template<> unsigned int fromString( const std::string &s );
+template<> long fromString( const std::string &s );
+template<> unsigned long fromString( const std::string &s );
+template<> long long fromString( const std::string &s );
+template<> unsigned long long fromString( const std::string &s );
+template<> float fromString( const std::string &s );
+template<> double fromString( const std::string &s );
+
+template<> bool tryFromString( const std::string &s, short *result );
+template<> bool tryFromString( const std::string &s, unsigned short *result );
+template<> bool tryFromString( const std::string &s, int *result );
+template<> bool tryFromString( const std::string &s, unsigned int *result );
+template<> bool tryFromString( const std::string &s, long *result );
+template<> bool tryFromString( const std::string &s, unsigned long *result );
+template<> bool tryFromString( const std::string &s, long long *result );
+template<> bool tryFromString( const std::string &s, unsigned long long *result );
+template<> bool tryFromString( const std::string &s, float *result );
+template<> bool tryFromString( const std::string &s, double *result );
 
 //! Returns a stack trace (aka backtrace) where \c stackTrace()[0] == caller, \c stackTrace()[1] == caller's parent, etc
 std::vector<std::string> stackTrace();
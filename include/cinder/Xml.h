@@ -50,6 +50,42 @@ class XmlTree {
 	typedef std::list<std::unique_ptr<XmlTree> > Container;
 	//! \endcond
 
+	/** \brief A child path compiled once for repeated lookups
+		The path is split and its tags case-folded when the Query is constructed, so lookups do no string processing. Lookups through a Query
+		on a node with many children build a hashed index of the node's children on first use, which later lookups probe instead of scanning.
+		The index is rebuilt after the children change. Building it modifies the node, so the first Query lookup on a node must not race with another.
+		<br><tt>XmlTree::Query trackQuery( "album/track" );</tt> **/
+	class Query {
+	  public:
+		//! Creates an empty Query, which matches the node it is applied to
+		Query() : mCaseSensitive( false ) {}
+		//! Compiles \a path, whose components are separated by \a separator. Empty components are ignored, so "/one/two" is equivalent to "one/two".
+		explicit Query( const std::string &path, bool caseSensitive = false, char separator = '/' );
+
+		//! Returns the path the Query was compiled from
+		const std::string&	getPath() const { return mPath; }
+		bool				isCaseSensitive() const { return mCaseSensitive; }
+		//! Returns the number of non-empty components of the path
+		size_t				size() const { return mComponents ? mComponents->size() : 0; }
+
+		//! \cond
+		struct Component {
+			bool	matches( const std::string &tag, bool caseSensitive ) const;
+
+			std::string		mTag, mLowerTag;
+		};
+		//! \endcond
+
+	  private:
+		//! \cond
+		std::string										mPath;
+		bool											mCaseSensitive;
+		std::shared_ptr<const std::vector<Component> >	mComponents;
+		//! \endcond
+
+		friend class XmlTree;
+	};
+
 	//! A const iterator over the children of an XmlTree.
 	class ConstIter {
 	  public:
@@ -57,6 +93,7 @@ class XmlTree {
 		ConstIter( const Container *sequence );
 		ConstIter( const Container *sequence, Container::const_iterator iter );
 		ConstIter( const XmlTree &root, const std::string &filterPath, bool caseSensitive = false, char separator = '/' );
+		ConstIter( const XmlTree &root, const Query &filter );
 		//! \endcond
 
 		//! Returns a reference to the XmlTree the iterator currently points to.
@@ -82,14 +119,14 @@ class XmlTree {
 		
 	  protected:
 		//! \cond
+		void	init( const XmlTree &root );
 		void	increment();
 		void	setToEnd( const Container *seq );
 		bool	isDone() const;
 		
 		std::vector<const Container*>				mSequenceStack;
 		std::vector<Container::const_iterator>		mIterStack;
-		std::vector<std::string>					mFilter;
-		bool										mCaseSensitive;
+		Query										mFilter;
 		//! \endcond		
 	};
 
@@ -108,6 +145,10 @@ class XmlTree {
 		Iter( XmlTree &root, const std::string &filterPath, bool caseSensitive, char separator )
 			: ConstIter( root, filterPath, caseSensitive, separator )
 		{}
+
+		Iter( XmlTree &root, const Query &filter )
+			: ConstIter( root, filter )
+		{}
 		//! \endcond
 
 		
@@ -173,7 +214,7 @@ class XmlTree {
 		void					setValue( const std::string &value ) { mValue = value; }
 		/** Sets the value of the attribute to \a value, which is cast to a string first. Requires T to support the ostream<< operator. **/
 		template<typename T>
-		void					setValue( const T &value ) { mValue = boost::lexical_cast<std::string>( value ); }
+		void					setValue( const T &value ) { mValue = toString( value ); }
 
 	  private:
 	  	XmlTree			*mXml;
@@ -214,7 +255,7 @@ class XmlTree {
 	typedef enum { NODE_UNKNOWN, NODE_DOCUMENT, NODE_ELEMENT, NODE_CDATA, NODE_COMMENT, NODE_DATA } NodeType;
 
 	//! Default constructor, creating an empty node.
-	XmlTree() : mParent( 0 ), mNodeType( NODE_ELEMENT ) {}
+	XmlTree() : mNodeType( NODE_ELEMENT ), mParent( 0 ), mChildrenExposed( false ) {}
 
 	//! Copy constuctor
 	XmlTree( const XmlTree &rhs );
@@ -222,7 +263,9 @@ class XmlTree {
 	
 	/** \brief Parses XML contained in \a dataSource using the options \a parseOptions. Commonly used with the results of loadUrl(), loadFile() or loadResource().
 		<br><tt>XmlTree myDoc( loadUrl( "http://rss.cnn.com/rss/cnn_topstories.rss" ) );</tt> **/
-	explicit XmlTree( DataSourceRef dataSource, ParseOptions parseOptions = ParseOptions() ) {
+	explicit XmlTree( DataSourceRef dataSource, ParseOptions parseOptions = ParseOptions() )
+		: mParent( 0 ), mChildrenExposed( false )
+	{
 		loadFromDataSource( dataSource, this, parseOptions );
 	}
 
@@ -231,7 +274,7 @@ class XmlTree {
 
 	//! Constructs an XML node with the tag \a tag, the value \a value. Optionally sets the pointer to the node's parent and sets the node type.
 	explicit XmlTree( const std::string &tag, const std::string &value, XmlTree *parent = 0, NodeType type = NODE_ELEMENT )
-		: mTag( tag ), mValue( value ), mParent( parent ), mNodeType( type )
+		: mNodeType( type ), mTag( tag ), mValue( value ), mParent( parent ), mChildrenExposed( false )
 	{}
 
 	//! Returns an XML document node
@@ -253,22 +296,22 @@ class XmlTree {
 	//! Returns the tag or name of the node as a string.
 	const std::string&			getTag() const { return mTag; }
 	//! Sets the tag or name of the node to the string \a tag.
-	void						setTag( const std::string &tag ) { mTag = tag; }
+	void						setTag( const std::string &tag ) { mTag = tag; if( mParent ) mParent->mChildIndex.reset(); }
 	
 	//! Returns the value of the node as a string.
 	std::string					getValue() const { return mValue; }
 	//! Returns the value of the node parsed as a T. Requires T to support the istream>> operator.
 	template<typename T>
-	T							getValue() const { return boost::lexical_cast<T>( mValue ); }
+	T							getValue() const { return fromString<T>( mValue ); }
 	//! Returns the value of the node parsed as a T. If the value is empty or fails to parse \a defaultValue is returned. Requires T to support the istream>> operator.
 	template<typename T>
-	T							getValue( const T &defaultValue ) const { try { return boost::lexical_cast<T>( mValue ); } catch( ... ) { return defaultValue; } }
+	T							getValue( const T &defaultValue ) const { T result = defaultValue; tryFromString( mValue, &result ); return result; }
 
 	//! Sets the value of the node to the string \a value.
 	void						setValue( const std::string &value ) { mValue = value; }
 	//! Sets the value of the node to \a value which is converted to a string first. Requires T to support the ostream<< operator.
 	template<typename T>
-	void						setValue( const T &value ) { mValue = boost::lexical_cast<std::string>( value ); }
+	void						setValue( const T &value ) { mValue = toString( value ); }
 
 	//! Returns whether this node has a parent node.
 	bool						hasParent() const { return mParent != NULL; }
@@ -281,6 +324,10 @@ class XmlTree {
 	Iter						find( const std::string &relativePath, bool caseSensitive = false, char separator = '/' ) { return Iter( *this, relativePath, caseSensitive, separator ); }
 	//! Returns the first child that matches \a relativePath or end() if none matches
 	ConstIter					find( const std::string &relativePath, bool caseSensitive = false, char separator = '/' ) const { return ConstIter( *this, relativePath, caseSensitive, separator ); }
+	//! Returns the first child that matches \a query or end() if none matches
+	Iter						find( const Query &query ) { return Iter( *this, query ); }
+	//! Returns the first child that matches \a query or end() if none matches
+	ConstIter					find( const Query &query ) const { return ConstIter( *this, query ); }
 	//! Returns whether at least one child matches \a relativePath
 	bool						hasChild( const std::string &relativePath, bool caseSensitive = false, char separator = '/' ) const;
 
@@ -288,8 +335,14 @@ class XmlTree {
 	XmlTree&					getChild( const std::string &relativePath, bool caseSensitive = false, char separator = '/' );
 	//! Returns the first child that matches \a relativePath. Throws ExcChildNotFound if none matches.
 	const XmlTree&				getChild( const std::string &relativePath, bool caseSensitive = false, char separator = '/' ) const;
-	//! Returns a reference to the node's list of children nodes.
-	Container&			getChildren() { return mChildren; }
+	//! Returns whether at least one child matches \a query
+	bool						hasChild( const Query &query ) const { return getNodePtr( query ) != 0; }
+	//! Returns the first child that matches \a query. Throws ExcChildNotFound if none matches.
+	XmlTree&					getChild( const Query &query );
+	//! Returns the first child that matches \a query. Throws ExcChildNotFound if none matches.
+	const XmlTree&				getChild( const Query &query ) const;
+	//! Returns a reference to the node's list of children nodes. Since the list may then be modified at any time, Query lookups on this node no longer use a child index.
+	Container&			getChildren() { mChildrenExposed = true; mChildIndex.reset(); return mChildren; }
 	//! Returns a reference to the node's list of children nodes.
 	const Container&	getChildren() const { return mChildren; }
 
@@ -334,7 +387,7 @@ class XmlTree {
 	XmlTree&					setAttribute( const std::string &attrName, const std::string &value );
 	/** Sets the value of the attribute \a attrName to \a value, which is cast to a string first. Requires T to support the ostream<< operator. If the attribute does not exist it is appended. **/
 	template<typename T>
-	XmlTree&					setAttribute( const std::string &attrName, const T &value ) { return setAttribute( attrName, boost::lexical_cast<std::string>( value ) ); }
+	XmlTree&					setAttribute( const std::string &attrName, const T &value ) { return setAttribute( attrName, toString( value ) ); }
 	/** Returns whether the node has an attribute named \a attrName. **/
 	bool						hasAttribute( const std::string &attrName ) const;
 	/** Returns a path to this node, separated by the character \a separator. **/	
@@ -348,6 +401,10 @@ class XmlTree {
 	ConstIter					begin() const { return ConstIter( &mChildren ); }
 	/** Returns an Iter to the children node of this node which match the path \a filterPath. **/	
 	ConstIter					begin( const std::string &filterPath, bool caseSensitive = false, char separator = '/' ) const { return ConstIter( *this, filterPath, caseSensitive, separator ); }	
+	/** Returns an Iter to the children node of this node which match \a query. **/	
+	Iter						begin( const Query &query ) { return Iter( *this, query ); }
+	/** Returns an Iter to the children node of this node which match \a query. **/	
+	ConstIter					begin( const Query &query ) const { return ConstIter( *this, query ); }
 	/** Returns an Iter which marks the end of the children of this node. **/	
 	Iter						end() { return Iter( &mChildren, mChildren.end() ); }
 	/** Returns an Iter which marks the end of the children of this node. **/	
@@ -400,9 +457,12 @@ class XmlTree {
 
   private:
 	XmlTree*	getNodePtr( const std::string &relativePath, bool caseSensitive, char separator ) const;
+	XmlTree*	getNodePtr( const Query &query ) const;
+	XmlTree*	findChildNamed( const Query::Component &component, bool caseSensitive ) const;
 	void		appendRapidXmlNode( rapidxml::xml_document<char> &doc, rapidxml::xml_node<char> *parent ) const;
 
 	static Container::const_iterator	findNextChildNamed( const Container &sequence, Container::const_iterator firstCandidate, const std::string &searchTag, bool caseSensitive );
+	static Container::const_iterator	findNextChildNamed( const Container &sequence, Container::const_iterator firstCandidate, const Query::Component &component, bool caseSensitive );
 
 	NodeType					mNodeType;
   	std::string					mTag;
@@ -411,6 +471,14 @@ class XmlTree {
 	XmlTree						*mParent;
 	Container					mChildren;
 	std::list<Attr>				mAttributes;
+
+	//! hashed index of mChildren by case-folded tag, built by the first Query lookup on a node with many children
+	struct ChildIndex;
+	mutable std::shared_ptr<ChildIndex>	mChildIndex;
+	//! set once a mutable reference to mChildren has been handed out, after which an index could outlive the children it points to
+	bool						mChildrenExposed;
+
+	friend void		parseItem( const rapidxml::xml_node<char> &node, XmlTree *parent, XmlTree *result, const ParseOptions &options );
 	
 	static void		loadFromDataSource( DataSourceRef dataSource, XmlTree *result, const ParseOptions &parseOptions );
 };
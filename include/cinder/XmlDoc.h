@@ -0,0 +1,276 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/DataSource.h"
+#include "cinder/Exception.h"
+#include "cinder/Stream.h"
+#include "cinder/Xml.h"
+
+#include <boost/noncopyable.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//! \cond
+namespace rapidxml {
+	template<class Ch> class xml_document;
+	template<class Ch> class xml_node;
+	template<class Ch> class xml_attribute;
+};
+//! \endcond
+
+namespace cinder {
+
+typedef std::shared_ptr<class XmlDoc>	XmlDocRef;
+
+/** \brief Read-only XML document parsed in place
+ *
+ * A lighter-weight alternative to XmlTree for large documents. The source is parsed in situ by RapidXML and the resulting node graph is kept alive,
+ * so tags, values and attributes are exposed as StringRef views into the source rather than copied into strings. A document loaded from a file
+ * is memory mapped copy-on-write, so beyond the mapping the only allocation is RapidXML's node arena.
+ * Nodes and attributes are only valid for the lifetime of the XmlDoc which produced them.
+ * \n Example usage:
+ * \code
+ * XmlDocRef doc = XmlDoc::create( loadFile( "scene.dae" ) );
+ * for( XmlDoc::Node geom = doc->getRoot().getChild( "COLLADA/library_geometries" ).firstChild( "geometry" ); geom; geom = geom.nextSibling( "geometry" ) )
+ *     console() << geom.getAttribute( "id" ).getValue().str() << std::endl;
+ * \endcode
+**/
+class XmlDoc : private boost::noncopyable {
+  public:
+	//! A non-owning view of a string inside an XmlDoc. Not null-terminated.
+	class StringRef {
+	  public:
+		StringRef() : mData( "" ), mSize( 0 ) {}
+		StringRef( const char *data, size_t size ) : mData( data ), mSize( size ) {}
+
+		const char*		data() const { return mData; }
+		size_t			size() const { return mSize; }
+		bool			empty() const { return mSize == 0; }
+		//! Returns a copy of the view as a std::string
+		std::string		str() const { return std::string( mData, mSize ); }
+
+		bool			operator==( const StringRef &rhs ) const { return mSize == rhs.mSize && memcmp( mData, rhs.mData, mSize ) == 0; }
+		bool			operator==( const char *rhs ) const { return *this == StringRef( rhs, strlen( rhs ) ); }
+		bool			operator==( const std::string &rhs ) const { return *this == StringRef( rhs.c_str(), rhs.size() ); }
+		bool			operator!=( const StringRef &rhs ) const { return ! ( *this == rhs ); }
+		bool			operator!=( const char *rhs ) const { return ! ( *this == rhs ); }
+		bool			operator!=( const std::string &rhs ) const { return ! ( *this == rhs ); }
+		//! Returns whether the view equals \a rhs ignoring ASCII case
+		bool			equalsIgnoreCase( const StringRef &rhs ) const;
+
+		//! Returns the contents parsed as a T. Numeric types are parsed without allocating. Throws boost::bad_lexical_cast on failure.
+		template<typename T>
+		T				as() const { return fromString<T>( str() ); }
+
+	  private:
+		const char		*mData;
+		size_t			mSize;
+	};
+
+	//! A handle to an attribute of an XmlDoc node
+	class Attr {
+	  public:
+		//! Creates an invalid Attr, as returned by Node::getAttribute() when no attribute matches
+		Attr() : mAttr( 0 ) {}
+
+		//! Returns whether the Attr refers to an attribute
+		bool			isValid() const { return mAttr != 0; }
+		operator bool() const { return isValid(); }
+
+		StringRef		getName() const;
+		StringRef		getValue() const;
+		//! Returns the value of the attribute parsed as a T. Throws boost::bad_lexical_cast on failure.
+		template<typename T>
+		T				getValue() const { return getValue().as<T>(); }
+		//! Returns the next attribute of the same node, or an invalid Attr after the last
+		Attr			next() const;
+
+	  private:
+		explicit Attr( const rapidxml::xml_attribute<char> *attr ) : mAttr( attr ) {}
+
+		const rapidxml::xml_attribute<char>		*mAttr;
+
+		friend class XmlDoc;
+	};
+
+	//! A handle to a node of an XmlDoc
+	class Node {
+	  public:
+		//! Creates an invalid Node, as returned by the traversal methods when no node matches
+		Node() : mNode( 0 ), mDoc( 0 ) {}
+
+		//! Returns whether the Node refers to a node
+		bool				isValid() const { return mNode != 0; }
+		operator bool() const { return isValid(); }
+
+		XmlTree::NodeType	getNodeType() const;
+		bool				isDocument() const { return getNodeType() == XmlTree::NODE_DOCUMENT; }
+		bool				isElement() const { return getNodeType() == XmlTree::NODE_ELEMENT; }
+		//! Returns the tag of an element node, or an empty string for any other type
+		StringRef			getTag() const;
+		//! Returns the text of the node. For an element this is its first text child.
+		StringRef			getValue() const;
+		//! Returns the value of the node parsed as a T. Throws boost::bad_lexical_cast on failure.
+		template<typename T>
+		T					getValue() const { return getValue().as<T>(); }
+		//! Returns the value of the node parsed as a T, or \a defaultValue if it fails to parse
+		template<typename T>
+		T					getValue( const T &defaultValue ) const { try { return getValue().as<T>(); } catch( ... ) { return defaultValue; } }
+
+		//! Returns the parent node, or an invalid Node for the document
+		Node				getParent() const;
+		/** Returns the first child. Data children are skipped if the document was created with XmlTree::ParseOptions::ignoreDataChildren().
+			If \a tag is non-empty only elements whose tag matches are considered. **/
+		Node				firstChild( const std::string &tag = "", bool caseSensitive = false ) const { return firstChild( tag.c_str(), tag.size(), caseSensitive ); }
+		Node				firstChild( const char *tag, size_t tagLength, bool caseSensitive = false ) const;
+		//! Returns the following sibling, using the same rules as firstChild()
+		Node				nextSibling( const std::string &tag = "", bool caseSensitive = false ) const { return nextSibling( tag.c_str(), tag.size(), caseSensitive ); }
+		Node				nextSibling( const char *tag, size_t tagLength, bool caseSensitive = false ) const;
+		//! Returns the first descendant matching \a relativePath, or an invalid Node if none matches. Path components are matched as by XmlTree::getChild().
+		Node				findChild( const std::string &relativePath, bool caseSensitive = false, char separator = '/' ) const;
+		//! Returns the first descendant matching \a relativePath. Throws ExcChildNotFound if none matches.
+		Node				getChild( const std::string &relativePath, bool caseSensitive = false, char separator = '/' ) const;
+		//! Returns whether at least one descendant matches \a relativePath
+		bool				hasChild( const std::string &relativePath, bool caseSensitive = false, char separator = '/' ) const { return findChild( relativePath, caseSensitive, separator ).isValid(); }
+		//! Returns the first child element whose tag matches \a childName. Throws ExcChildNotFound if none matches.
+		Node				operator/( const std::string &childName ) const { return getChild( childName ); }
+
+		//! Returns the first attribute, or an invalid Attr if the node has none
+		Attr				firstAttribute() const;
+		//! Returns the attribute named \a attrName, or an invalid Attr if there is none
+		Attr				getAttribute( const std::string &attrName ) const;
+		bool				hasAttribute( const std::string &attrName ) const { return getAttribute( attrName ).isValid(); }
+		//! Returns the value of the attribute \a attrName parsed as a T. Throws ExcAttrNotFound if no attribute exists with that name.
+		template<typename T>
+		T					getAttributeValue( const std::string &attrName ) const;
+		//! Returns the value of the attribute \a attrName parsed as a T. Returns \a defaultValue if no attribute exists with that name or it fails to parse.
+		template<typename T>
+		T					getAttributeValue( const std::string &attrName, const T &defaultValue ) const;
+
+		//! Returns a deep copy of the node and its descendants as an XmlTree
+		XmlTree				toXmlTree() const;
+
+	  private:
+		Node( const rapidxml::xml_node<char> *node, const XmlDoc *doc ) : mNode( node ), mDoc( doc ) {}
+		Node				skipIgnored( const rapidxml::xml_node<char> *node, const char *tag, size_t tagLength, bool caseSensitive ) const;
+
+		const rapidxml::xml_node<char>	*mNode;
+		const XmlDoc					*mDoc;
+
+		friend class XmlDoc;
+	};
+
+	//! Parses the XML in \a dataSource. A file is memory mapped and parsed in place; any other source is copied once.
+	static XmlDocRef	create( DataSourceRef dataSource, XmlTree::ParseOptions parseOptions = XmlTree::ParseOptions() );
+	//! Parses a copy of the XML in \a xmlString
+	static XmlDocRef	create( const std::string &xmlString, XmlTree::ParseOptions parseOptions = XmlTree::ParseOptions() );
+	~XmlDoc();
+
+	//! Returns the document node
+	Node				getRoot() const;
+	//! Returns the DOCTYPE of the document, or an empty string if it has none
+	StringRef			getDocType() const;
+	//! Returns whether the document was parsed in place in a memory mapped file
+	bool				isMemoryMapped() const { return mMappedFile != 0; }
+
+	//! Base class for XmlDoc exceptions.
+	class Exception : public cinder::Exception {
+	};
+
+	//! Exception expressing malformed XML.
+	class ExcParse : public XmlDoc::Exception {
+	  public:
+		ExcParse( const char *message, size_t offset ) throw();
+		virtual const char* what() const throw() { return mMessage; }
+
+	  private:
+		char mMessage[256];
+	};
+
+	//! Exception expressing the absence of an expected child node.
+	class ExcChildNotFound : public XmlDoc::Exception {
+	  public:
+		ExcChildNotFound( const std::string &childPath ) throw();
+		virtual const char* what() const throw() { return mMessage; }
+
+	  private:
+		char mMessage[2048];
+	};
+
+	//! Exception expressing the absence of an expected attribute.
+	class ExcAttrNotFound : public XmlDoc::Exception {
+	  public:
+		ExcAttrNotFound( const std::string &attrName ) throw();
+		virtual const char* what() const throw() { return mMessage; }
+
+	  private:
+		char mMessage[2048];
+	};
+
+  protected:
+	XmlDoc( const XmlTree::ParseOptions &parseOptions );
+
+	void		parse( char *text );
+
+	XmlTree::ParseOptions						mParseOptions;
+	MappedFileRef								mMappedFile;
+	std::vector<char>							mText;
+	std::unique_ptr<rapidxml::xml_document<char> >	mDocument;
+};
+
+//! \cond
+template<> float	XmlDoc::StringRef::as<float>() const;
+template<> double	XmlDoc::StringRef::as<double>() const;
+template<> int32_t	XmlDoc::StringRef::as<int32_t>() const;
+template<> uint32_t	XmlDoc::StringRef::as<uint32_t>() const;
+template<> int64_t	XmlDoc::StringRef::as<int64_t>() const;
+template<> uint64_t	XmlDoc::StringRef::as<uint64_t>() const;
+//! \endcond
+
+template<typename T>
+T XmlDoc::Node::getAttributeValue( const std::string &attrName ) const
+{
+	Attr attr = getAttribute( attrName );
+	if( ! attr )
+		throw ExcAttrNotFound( attrName );
+	return attr.getValue<T>();
+}
+
+template<typename T>
+T XmlDoc::Node::getAttributeValue( const std::string &attrName, const T &defaultValue ) const
+{
+	Attr attr = getAttribute( attrName );
+	if( ! attr )
+		return defaultValue;
+	try {
+		return attr.getValue<T>();
+	}
+	catch( ... ) {
+		return defaultValue;
+	}
+}
+
+} // namespace cinder
@@ -0,0 +1,149 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Stream.h"
+#include "cinder/Exception.h"
+#include "cinder/Utilities.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace cinder {
+
+/** \brief Streaming XML reader for documents too large to hold in memory
+ *
+ * Reads XML from an IStream through a fixed-size buffer as a sequence of events, without building an XmlTree or RapidXML DOM.
+ * Memory use is bounded by the buffer, the nesting depth and the longest single tag or run of text.
+ * A start element's attributes are available until the following call to next(). Comments, processing instructions, the DOCTYPE
+ * and runs of text consisting only of whitespace are skipped, as is a leading UTF-8 byte order mark. Entities in text and attribute values are decoded.
+ * \n Example usage:
+ * \code
+ * XmlReader reader( loadFileStream( "feed.xml" ) );
+ * while( reader.next() != XmlReader::EVENT_END_OF_DOCUMENT ) {
+ *     if( reader.getEvent() == XmlReader::EVENT_START_ELEMENT ) {
+ *         if( reader.getName() == "entry" ) console() << reader.getAttributeValue( "id" ) << std::endl;
+ *         else if( reader.getName() == "content" ) reader.skip(); // skips the subtree without decoding it
+ *     }
+ * }
+ * \endcode
+**/
+class XmlReader {
+  public:
+	typedef enum {
+		EVENT_NONE, EVENT_START_ELEMENT, EVENT_END_ELEMENT, EVENT_TEXT, EVENT_CDATA, EVENT_END_OF_DOCUMENT
+	} Event;
+
+	//! Creates a reader of \a stream which reads \a bufferSize bytes at a time
+	explicit XmlReader( IStreamRef stream, size_t bufferSize = 64 * 1024 );
+
+	//! Advances to and returns the next event. An empty element such as <tt>\<a/\></tt> produces both a start and an end event. Throws ExcParse on malformed input.
+	Event				next();
+	//! Returns the current event
+	Event				getEvent() const { return mEvent; }
+	/** Skips the contents of the current element without decoding them and advances to its EVENT_END_ELEMENT.
+		Has no effect unless the current event is EVENT_START_ELEMENT. Skipped elements are only checked for balanced tags. **/
+	void				skip();
+	//! Returns the number of elements enclosing the current position, counting an element whose start is the current event
+	size_t				getDepth() const { return mDepth; }
+	//! Returns the number of bytes consumed from the stream
+	uint64_t			getOffset() const { return mBufferOffset + ( mPos - mBufferBegin ); }
+
+	//! Returns the tag of the current EVENT_START_ELEMENT or EVENT_END_ELEMENT
+	const std::string&	getName() const { return mName; }
+	//! Returns the decoded contents of the current EVENT_TEXT or EVENT_CDATA
+	const std::string&	getText() const { return mText; }
+	//! Returns whether the current EVENT_START_ELEMENT was written as an empty element tag
+	bool				isEmptyElement() const { return mEmptyElement; }
+
+	//! Returns the number of attributes of the current EVENT_START_ELEMENT
+	size_t				getNumAttributes() const { return mNumAttributes; }
+	const std::string&	getAttributeName( size_t index ) const { return mAttributes[index].first; }
+	const std::string&	getAttributeValue( size_t index ) const { return mAttributes[index].second; }
+	//! Returns whether the current EVENT_START_ELEMENT has an attribute named \a name
+	bool				hasAttribute( const std::string &name ) const { return findAttribute( name ) != 0; }
+	//! Returns the value of the attribute \a name of the current EVENT_START_ELEMENT, or an empty string if it has none
+	const std::string&	getAttributeValue( const std::string &name ) const;
+	//! Returns the value of the attribute \a name parsed as a T, or \a defaultValue if there is no such attribute or it fails to parse
+	template<typename T>
+	T					getAttributeValue( const std::string &name, const T &defaultValue ) const
+	{
+		const std::string *value = findAttribute( name );
+		T result = defaultValue;
+		if( value )
+			tryFromString( *value, &result );
+		return result;
+	}
+
+	//! Base class for XmlReader exceptions.
+	class Exception : public cinder::Exception {
+	};
+
+	//! Exception expressing malformed XML.
+	class ExcParse : public XmlReader::Exception {
+	  public:
+		ExcParse( const char *message, uint64_t offset ) throw();
+		virtual const char* what() const throw() { return mMessage; }
+
+	  private:
+		char mMessage[256];
+	};
+
+  private:
+	bool		fill();
+	int			peek();
+	int			get();
+	void		expect( char c, const char *message );
+	void		error( const char *message ) const;
+
+	bool		skipWhitespace();
+	void		skipPast( const char *terminator, size_t length );
+	void		readName( std::string *result );
+	void		readText();
+	void		readAttributeValue( char quote, std::string *result );
+	void		readEntity( std::string *result );
+	void		readStartTag();
+	void		readEndTag();
+	bool		readMarkup();
+	void		pushElement();
+
+	const std::string*	findAttribute( const std::string &name ) const;
+
+	IStreamRef			mStream;
+	std::vector<char>	mBuffer;
+	const char			*mBufferBegin, *mPos, *mEnd;
+	uint64_t			mBufferOffset;
+
+	Event				mEvent;
+	std::string			mName, mText;
+	bool				mEmptyElement, mPendingEnd, mRootClosed;
+	// open element names; entries beyond mDepth keep their capacity for reuse
+	std::vector<std::string>	mStack;
+	size_t						mDepth;
+	std::vector<std::pair<std::string, std::string> >	mAttributes;
+	size_t												mNumAttributes;
+};
+
+} // namespace cinder
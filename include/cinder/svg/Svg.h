@@ -58,6 +58,7 @@ class Ellipse;
 class Polyline;
 class Polygon;
 class Image;
+class NodeIndex;
 class ExcChildNotFound;
 
 typedef std::function<bool(const Node&, svg::Style *)> RenderVisitor;
@@ -426,6 +427,7 @@ class Node {
 
 	friend class Group;
 	friend class Use;
+	friend class RenderList;
 };
 
 //! Base class for SVG Gradients. See SVG Gradients: http://www.w3.org/TR/SVG/pservers.html#Gradients
@@ -635,6 +637,8 @@ class Use : public Node {
 	virtual bool	isDrawable() const { return false; }
 	
 	virtual Shape2d	getShape() const{ if( mReferenced ) return mReferenced->getShape(); else return Shape2d(); }
+	//! Returns the Node this Use instantiates, or NULL if its reference couldn't be resolved
+	const Node*		getReferenced() const { return mReferenced; }
 
   protected:
 	virtual void	renderSelf( Renderer &renderer ) const;  
@@ -770,6 +774,8 @@ class Group : public Node, private boost::noncopyable {
 
 	virtual bool	isDrawable() const { return false; }
 	void 			parse( const XmlTree &xml );
+	//! Returns a new node for \a xml, which becomes a child of this Group, or NULL if the element isn't supported. Does not handle \c defs.
+	Node*			createChild( const XmlTree &xml );
 
 	std::list<Node*>		mChildren;
 	std::shared_ptr<Group>	mDefs;
@@ -804,17 +810,28 @@ class Doc : public Group {
 	
 	//! Returns the top-most Node which contains \a pt. Returns NULL if no Node contains the point.
 	Node*		nodeUnderPoint( const Vec2f &pt );
+	//! Returns every rendered Node which contains \a pt, top-most first. Uses the Doc's NodeIndex, so is much faster than nodeUnderPoint() on large documents.
+	std::vector<Node*>	findNodesAt( const Vec2f &pt ) const;
+	//! Returns every Node whose absolute bounding box intersects \a rect, in document order. Uses the Doc's NodeIndex.
+	std::vector<Node*>	findNodesIntersecting( const Rectf &rect ) const;
+	//! Returns the spatial index of the Doc's Nodes, building it if necessary. See svg::NodeIndex.
+	const NodeIndex&	getNodeIndex() const;
+	//! Discards the Doc's NodeIndex. Call after modifying the transforms or geometry of Nodes; the next query rebuilds it.
+	void				invalidateNodeIndex() { mNodeIndex.reset(); }
 	
 	//! Utility function to load an image relative to the document. Caches results.
 	std::shared_ptr<Surface8u>	loadImage( fs::path relativePath );
   private:
   	void 	loadDoc( DataSourceRef source, fs::path filePath );
+	void	parseTopLevel( const XmlTree &xml );
 
 	virtual void		renderSelf( Renderer &renderer ) const;
   
 	std::shared_ptr<XmlTree>	mXmlTree;
 	std::map<fs::path,std::shared_ptr<Surface8u> >	mImageCache;
 	
+	mutable std::shared_ptr<NodeIndex>	mNodeIndex;
+
 	fs::path		mFilePath;
 	Area			mViewBox;
 	int32_t			mWidth, mHeight;
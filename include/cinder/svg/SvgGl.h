@@ -28,6 +28,7 @@
 #include "cinder/gl/gl.h"
 #include "cinder/gl/Texture.h"
 #include "cinder/svg/Svg.h"
+#include "cinder/svg/SvgRenderList.h"
 #include "cinder/Triangulate.h"
 
 namespace cinder {
@@ -180,6 +181,46 @@ inline void draw( const svg::Doc &svg )
 	SvgRendererGl renderGl;
 	svg.render( renderGl );
 }
+
+//! Draws the fills and strokes of \a renderList's shapes using its cached geometry. Images and text are ignored, as with SvgRendererGl.
+inline void draw( const svg::RenderList &renderList )
+{
+	const std::vector<svg::RenderList::Item> &items = renderList.getItems();
+	const std::vector<svg::Paint> &paints = renderList.getPaints();
+	const std::vector<svg::RenderList::Contour> &contours = renderList.getContours();
+	glEnableClientState( GL_VERTEX_ARRAY );
+	for( std::vector<svg::RenderList::Item>::const_iterator itemIt = items.begin(); itemIt != items.end(); ++itemIt ) {
+		if( itemIt->mType != svg::RenderList::SHAPE )
+			continue;
+		const svg::Paint &fill = paints[itemIt->mFill];
+		const svg::Paint &stroke = paints[itemIt->mStroke];
+		bool drawFill = itemIt->mNumFillVertices && ( ! fill.isNone() );
+		bool drawStroke = itemIt->mNumContours && ( ! stroke.isNone() );
+		if( ! ( drawFill || drawStroke ) )
+			continue;
+
+		glPushMatrix();
+		glMultMatrixf( Matrix44f( itemIt->mTransform ) );
+		if( drawFill ) {
+			ColorA color( fill.getColor() ); color.a = itemIt->mFillOpacity;
+			gl::color( color );
+			glVertexPointer( 2, GL_FLOAT, 0, &renderList.getFillVertices()[itemIt->mFirstFillVertex] );
+			glDrawArrays( GL_TRIANGLES, 0, itemIt->mNumFillVertices );
+		}
+		if( drawStroke ) {
+			ColorA color( stroke.getColor() ); color.a = itemIt->mStrokeOpacity;
+			gl::color( color );
+			glLineWidth( itemIt->mStrokeWidth );
+			for( uint32_t c = itemIt->mFirstContour; c < itemIt->mFirstContour + itemIt->mNumContours; ++c ) {
+				glVertexPointer( 2, GL_FLOAT, 0, &renderList.getPoints()[contours[c].mFirstPoint] );
+				glDrawArrays( GL_LINE_STRIP, 0, contours[c].mNumPoints );
+			}
+			glLineWidth( 1.0f );
+		}
+		glPopMatrix();
+	}
+	glDisableClientState( GL_VERTEX_ARRAY );
+}
 } // namespace gl
 
 } // namespace cinder
\ No newline at end of file
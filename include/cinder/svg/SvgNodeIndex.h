@@ -0,0 +1,85 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/svg/Svg.h"
+
+#include <vector>
+
+namespace cinder { namespace svg {
+
+/** \brief A bounding volume hierarchy over the drawable Nodes beneath a Group, for hit testing and culling.
+ *
+ * Each drawable descendant is indexed by its bounding box in the root's absolute (document) space. Queries visit only
+ * the branches of the hierarchy which overlap the query, so the cost grows with the number of candidates rather than with
+ * the size of the tree. The index is a snapshot: rebuild it after modifying the transforms or geometry of indexed Nodes.
+ * Nodes beneath a \c use element are not indexed individually, consistent with Doc::nodeUnderPoint(). Unlike nodeUnderPoint(),
+ * Nodes which are not rendered because they are hidden or have display:none are never found.
+ * \code
+ * svg::NodeIndex index( *doc );
+ * vector<svg::Node*> hits = index.findNodesAt( mousePos );
+ * if( ! hits.empty() )
+ *	mSelected = hits.front();
+ * \endcode
+**/
+class NodeIndex {
+  public:
+	//! Builds an index over the rendered descendants of \a root, leaving out gradients, hidden Nodes and subtrees with display:none
+	NodeIndex( const Group &root );
+
+	//! Returns the Nodes whose shapes contain \a pt, which is in document space. Candidates are culled with the index and then tested with Node::containsPoint(). Sorted top-most first.
+	std::vector<Node*>	findNodesAt( const Vec2f &pt ) const;
+	//! Returns the Nodes whose absolute bounding boxes intersect \a rect, which is in document space. Sorted in document order.
+	std::vector<Node*>	findNodesIntersecting( const Rectf &rect ) const;
+
+	//! Returns the number of Nodes in the index
+	size_t		getNumNodes() const { return mEntries.size(); }
+	//! Returns the union of the absolute bounding boxes of the indexed Nodes
+	Rectf		getBounds() const { return mBvhNodes.empty() ? Rectf( 0, 0, 0, 0 ) : mBvhNodes[0].mBounds; }
+
+  private:
+	struct Entry {
+		Node			*mNode;
+		//! Position of the Node in document order
+		uint32_t		mOrder;
+		Rectf			mBounds;
+		//! Maps document space into the Node's local space
+		MatrixAffine2f	mInverseTransform;
+	};
+
+	//! A node of the hierarchy. Leaves reference \a mCount Entries starting at \a mFirst; interior nodes have \a mCount of 0, with children at the next index and at \a mFirst.
+	struct BvhNode {
+		Rectf		mBounds;
+		uint32_t	mFirst, mCount;
+	};
+
+	void		addNodes( const Group &group, const MatrixAffine2f &transform );
+	uint32_t	build( uint32_t begin, uint32_t end );
+
+	std::vector<Entry>		mEntries;
+	std::vector<BvhNode>	mBvhNodes;
+};
+
+} } // namespace cinder::svg
@@ -0,0 +1,124 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/svg/Svg.h"
+
+#include <vector>
+
+namespace cinder { namespace svg {
+
+/** \brief A flattened, cached form of a Node and its descendants for repeated rendering.
+ *
+ * Compiling walks the tree once, resolving every Node's inherited style and absolute transform and subdividing
+ * its geometry, so that drawing iterates a flat array rather than re-walking the tree each frame. The Items are
+ * in pre-order, one per visited Node, and the subtree of an Item is the contiguous run of Items which follows it.
+ * After modifying a Node, call invalidate() on it (or on its parent Group when adding or removing children) and
+ * update() before the next draw; only the invalidated subtrees are recompiled. Renderer visitors are not consulted.
+ * \code
+ * svg::RenderList renderList( *doc );
+ * ...
+ * node->setTransform( MatrixAffine2f::makeRotate( angle ) );
+ * renderList.invalidate( *node );
+ * renderList.update();
+ * gl::draw( renderList );
+ * \endcode
+**/
+class RenderList {
+  public:
+	typedef enum { GROUP, USE, SHAPE, OTHER, SKIPPED } ItemType;
+
+	//! A visited Node along with its resolved style and transform
+	struct Item {
+		const Node		*mNode;
+		ItemType		mType;
+		//! Number of Items in this Item's subtree, including itself
+		uint32_t		mSubtreeSize;
+		//! Absolute transformation of the Node
+		MatrixAffine2f	mTransform;
+		//! Indices into getPaints()
+		uint32_t		mFill, mStroke;
+		float			mFillOpacity, mStrokeOpacity, mStrokeWidth;
+		FillRule		mFillRule;
+		LineCap			mLineCap;
+		LineJoin		mLineJoin;
+		//! The opacity passed to Renderer::pushGroup(). GROUP only.
+		float			mGroupOpacity;
+		//! Range of getContours() holding the subdivided outline. SHAPE only.
+		uint32_t		mFirstContour, mNumContours;
+		//! Range of getFillVertices() holding the triangulated fill. SHAPE only, and empty when the fill is none.
+		uint32_t		mFirstFillVertex, mNumFillVertices;
+	};
+
+	//! A subdivided contour of a SHAPE Item; a line strip of getPoints() in the Node's local coordinates.
+	struct Contour {
+		uint32_t	mFirstPoint, mNumPoints;
+	};
+
+	RenderList();
+	//! Compiles \a root and its descendants. \a approximationScale represents how finely curves are subdivided, with 1.0 corresponding to 1:1 with the document's coordinates. Fills are only triangulated when \a tessellateFills is \c true.
+	RenderList( const Node &root, float approximationScale = 1.0f, bool tessellateFills = true );
+
+	//! Marks \a node and its descendants for recompilation by the next update(). Invalidate the parent Group when adding or removing children.
+	void		invalidate( const Node &node );
+	//! Returns whether any Node has been invalidated since the last update()
+	bool		isDirty() const { return ! mDirty.empty(); }
+	//! Recompiles the subtrees invalidated since the last update()
+	void		update();
+
+	//! Replays the list into \a renderer. Equivalent to calling render() on the root Node, but without walking the tree.
+	void		render( Renderer &renderer ) const;
+
+	//! Returns the Node the list was compiled from, or NULL for a default-constructed list
+	const Node*						getRoot() const { return mRoot; }
+	float							getApproximationScale() const { return mApproximationScale; }
+
+	const std::vector<Item>&		getItems() const { return mItems; }
+	const std::vector<Paint>&		getPaints() const { return mPaints; }
+	const std::vector<Contour>&		getContours() const { return mContours; }
+	const std::vector<Vec2f>&		getPoints() const { return mPoints; }
+	//! Returns the fill triangles of every SHAPE Item, three vertices per triangle in the Node's local coordinates
+	const std::vector<Vec2f>&		getFillVertices() const { return mFillVertices; }
+
+  private:
+	Item		makeRootItem() const;
+	void		compileNode( const Node &node, const Item &parent, bool checkVisibility, std::vector<const Node*> *activeUses, std::vector<Item> *result );
+	void		compileShape( const Node &node, Item *item );
+	void		compactGeometry();
+
+	const Node					*mRoot;
+	float						mApproximationScale;
+	bool						mTessellateFills;
+
+	std::vector<Item>			mItems;
+	std::vector<Paint>			mPaints;
+	std::vector<Contour>		mContours;
+	std::vector<Vec2f>			mPoints;
+	std::vector<Vec2f>			mFillVertices;
+
+	std::vector<const Node*>	mDirty;
+};
+
+} } // namespace cinder::svg
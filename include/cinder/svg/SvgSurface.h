@@ -0,0 +1,113 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/svg/Svg.h"
+#include "cinder/Rasterizer.h"
+#include "cinder/Surface.h"
+
+namespace cinder {
+
+/** \brief svg::Renderer which rasterizes into a premultiplied Surface8u on the CPU, without requiring OpenGL or Cairo
+ *
+ * Supports solid, linear and radial gradient paints, both fill rules, stroke widths, caps and joins, group opacity and
+ * images. Text is not drawn.
+ * \code
+ * Surface8u surface( doc->getWidth(), doc->getHeight(), true );
+ * ip::fill( &surface, ColorA( 0, 0, 0, 0 ) );
+ * SvgRendererSurface renderer( &surface );
+ * doc->render( renderer );
+ * \endcode
+**/
+class SvgRendererSurface : public svg::Renderer {
+  public:
+	//! Renders into \a surface, which is treated as premultiplied. \a approximationScale represents how finely curves are subdivided, with 1.0 corresponding to 1:1 with pixels.
+	SvgRendererSurface( Surface8u *surface, float approximationScale = 1.0f );
+
+	void	pushGroup( const svg::Group &group, float opacity );
+	void	popGroup();
+	void	drawPath( const svg::Path &path );
+	void	drawPolyline( const svg::Polyline &polyline );
+	void	drawPolygon( const svg::Polygon &polygon );
+	void	drawLine( const svg::Line &line );
+	void	drawRect( const svg::Rect &rect );
+	void	drawCircle( const svg::Circle &circle );
+	void	drawEllipse( const svg::Ellipse &ellipse );
+	void	drawImage( const svg::Image &image );
+
+	void	pushMatrix( const MatrixAffine2f &m ) { mMatrixStack.push_back( mMatrixStack.back() * m ); }
+	void	popMatrix() { mMatrixStack.pop_back(); }
+	void	pushFill( const svg::Paint &paint ) { mFillStack.push_back( paint ); }
+	void	popFill() { mFillStack.pop_back(); }
+	void	pushStroke( const svg::Paint &paint ) { mStrokeStack.push_back( paint ); }
+	void	popStroke() { mStrokeStack.pop_back(); }
+	void	pushFillOpacity( float opacity ) { mFillOpacityStack.push_back( opacity ); }
+	void	popFillOpacity() { mFillOpacityStack.pop_back(); }
+	void	pushStrokeOpacity( float opacity ) { mStrokeOpacityStack.push_back( opacity ); }
+	void	popStrokeOpacity() { mStrokeOpacityStack.pop_back(); }
+	void	pushStrokeWidth( float width ) { mStrokeWidthStack.push_back( width ); }
+	void	popStrokeWidth() { mStrokeWidthStack.pop_back(); }
+	void	pushFillRule( svg::FillRule rule ) { mFillRuleStack.push_back( rule ); }
+	void	popFillRule() { mFillRuleStack.pop_back(); }
+	void	pushLineCap( svg::LineCap lineCap ) { mLineCapStack.push_back( lineCap ); }
+	void	popLineCap() { mLineCapStack.pop_back(); }
+	void	pushLineJoin( svg::LineJoin lineJoin ) { mLineJoinStack.push_back( lineJoin ); }
+	void	popLineJoin() { mLineJoinStack.pop_back(); }
+
+  private:
+	// the offscreen target of a Group drawn with opacity; mSurface is null for opaque Groups, which draw straight through
+	struct Layer {
+		Surface8u	mSurface;
+		float		mOpacity;
+		Area		mBounds;
+	};
+
+	void		fillAndStroke( const svg::Node &node, const Shape2d &shape, bool fill );
+	void		fillRasterizer( const svg::Node &node, const svg::Paint &paint, float opacity, Triangulator::Winding winding );
+	Layer*		getTargetLayer();
+
+	Surface8u					*mSurface;
+	float						mApproximationScale;
+	Rasterizer					mRasterizer;
+	std::vector<uint32_t>		mGradientColors;
+
+	std::vector<MatrixAffine2f>	mMatrixStack;
+	std::vector<svg::Paint>		mFillStack, mStrokeStack;
+	std::vector<float>			mFillOpacityStack, mStrokeOpacityStack;
+	std::vector<float>			mStrokeWidthStack;
+	std::vector<svg::FillRule>	mFillRuleStack;
+	std::vector<svg::LineCap>	mLineCapStack;
+	std::vector<svg::LineJoin>	mLineJoinStack;
+	std::vector<Layer>			mLayers;
+};
+
+namespace svg {
+
+//! Renders \a doc into a new premultiplied Surface8u of \a size, scaling the document to fill it. The document's own size is used when \a size is zero.
+Surface8u	renderToSurface( const Doc &doc, const Vec2i &size = Vec2i::zero() );
+
+} // namespace svg
+
+} // namespace cinder
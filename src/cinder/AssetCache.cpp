@@ -0,0 +1,354 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/AssetCache.h"
+#include "cinder/ImageIo.h"
+#include "cinder/ObjLoader.h"
+#include "cinder/DataTarget.h"
+#include "cinder/Triangulate.h"
+#include "cinder/Utilities.h"
+#include "cinder/svg/Svg.h"
+
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+
+namespace cinder {
+
+namespace {
+
+// bump whenever the layout of an entry or its payload changes
+const uint32_t	FORMAT_VERSION = 1;
+const char		ENTRY_MAGIC[4] = { 'C', 'I', 'A', 'C' };
+
+// 64 bytes, so that the payload following it is aligned to a cache line in the mapping
+struct EntryHeader {
+	char		magic[4];
+	uint32_t	version;
+	uint32_t	type;
+	uint32_t	reserved;
+	uint64_t	key;
+	uint64_t	payloadSize;
+	uint32_t	params[8];		// type-specific description of the payload
+};
+
+// MurmurHash64A, reading unaligned words with memcpy()
+uint64_t hash64( const void *data, size_t size, uint64_t seed )
+{
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	const int r = 47;
+	uint64_t h = seed ^ ( size * m );
+
+	const uint8_t *p = reinterpret_cast<const uint8_t*>( data );
+	const uint8_t *end = p + ( size & ~(size_t)7 );
+	for( ; p != end; p += 8 ) {
+		uint64_t k;
+		memcpy( &k, p, 8 );
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+		h ^= k;
+		h *= m;
+	}
+
+	switch( size & 7 ) {
+		case 7: h ^= uint64_t( p[6] ) << 48;
+		case 6: h ^= uint64_t( p[5] ) << 40;
+		case 5: h ^= uint64_t( p[4] ) << 32;
+		case 4: h ^= uint64_t( p[3] ) << 24;
+		case 3: h ^= uint64_t( p[2] ) << 16;
+		case 2: h ^= uint64_t( p[1] ) << 8;
+		case 1: h ^= uint64_t( p[0] );
+				h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+	return h;
+}
+
+char triboolCode( boost::tribool b )
+{
+	return ( b ) ? 'y' : ( ( ! b ) ? 'n' : '?' );
+}
+
+void deleteMappedFileRef( void *refcon )
+{
+	delete reinterpret_cast<MappedFileRef*>( refcon );
+}
+
+void appendShapeMesh( const svg::Node &node, float approximationScale, TriMesh2d *result )
+{
+	if( node.isDisplayNone() )
+		return;
+
+	if( const svg::Group *group = dynamic_cast<const svg::Group*>( &node ) ) {
+		for( list<svg::Node*>::const_iterator childIt = group->getChildren().begin(); childIt != group->getChildren().end(); ++childIt )
+			appendShapeMesh( **childIt, approximationScale, result );
+		return;
+	}
+
+	if( ! node.isVisible() || node.getFill().isNone() )
+		return;
+
+	Shape2d shape = node.getShapeAbsolute();
+	if( shape.getContours().empty() )
+		return;
+
+	Triangulator::Winding winding = ( node.getFillRule() == svg::FILL_RULE_EVENODD ) ? Triangulator::WINDING_ODD : Triangulator::WINDING_NONZERO;
+	TriMesh2d mesh = Triangulator( shape, approximationScale ).calcMesh( winding );
+	if( mesh.getNumVertices() == 0 )
+		return;
+
+	uint32_t baseIndex = static_cast<uint32_t>( result->getNumVertices() );
+	result->appendVertices( &mesh.getVertices()[0], mesh.getNumVertices() );
+	vector<uint32_t> &indices = result->getIndices();
+	for( vector<uint32_t>::const_iterator idxIt = mesh.getIndices().begin(); idxIt != mesh.getIndices().end(); ++idxIt )
+		indices.push_back( baseIndex + *idxIt );
+}
+
+const size_t	PAYLOAD_OFFSET = sizeof(EntryHeader);
+
+} // anonymous namespace
+
+AssetCacheRef AssetCache::create( const fs::path &directory )
+{
+	return AssetCacheRef( new AssetCache( directory ) );
+}
+
+AssetCache::AssetCache( const fs::path &directory )
+	: mDirectory( directory )
+{
+	boost::system::error_code ec;
+	if( ! fs::exists( mDirectory, ec ) && ! createDirectories( mDirectory ) )
+		throw AssetCacheExc();
+}
+
+uint64_t AssetCache::calcKey( const void *data, size_t size, const std::string &options )
+{
+	uint64_t h = hash64( data, size, FORMAT_VERSION );
+	return hash64( options.c_str(), options.size(), h );
+}
+
+uint64_t AssetCache::calcKey( DataSourceRef source, const std::string &options )
+{
+	Buffer &buffer = source->getBuffer();
+	return calcKey( buffer.getData(), buffer.getDataSize(), options );
+}
+
+fs::path AssetCache::getEntryPath( uint64_t key ) const
+{
+	char name[32];
+	sprintf( name, "%08x%08x.ciac", (uint32_t)( key >> 32 ), (uint32_t)key );
+	return mDirectory / name;
+}
+
+MappedFileRef AssetCache::findEntry( uint64_t key, uint32_t type, uint32_t params[8] )
+{
+	fs::path path = getEntryPath( key );
+	boost::system::error_code ec;
+	if( ! fs::exists( path, ec ) )
+		return MappedFileRef();
+
+	MappedFileRef file;
+	try {
+		// mapped copy-on-write so that results can be handed out as mutable objects
+		file = MappedFile::create( path, true );
+	}
+	catch( StreamExc & ) {
+		return MappedFileRef();
+	}
+
+	// anything unexpected is treated as a miss and overwritten by the next store
+	EntryHeader header;
+	if( file->getSize() < PAYLOAD_OFFSET )
+		return MappedFileRef();
+	memcpy( &header, file->getData(), sizeof(header) );
+	if( memcmp( header.magic, ENTRY_MAGIC, 4 ) != 0 || header.version != FORMAT_VERSION || header.type != type || header.key != key
+		|| header.payloadSize != file->getSize() - PAYLOAD_OFFSET )
+		return MappedFileRef();
+
+	memcpy( params, header.params, sizeof(header.params) );
+	return file;
+}
+
+void AssetCache::storeEntry( uint64_t key, uint32_t type, const uint32_t params[8], const void *data, size_t size )
+{
+	EntryHeader header;
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, ENTRY_MAGIC, 4 );
+	header.version = FORMAT_VERSION;
+	header.type = type;
+	header.key = key;
+	header.payloadSize = size;
+	memcpy( header.params, params, sizeof(header.params) );
+
+	// written under a unique name and renamed into place so that readers never observe a partial entry
+	fs::path path = getEntryPath( key );
+	boost::system::error_code ec;
+	fs::path tempPath = mDirectory / fs::unique_path( "%%%%%%%%%%%%.tmp", ec );
+	if( ec )
+		return;
+
+	FILE *f = fopen( tempPath.string().c_str(), "wb" );
+	if( ! f )
+		return;
+	bool written = ( fwrite( &header, sizeof(header), 1, f ) == 1 ) && ( size == 0 || fwrite( data, size, 1, f ) == 1 );
+	written = ( fclose( f ) == 0 ) && written;
+
+	if( written )
+		fs::rename( tempPath, path, ec );
+	if( ! written || ec )
+		fs::remove( tempPath, ec );
+}
+
+IStreamRef AssetCache::find( uint64_t key )
+{
+	uint32_t params[8];
+	MappedFileRef file = findEntry( key, ENTRY_RAW, params );
+	if( ! file )
+		return IStreamRef();
+	return file->createStream( PAYLOAD_OFFSET, file->getSize() - PAYLOAD_OFFSET );
+}
+
+void AssetCache::store( uint64_t key, const void *data, size_t size )
+{
+	uint32_t params[8] = { 0 };
+	storeEntry( key, ENTRY_RAW, params, data, size );
+}
+
+void AssetCache::clear()
+{
+	boost::system::error_code ec;
+	for( fs::directory_iterator it( mDirectory, ec ), end; it != end; it.increment( ec ) ) {
+		if( ec )
+			break;
+		if( it->path().extension() == ".ciac" )
+			fs::remove( it->path(), ec );
+	}
+}
+
+Surface8u AssetCache::loadSurface( DataSourceRef source )
+{
+	const uint64_t key = calcKey( source, "surface8u:" + getPathExtension( source->getFilePathHint() ) );
+
+	uint32_t params[8];
+	MappedFileRef file = findEntry( key, ENTRY_SURFACE, params );
+	if( file ) {
+		const int32_t width = params[0], height = params[1], rowBytes = params[2];
+		if( file->getSize() - PAYLOAD_OFFSET >= (size_t)rowBytes * height ) {
+			uint8_t *pixels = reinterpret_cast<uint8_t*>( file->getData() ) + PAYLOAD_OFFSET;
+			Surface8u result( pixels, width, height, rowBytes, SurfaceChannelOrder( params[3] ) );
+			result.setPremultiplied( params[4] != 0 );
+			// the Surface keeps the mapping alive until it is destroyed
+			result.setDeallocator( deleteMappedFileRef, new MappedFileRef( file ) );
+			return result;
+		}
+	}
+
+	Surface8u result( loadImage( source ) );
+	params[0] = result.getWidth();
+	params[1] = result.getHeight();
+	params[2] = result.getRowBytes();
+	params[3] = result.getChannelOrder().getCode();
+	params[4] = result.isPremultiplied() ? 1 : 0;
+	for( int p = 5; p < 8; ++p )
+		params[p] = 0;
+	storeEntry( key, ENTRY_SURFACE, params, result.getData(), (size_t)result.getRowBytes() * result.getHeight() );
+	return result;
+}
+
+TriMesh AssetCache::loadObj( DataSourceRef source, boost::tribool loadNormals, boost::tribool loadTexCoords, bool optimizeVertices )
+{
+	string options = "obj:";
+	options += triboolCode( loadNormals );
+	options += triboolCode( loadTexCoords );
+	options += optimizeVertices ? 'y' : 'n';
+	const uint64_t key = calcKey( source, options );
+
+	TriMesh result;
+	uint32_t params[8];
+	MappedFileRef file = findEntry( key, ENTRY_TRIMESH, params );
+	if( file ) {
+		try {
+			Buffer payload( reinterpret_cast<uint8_t*>( file->getData() ) + PAYLOAD_OFFSET, file->getSize() - PAYLOAD_OFFSET );
+			result.read( DataSourceBuffer::create( payload ) );
+			return result;
+		}
+		catch( StreamExc & ) { // truncated entry; reload from the source
+		}
+		catch( TriMeshExc & ) { // damaged entry; reload from the source
+		}
+	}
+
+	ObjLoader loader( source );
+	loader.load( &result, loadNormals, loadTexCoords, optimizeVertices );
+
+	OStreamMemRef stream = OStreamMem::create();
+	// version 2 carries colors and a checksum, so a damaged entry is detected rather than loaded
+	result.write( DataTargetStream::createRef( stream ), TriMesh::WriteOptions().version( 2 ) );
+	for( int p = 0; p < 8; ++p )
+		params[p] = 0;
+	storeEntry( key, ENTRY_TRIMESH, params, stream->getBuffer(), stream->tell() );
+	return result;
+}
+
+TriMesh2d AssetCache::loadSvgMesh( DataSourceRef source, float approximationScale )
+{
+	const uint64_t key = calcKey( source, "svgmesh:" + toString( approximationScale ) );
+
+	TriMesh2d result;
+	uint32_t params[8];
+	MappedFileRef file = findEntry( key, ENTRY_TRIMESH2D, params );
+	if( file ) {
+		const size_t numVertices = params[0], numIndices = params[1];
+		if( file->getSize() - PAYLOAD_OFFSET == numVertices * sizeof(Vec2f) + numIndices * sizeof(uint32_t) ) {
+			const uint8_t *payload = reinterpret_cast<const uint8_t*>( file->getData() ) + PAYLOAD_OFFSET;
+			const Vec2f *vertices = reinterpret_cast<const Vec2f*>( payload );
+			const uint32_t *indices = reinterpret_cast<const uint32_t*>( payload + numVertices * sizeof(Vec2f) );
+			result.getVertices().assign( vertices, vertices + numVertices );
+			result.getIndices().assign( indices, indices + numIndices );
+			return result;
+		}
+	}
+
+	svg::DocRef doc = svg::Doc::create( source );
+	appendShapeMesh( *doc, approximationScale, &result );
+
+	const size_t verticesSize = result.getNumVertices() * sizeof(Vec2f);
+	const size_t indicesSize = result.getNumIndices() * sizeof(uint32_t);
+	vector<uint8_t> payload( verticesSize + indicesSize );
+	if( verticesSize )
+		memcpy( &payload[0], &result.getVertices()[0], verticesSize );
+	if( indicesSize )
+		memcpy( &payload[verticesSize], &result.getIndices()[0], indicesSize );
+	params[0] = static_cast<uint32_t>( result.getNumVertices() );
+	params[1] = static_cast<uint32_t>( result.getNumIndices() );
+	for( int p = 2; p < 8; ++p )
+		params[p] = 0;
+	storeEntry( key, ENTRY_TRIMESH2D, params, payload.empty() ? 0 : &payload[0], payload.size() );
+	return result;
+}
+
+} // namespace cinder
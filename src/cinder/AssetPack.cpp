@@ -0,0 +1,499 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/AssetPack.h"
+#include "cinder/Utilities.h"
+
+#include <zlib.h>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+using namespace std;
+
+// The index is read in place from the mapped file, so its fields are in host byte order
+#if ! defined( CINDER_LITTLE_ENDIAN )
+	#error "AssetPack requires a little-endian host"
+#endif
+
+namespace cinder {
+
+namespace {
+
+const char PACK_MAGIC[4] = { 'C', 'I', 'P', 'K' };
+
+// Followed by the entry table, the name hash table and the names. All fields are little-endian, the byte order of every platform Cinder supports.
+struct PackHeader {
+	char		magic[4];
+	uint32_t	version;
+	uint32_t	numEntries;
+	uint32_t	numBuckets;		// power of two; each bucket holds an entry index + 1, or 0 when empty
+	uint64_t	indexSize;		// bytes of entry table, hash table and names following the header
+	uint64_t	namesSize;
+	uint8_t		reserved[32];
+};
+
+// FNV-1a
+uint64_t hashName( const char *name, size_t length )
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for( size_t i = 0; i < length; ++i ) {
+		h ^= (uint8_t)name[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+// A window of \a size bytes of \a source beginning at \a base. The source is repositioned before every read.
+class IStreamRange : public IStream {
+  public:
+	IStreamRange( IStreamRef source, off_t base, off_t size )
+		: mSource( source ), mBase( base ), mSize( size ), mOffset( 0 )
+	{
+		setFileName( source->getFileName() );
+	}
+
+	size_t readDataAvailable( void *dest, size_t maxSize )
+	{
+		size_t available = static_cast<size_t>( mSize - mOffset );
+		if( maxSize > available )
+			maxSize = available;
+		if( maxSize ) {
+			mSource->seekAbsolute( mBase + mOffset );
+			mSource->readData( dest, maxSize );
+			mOffset += maxSize;
+		}
+		return maxSize;
+	}
+
+	void	seekAbsolute( off_t absoluteOffset )
+	{
+		if( absoluteOffset < 0 )
+			absoluteOffset = mSize + absoluteOffset;
+		if( absoluteOffset < 0 || absoluteOffset > mSize )
+			throw StreamExc();
+		mOffset = absoluteOffset;
+	}
+
+	void	seekRelative( off_t relativeOffset ) { seekAbsolute( mOffset + relativeOffset ); }
+	off_t	tell() const { return mOffset; }
+	off_t	size() const { return mSize; }
+	bool	isEof() const { return mOffset >= mSize; }
+
+  protected:
+	void	IORead( void *t, size_t size )
+	{
+		if( mOffset + (off_t)size > mSize )
+			throw StreamExc();
+		readDataAvailable( t, size );
+	}
+
+	IStreamRef	mSource;
+	off_t		mBase, mSize, mOffset;
+};
+
+// An IStreamMem which owns the Buffer it reads from
+class IStreamBuffer : public IStreamMem {
+  public:
+	IStreamBuffer( const Buffer &buffer )
+		: IStreamMem( buffer.getData(), buffer.getDataSize() ), mBuffer( buffer )
+	{}
+
+  private:
+	Buffer		mBuffer;
+};
+
+void writePadding( OStreamRef out, size_t alignment )
+{
+	static const uint8_t zeros[AssetPack::ENTRY_ALIGNMENT] = { 0 };
+	size_t remainder = static_cast<size_t>( out->tell() ) % alignment;
+	if( remainder )
+		out->writeData( zeros, alignment - remainder );
+}
+
+} // anonymous namespace
+
+struct AssetPack::IndexEntry {
+	uint64_t	offset;			// from the start of the file
+	uint64_t	storedSize;
+	uint64_t	size;
+	uint64_t	nameHash;
+	uint32_t	nameOffset;		// into the name table
+	uint32_t	nameLength;
+	uint32_t	compression;
+	uint32_t	reserved;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+// AssetPack
+AssetPackRef AssetPack::create( const fs::path &path, bool memoryMap )
+{
+	return AssetPackRef( new AssetPack( path, memoryMap ) );
+}
+
+AssetPackRef AssetPack::create( IStreamRef stream )
+{
+	return AssetPackRef( new AssetPack( stream ) );
+}
+
+AssetPack::AssetPack( const fs::path &path, bool memoryMap )
+	: mFilePath( path ), mNumEntries( 0 ), mNumBuckets( 0 ), mEntries( 0 ), mBuckets( 0 ), mNames( 0 ), mNamesSize( 0 )
+{
+	if( memoryMap ) {
+		try {
+			mMappedFile = MappedFile::create( path );
+		}
+		catch( StreamExc & ) {
+			throw AssetPackExcInvalidFile();
+		}
+		if( mMappedFile->getSize() < sizeof(PackHeader) )
+			throw AssetPackExcInvalidFile();
+		const uint8_t *data = reinterpret_cast<const uint8_t*>( mMappedFile->getData() );
+		parseIndex( data, mMappedFile->getSize() - sizeof(PackHeader), mMappedFile->getSize() );
+	}
+	else {
+		IStreamFileRef stream = loadFileStream( path );
+		if( ! stream )
+			throw AssetPackExcInvalidFile();
+		readIndex( stream, stream->size() );
+	}
+}
+
+AssetPack::AssetPack( IStreamRef stream )
+	: mStream( stream ), mNumEntries( 0 ), mNumBuckets( 0 ), mEntries( 0 ), mBuckets( 0 ), mNames( 0 ), mNamesSize( 0 )
+{
+	if( ! stream )
+		throw AssetPackExcInvalidFile();
+	mFilePath = stream->getFileName();
+	readIndex( stream, stream->size() );
+}
+
+void AssetPack::readIndex( IStreamRef stream, uint64_t fileSize )
+{
+	PackHeader header;
+	try {
+		stream->seekAbsolute( 0 );
+		stream->readData( &header, sizeof(header) );
+		if( fileSize < sizeof(PackHeader) || header.indexSize > fileSize - sizeof(PackHeader) )
+			throw AssetPackExcInvalidFile();
+		// the header is kept in front of the index so that both paths share parseIndex()
+		mIndexStorage.resize( sizeof(PackHeader) + static_cast<size_t>( header.indexSize ) );
+		memcpy( &mIndexStorage[0], &header, sizeof(header) );
+		if( header.indexSize )
+			stream->readData( &mIndexStorage[sizeof(PackHeader)], static_cast<size_t>( header.indexSize ) );
+	}
+	catch( StreamExc & ) {
+		throw AssetPackExcInvalidFile();
+	}
+
+	parseIndex( &mIndexStorage[0], static_cast<size_t>( header.indexSize ), fileSize );
+}
+
+void AssetPack::parseIndex( const uint8_t *data, size_t available, uint64_t fileSize )
+{
+	PackHeader header;
+	memcpy( &header, data, sizeof(header) );
+	if( memcmp( header.magic, PACK_MAGIC, 4 ) != 0 || header.version != FORMAT_VERSION )
+		throw AssetPackExcInvalidFile();
+
+	const uint64_t entriesSize = (uint64_t)header.numEntries * sizeof(IndexEntry);
+	const uint64_t bucketsSize = (uint64_t)header.numBuckets * sizeof(uint32_t);
+	if( header.indexSize > available || entriesSize + bucketsSize + header.namesSize != header.indexSize
+		|| header.numBuckets < header.numEntries || ( header.numBuckets & ( header.numBuckets - 1 ) ) != 0 )
+		throw AssetPackExcInvalidFile();
+
+	mNumEntries = header.numEntries;
+	mNumBuckets = header.numBuckets;
+	mEntries = data + sizeof(PackHeader);
+	mBuckets = reinterpret_cast<const uint32_t*>( mEntries + entriesSize );
+	mNames = reinterpret_cast<const char*>( mEntries + entriesSize + bucketsSize );
+	mNamesSize = static_cast<size_t>( header.namesSize );
+
+	for( size_t e = 0; e < mNumEntries; ++e ) {
+		const IndexEntry &entry = getEntry( e );
+		if( entry.offset > fileSize || entry.storedSize > fileSize - entry.offset || (uint64_t)entry.nameOffset + entry.nameLength > mNamesSize
+			|| entry.compression > COMPRESSION_ZLIB || ( entry.compression == COMPRESSION_NONE && entry.storedSize != entry.size ) )
+			throw AssetPackExcInvalidFile();
+	}
+}
+
+const AssetPack::IndexEntry& AssetPack::getEntry( size_t index ) const
+{
+	return reinterpret_cast<const IndexEntry*>( mEntries )[index];
+}
+
+int AssetPack::findEntry( const std::string &name ) const
+{
+	if( mNumBuckets == 0 )
+		return -1;
+
+	const uint64_t h = hashName( name.c_str(), name.size() );
+	const size_t mask = mNumBuckets - 1;
+	size_t bucket = static_cast<size_t>( h ) & mask;
+	for( size_t probe = 0; probe < mNumBuckets; ++probe ) {
+		uint32_t slot = mBuckets[bucket];
+		if( slot == 0 || slot > mNumEntries )
+			return -1;
+		const IndexEntry &entry = getEntry( slot - 1 );
+		if( entry.nameHash == h && entry.nameLength == name.size() && memcmp( mNames + entry.nameOffset, name.c_str(), name.size() ) == 0 )
+			return static_cast<int>( slot - 1 );
+		bucket = ( bucket + 1 ) & mask;
+	}
+
+	return -1;
+}
+
+std::string AssetPack::getEntryName( size_t index ) const
+{
+	const IndexEntry &entry = getEntry( index );
+	return std::string( mNames + entry.nameOffset, entry.nameLength );
+}
+
+uint64_t AssetPack::getEntrySize( size_t index ) const
+{
+	return getEntry( index ).size;
+}
+
+bool AssetPack::isEntryCompressed( size_t index ) const
+{
+	return getEntry( index ).compression != COMPRESSION_NONE;
+}
+
+IStreamRef AssetPack::createStream( const std::string &name )
+{
+	int index = findEntry( name );
+	if( index < 0 )
+		throw AssetPackExcEntryNotFound( name );
+	return createStream( static_cast<size_t>( index ) );
+}
+
+IStreamRef AssetPack::createStream( size_t index )
+{
+	const IndexEntry &entry = getEntry( index );
+	IStreamRef result;
+	if( entry.compression == COMPRESSION_NONE )
+		result = createRawStream( entry.offset, entry.size );
+	else
+		result = IStreamRef( new IStreamBuffer( loadBuffer( index ) ) );
+	result->setFileName( getEntryName( index ) );
+	return result;
+}
+
+IStreamRef AssetPack::createRawStream( uint64_t offset, uint64_t size )
+{
+	if( mMappedFile )
+		return mMappedFile->createStream( static_cast<size_t>( offset ), static_cast<size_t>( size ) );
+	else if( mStream )
+		return IStreamRef( new IStreamRange( mStream, static_cast<off_t>( offset ), static_cast<off_t>( size ) ) );
+	else {
+		// a file per stream, so that entries may be read concurrently
+		IStreamFileRef file = loadFileStream( mFilePath );
+		if( ! file )
+			throw AssetPackExcInvalidFile();
+		return IStreamRef( new IStreamRange( file, static_cast<off_t>( offset ), static_cast<off_t>( size ) ) );
+	}
+}
+
+Buffer AssetPack::loadBuffer( size_t index )
+{
+	const IndexEntry &entry = getEntry( index );
+	const uint8_t *mapped = mMappedFile ? reinterpret_cast<const uint8_t*>( mMappedFile->getData() ) + entry.offset : 0;
+
+	if( entry.compression == COMPRESSION_NONE ) {
+		if( mapped )
+			return Buffer( const_cast<uint8_t*>( mapped ), static_cast<size_t>( entry.size ) );
+		Buffer result( static_cast<size_t>( entry.size ) );
+		createRawStream( entry.offset, entry.size )->readData( result.getData(), result.getDataSize() );
+		return result;
+	}
+
+	Buffer stored;
+	if( ! mapped ) {
+		stored = Buffer( static_cast<size_t>( entry.storedSize ) );
+		createRawStream( entry.offset, entry.storedSize )->readData( stored.getData(), stored.getDataSize() );
+		mapped = reinterpret_cast<const uint8_t*>( stored.getData() );
+	}
+
+	Buffer result( static_cast<size_t>( entry.size ) );
+	uLongf resultSize = static_cast<uLongf>( entry.size );
+	if( uncompress( reinterpret_cast<Bytef*>( result.getData() ), &resultSize, mapped, static_cast<uLong>( entry.storedSize ) ) != Z_OK || resultSize != entry.size )
+		throw AssetPackExcInvalidFile();
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// DataSourcePack
+DataSourcePackRef DataSourcePack::create( AssetPackRef pack, const std::string &name )
+{
+	int index = pack->findEntry( name );
+	if( index < 0 )
+		throw AssetPackExcEntryNotFound( name );
+
+	DataSourcePackRef result( new DataSourcePack( pack, static_cast<size_t>( index ) ) );
+	result->setFilePathHint( name );
+	return result;
+}
+
+DataSourcePack::DataSourcePack( AssetPackRef pack, size_t entryIndex )
+	: DataSource( "", Url() ), mPack( pack ), mEntryIndex( entryIndex )
+{
+}
+
+void DataSourcePack::createBuffer()
+{
+	// a mapped entry's Buffer refers to the pack, which this DataSource keeps alive
+	mBuffer = mPack->loadBuffer( mEntryIndex );
+}
+
+IStreamRef DataSourcePack::createStream()
+{
+	return mPack->createStream( mEntryIndex );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// AssetPackWriter
+void AssetPackWriter::addFile( const std::string &name, const fs::path &path, bool compress )
+{
+	Entry entry;
+	entry.mName = name;
+	entry.mPath = path;
+	entry.mCompress = compress;
+	addEntry( entry );
+}
+
+void AssetPackWriter::addBuffer( const std::string &name, const Buffer &data, bool compress )
+{
+	Entry entry;
+	entry.mName = name;
+	entry.mData = data;
+	entry.mCompress = compress;
+	addEntry( entry );
+}
+
+void AssetPackWriter::addEntry( const Entry &entry )
+{
+	map<string,size_t>::iterator existing = mEntryIndices.find( entry.mName );
+	if( existing != mEntryIndices.end() )
+		mEntries[existing->second] = entry;
+	else {
+		mEntryIndices[entry.mName] = mEntries.size();
+		mEntries.push_back( entry );
+	}
+}
+
+void AssetPackWriter::write( const fs::path &path ) const
+{
+	// the name table and hash table are known up front; the entry table is rewritten once the data offsets are known
+	vector<AssetPack::IndexEntry> index( mEntries.size() );
+	string names;
+	for( size_t e = 0; e < mEntries.size(); ++e ) {
+		memset( &index[e], 0, sizeof(AssetPack::IndexEntry) );
+		index[e].nameOffset = static_cast<uint32_t>( names.size() );
+		index[e].nameLength = static_cast<uint32_t>( mEntries[e].mName.size() );
+		index[e].nameHash = hashName( mEntries[e].mName.c_str(), mEntries[e].mName.size() );
+		names += mEntries[e].mName;
+	}
+
+	// keep the load factor at or below one half
+	size_t numBuckets = 1;
+	while( numBuckets < mEntries.size() * 2 )
+		numBuckets *= 2;
+	vector<uint32_t> buckets( numBuckets, 0 );
+	for( size_t e = 0; e < mEntries.size(); ++e ) {
+		size_t bucket = static_cast<size_t>( index[e].nameHash ) & ( numBuckets - 1 );
+		while( buckets[bucket] )
+			bucket = ( bucket + 1 ) & ( numBuckets - 1 );
+		buckets[bucket] = static_cast<uint32_t>( e + 1 );
+	}
+
+	PackHeader header;
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, PACK_MAGIC, 4 );
+	header.version = AssetPack::FORMAT_VERSION;
+	header.numEntries = static_cast<uint32_t>( mEntries.size() );
+	header.numBuckets = static_cast<uint32_t>( numBuckets );
+	header.namesSize = names.size();
+	header.indexSize = index.size() * sizeof(AssetPack::IndexEntry) + numBuckets * sizeof(uint32_t) + names.size();
+
+	OStreamRef out = writeFileStream( path );
+	if( ! out )
+		throw AssetPackExc();
+	out->writeData( &header, sizeof(header) );
+	if( ! index.empty() )
+		out->writeData( &index[0], index.size() * sizeof(AssetPack::IndexEntry) );
+	out->writeData( &buckets[0], buckets.size() * sizeof(uint32_t) );
+	if( ! names.empty() )
+		out->writeData( names.c_str(), names.size() );
+
+	for( size_t e = 0; e < mEntries.size(); ++e ) {
+		const Entry &entry = mEntries[e];
+		Buffer data = entry.mData;
+		if( ! entry.mPath.empty() ) {
+			IStreamFileRef in = loadFileStream( entry.mPath );
+			if( ! in )
+				throw AssetPackExcEntryNotFound( entry.mPath.string() );
+			data = loadStreamBuffer( in );
+		}
+		// a default-constructed Buffer is an empty entry
+		const size_t dataSize = data ? data.getDataSize() : 0;
+		index[e].size = dataSize;
+
+		Buffer compressed;
+		if( entry.mCompress && dataSize > 0 ) {
+			uLongf compressedSize = compressBound( static_cast<uLong>( dataSize ) );
+			compressed = Buffer( compressedSize );
+			if( compress2( reinterpret_cast<Bytef*>( compressed.getData() ), &compressedSize, reinterpret_cast<const Bytef*>( data.getData() ), static_cast<uLong>( dataSize ), Z_BEST_COMPRESSION ) == Z_OK
+				&& compressedSize < dataSize )
+				compressed.setDataSize( compressedSize );
+			else
+				compressed = Buffer();
+		}
+
+		if( compressed ) {
+			index[e].compression = AssetPack::COMPRESSION_ZLIB;
+			index[e].offset = out->tell();
+			index[e].storedSize = compressed.getDataSize();
+			out->writeData( compressed.getData(), compressed.getDataSize() );
+		}
+		else {
+			writePadding( out, AssetPack::ENTRY_ALIGNMENT );
+			index[e].compression = AssetPack::COMPRESSION_NONE;
+			index[e].offset = out->tell();
+			index[e].storedSize = dataSize;
+			if( dataSize )
+				out->writeData( data.getData(), dataSize );
+		}
+	}
+
+	if( ! index.empty() ) {
+		out->seekAbsolute( sizeof(PackHeader) );
+		out->writeData( &index[0], index.size() * sizeof(AssetPack::IndexEntry) );
+	}
+}
+
+AssetPackExcEntryNotFound::AssetPackExcEntryNotFound( const std::string &name ) throw()
+{
+	strncpy( mMessage, name.c_str(), sizeof(mMessage) - 1 );
+	mMessage[sizeof(mMessage) - 1] = 0;
+}
+
+} // namespace cinder
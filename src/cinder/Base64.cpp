@@ -25,8 +25,22 @@
 
 #include "cinder/Base64.h"
 
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#if defined( __SSSE3__ ) || defined( __AVX__ )
+	#define CINDER_BASE64_SSSE3
+	#include <tmmintrin.h>
+#elif defined( __ARM_NEON__ ) || defined( __ARM_NEON )
+	#define CINDER_BASE64_NEON
+	#include <arm_neon.h>
+#endif
+
 namespace {
 
+const char *sEncoding = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
 typedef enum { step_a, step_b, step_c, step_d } base64_decodestep;
 
 typedef struct {
@@ -38,7 +52,7 @@ int base64_decode_value( char value_in ) {
 	static const int8_t decoding[] = {62,-1,-1,-1,63,52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-2,-1,-1,-1,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1,-1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,48,49,50,51};
 	static const int8_t decoding_size = sizeof(decoding);
 	value_in -= 43;
-	if (value_in < 0 || value_in > decoding_size) return -1;
+	if (value_in < 0 || value_in >= decoding_size) return -1;
 	return decoding[(int)value_in];
 }
 
@@ -48,174 +62,211 @@ void base64_init_decodestate( base64_decodestate* state_in )
 	state_in->plainchar = 0;
 }
 
-int base64_decode_block( const char* code_in, const int length_in, char* plaintext_out, base64_decodestate* state_in )
+// Scalar decoder; characters outside the alphabet (whitespace, padding) are skipped. Never writes past the bytes it reports.
+size_t base64_decode_block( const char* code_in, size_t length_in, char* plaintext_out, base64_decodestate* state_in )
 {
 	const char* codechar = code_in;
+	const char* const codeend = code_in + length_in;
 	char* plainchar = plaintext_out;
-	char fragment;
-	
-	*plainchar = state_in->plainchar;
-	
-	switch (state_in->step)
-	{
-		while (1)
-		{
-	case step_a:
-			do {
-				if (codechar == code_in+length_in)
-				{
-					state_in->step = step_a;
-					state_in->plainchar = *plainchar;
-					return plainchar - plaintext_out;
-				}
-				fragment = (char)base64_decode_value(*codechar++);
-			} while (fragment < 0);
-			*plainchar    = (fragment & 0x03f) << 2;
-	case step_b:
-			do {
-				if (codechar == code_in+length_in)
-				{
-					state_in->step = step_b;
-					state_in->plainchar = *plainchar;
-					return plainchar - plaintext_out;
-				}
-				fragment = (char)base64_decode_value(*codechar++);
-			} while (fragment < 0);
-			*plainchar++ |= (fragment & 0x030) >> 4;
-			*plainchar    = (fragment & 0x00f) << 4;
-	case step_c:
-			do {
-				if (codechar == code_in+length_in)
-				{
-					state_in->step = step_c;
-					state_in->plainchar = *plainchar;
-					return plainchar - plaintext_out;
-				}
-				fragment = (char)base64_decode_value(*codechar++);
-			} while (fragment < 0);
-			*plainchar++ |= (fragment & 0x03c) >> 2;
-			*plainchar    = (fragment & 0x003) << 6;
-	case step_d:
-			do {
-				if (codechar == code_in+length_in)
-				{
-					state_in->step = step_d;
-					state_in->plainchar = *plainchar;
-					return plainchar - plaintext_out;
-				}
-				fragment = (char)base64_decode_value(*codechar++);
-			} while (fragment < 0);
-			*plainchar++   |= (fragment & 0x03f);
+	char pending = state_in->plainchar;
+	base64_decodestep step = state_in->step;
+
+	while( codechar != codeend ) {
+		int fragment = base64_decode_value( *codechar++ );
+		if( fragment < 0 )
+			continue;
+		switch( step ) {
+			case step_a:
+				pending = (char)( ( fragment & 0x03f ) << 2 );
+				step = step_b;
+			break;
+			case step_b:
+				*plainchar++ = pending | (char)( ( fragment & 0x030 ) >> 4 );
+				pending = (char)( ( fragment & 0x00f ) << 4 );
+				step = step_c;
+			break;
+			case step_c:
+				*plainchar++ = pending | (char)( ( fragment & 0x03c ) >> 2 );
+				pending = (char)( ( fragment & 0x003 ) << 6 );
+				step = step_d;
+			break;
+			case step_d:
+				*plainchar++ = pending | (char)( fragment & 0x03f );
+				step = step_a;
+			break;
 		}
 	}
-	/* control should not reach here */
+
+	state_in->step = step;
+	state_in->plainchar = pending;
 	return plainchar - plaintext_out;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-// encode
-typedef enum { step_A, step_B, step_C } base64_encodestep;
+// SIMD kernels; each processes a whole number of 3-byte / 4-character groups
 
-typedef struct {
-	base64_encodestep step;
-	char result;
-	int stepcount;
-} base64_encodestate;
+#if defined( CINDER_BASE64_SSSE3 )
+const size_t SIMD_ENCODE_INPUT = 12;	// bytes consumed per step; 16 bytes must be readable
+const size_t SIMD_DECODE_INPUT = 16;	// characters consumed per step
 
-void base64_init_encodestate( base64_encodestate* state_in )
+inline void simdEncode( const uint8_t *in, char *out )
 {
-	state_in->step = step_A;
-	state_in->result = 0;
-	state_in->stepcount = 0;
+	__m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( in ) );
+	v = _mm_shuffle_epi8( v, _mm_set_epi8( 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1 ) );
+	// isolate the four 6-bit fields of each 24-bit group into their own bytes
+	__m128i t0 = _mm_mulhi_epu16( _mm_and_si128( v, _mm_set1_epi32( 0x0fc0fc00 ) ), _mm_set1_epi32( 0x04000040 ) );
+	__m128i t1 = _mm_mullo_epi16( _mm_and_si128( v, _mm_set1_epi32( 0x003f03f0 ) ), _mm_set1_epi32( 0x01000010 ) );
+	__m128i indices = _mm_or_si128( t0, t1 );
+	// map 0..63 onto the alphabet by adding a per-range offset
+	__m128i range = _mm_subs_epu8( indices, _mm_set1_epi8( 51 ) );
+	__m128i less = _mm_cmpgt_epi8( _mm_set1_epi8( 26 ), indices );
+	range = _mm_or_si128( range, _mm_and_si128( less, _mm_set1_epi8( 13 ) ) );
+	const __m128i offsets = _mm_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0 );
+	__m128i result = _mm_add_epi8( _mm_shuffle_epi8( offsets, range ), indices );
+	_mm_storeu_si128( reinterpret_cast<__m128i*>( out ), result );
 }
 
-char base64_encode_value(char value_in)
+// Returns false without writing if any character is outside the alphabet
+inline bool simdDecode( const char *in, uint8_t *out )
 {
-	static const char* encoding = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-	if (value_in > 63) return '=';
-	return encoding[(int)value_in];
+	__m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( in ) );
+	__m128i hiNibbles = _mm_and_si128( _mm_srli_epi32( v, 4 ), _mm_set1_epi8( 0x0f ) );
+	__m128i loNibbles = _mm_and_si128( v, _mm_set1_epi8( 0x0f ) );
+	const __m128i lutLo = _mm_setr_epi8( 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A );
+	const __m128i lutHi = _mm_setr_epi8( 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 );
+	__m128i lo = _mm_shuffle_epi8( lutLo, loNibbles );
+	__m128i hi = _mm_shuffle_epi8( lutHi, hiNibbles );
+	if( _mm_movemask_epi8( _mm_cmpgt_epi8( _mm_and_si128( lo, hi ), _mm_setzero_si128() ) ) != 0 )
+		return false;
+
+	const __m128i lutRoll = _mm_setr_epi8( 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0 );
+	__m128i eq2F = _mm_cmpeq_epi8( v, _mm_set1_epi8( 0x2f ) );
+	__m128i values = _mm_add_epi8( v, _mm_shuffle_epi8( lutRoll, _mm_add_epi8( eq2F, hiNibbles ) ) );
+	// pack four 6-bit values into three bytes
+	__m128i merged = _mm_maddubs_epi16( values, _mm_set1_epi32( 0x01400140 ) );
+	merged = _mm_madd_epi16( merged, _mm_set1_epi32( 0x00011000 ) );
+	merged = _mm_shuffle_epi8( merged, _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 ) );
+	uint8_t temp[16];
+	_mm_storeu_si128( reinterpret_cast<__m128i*>( temp ), merged );
+	memcpy( out, temp, 12 );
+	return true;
 }
 
-int base64_encode_block(const char* plaintext_in, int length_in, char* code_out, base64_encodestate* state_in, int charsPerLine )
+#elif defined( CINDER_BASE64_NEON )
+const size_t SIMD_ENCODE_INPUT = 48;
+const size_t SIMD_DECODE_INPUT = 64;
+
+inline uint8x16_t neonEncodeLookup( uint8x16_t i )
 {
-	const char* plainchar = plaintext_in;
-	const char* const plaintextend = plaintext_in + length_in;
-	char* codechar = code_out;
-	char result;
-	char fragment;
-	
-	result = state_in->result;
-	
-	switch (state_in->step)
-	{
-		while (1)
-		{
-	case step_A:
-			if (plainchar == plaintextend)
-			{
-				state_in->result = result;
-				state_in->step = step_A;
-				return codechar - code_out;
-			}
-			fragment = *plainchar++;
-			result = (fragment & 0x0fc) >> 2;
-			*codechar++ = base64_encode_value(result);
-			result = (fragment & 0x003) << 4;
-	case step_B:
-			if (plainchar == plaintextend)
-			{
-				state_in->result = result;
-				state_in->step = step_B;
-				return codechar - code_out;
-			}
-			fragment = *plainchar++;
-			result |= (fragment & 0x0f0) >> 4;
-			*codechar++ = base64_encode_value(result);
-			result = (fragment & 0x00f) << 2;
-	case step_C:
-			if (plainchar == plaintextend)
-			{
-				state_in->result = result;
-				state_in->step = step_C;
-				return codechar - code_out;
-			}
-			fragment = *plainchar++;
-			result |= (fragment & 0x0c0) >> 6;
-			*codechar++ = base64_encode_value(result);
-			result  = (fragment & 0x03f) >> 0;
-			*codechar++ = base64_encode_value(result);
-			
-			++(state_in->stepcount);
-			if ( ( charsPerLine != 0 ) && ( state_in->stepcount == charsPerLine/4 ) )
-			{
-				*codechar++ = '\n';
-				state_in->stepcount = 0;
-			}
-		}
+	uint8x16_t offset = vdupq_n_u8( 'A' );
+	offset = vbslq_u8( vcgeq_u8( i, vdupq_n_u8( 26 ) ), vdupq_n_u8( 'a' - 26 ), offset );
+	offset = vbslq_u8( vcgeq_u8( i, vdupq_n_u8( 52 ) ), vdupq_n_u8( (uint8_t)( '0' - 52 ) ), offset );
+	offset = vbslq_u8( vceqq_u8( i, vdupq_n_u8( 62 ) ), vdupq_n_u8( (uint8_t)( '+' - 62 ) ), offset );
+	offset = vbslq_u8( vceqq_u8( i, vdupq_n_u8( 63 ) ), vdupq_n_u8( (uint8_t)( '/' - 63 ) ), offset );
+	return vaddq_u8( i, offset );
+}
+
+inline void simdEncode( const uint8_t *in, char *out )
+{
+	uint8x16x3_t src = vld3q_u8( in );
+	const uint8x16_t mask = vdupq_n_u8( 0x3f );
+	uint8x16x4_t dst;
+	dst.val[0] = neonEncodeLookup( vshrq_n_u8( src.val[0], 2 ) );
+	dst.val[1] = neonEncodeLookup( vandq_u8( vorrq_u8( vshrq_n_u8( src.val[1], 4 ), vshlq_n_u8( src.val[0], 4 ) ), mask ) );
+	dst.val[2] = neonEncodeLookup( vandq_u8( vorrq_u8( vshrq_n_u8( src.val[2], 6 ), vshlq_n_u8( src.val[1], 2 ) ), mask ) );
+	dst.val[3] = neonEncodeLookup( vandq_u8( src.val[2], mask ) );
+	vst4q_u8( reinterpret_cast<uint8_t*>( out ), dst );
+}
+
+// Maps characters to 6-bit values; bytes of \a invalid are set for characters outside the alphabet
+inline uint8x16_t neonDecodeLookup( uint8x16_t c, uint8x16_t *invalid )
+{
+	uint8x16_t result = vdupq_n_u8( 0xff );
+	uint8x16_t upper = vandq_u8( vcgeq_u8( c, vdupq_n_u8( 'A' ) ), vcleq_u8( c, vdupq_n_u8( 'Z' ) ) );
+	uint8x16_t lower = vandq_u8( vcgeq_u8( c, vdupq_n_u8( 'a' ) ), vcleq_u8( c, vdupq_n_u8( 'z' ) ) );
+	uint8x16_t digit = vandq_u8( vcgeq_u8( c, vdupq_n_u8( '0' ) ), vcleq_u8( c, vdupq_n_u8( '9' ) ) );
+	result = vbslq_u8( upper, vsubq_u8( c, vdupq_n_u8( 'A' ) ), result );
+	result = vbslq_u8( lower, vsubq_u8( c, vdupq_n_u8( 'a' - 26 ) ), result );
+	result = vbslq_u8( digit, vaddq_u8( c, vdupq_n_u8( 52 - '0' ) ), result );
+	result = vbslq_u8( vceqq_u8( c, vdupq_n_u8( '+' ) ), vdupq_n_u8( 62 ), result );
+	result = vbslq_u8( vceqq_u8( c, vdupq_n_u8( '/' ) ), vdupq_n_u8( 63 ), result );
+	*invalid = vorrq_u8( *invalid, vceqq_u8( result, vdupq_n_u8( 0xff ) ) );
+	return result;
+}
+
+inline bool simdDecode( const char *in, uint8_t *out )
+{
+	uint8x16x4_t src = vld4q_u8( reinterpret_cast<const uint8_t*>( in ) );
+	uint8x16_t invalid = vdupq_n_u8( 0 );
+	uint8x16_t a = neonDecodeLookup( src.val[0], &invalid );
+	uint8x16_t b = neonDecodeLookup( src.val[1], &invalid );
+	uint8x16_t c = neonDecodeLookup( src.val[2], &invalid );
+	uint8x16_t d = neonDecodeLookup( src.val[3], &invalid );
+	uint64x2_t invalid64 = vreinterpretq_u64_u8( invalid );
+	if( ( vgetq_lane_u64( invalid64, 0 ) | vgetq_lane_u64( invalid64, 1 ) ) != 0 )
+		return false;
+
+	uint8x16x3_t dst;
+	dst.val[0] = vorrq_u8( vshlq_n_u8( a, 2 ), vshrq_n_u8( b, 4 ) );
+	dst.val[1] = vorrq_u8( vshlq_n_u8( b, 4 ), vshrq_n_u8( c, 2 ) );
+	dst.val[2] = vorrq_u8( vshlq_n_u8( c, 6 ), d );
+	vst3q_u8( out, dst );
+	return true;
+}
+#endif
+
+// Encodes \a groups complete 3-byte groups from \a in, writing groups * 4 characters to \a out
+void encodeGroups( const uint8_t *in, size_t groups, char *out )
+{
+	const uint8_t *inEnd = in + groups * 3;
+#if defined( CINDER_BASE64_SSSE3 )
+	// the SSSE3 kernel loads 16 bytes to consume 12, so stop while a full load still lies inside the group run
+	while( inEnd - in >= 16 ) {
+		simdEncode( in, out );
+		in += SIMD_ENCODE_INPUT;
+		out += SIMD_ENCODE_INPUT / 3 * 4;
+	}
+#elif defined( CINDER_BASE64_NEON )
+	while( inEnd - in >= (ptrdiff_t)SIMD_ENCODE_INPUT ) {
+		simdEncode( in, out );
+		in += SIMD_ENCODE_INPUT;
+		out += SIMD_ENCODE_INPUT / 3 * 4;
+	}
+#endif
+	while( in != inEnd ) {
+		uint32_t triple = ( in[0] << 16 ) | ( in[1] << 8 ) | in[2];
+		out[0] = sEncoding[( triple >> 18 ) & 0x3f];
+		out[1] = sEncoding[( triple >> 12 ) & 0x3f];
+		out[2] = sEncoding[( triple >> 6 ) & 0x3f];
+		out[3] = sEncoding[triple & 0x3f];
+		in += 3;
+		out += 4;
 	}
-	/* control should not reach here */
-	return codechar - code_out;
 }
 
-int base64_encode_blockend( char* code_out, base64_encodestate* state_in )
+// Decodes \a inputSize characters, continuing from and updating \a state. SIMD blocks are only attempted
+// on group boundaries; blocks containing whitespace or padding go through the scalar decoder.
+size_t decodeChunk( const char *in, size_t inputSize, uint8_t *out, base64_decodestate *state )
 {
-	char* codechar = code_out;
-	
-	switch (state_in->step) {
-	case step_B:
-		*codechar++ = base64_encode_value(state_in->result);
-		*codechar++ = '=';
-		*codechar++ = '=';
-		break;
-	case step_C:
-		*codechar++ = base64_encode_value(state_in->result);
-		*codechar++ = '=';
-		break;
-	case step_A:
-		break;
+	const char *inEnd = in + inputSize;
+	uint8_t *outStart = out;
+#if defined( CINDER_BASE64_SSSE3 ) || defined( CINDER_BASE64_NEON )
+	while( (size_t)( inEnd - in ) >= SIMD_DECODE_INPUT ) {
+		if( state->step == step_a && simdDecode( in, out ) ) {
+			in += SIMD_DECODE_INPUT;
+			out += SIMD_DECODE_INPUT / 4 * 3;
+		}
+		else {
+			// consume characters until realigned on a group boundary at a valid character
+			do {
+				out += base64_decode_block( in, 1, reinterpret_cast<char*>( out ), state );
+				++in;
+			} while( in != inEnd && ( state->step != step_a || base64_decode_value( *in ) < 0 ) );
+		}
 	}
-	
-	return codechar - code_out;
+#endif
+	out += base64_decode_block( in, inEnd - in, reinterpret_cast<char*>( out ), state );
+	return out - outStart;
 }
 
 } // anonymous namespace
@@ -223,6 +274,71 @@ int base64_encode_blockend( char* code_out, base64_encodestate* state_in )
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 namespace cinder {
 
+size_t calcBase64EncodedSize( size_t inputSize, int charsPerLine )
+{
+	size_t groupsPerLine = ( charsPerLine > 0 ) ? charsPerLine / 4 : 0;
+	size_t result = ( inputSize + 2 ) / 3 * 4;
+	if( groupsPerLine )
+		result += inputSize / 3 / groupsPerLine; // a carriage return follows every complete line
+	return result;
+}
+
+size_t calcBase64DecodedMaxSize( size_t inputSize )
+{
+	return inputSize / 4 * 3 + ( inputSize % 4 ) * 3 / 4;
+}
+
+size_t encodeBase64( const void *input, size_t inputSize, char *output, int charsPerLine )
+{
+	const uint8_t *in = reinterpret_cast<const uint8_t*>( input );
+	char *out = output;
+	size_t groups = inputSize / 3;
+	size_t groupsPerLine = ( charsPerLine > 0 ) ? charsPerLine / 4 : 0;
+
+	if( groupsPerLine == 0 ) {
+		encodeGroups( in, groups, out );
+		in += groups * 3;
+		out += groups * 4;
+	}
+	else {
+		while( groups >= groupsPerLine ) {
+			encodeGroups( in, groupsPerLine, out );
+			in += groupsPerLine * 3;
+			out += groupsPerLine * 4;
+			*out++ = '\n';
+			groups -= groupsPerLine;
+		}
+		encodeGroups( in, groups, out );
+		in += groups * 3;
+		out += groups * 4;
+	}
+
+	// trailing partial group and padding
+	switch( inputSize % 3 ) {
+		case 1:
+			*out++ = sEncoding[in[0] >> 2];
+			*out++ = sEncoding[( in[0] & 0x03 ) << 4];
+			*out++ = '=';
+			*out++ = '=';
+		break;
+		case 2:
+			*out++ = sEncoding[in[0] >> 2];
+			*out++ = sEncoding[( ( in[0] & 0x03 ) << 4 ) | ( in[1] >> 4 )];
+			*out++ = sEncoding[( in[1] & 0x0f ) << 2];
+			*out++ = '=';
+		break;
+	}
+
+	return out - output;
+}
+
+size_t decodeBase64( const void *input, size_t inputSize, void *output )
+{
+	base64_decodestate decs;
+	base64_init_decodestate( &decs );
+	return decodeChunk( reinterpret_cast<const char*>( input ), inputSize, reinterpret_cast<uint8_t*>( output ), &decs );
+}
+
 std::string toBase64( const std::string &input, int charsPerLine )
 {
 	return toBase64( input.c_str(), input.size(), charsPerLine );
@@ -237,19 +353,10 @@ std::string toBase64( const void *input, size_t inputSize, int charsPerLine )
 {
 	if( inputSize == 0 ) return std::string();
 
-	if( charsPerLine != 0 )
-		charsPerLine -= charsPerLine % 4;
-	size_t lines = ( charsPerLine == 0 ) ? 0 : ( inputSize * 4 / 3 / charsPerLine + 1 ); // account for inserted carriage returns
-	char *buffer = new char[inputSize * 4 / 3 + 4 + lines];
-
-	base64_encodestate encs;
-	base64_init_encodestate( &encs );
-	size_t resultSize = base64_encode_block( reinterpret_cast<const char*>(input), inputSize, &buffer[0], &encs, charsPerLine );
-	resultSize += base64_encode_blockend( &buffer[resultSize], &encs );
-	buffer[resultSize] = 0; // null terminate the string
-	
-	std::string result( buffer );
-	delete [] buffer;
+	// encode directly into the result rather than through an intermediate buffer
+	std::string result( calcBase64EncodedSize( inputSize, charsPerLine ), 0 );
+	size_t resultSize = encodeBase64( input, inputSize, &result[0], charsPerLine );
+	result.resize( resultSize );
 	return result;
 }
 
@@ -265,16 +372,49 @@ Buffer fromBase64( const Buffer &input )
 
 Buffer fromBase64( const void *input, size_t inputSize )
 {
-	size_t outputSize = inputSize / 4 * 3;
-	Buffer result( outputSize );
-	if( inputSize >= 4 ) {
-		base64_decodestate decs;
-		base64_init_decodestate( &decs );
-		int actualSize = base64_decode_block( reinterpret_cast<const char*>(input), inputSize, (char*)result.getData(), &decs );
-		result.setDataSize( actualSize );
-	}
+	Buffer result( calcBase64DecodedMaxSize( inputSize ) );
+	result.setDataSize( decodeBase64( input, inputSize, result.getData() ) );
 	return result;
 }
 
+void toBase64( const IStreamRef &input, const OStreamRef &output, int charsPerLine )
+{
+	// chunks hold whole lines of whole groups, so that encoding them independently matches encoding the entire stream at once
+	size_t groupsPerLine = ( charsPerLine > 0 ) ? charsPerLine / 4 : 0;
+	size_t chunkSize = 3 * 16384;
+	if( groupsPerLine )
+		chunkSize = std::max<size_t>( 1, chunkSize / ( groupsPerLine * 3 ) ) * groupsPerLine * 3;
+
+	std::vector<uint8_t> inBuffer( chunkSize );
+	std::vector<char> outBuffer( calcBase64EncodedSize( chunkSize, charsPerLine ) );
+	while( ! input->isEof() ) {
+		size_t filled = 0;
+		while( filled < chunkSize && ! input->isEof() )
+			filled += input->readDataAvailable( &inBuffer[filled], chunkSize - filled );
+		if( filled == 0 )
+			break;
+		size_t encoded = encodeBase64( &inBuffer[0], filled, &outBuffer[0], charsPerLine );
+		output->writeData( &outBuffer[0], encoded );
+	}
+}
+
+void fromBase64( const IStreamRef &input, const OStreamRef &output )
+{
+	const size_t chunkSize = 65536;
+	std::vector<char> inBuffer( chunkSize );
+	// up to three characters of a partial group may carry over from the previous chunk
+	std::vector<uint8_t> outBuffer( calcBase64DecodedMaxSize( chunkSize + 3 ) );
+
+	base64_decodestate decs;
+	base64_init_decodestate( &decs );
+	while( ! input->isEof() ) {
+		size_t filled = input->readDataAvailable( &inBuffer[0], chunkSize );
+		if( filled == 0 )
+			break;
+		size_t decoded = decodeChunk( &inBuffer[0], filled, &outBuffer[0], &decs );
+		if( decoded )
+			output->writeData( &outBuffer[0], decoded );
+	}
+}
 
 } // namespace cinder
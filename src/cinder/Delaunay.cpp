@@ -0,0 +1,910 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/Delaunay.h"
+#include "cinder/Rand.h"
+
+#include <algorithm>
+#include <float.h>
+#include <limits>
+
+using std::vector;
+
+namespace cinder {
+
+namespace {
+
+// Stands in for the vertex at infinity which the ghost triangles outside each edge of the convex hull share
+const uint32_t	GHOST = 0xFFFFFFFF;
+const uint32_t	NONE = 0xFFFFFFFF;
+const int32_t	UNCONSTRAINED = std::numeric_limits<int32_t>::min();
+// the insertion order is made of rounds which each double the number of points, down to a first round of at least this many
+const size_t	MIN_ROUND_SIZE = 64;
+const uint32_t	MAX_ROUNDS = 32;
+// the Hilbert curve's grid is small enough that the round and the index along it fit in 32 bits
+const uint32_t	HILBERT_BITS = 13;
+const uint32_t	HILBERT_SIZE = 1 << HILBERT_BITS;
+
+// Error bounds on the fast predicates, from Shewchuk's "Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates"
+const double	EPSILON = DBL_EPSILON / 2;
+const double	ORIENT_ERROR_BOUND = ( 3 + 16 * EPSILON ) * EPSILON;
+const double	INCIRCLE_ERROR_BOUND = ( 10 + 96 * EPSILON ) * EPSILON;
+
+// Exact arithmetic on expansions, sums of doubles which don't overlap, in order of increasing magnitude
+
+inline void twoSum( double a, double b, double *x, double *y )
+{
+	*x = a + b;
+	const double bVirtual = *x - a, aVirtual = *x - bVirtual;
+	*y = ( a - aVirtual ) + ( b - bVirtual );
+}
+
+inline void split( double a, double *hi, double *lo )
+{
+	const double c = 134217729.0 * a; // 2^27 + 1
+	const double big = c - a;
+	*hi = c - big;
+	*lo = a - *hi;
+}
+
+inline void twoProduct( double a, double b, double *x, double *y )
+{
+	*x = a * b;
+	double aHi, aLo, bHi, bLo;
+	split( a, &aHi, &aLo );
+	split( b, &bHi, &bLo );
+	const double err1 = *x - aHi * bHi;
+	const double err2 = err1 - aLo * bHi;
+	const double err3 = err2 - aHi * bLo;
+	*y = aLo * bLo - err3;
+}
+
+//! Adds \a b to the expansion \a e in place, returning its new length
+int growExpansion( int eLength, double *e, double b )
+{
+	int length = 0;
+	double q = b;
+	for( int i = 0; i < eLength; ++i ) {
+		double sum, error;
+		twoSum( q, e[i], &sum, &error );
+		q = sum;
+		if( error != 0 )
+			e[length++] = error;
+	}
+	if( q != 0 || length == 0 )
+		e[length++] = q;
+	return length;
+}
+
+//! Adds the expansion \a f to the expansion \a e in place, returning its new length
+int addExpansion( int eLength, double *e, int fLength, const double *f )
+{
+	for( int i = 0; i < fLength; ++i )
+		eLength = growExpansion( eLength, e, f[i] );
+	return eLength;
+}
+
+//! Stores \a e times \a b in \a h, returning its length, which is at most twice that of \a e
+int scaleExpansion( int eLength, const double *e, double b, double *h )
+{
+	int length = 0;
+	double q, error;
+	twoProduct( e[0], b, &q, &error );
+	if( error != 0 )
+		h[length++] = error;
+	for( int i = 1; i < eLength; ++i ) {
+		double product, productError, sum;
+		twoProduct( e[i], b, &product, &productError );
+		twoSum( q, productError, &sum, &error );
+		if( error != 0 )
+			h[length++] = error;
+		q = product + sum;
+		error = sum - ( q - product );
+		if( error != 0 )
+			h[length++] = error;
+	}
+	if( q != 0 || length == 0 )
+		h[length++] = q;
+	return length;
+}
+
+//! Stores the orientation of \a a, \a b and \a c exactly in \a h, returning its length. The products of floats are exact in double precision.
+int orientExact( const Vec2f &a, const Vec2f &b, const Vec2f &c, double *h )
+{
+	const double terms[6] = { (double)a.x * b.y, -(double)a.y * b.x, (double)b.x * c.y, -(double)b.y * c.x, (double)c.x * a.y, -(double)c.y * a.x };
+	int length = 0;
+	for( int i = 0; i < 6; ++i )
+		length = growExpansion( length, h, terms[i] );
+	return length;
+}
+
+//! Adds \a sign times the squared length of \a lifted times the orientation of \a a, \a b and \a c to the expansion \a e in place, returning its new length
+int addLiftedOrient( int eLength, double *e, const Vec2f &lifted, const Vec2f &a, const Vec2f &b, const Vec2f &c, double sign )
+{
+	double orient[6], lift[2], scaled0[12], scaled1[12];
+	const int orientLength = orientExact( a, b, c, orient );
+	twoSum( (double)lifted.x * lifted.x, (double)lifted.y * lifted.y, &lift[1], &lift[0] );
+	const int length0 = scaleExpansion( orientLength, orient, sign * lift[0], scaled0 );
+	const int length1 = scaleExpansion( orientLength, orient, sign * lift[1], scaled1 );
+	eLength = addExpansion( eLength, e, length0, scaled0 );
+	return addExpansion( eLength, e, length1, scaled1 );
+}
+
+//! Positive when \a c lies to the left of the line from \a a to \a b, negative to its right and zero when the three are collinear
+double orient( const Vec2f &a, const Vec2f &b, const Vec2f &c )
+{
+	const double left = ( (double)a.x - c.x ) * ( (double)b.y - c.y );
+	const double right = ( (double)a.y - c.y ) * ( (double)b.x - c.x );
+	const double det = left - right;
+	const double errorBound = ORIENT_ERROR_BOUND * ( math<double>::abs( left ) + math<double>::abs( right ) );
+	if( det > errorBound || -det > errorBound )
+		return det;
+
+	double exact[6];
+	return exact[orientExact( a, b, c, exact ) - 1];
+}
+
+//! Positive when \a d lies inside the circle through \a a, \a b and \a c in counterclockwise order, negative outside and zero on it
+double incircle( const Vec2f &a, const Vec2f &b, const Vec2f &c, const Vec2f &d )
+{
+	const double adx = (double)a.x - d.x, ady = (double)a.y - d.y;
+	const double bdx = (double)b.x - d.x, bdy = (double)b.y - d.y;
+	const double cdx = (double)c.x - d.x, cdy = (double)c.y - d.y;
+	const double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy, aLift = adx * adx + ady * ady;
+	const double cdxady = cdx * ady, adxcdy = adx * cdy, bLift = bdx * bdx + bdy * bdy;
+	const double adxbdy = adx * bdy, bdxady = bdx * ady, cLift = cdx * cdx + cdy * cdy;
+	const double det = aLift * ( bdxcdy - cdxbdy ) + bLift * ( cdxady - adxcdy ) + cLift * ( adxbdy - bdxady );
+	const double permanent = ( math<double>::abs( bdxcdy ) + math<double>::abs( cdxbdy ) ) * aLift
+		+ ( math<double>::abs( cdxady ) + math<double>::abs( adxcdy ) ) * bLift
+		+ ( math<double>::abs( adxbdy ) + math<double>::abs( bdxady ) ) * cLift;
+	const double errorBound = INCIRCLE_ERROR_BOUND * permanent;
+	if( det > errorBound || -det > errorBound )
+		return det;
+
+	// expand the 4x4 determinant along the column of squared lengths
+	double exact[96];
+	int length = 0;
+	length = addLiftedOrient( length, exact, a, b, c, d, 1 );
+	length = addLiftedOrient( length, exact, b, a, c, d, -1 );
+	length = addLiftedOrient( length, exact, c, a, b, d, 1 );
+	length = addLiftedOrient( length, exact, d, a, b, c, -1 );
+	return exact[length - 1];
+}
+
+//! Returns whether \a p, which is collinear with \a a and \a b, lies strictly between them
+bool isBetween( const Vec2f &a, const Vec2f &b, const Vec2f &p )
+{
+	if( a.x != b.x )
+		return ( a.x < p.x && p.x < b.x ) || ( b.x < p.x && p.x < a.x );
+	return ( a.y < p.y && p.y < b.y ) || ( b.y < p.y && p.y < a.y );
+}
+
+//! Returns whether \a p, which is collinear with \a a and \a b, lies on the same side of \a a as \a b
+bool isAhead( const Vec2f &a, const Vec2f &b, const Vec2f &p )
+{
+	if( a.x != b.x )
+		return ( a.x < b.x ) ? ( a.x < p.x ) : ( p.x < a.x );
+	return ( a.y < b.y ) ? ( a.y < p.y ) : ( p.y < a.y );
+}
+
+//! Spreads the lower 16 bits of \a x out to the even bits of the result
+uint32_t interleave( uint32_t x )
+{
+	x = ( x | ( x << 8 ) ) & 0x00FF00FF;
+	x = ( x | ( x << 4 ) ) & 0x0F0F0F0F;
+	x = ( x | ( x << 2 ) ) & 0x33333333;
+	return ( x | ( x << 1 ) ) & 0x55555555;
+}
+
+/* Returns the distance along the Hilbert curve through a grid of \c HILBERT_SIZE squared cells to the cell at \a x, \a y.
+   Rather than following the curve down one level at a time, which branches unpredictably at each, the rotations of every
+   level are combined with a parallel prefix scan over the bits of both coordinates at once. */
+uint32_t calcHilbertIndex( uint32_t x, uint32_t y )
+{
+	x <<= 16 - HILBERT_BITS;
+	y <<= 16 - HILBERT_BITS;
+	uint32_t a = x ^ y, b = 0xFFFF ^ a, c = 0xFFFF ^ ( x | y ), d = x & ( y ^ 0xFFFF );
+	uint32_t A = a | ( b >> 1 ), B = ( a >> 1 ) ^ a, C = ( ( c >> 1 ) ^ ( b & ( d >> 1 ) ) ) ^ c, D = ( ( a & ( c >> 1 ) ) ^ ( d >> 1 ) ) ^ d;
+	for( int shift = 2; shift <= 8; shift *= 2 ) {
+		a = A; b = B; c = C; d = D;
+		A = ( a & ( a >> shift ) ) ^ ( b & ( b >> shift ) );
+		B = ( a & ( b >> shift ) ) ^ ( b & ( ( a ^ b ) >> shift ) );
+		C ^= ( a & ( c >> shift ) ) ^ ( b & ( d >> shift ) );
+		D ^= ( b & ( c >> shift ) ) ^ ( ( a ^ b ) & ( d >> shift ) );
+	}
+	a = C ^ ( C >> 1 );
+	b = D ^ ( D >> 1 );
+	const uint32_t low = x ^ y, high = b | ( 0xFFFF ^ ( low | a ) );
+	return ( ( interleave( high ) << 1 ) | interleave( low ) ) >> ( 32 - 2 * HILBERT_BITS );
+}
+
+bool isInside( int winding, Triangulator::Winding rule )
+{
+	switch( rule ) {
+		case Triangulator::WINDING_ODD: return ( winding & 1 ) != 0;
+		case Triangulator::WINDING_NONZERO: return winding != 0;
+		case Triangulator::WINDING_POSITIVE: return winding > 0;
+		case Triangulator::WINDING_NEGATIVE: return winding < 0;
+		default: return winding >= 2 || winding <= -2;
+	}
+}
+
+//! Sorts \a keys by their upper 32 bits, keeping the order of equal keys, using \a scratch as space for a copy
+void radixSort( vector<uint64_t> *keys, vector<uint64_t> *scratch )
+{
+	const int DIGIT_BITS = 11, NUM_BUCKETS = 1 << DIGIT_BITS;
+	scratch->resize( keys->size() );
+	vector<size_t> offsets( NUM_BUCKETS );
+	for( int shift = 32; shift < 64; shift += DIGIT_BITS ) {
+		std::fill( offsets.begin(), offsets.end(), 0 );
+		for( size_t k = 0; k < keys->size(); ++k )
+			++offsets[( (*keys)[k] >> shift ) & ( NUM_BUCKETS - 1 )];
+		size_t sum = 0;
+		for( int b = 0; b < NUM_BUCKETS; ++b ) {
+			const size_t count = offsets[b];
+			offsets[b] = sum;
+			sum += count;
+		}
+		for( size_t k = 0; k < keys->size(); ++k )
+			(*scratch)[offsets[( (*keys)[k] >> shift ) & ( NUM_BUCKETS - 1 )]++] = (*keys)[k];
+		keys->swap( *scratch );
+	}
+}
+
+// Biased randomized insertion order: each point is assigned at random to one of a series of rounds which each double the
+// number of points inserted so far, which avoids the worst cases of any fixed order, and each round follows a Hilbert
+// curve so that consecutive points are close together. Alternate rounds run backwards so that each one starts near where
+// the last one ended. A single sort by round and then Hilbert index puts the points in order.
+void calcInsertionOrder( const vector<Vec2f> &points, vector<uint32_t> *result )
+{
+	const size_t numPoints = points.size();
+	Vec2f minCorner = points[0], maxCorner = points[0];
+	for( size_t p = 1; p < numPoints; ++p ) {
+		minCorner.x = std::min( minCorner.x, points[p].x ); minCorner.y = std::min( minCorner.y, points[p].y );
+		maxCorner.x = std::max( maxCorner.x, points[p].x ); maxCorner.y = std::max( maxCorner.y, points[p].y );
+	}
+	const double extent = std::max( (double)maxCorner.x - minCorner.x, (double)maxCorner.y - minCorner.y );
+	const double scale = ( extent > 0 ) ? ( HILBERT_SIZE - 1 ) / extent : 0;
+
+	uint32_t lastRound = 0;
+	while( lastRound < MAX_ROUNDS - 1 && ( numPoints >> ( lastRound + 1 ) ) >= MIN_ROUND_SIZE )
+		++lastRound;
+
+	// a point is in the last round with probability 1/2, the one before with 1/4 and so on, with the rest in the first
+	vector<uint64_t> keys( numPoints ), scratch;
+	Rand rand( 1 );
+	for( size_t p = 0; p < numPoints; ++p ) {
+		uint32_t bits = rand.nextUint(), round = lastRound;
+		while( round > 0 && ( bits & 1 ) ) {
+			bits >>= 1;
+			--round;
+		}
+		uint32_t key = calcHilbertIndex( (uint32_t)( ( points[p].x - minCorner.x ) * scale ), (uint32_t)( ( points[p].y - minCorner.y ) * scale ) );
+		if( ( lastRound - round ) % 2 )
+			key = HILBERT_SIZE * HILBERT_SIZE - 1 - key;
+		keys[p] = ( (uint64_t)( round * HILBERT_SIZE * HILBERT_SIZE + key ) << 32 ) | p;
+	}
+	radixSort( &keys, &scratch );
+
+	result->resize( numPoints );
+	for( size_t p = 0; p < numPoints; ++p )
+		(*result)[p] = (uint32_t)keys[p];
+}
+
+inline uint32_t nextEdge( uint32_t e ) { return ( e % 3 == 2 ) ? e - 2 : e + 1; }
+inline uint32_t prevEdge( uint32_t e ) { return ( e % 3 == 0 ) ? e + 2 : e - 1; }
+inline uint64_t makeEdgeKey( uint32_t from, uint32_t to ) { return ( (uint64_t)from << 32 ) | to; }
+
+/* A triangulation stored as counterclockwise triangles of three half-edges each, where half-edge e runs from vertex
+   mVertices[e] to the start of the next half-edge of its triangle and mTwins[e] is the half-edge running the other way.
+   Each edge of the convex hull is shared with a ghost triangle whose third vertex is GHOST, so that every half-edge has
+   a twin and points outside the hull are inserted the same way as points inside it. */
+class Triangulation {
+  public:
+	Triangulation( const vector<Vec2f> &points )
+		: mPoints( points.size() ), mCanonical( points.size() ), mVertexTriangles( points.size(), NONE ), mGhostTriangle( NONE ), mHint( NONE ), mNumTriangles( 0 ), mEpoch( 0 ), mRandom( 1 )
+	{
+		if( points.empty() )
+			return;
+		calcInsertionOrder( points, &mOriginals );
+		for( uint32_t p = 0; p < points.size(); ++p ) {
+			mPoints[p] = points[mOriginals[p]];
+			mCanonical[p] = p;
+		}
+	}
+
+	//! Inserts every point, returning false if they are all collinear
+	bool	insertPoints();
+	//! Makes each pair of \a outlineEdges an edge of the triangulation, adding points where they cross
+	void	insertOutlineEdges( const vector<uint32_t> &outlineEdges );
+	void	calcMesh( Triangulator::Winding winding, TriMesh2d *result ) const;
+
+  private:
+	struct BoundaryEdge {
+		uint32_t	mFrom, mTo, mTwin;
+		int32_t		mConstraint;
+	};
+
+	struct Segment {
+		uint32_t	mFrom, mTo;
+		int32_t		mWinding;
+	};
+
+	struct Polygon {
+		uint32_t	mFrom, mTo;
+		size_t		mBegin, mEnd;
+	};
+
+	typedef std::pair<uint64_t, uint32_t>	KeyedEdge;
+
+	bool		isGhost( uint32_t t ) const { return mVertices[3 * t] == GHOST || mVertices[3 * t + 1] == GHOST || mVertices[3 * t + 2] == GHOST; }
+	//! Returns the half-edge of ghost triangle \a t along the convex hull
+	uint32_t	getHullEdge( uint32_t t ) const
+	{
+		for( uint32_t i = 0; i < 3; ++i )
+			if( mVertices[3 * t + i] == GHOST )
+				return 3 * t + ( i + 1 ) % 3;
+		return NONE;
+	}
+	bool		isConstrained( uint32_t e ) const { return ! mConstraints.empty() && mConstraints[e] != UNCONSTRAINED; }
+	uint32_t&	vertexTriangle( uint32_t v ) { return ( v == GHOST ) ? mGhostTriangle : mVertexTriangles[v]; }
+	//! Appends the vertices of triangle \a t to \a indices, numbered as the points were passed in
+	void		appendIndices( uint32_t t, vector<uint32_t> *indices ) const
+	{
+		for( uint32_t e = 3 * t; e < 3 * t + 3; ++e )
+			indices->push_back( mOriginals[mVertices[e]] );
+	}
+
+	uint32_t	appendTriangle();
+	void		setTriangle( uint32_t t, uint32_t v0, uint32_t v1, uint32_t v2 );
+	void		link( uint32_t e0, uint32_t e1 ) { mTwins[e0] = e1; mTwins[e1] = e0; }
+	void		addConstraint( uint32_t e, int32_t winding );
+	bool		createFirstTriangle();
+	uint32_t	locate( const Vec2f &p );
+	bool		isInCircumcircle( uint32_t t, const Vec2f &p ) const;
+	uint32_t	insertPoint( uint32_t point );
+	void		insertSegment( Segment segment );
+	void		splitSegments( const Segment &segment, uint32_t crossing );
+	void		triangulatePolygon( uint32_t from, uint32_t to, const vector<uint32_t> &chain );
+
+	//! The points in insertion order, so that the vertices each insertion touches are close together in memory
+	vector<Vec2f>			mPoints;
+	//! The index each of mPoints had in the points passed in, or its own for points added where outlines cross
+	vector<uint32_t>		mOriginals;
+	//! The vertex each point became, which is an earlier point for duplicates
+	vector<uint32_t>		mCanonical;
+	vector<uint32_t>		mVertices, mTwins;
+	//! The winding of the outline edges along each half-edge, if any have been inserted, or UNCONSTRAINED where there are none
+	vector<int32_t>			mConstraints;
+	//! Marks triangles visited by the current insertion with mEpoch, or those rejected with mEpoch + 1
+	vector<uint32_t>		mMarks;
+	//! Scratch space mapping vertices to the new triangles whose first half-edge leaves them
+	vector<uint32_t>		mVertexTriangles;
+	uint32_t				mGhostTriangle, mHint, mNumTriangles, mEpoch, mRandom;
+
+	vector<uint32_t>		mCavity, mNewTriangles, mLeftChain, mRightChain, mPolygonTriangles;
+	vector<BoundaryEdge>	mBoundary;
+	vector<Polygon>			mPolygons;
+	vector<KeyedEdge>		mOuterEdges, mNewEdges;
+	//! The twin and winding of each of mOuterEdges, which have to survive their triangles being overwritten
+	vector<std::pair<uint32_t, int32_t> >	mOuterTwins;
+	vector<Segment>			mSegments;
+};
+
+uint32_t Triangulation::appendTriangle()
+{
+	if( mNumTriangles == mMarks.size() ) {
+		mMarks.resize( mNumTriangles * 2 + 4, 0 );
+		mVertices.resize( mMarks.size() * 3 );
+		mTwins.resize( mMarks.size() * 3 );
+		if( ! mConstraints.empty() )
+			mConstraints.resize( mMarks.size() * 3, UNCONSTRAINED );
+	}
+	return mNumTriangles++;
+}
+
+void Triangulation::setTriangle( uint32_t t, uint32_t v0, uint32_t v1, uint32_t v2 )
+{
+	mVertices[3 * t] = v0;
+	mVertices[3 * t + 1] = v1;
+	mVertices[3 * t + 2] = v2;
+	if( ! mConstraints.empty() )
+		mConstraints[3 * t] = mConstraints[3 * t + 1] = mConstraints[3 * t + 2] = UNCONSTRAINED;
+}
+
+void Triangulation::addConstraint( uint32_t e, int32_t winding )
+{
+	const int32_t total = ( mConstraints[e] == UNCONSTRAINED ) ? winding : mConstraints[e] + winding;
+	mConstraints[e] = total;
+	mConstraints[mTwins[e]] = -total;
+}
+
+bool Triangulation::createFirstTriangle()
+{
+	const uint32_t numPoints = (uint32_t)mPoints.size();
+	uint32_t b = 1;
+	while( b < numPoints && mPoints[b] == mPoints[0] )
+		++b;
+	if( b == numPoints )
+		return false;
+	uint32_t c = b + 1;
+	while( c < numPoints && orient( mPoints[0], mPoints[b], mPoints[c] ) == 0 )
+		++c;
+	if( c == numPoints )
+		return false;
+
+	uint32_t v[3] = { 0, b, c };
+	if( orient( mPoints[v[0]], mPoints[v[1]], mPoints[v[2]] ) < 0 )
+		std::swap( v[1], v[2] );
+	setTriangle( appendTriangle(), v[0], v[1], v[2] );
+	for( uint32_t i = 0; i < 3; ++i ) {
+		const uint32_t ghost = appendTriangle();
+		setTriangle( ghost, v[( i + 1 ) % 3], v[i], GHOST );
+		link( 3 * ghost, i );
+	}
+	// the ghost outside edge i leaves vertex i towards the ghost vertex, which the previous ghost arrives from
+	for( uint32_t i = 0; i < 3; ++i )
+		link( 3 * ( 1 + i ) + 1, 3 * ( 1 + ( i + 2 ) % 3 ) + 2 );
+	mHint = 0;
+	return true;
+}
+
+// A visibility walk, which testing the edges in a random order keeps from cycling. Returns a triangle whose closure
+// contains p, or a ghost triangle whose hull edge p lies strictly outside of.
+uint32_t Triangulation::locate( const Vec2f &p )
+{
+	uint32_t t = mHint;
+	if( isGhost( t ) )
+		t = mTwins[getHullEdge( t )] / 3;
+	for( ; ; ) {
+		if( isGhost( t ) )
+			return t;
+		mRandom = mRandom * 1103515245 + 12345;
+		const uint32_t start = ( mRandom >> 16 ) % 3;
+		uint32_t i = 0;
+		for( ; i < 3; ++i ) {
+			const uint32_t e = 3 * t + ( start + i ) % 3;
+			if( orient( mPoints[mVertices[e]], mPoints[mVertices[nextEdge( e )]], p ) < 0 ) {
+				t = mTwins[e] / 3;
+				break;
+			}
+		}
+		if( i == 3 )
+			return t;
+	}
+}
+
+// The circumcircle of a ghost triangle is the open half-plane outside its hull edge, along with the open edge itself
+bool Triangulation::isInCircumcircle( uint32_t t, const Vec2f &p ) const
+{
+	if( isGhost( t ) ) {
+		const uint32_t e = getHullEdge( t );
+		const Vec2f &a = mPoints[mVertices[e]], &b = mPoints[mVertices[nextEdge( e )]];
+		const double o = orient( a, b, p );
+		return o > 0 || ( o == 0 && isBetween( a, b, p ) );
+	}
+	return incircle( mPoints[mVertices[3 * t]], mPoints[mVertices[3 * t + 1]], mPoints[mVertices[3 * t + 2]], p ) > 0;
+}
+
+// Bowyer-Watson insertion: removes the triangles whose circumcircles contain the point and which it can see past the
+// outline edges, and connects the point to the boundary of the cavity they leave. Returns the vertex the point became.
+uint32_t Triangulation::insertPoint( uint32_t point )
+{
+	const Vec2f &p = mPoints[point];
+	const uint32_t seed = locate( p );
+
+	// a point on an outline edge splits it, and so may remove the triangles on both of its sides
+	uint32_t splitEdge = NONE, splitFrom = NONE, splitTo = NONE;
+	int32_t splitWinding = 0;
+	if( ! isGhost( seed ) ) {
+		for( uint32_t e = 3 * seed; e < 3 * seed + 3; ++e ) {
+			if( mPoints[mVertices[e]] == p )
+				return mVertices[e];
+			if( isConstrained( e ) && orient( mPoints[mVertices[e]], mPoints[mVertices[nextEdge( e )]], p ) == 0 ) {
+				splitEdge = e;
+				splitFrom = mVertices[e];
+				splitTo = mVertices[nextEdge( e )];
+				splitWinding = mConstraints[e];
+			}
+		}
+	}
+
+	mEpoch += 2;
+	mCavity.clear();
+	mBoundary.clear();
+	mMarks[seed] = mEpoch;
+	mCavity.push_back( seed );
+	for( size_t c = 0; c < mCavity.size(); ++c ) {
+		for( uint32_t e = 3 * mCavity[c]; e < 3 * mCavity[c] + 3; ++e ) {
+			const uint32_t twin = mTwins[e], neighbor = twin / 3;
+			if( mMarks[neighbor] == mEpoch )
+				continue;
+			bool inCavity = false;
+			if( mMarks[neighbor] != mEpoch + 1 && ( ! isConstrained( e ) || e == splitEdge || twin == splitEdge ) ) {
+				inCavity = isInCircumcircle( neighbor, p );
+				mMarks[neighbor] = inCavity ? mEpoch : mEpoch + 1;
+			}
+			if( inCavity )
+				mCavity.push_back( neighbor );
+			else {
+				BoundaryEdge edge = { mVertices[e], mVertices[nextEdge( e )], twin, mConstraints.empty() ? UNCONSTRAINED : mConstraints[e] };
+				mBoundary.push_back( edge );
+			}
+		}
+	}
+
+	// the new triangles reuse the slots of the cavity's, which are two fewer
+	mNewTriangles.clear();
+	for( size_t b = 0; b < mBoundary.size(); ++b ) {
+		const BoundaryEdge &edge = mBoundary[b];
+		const uint32_t t = ( b < mCavity.size() ) ? mCavity[b] : appendTriangle();
+		setTriangle( t, edge.mFrom, edge.mTo, point );
+		link( 3 * t, edge.mTwin );
+		if( ! mConstraints.empty() )
+			mConstraints[3 * t] = edge.mConstraint;
+		vertexTriangle( edge.mFrom ) = t;
+		mNewTriangles.push_back( t );
+	}
+	for( size_t n = 0; n < mNewTriangles.size(); ++n ) {
+		const uint32_t t = mNewTriangles[n];
+		link( 3 * t + 1, 3 * vertexTriangle( mVertices[3 * t + 1] ) + 2 );
+	}
+
+	if( splitEdge != NONE ) {
+		for( size_t n = 0; n < mNewTriangles.size(); ++n ) {
+			const uint32_t t = mNewTriangles[n];
+			if( mVertices[3 * t] == splitTo )
+				addConstraint( 3 * t + 2, splitWinding );
+			else if( mVertices[3 * t] == splitFrom )
+				addConstraint( 3 * t + 2, -splitWinding );
+		}
+	}
+
+	mHint = mNewTriangles.back();
+	return point;
+}
+
+bool Triangulation::insertPoints()
+{
+	if( mPoints.size() < 3 )
+		return false;
+	// n distinct vertices make exactly 2n - 2 triangles, counting the ghosts
+	mMarks.resize( mPoints.size() * 2 - 2, 0 );
+	mVertices.resize( mMarks.size() * 3 );
+	mTwins.resize( mMarks.size() * 3 );
+	if( ! createFirstTriangle() )
+		return false;
+
+	for( uint32_t p = 1; p < mPoints.size(); ++p )
+		if( p != mVertices[0] && p != mVertices[1] && p != mVertices[2] )
+			mCanonical[p] = insertPoint( p );
+	return true;
+}
+
+void Triangulation::insertOutlineEdges( const vector<uint32_t> &outlineEdges )
+{
+	vector<uint32_t> vertices( mOriginals.size() );
+	for( uint32_t p = 0; p < mOriginals.size(); ++p )
+		vertices[mOriginals[p]] = mCanonical[p];
+
+	mConstraints.assign( mTwins.size(), UNCONSTRAINED );
+	for( size_t e = outlineEdges.size(); e > 0; e -= 2 ) {
+		Segment segment = { vertices[outlineEdges[e - 2]], vertices[outlineEdges[e - 1]], 1 };
+		mSegments.push_back( segment );
+	}
+	while( ! mSegments.empty() ) {
+		const Segment segment = mSegments.back();
+		mSegments.pop_back();
+		insertSegment( segment );
+	}
+}
+
+// Makes the segment an edge of the triangulation. When it passes through vertices it is split at them; otherwise the
+// triangles it crosses are removed, and the polygons on either side of it are retriangulated, which keeps the rest of
+// the triangulation constrained Delaunay.
+void Triangulation::insertSegment( Segment segment )
+{
+	const uint32_t a = segment.mFrom;
+	uint32_t b = segment.mTo;
+	if( a == b )
+		return;
+	const Vec2f &pa = mPoints[a], &pb = mPoints[b];
+
+	// find the triangle around a which the segment leaves through
+	mHint = locate( pa );
+	uint32_t first = 3 * mHint;
+	while( mVertices[first] != a )
+		++first;
+	uint32_t crossing = NONE;
+	for( uint32_t e = first; ; ) {
+		if( ! isGhost( e / 3 ) ) {
+			const uint32_t u = mVertices[nextEdge( e )], w = mVertices[prevEdge( e )];
+			if( u == b ) {
+				addConstraint( e, segment.mWinding );
+				return;
+			}
+			if( w == b ) {
+				addConstraint( prevEdge( e ), -segment.mWinding );
+				return;
+			}
+			const double orientU = orient( pa, pb, mPoints[u] ), orientW = orient( pa, pb, mPoints[w] );
+			const uint32_t through = ( orientU == 0 && isAhead( pa, pb, mPoints[u] ) ) ? u : ( ( orientW == 0 && isAhead( pa, pb, mPoints[w] ) ) ? w : NONE );
+			if( through != NONE ) {
+				Segment second = { through, b, segment.mWinding }, firstPart = { a, through, segment.mWinding };
+				mSegments.push_back( second );
+				mSegments.push_back( firstPart );
+				return;
+			}
+			if( orientU < 0 && orientW > 0 ) {
+				crossing = nextEdge( e );
+				break;
+			}
+		}
+		e = mTwins[prevEdge( e )];
+		if( e == first )
+			return;
+	}
+
+	// walk along the segment collecting the triangles it crosses, and the vertices to its left and right
+	mCavity.clear();
+	mLeftChain.clear();
+	mRightChain.clear();
+	mCavity.push_back( crossing / 3 );
+	mRightChain.push_back( mVertices[crossing] );
+	mLeftChain.push_back( mVertices[nextEdge( crossing )] );
+	for( ; ; ) {
+		if( isConstrained( crossing ) ) {
+			splitSegments( segment, crossing );
+			return;
+		}
+		const uint32_t twin = mTwins[crossing];
+		const uint32_t x = mVertices[prevEdge( twin )];
+		mCavity.push_back( twin / 3 );
+		if( x == b )
+			break;
+		const double side = orient( pa, pb, mPoints[x] );
+		if( side == 0 ) {
+			// the segment passes through x, so finish at x and carry on from it afterwards
+			Segment rest = { x, b, segment.mWinding };
+			mSegments.push_back( rest );
+			b = x;
+			break;
+		}
+		if( side > 0 ) {
+			mLeftChain.push_back( x );
+			crossing = nextEdge( twin );
+		}
+		else {
+			mRightChain.push_back( x );
+			crossing = prevEdge( twin );
+		}
+	}
+
+	mEpoch += 2;
+	mOuterEdges.clear();
+	for( size_t c = 0; c < mCavity.size(); ++c )
+		mMarks[mCavity[c]] = mEpoch;
+	for( size_t c = 0; c < mCavity.size(); ++c )
+		for( uint32_t e = 3 * mCavity[c]; e < 3 * mCavity[c] + 3; ++e )
+			if( mMarks[mTwins[e] / 3] != mEpoch )
+				mOuterEdges.push_back( KeyedEdge( makeEdgeKey( mVertices[e], mVertices[nextEdge( e )] ), e ) );
+	mOuterTwins.resize( mOuterEdges.size() );
+	for( size_t o = 0; o < mOuterEdges.size(); ++o ) {
+		mOuterTwins[o] = std::make_pair( mTwins[mOuterEdges[o].second], mConstraints[mOuterEdges[o].second] );
+		mOuterEdges[o].second = (uint32_t)o;
+	}
+	std::sort( mOuterEdges.begin(), mOuterEdges.end() );
+
+	mPolygonTriangles.clear();
+	triangulatePolygon( a, b, mLeftChain );
+	std::reverse( mRightChain.begin(), mRightChain.end() );
+	triangulatePolygon( b, a, mRightChain );
+
+	mNewEdges.clear();
+	for( size_t n = 0; n < mCavity.size(); ++n ) {
+		const uint32_t t = mCavity[n];
+		setTriangle( t, mPolygonTriangles[3 * n], mPolygonTriangles[3 * n + 1], mPolygonTriangles[3 * n + 2] );
+		for( uint32_t e = 3 * t; e < 3 * t + 3; ++e )
+			mNewEdges.push_back( KeyedEdge( makeEdgeKey( mVertices[e], mVertices[nextEdge( e )] ), e ) );
+	}
+	std::sort( mNewEdges.begin(), mNewEdges.end() );
+	for( size_t n = 0; n < mNewEdges.size(); ++n ) {
+		const uint32_t e = mNewEdges[n].second;
+		const uint32_t from = mVertices[e], to = mVertices[nextEdge( e )];
+		vector<KeyedEdge>::const_iterator twin = std::lower_bound( mNewEdges.begin(), mNewEdges.end(), KeyedEdge( makeEdgeKey( to, from ), 0 ) );
+		if( twin != mNewEdges.end() && twin->first == makeEdgeKey( to, from ) )
+			mTwins[e] = twin->second;
+		else {
+			vector<KeyedEdge>::const_iterator outerEdge = std::lower_bound( mOuterEdges.begin(), mOuterEdges.end(), KeyedEdge( mNewEdges[n].first, 0 ) );
+			link( e, mOuterTwins[outerEdge->second].first );
+			mConstraints[e] = mOuterTwins[outerEdge->second].second;
+		}
+	}
+
+	// the first triangle of the left polygon starts with the segment
+	addConstraint( 3 * mCavity[0], segment.mWinding );
+	mHint = mCavity[0];
+}
+
+// Anglada's algorithm: the vertex of the chain whose circle with the edge from \a from to \a to contains no others forms a
+// triangle with it, and the parts of the chain on either side of that vertex are triangulated against its other edges
+void Triangulation::triangulatePolygon( uint32_t from, uint32_t to, const vector<uint32_t> &chain )
+{
+	mPolygons.clear();
+	Polygon whole = { from, to, 0, chain.size() };
+	mPolygons.push_back( whole );
+	while( ! mPolygons.empty() ) {
+		const Polygon polygon = mPolygons.back();
+		mPolygons.pop_back();
+		if( polygon.mBegin == polygon.mEnd )
+			continue;
+		size_t c = polygon.mBegin;
+		for( size_t i = polygon.mBegin + 1; i < polygon.mEnd; ++i )
+			if( incircle( mPoints[polygon.mFrom], mPoints[polygon.mTo], mPoints[chain[c]], mPoints[chain[i]] ) > 0 )
+				c = i;
+		mPolygonTriangles.push_back( polygon.mFrom );
+		mPolygonTriangles.push_back( polygon.mTo );
+		mPolygonTriangles.push_back( chain[c] );
+		Polygon before = { polygon.mFrom, chain[c], polygon.mBegin, c }, after = { chain[c], polygon.mTo, c + 1, polygon.mEnd };
+		mPolygons.push_back( after );
+		mPolygons.push_back( before );
+	}
+}
+
+// Splits two crossing outline edges where they meet, by adding the point where they cross and inserting the four halves
+void Triangulation::splitSegments( const Segment &segment, uint32_t crossing )
+{
+	const uint32_t u = mVertices[crossing], w = mVertices[nextEdge( crossing )];
+	const int32_t crossingWinding = mConstraints[crossing];
+	mConstraints[crossing] = mConstraints[mTwins[crossing]] = UNCONSTRAINED;
+
+	const Vec2f &a = mPoints[segment.mFrom], &b = mPoints[segment.mTo], &c = mPoints[u], &d = mPoints[w];
+	const double denominator = ( (double)b.x - a.x ) * ( (double)d.y - c.y ) - ( (double)b.y - a.y ) * ( (double)d.x - c.x );
+	const double t = ( ( (double)c.x - a.x ) * ( (double)d.y - c.y ) - ( (double)c.y - a.y ) * ( (double)d.x - c.x ) ) / denominator;
+	const uint32_t point = (uint32_t)mPoints.size();
+	mPoints.push_back( Vec2f( (float)( a.x + t * ( (double)b.x - a.x ) ), (float)( a.y + t * ( (double)b.y - a.y ) ) ) );
+	mOriginals.push_back( point );
+	mCanonical.push_back( point );
+	mVertexTriangles.push_back( NONE );
+	const uint32_t x = insertPoint( point );
+	mCanonical[point] = x;
+
+	Segment halves[4] = { { x, w, crossingWinding }, { u, x, crossingWinding }, { x, segment.mTo, segment.mWinding }, { segment.mFrom, x, segment.mWinding } };
+	mSegments.insert( mSegments.end(), halves, halves + 4 );
+}
+
+void Triangulation::calcMesh( Triangulator::Winding winding, TriMesh2d *result ) const
+{
+	vector<Vec2f> vertices( mPoints.size() );
+	for( size_t p = 0; p < mPoints.size(); ++p )
+		vertices[mOriginals[p]] = mPoints[p];
+	result->appendVertices( &vertices[0], vertices.size() );
+
+	vector<uint32_t> indices;
+	indices.reserve( mNumTriangles * 3 );
+	if( mConstraints.empty() ) {
+		for( uint32_t t = 0; t < mNumTriangles; ++t )
+			if( ! isGhost( t ) )
+				appendIndices( t, &indices );
+		result->appendIndices( &indices[0], indices.size() );
+		return;
+	}
+
+	// flood the winding numbers inwards from the ghost triangles, which are outside everything. A triangle lies to the
+	// left of its half-edges, so crossing one steps outside the outline edges running along it.
+	vector<int> windings( mNumTriangles, 0 );
+	vector<bool> visited( mNumTriangles, false );
+	vector<uint32_t> queue;
+	for( uint32_t t = 0; t < mNumTriangles; ++t ) {
+		if( isGhost( t ) ) {
+			visited[t] = true;
+			queue.push_back( t );
+		}
+	}
+	for( size_t q = 0; q < queue.size(); ++q ) {
+		const uint32_t t = queue[q];
+		for( uint32_t e = 3 * t; e < 3 * t + 3; ++e ) {
+			const uint32_t neighbor = mTwins[e] / 3;
+			if( visited[neighbor] )
+				continue;
+			visited[neighbor] = true;
+			windings[neighbor] = windings[t] - ( isConstrained( e ) ? mConstraints[e] : 0 );
+			queue.push_back( neighbor );
+		}
+	}
+	for( uint32_t t = 0; t < mNumTriangles; ++t )
+		if( ! isGhost( t ) && isInside( windings[t], winding ) )
+			appendIndices( t, &indices );
+	if( ! indices.empty() )
+		result->appendIndices( &indices[0], indices.size() );
+}
+
+} // anonymous namespace
+
+DelaunayTriangulator::DelaunayTriangulator( const std::vector<Vec2f> &points )
+	: mPoints( points )
+{
+}
+
+DelaunayTriangulator::DelaunayTriangulator( const Shape2d &shape, float approximationScale )
+{
+	addShape( shape, approximationScale );
+}
+
+DelaunayTriangulator::DelaunayTriangulator( const Path2d &path, float approximationScale )
+{
+	addPath( path, approximationScale );
+}
+
+DelaunayTriangulator::DelaunayTriangulator( const PolyLine2f &polyLine )
+{
+	addPolyLine( polyLine );
+}
+
+void DelaunayTriangulator::addPoints( const std::vector<Vec2f> &points )
+{
+	mPoints.insert( mPoints.end(), points.begin(), points.end() );
+}
+
+void DelaunayTriangulator::addShape( const Shape2d &shape, float approximationScale )
+{
+	for( size_t c = 0; c < shape.getNumContours(); ++c )
+		addPath( shape.getContour( c ), approximationScale );
+}
+
+void DelaunayTriangulator::addPath( const Path2d &path, float approximationScale )
+{
+	addOutline( path.subdivide( approximationScale ) );
+}
+
+void DelaunayTriangulator::addPolyLine( const PolyLine2f &polyLine )
+{
+	addOutline( polyLine.getPoints() );
+}
+
+void DelaunayTriangulator::addOutline( const std::vector<Vec2f> &points )
+{
+	const uint32_t first = (uint32_t)mPoints.size();
+	mPoints.insert( mPoints.end(), points.begin(), points.end() );
+	for( uint32_t p = 0; p < points.size(); ++p ) {
+		mOutlineEdges.push_back( first + p );
+		mOutlineEdges.push_back( first + ( p + 1 ) % (uint32_t)points.size() );
+	}
+}
+
+TriMesh2d DelaunayTriangulator::calcMesh( Triangulator::Winding winding ) const
+{
+	TriMesh2d result;
+	Triangulation triangulation( mPoints );
+	if( ! triangulation.insertPoints() ) {
+		result.appendVertices( mPoints.empty() ? 0 : &mPoints[0], mPoints.size() );
+		return result;
+	}
+	if( ! mOutlineEdges.empty() )
+		triangulation.insertOutlineEdges( mOutlineEdges );
+	triangulation.calcMesh( winding, &result );
+	return result;
+}
+
+} // namespace cinder
@@ -27,14 +27,77 @@
 #include "json/json.h"
 
 #include "cinder/Json.h"
+#include "cinder/JsonWriter.h"
 #include "cinder/Stream.h"
 #include "cinder/Utilities.h"
 
 #include <cstdlib>
 
+#if defined( _MSC_VER ) && ( _MSC_VER >= 1600 ) || defined( _LIBCPP_VERSION )
+	#include <unordered_map>
+	using std::unordered_map;
+#else
+	#include <boost/unordered_map.hpp>
+	using boost::unordered_map;
+#endif
+
 using namespace std;
 
 namespace cinder {
+
+namespace {
+
+inline char toLowerAscii( char c )
+{
+	return ( c >= 'A' && c <= 'Z' ) ? ( c - 'A' + 'a' ) : c;
+}
+
+bool keyMatches( const std::string &key, const JsonTree::Query::Component &component, bool caseSensitive )
+{
+	if( caseSensitive )
+		return key == component.mKey;
+	if( key.size() != component.mLowerKey.size() )
+		return false;
+	for( size_t i = 0; i < key.size(); ++i )
+		if( toLowerAscii( key[i] ) != component.mLowerKey[i] )
+			return false;
+	return true;
+}
+
+// nodes with fewer children than this are scanned rather than indexed
+const size_t CHILD_INDEX_THRESHOLD = 16;
+
+} // anonymous namespace
+
+struct JsonTree::ChildIndex {
+	vector<JsonTree*>							mByPosition;
+	// children in order, keyed by case-folded key
+	unordered_map<string, vector<JsonTree*> >	mByKey;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+JsonTree::Query::Query( const std::string &path, bool caseSensitive, char separator )
+	: mPath( path ), mCaseSensitive( caseSensitive )
+{
+	// same normalization as getChild(): "a[0]['b']" is equivalent to "a.0.b"
+	std::string normalized = boost::replace_all_copy( path, "[", std::string( 1, separator ) );
+	normalized = boost::replace_all_copy( normalized, "'", "" );
+	normalized = boost::replace_all_copy( normalized, "]", "" );
+
+	shared_ptr<vector<Component> > components( new vector<Component>() );
+	vector<string> keys = split( normalized, separator );
+	for( vector<string>::const_iterator keyIt = keys.begin(); keyIt != keys.end(); ++keyIt ) {
+		Component component;
+		component.mIsIndex = isIndex( *keyIt );
+		component.mIndex = component.mIsIndex ? strtoul( keyIt->c_str(), NULL, 10 ) : 0;
+		component.mKey = *keyIt;
+		component.mLowerKey.resize( keyIt->size() );
+		std::transform( keyIt->begin(), keyIt->end(), component.mLowerKey.begin(), toLowerAscii );
+		components->push_back( component );
+	}
+	mComponents = components;
+}
 	
 JsonTree::ParseOptions::ParseOptions() 
 : mIgnoreErrors( false ) 
@@ -101,6 +164,8 @@ JsonTree::JsonTree( const JsonTree &jsonTree )
 
 JsonTree& JsonTree::operator=( const JsonTree &jsonTree )
 {
+	if( mParent ) // our key may have changed
+		mParent->mChildIndex.reset();
 	mParent = NULL;
 	mKey = jsonTree.mKey;
 	mNodeType = jsonTree.mNodeType;
@@ -108,6 +173,7 @@ JsonTree& JsonTree::operator=( const JsonTree &jsonTree )
 	mValueType = jsonTree.mValueType;
 
 	mChildren.clear();
+	mChildIndex.reset();
 
 	for( ConstIter childIt = jsonTree.begin(); childIt != jsonTree.end(); ++childIt ) {
 		pushBack( *childIt );
@@ -286,6 +352,7 @@ Json::Value JsonTree::deserializeNative( const string &jsonString, ParseOptions
 	
 void JsonTree::clear()
 {
+	mChildIndex.reset();
 	mChildren.clear();
 }
 
@@ -297,6 +364,7 @@ void JsonTree::pushBack( const JsonTree &newChild )
 		mNodeType = NODE_OBJECT;
 	}
 
+	mChildIndex.reset();
 	mChildren.push_back( newChild );
 	mChildren.back().mParent = this;
     mValue = "";
@@ -308,6 +376,7 @@ void JsonTree::removeChild( size_t index )
 		JsonTree::Iter pos = mChildren.begin();
 		for( uint32_t i = 0; i < index; i++, ++pos ) {
 		}
+		mChildIndex.reset();
 		mChildren.erase( pos );
 	} else {
 		throw ExcChildNotFound( *this, toString( index ) );
@@ -317,6 +386,7 @@ void JsonTree::removeChild( size_t index )
 JsonTree::Iter JsonTree::removeChild( JsonTree::Iter pos )
 {
 	try {
+		mChildIndex.reset();
 		return mChildren.erase( pos );
 	} catch ( ... ) {
 		throw ExcChildNotFound( *this, pos->getPath() );
@@ -331,6 +401,7 @@ void JsonTree::replaceChild( size_t index, const JsonTree &newChild )
 		}
 		*oldChild = newChild;
 		oldChild->mParent = this;
+		mChildIndex.reset();
 	} else {
 		throw ExcChildNotFound( *this, toString( index ) );
 	}
@@ -341,6 +412,7 @@ void JsonTree::replaceChild( JsonTree::Iter pos, const JsonTree &newChild )
 	try {
 		*pos = newChild;
 		pos->mParent = this;
+		mChildIndex.reset();
 	} catch ( ... ) {
 		throw ExcChildNotFound( *this, pos->getPath() );
 	}
@@ -408,6 +480,24 @@ const JsonTree& JsonTree::getChild( const std::string &relativePath, bool caseSe
 	}
 }
 
+const JsonTree& JsonTree::getChild( const Query &query ) const
+{
+	JsonTree *child = getNodePtr( query );
+	if( child )
+		return *child;
+	else
+		throw ExcChildNotFound( *this, query.getPath() );
+}
+
+JsonTree& JsonTree::getChild( const Query &query )
+{
+	JsonTree *child = getNodePtr( query );
+	if( child )
+		return *child;
+	else
+		throw ExcChildNotFound( *this, query.getPath() );
+}
+
 JsonTree& JsonTree::getChild( size_t index ) 
 {
 	JsonTree *child = getNodePtr( toString( index ), false, '.' );
@@ -515,7 +605,7 @@ JsonTree* JsonTree::getNodePtr( const string &relativePath, bool caseSensitive,
         // The key is numeric
 		if( isIndex( *pathIt ) ) {
             // Find child which uses this index as its key
-			uint32_t index = boost::lexical_cast<int32_t>( *pathIt );
+			uint32_t index = fromString<int32_t>( *pathIt );
 			uint32_t i = 0;
 			for ( node = curNode->getChildren().begin(); node != curNode->getChildren().end(); ++node, i++ ) {
 				if ( i == index ) {
@@ -561,6 +651,53 @@ JsonTree* JsonTree::getNodePtr( const string &relativePath, bool caseSensitive,
 
 }
 
+JsonTree* JsonTree::getNodePtr( const Query &query ) const
+{
+	JsonTree *curNode = const_cast<JsonTree*>( this );
+	if( query.mComponents ) {
+		for( vector<Query::Component>::const_iterator component = query.mComponents->begin(); component != query.mComponents->end() && curNode; ++component )
+			curNode = curNode->findChild( *component, query.isCaseSensitive() );
+	}
+	return curNode;
+}
+
+JsonTree* JsonTree::findChild( const Query::Component &component, bool caseSensitive ) const
+{
+	if( mChildren.size() < CHILD_INDEX_THRESHOLD ) {
+		size_t i = 0;
+		for( ConstIter child = mChildren.begin(); child != mChildren.end(); ++child, ++i ) {
+			if( component.mIsIndex ? ( i == component.mIndex ) : keyMatches( child->mKey, component, caseSensitive ) )
+				return const_cast<JsonTree*>( &*child );
+		}
+		return 0;
+	}
+
+	if( ! mChildIndex ) {
+		shared_ptr<ChildIndex> index( new ChildIndex );
+		index->mByPosition.reserve( mChildren.size() );
+		string lowerKey;
+		for( ConstIter child = mChildren.begin(); child != mChildren.end(); ++child ) {
+			JsonTree *childPtr = const_cast<JsonTree*>( &*child );
+			index->mByPosition.push_back( childPtr );
+			lowerKey.resize( child->mKey.size() );
+			std::transform( child->mKey.begin(), child->mKey.end(), lowerKey.begin(), toLowerAscii );
+			index->mByKey[lowerKey].push_back( childPtr );
+		}
+		mChildIndex = index;
+	}
+
+	if( component.mIsIndex )
+		return ( component.mIndex < mChildIndex->mByPosition.size() ) ? mChildIndex->mByPosition[component.mIndex] : 0;
+
+	unordered_map<string, vector<JsonTree*> >::const_iterator bucket = mChildIndex->mByKey.find( component.mLowerKey );
+	if( bucket == mChildIndex->mByKey.end() )
+		return 0;
+	for( vector<JsonTree*>::const_iterator child = bucket->second.begin(); child != bucket->second.end(); ++child )
+		if( ! caseSensitive || (*child)->mKey == component.mKey )
+			return *child;
+	return 0;
+}
+
 //! Checks if key is numeric
 bool JsonTree::isIndex( const string &key )
 {
@@ -576,77 +713,14 @@ bool JsonTree::isIndex( const string &key )
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Json::Value JsonTree::createNativeDoc( WriteOptions writeOptions ) const
-{
-	// Create JsonCpp value
-	Json::Value value( Json::nullValue );
-
-	// Key on node type
-    switch( mNodeType ) {
-		case NODE_ARRAY: {
-			uint32_t i = 0;
-			
-			// Add children to array as objects
-			for ( ConstIter childIt = mChildren.begin(); childIt != mChildren.end(); ++childIt, i++ ) {
-				value[ i ] = childIt->createNativeDoc();
-			}
-		}
-		break;
-		case NODE_OBJECT:
-			// Add children as value members
-			for ( ConstIter childIt = mChildren.begin(); childIt != mChildren.end(); ++childIt ) {
-				value[ childIt->getKey() ] = childIt->createNativeDoc();
-			}
-		break;
-		case NODE_VALUE:
-			// Set value with native data type
-			switch ( mValueType ) {
-			case VALUE_BOOL:
-				value = Json::Value( fromString<bool>( mValue ) );
-				break;
-			case VALUE_DOUBLE:
-				value = Json::Value( atof( mValue.c_str() ) );
-				break;
-			case VALUE_INT:
-				value = Json::Value( fromString<int64_t>( mValue ) );
-				break;
-			case VALUE_STRING:
-				value = Json::Value( mValue );
-				break;
-			case VALUE_UINT:
-				value = Json::Value( fromString<uint64_t>( mValue ) );
-				break;
-			}
-		break;
-		default:
-        break;
-    }
-    
-	// Return JsonCpp object
-    if ( writeOptions.getCreateDocument() && !value.isNull() ) { 
-        Json::Value doc( Json::objectValue );
-        doc[ mKey ] = value;
-        return doc;
-    } else {
-        return value;
-    }
-}
-
 string JsonTree::serialize() const
-{	
-    stringstream ss;
-    ss << *this;
-    return ss.str();
-}
-
-string JsonTree::serializeNative( const Json::Value & value )
-{	
-	try {
-		Json::StyledWriter writer;
-		return writer.write( value );
-	} catch ( ... ) {
-		throw ExcJsonParserError( "Unable to serialize JsonCpp value." );
+{
+	OStreamMemRef stream = OStreamMem::create();
+	{
+		JsonWriter writer( stream );
+		writer.write( *this, mNodeType == NODE_VALUE );
 	}
+	return string( static_cast<const char*>( stream->getBuffer() ), static_cast<size_t>( stream->tell() ) );
 }
 
 void JsonTree::write( const fs::path &path, JsonTree::WriteOptions writeOptions )
@@ -656,41 +730,10 @@ void JsonTree::write( const fs::path &path, JsonTree::WriteOptions writeOptions
 
 void JsonTree::write( DataTargetRef target, JsonTree::WriteOptions writeOptions )
 {
-	// Declare output string
-	string jsonString = "";
-
-	try {
-		
-		// Create JsonCpp data to send to parser
-		Json::Value value = createNativeDoc( writeOptions );
-
-		// This routine serializes JsonCpp data and formats it
-		if( writeOptions.getIndented() ) {
-			Json::StyledWriter writer;
-			jsonString = writer.write( value.toStyledString() );
-			boost::replace_all( jsonString, "\\n", "\r\n" );
-			boost::replace_all( jsonString, "\\\"", "\"" );
-			if( jsonString.length() >= 3 ) {
-				jsonString = jsonString.substr( 1, boost::trim_copy( jsonString ).length() - 2 );
-			}
-		} else {
-			Json::FastWriter writer;
-			jsonString = writer.write( value );
-		}
-		jsonString += "\0";
-	}
-	catch ( ... ) {
-		throw ExcJsonParserError( "Unable to serialize JsonTree." );
-	}
-
-	// Save data to file
-	OStreamRef os = target->getStream();
-	os->writeData( jsonString.c_str(), jsonString.length() );
-	
+	JsonWriter writer( target->getStream(), writeOptions.getIndented() );
+	writer.write( *this, writeOptions.getCreateDocument() );
 }
 
-
-
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 JsonTree::ExcChildNotFound::ExcChildNotFound( const JsonTree &node, const string &childPath ) throw()
@@ -712,12 +755,7 @@ JsonTree::ExcJsonParserError::ExcJsonParserError( const string &errorMessage ) t
 
 ostream& operator<<( ostream &out, const JsonTree &json )
 {
-	JsonTree::WriteOptions writeOptions;
-	bool createDocument = json.mNodeType == JsonTree::NODE_VALUE;
-	writeOptions.createDocument( createDocument );
-    Json::Value value = json.createNativeDoc( writeOptions );
-	string doc = JsonTree::serializeNative( value );
-	out << doc;
+	out << json.serialize();
 	return out;
 }
 
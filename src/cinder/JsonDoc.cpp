@@ -0,0 +1,648 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/JsonDoc.h"
+#include "cinder/Utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+
+namespace cinder {
+
+struct JsonDoc::Node {
+	uint32_t	type;
+	uint32_t	size;		// length of a string, or number of elements or members
+	union {
+		bool			b;
+		int64_t			i;
+		double			d;
+		const char		*str;
+		Node			*elements;
+		Member			*members;	// objects larger than SMALL_OBJECT_SIZE are followed by a uint32_t index sorted by key hash
+	};
+};
+
+struct JsonDoc::Member {
+	const char	*key;
+	uint32_t	keyLength;
+	uint32_t	keyHash;
+	Node		value;
+};
+
+namespace {
+
+const size_t	ARENA_BLOCK_SIZE = 64 * 1024;
+const uint32_t	SMALL_OBJECT_SIZE = 8; // objects up to this size are searched linearly
+const int		MAX_DEPTH = 1024;
+
+// FNV-1a
+uint32_t hashKey( const char *key, size_t length )
+{
+	uint32_t h = 2166136261U;
+	for( size_t i = 0; i < length; ++i ) {
+		h ^= (uint8_t)key[i];
+		h *= 16777619U;
+	}
+	return h;
+}
+
+const char* typeName( JsonDoc::Type type )
+{
+	static const char *names[] = { "null", "bool", "int", "double", "string", "array", "object" };
+	return names[type];
+}
+
+struct MemberHashLess {
+	MemberHashLess( const JsonDoc::Member *members ) : mMembers( members ) {}
+	bool operator()( uint32_t a, uint32_t b ) const;
+
+	const JsonDoc::Member	*mMembers;
+};
+
+} // anonymous namespace
+
+bool MemberHashLess::operator()( uint32_t a, uint32_t b ) const
+{
+	return ( mMembers[a].keyHash < mMembers[b].keyHash ) || ( mMembers[a].keyHash == mMembers[b].keyHash && a < b );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// JsonDocParser
+// Recursive descent over a mutable copy of the source; strings are unescaped in place. The elements and members of open
+// containers accumulate in shared scratch vectors and are copied into the arena once each container is closed.
+class JsonDocParser {
+  public:
+	JsonDocParser( JsonDoc *doc, char *begin, char *end )
+		: mDoc( doc ), mBegin( begin ), mPos( begin ), mEnd( end )
+	{}
+
+	void parseDocument( JsonDoc::Node *root )
+	{
+		skipWhitespace();
+		parseValue( root, 0 );
+		skipWhitespace();
+		if( mPos != mEnd )
+			error( "unexpected characters after the root value" );
+	}
+
+  private:
+	void skipWhitespace()
+	{
+		while( mPos < mEnd && ( *mPos == ' ' || *mPos == '\n' || *mPos == '\r' || *mPos == '\t' ) )
+			++mPos;
+	}
+
+	void parseValue( JsonDoc::Node *node, int depth )
+	{
+		if( mPos >= mEnd )
+			error( "unexpected end of input" );
+
+		switch( *mPos ) {
+			case '{': parseObject( node, depth ); break;
+			case '[': parseArray( node, depth ); break;
+			case '"':
+				node->type = JsonDoc::TYPE_STRING;
+				parseString( &node->str, &node->size );
+			break;
+			case 't':
+				parseLiteral( "true", 4 );
+				node->type = JsonDoc::TYPE_BOOL;
+				node->size = 0;
+				node->b = true;
+			break;
+			case 'f':
+				parseLiteral( "false", 5 );
+				node->type = JsonDoc::TYPE_BOOL;
+				node->size = 0;
+				node->b = false;
+			break;
+			case 'n':
+				parseLiteral( "null", 4 );
+				node->type = JsonDoc::TYPE_NULL;
+				node->size = 0;
+				node->i = 0;
+			break;
+			default:
+				parseNumber( node );
+		}
+	}
+
+	void parseLiteral( const char *literal, size_t length )
+	{
+		if( (size_t)( mEnd - mPos ) < length || memcmp( mPos, literal, length ) != 0 )
+			error( "invalid value" );
+		mPos += length;
+	}
+
+	void parseNumber( JsonDoc::Node *node )
+	{
+		// validate against the JSON grammar before handing the token to parseNumber()
+		const char *start = mPos, *p = mPos;
+		bool isInteger = true;
+		if( p < mEnd && *p == '-' )
+			++p;
+		if( p < mEnd && *p == '0' )
+			++p;
+		else if( p < mEnd && *p >= '1' && *p <= '9' )
+			while( p < mEnd && *p >= '0' && *p <= '9' ) ++p;
+		else
+			error( "invalid value" );
+		if( p < mEnd && *p == '.' ) {
+			isInteger = false;
+			if( ++p >= mEnd || *p < '0' || *p > '9' )
+				error( "invalid number" );
+			while( p < mEnd && *p >= '0' && *p <= '9' ) ++p;
+		}
+		if( p < mEnd && ( *p == 'e' || *p == 'E' ) ) {
+			isInteger = false;
+			if( ++p < mEnd && ( *p == '+' || *p == '-' ) )
+				++p;
+			if( p >= mEnd || *p < '0' || *p > '9' )
+				error( "invalid number" );
+			while( p < mEnd && *p >= '0' && *p <= '9' ) ++p;
+		}
+
+		node->size = 0;
+		if( isInteger && cinder::parseNumber( start, p, &node->i ) == p )
+			node->type = JsonDoc::TYPE_INT;
+		else { // fractional, or an integer too large for int64_t
+			cinder::parseNumber( start, p, &node->d );
+			node->type = JsonDoc::TYPE_DOUBLE;
+		}
+		mPos = const_cast<char*>( p );
+	}
+
+	static int hexValue( char c )
+	{
+		if( c >= '0' && c <= '9' ) return c - '0';
+		if( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+		if( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+		return -1;
+	}
+
+	uint32_t parseHex4()
+	{
+		if( mEnd - mPos < 4 )
+			error( "invalid \\u escape" );
+		uint32_t result = 0;
+		for( int i = 0; i < 4; ++i ) {
+			int v = hexValue( *mPos++ );
+			if( v < 0 )
+				error( "invalid \\u escape" );
+			result = ( result << 4 ) | v;
+		}
+		return result;
+	}
+
+	// the unescaped string is never longer than its source, so it is written over it
+	void parseString( const char **result, uint32_t *resultLength )
+	{
+		char *dst = ++mPos; // skip the opening quote
+		const char *start = dst;
+		while( true ) {
+			char *runStart = mPos;
+			while( mPos < mEnd && *mPos != '"' && *mPos != '\\' && (uint8_t)*mPos >= 0x20 )
+				++mPos;
+			if( dst != runStart )
+				memmove( dst, runStart, mPos - runStart );
+			dst += mPos - runStart;
+
+			if( mPos >= mEnd )
+				error( "unterminated string" );
+			else if( *mPos == '"' ) {
+				++mPos;
+				*dst = 0;
+				*result = start;
+				*resultLength = static_cast<uint32_t>( dst - start );
+				return;
+			}
+			else if( *mPos == '\\' ) {
+				if( ++mPos >= mEnd )
+					error( "unterminated string" );
+				char c = *mPos++;
+				switch( c ) {
+					case '"': case '\\': case '/': *dst++ = c; break;
+					case 'b': *dst++ = '\b'; break;
+					case 'f': *dst++ = '\f'; break;
+					case 'n': *dst++ = '\n'; break;
+					case 'r': *dst++ = '\r'; break;
+					case 't': *dst++ = '\t'; break;
+					case 'u': {
+						uint32_t cp = parseHex4();
+						if( cp >= 0xD800 && cp <= 0xDBFF && mEnd - mPos >= 6 && mPos[0] == '\\' && mPos[1] == 'u' ) {
+							char *save = mPos;
+							mPos += 2;
+							uint32_t low = parseHex4();
+							if( low >= 0xDC00 && low <= 0xDFFF )
+								cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+							else
+								mPos = save;
+						}
+						if( cp >= 0xD800 && cp <= 0xDFFF ) // unpaired surrogate
+							cp = 0xFFFD;
+						dst = encodeUtf8( cp, dst );
+					}
+					break;
+					default:
+						error( "invalid escape sequence" );
+				}
+			}
+			else
+				error( "control character in string" );
+		}
+	}
+
+	static char* encodeUtf8( uint32_t cp, char *dst )
+	{
+		if( cp < 0x80 )
+			*dst++ = (char)cp;
+		else if( cp < 0x800 ) {
+			*dst++ = (char)( 0xC0 | ( cp >> 6 ) );
+			*dst++ = (char)( 0x80 | ( cp & 0x3F ) );
+		}
+		else if( cp < 0x10000 ) {
+			*dst++ = (char)( 0xE0 | ( cp >> 12 ) );
+			*dst++ = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+			*dst++ = (char)( 0x80 | ( cp & 0x3F ) );
+		}
+		else {
+			*dst++ = (char)( 0xF0 | ( cp >> 18 ) );
+			*dst++ = (char)( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+			*dst++ = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+			*dst++ = (char)( 0x80 | ( cp & 0x3F ) );
+		}
+		return dst;
+	}
+
+	void parseArray( JsonDoc::Node *node, int depth )
+	{
+		if( depth >= MAX_DEPTH )
+			error( "nesting too deep" );
+		++mPos;
+		const size_t scratchStart = mElements.size();
+		skipWhitespace();
+		if( mPos < mEnd && *mPos == ']' )
+			++mPos;
+		else {
+			while( true ) {
+				JsonDoc::Node element;
+				skipWhitespace();
+				parseValue( &element, depth + 1 );
+				mElements.push_back( element );
+				skipWhitespace();
+				if( mPos < mEnd && *mPos == ',' )
+					++mPos;
+				else if( mPos < mEnd && *mPos == ']' ) {
+					++mPos;
+					break;
+				}
+				else
+					error( "expected ',' or ']'" );
+			}
+		}
+
+		const size_t count = mElements.size() - scratchStart;
+		node->type = JsonDoc::TYPE_ARRAY;
+		node->size = static_cast<uint32_t>( count );
+		node->elements = 0;
+		if( count ) {
+			node->elements = reinterpret_cast<JsonDoc::Node*>( mDoc->allocate( count * sizeof(JsonDoc::Node) ) );
+			memcpy( node->elements, &mElements[scratchStart], count * sizeof(JsonDoc::Node) );
+			mElements.resize( scratchStart );
+		}
+	}
+
+	void parseObject( JsonDoc::Node *node, int depth )
+	{
+		if( depth >= MAX_DEPTH )
+			error( "nesting too deep" );
+		++mPos;
+		const size_t scratchStart = mMembers.size();
+		skipWhitespace();
+		if( mPos < mEnd && *mPos == '}' )
+			++mPos;
+		else {
+			while( true ) {
+				JsonDoc::Member member;
+				skipWhitespace();
+				if( mPos >= mEnd || *mPos != '"' )
+					error( "expected a string key" );
+				parseString( &member.key, &member.keyLength );
+				member.keyHash = hashKey( member.key, member.keyLength );
+				skipWhitespace();
+				if( mPos >= mEnd || *mPos != ':' )
+					error( "expected ':'" );
+				++mPos;
+				skipWhitespace();
+				parseValue( &member.value, depth + 1 );
+				mMembers.push_back( member );
+				skipWhitespace();
+				if( mPos < mEnd && *mPos == ',' )
+					++mPos;
+				else if( mPos < mEnd && *mPos == '}' ) {
+					++mPos;
+					break;
+				}
+				else
+					error( "expected ',' or '}'" );
+			}
+		}
+
+		const size_t count = mMembers.size() - scratchStart;
+		node->type = JsonDoc::TYPE_OBJECT;
+		node->size = static_cast<uint32_t>( count );
+		node->members = 0;
+		if( count ) {
+			const size_t indexSize = ( count > SMALL_OBJECT_SIZE ) ? count * sizeof(uint32_t) : 0;
+			node->members = reinterpret_cast<JsonDoc::Member*>( mDoc->allocate( count * sizeof(JsonDoc::Member) + indexSize ) );
+			memcpy( node->members, &mMembers[scratchStart], count * sizeof(JsonDoc::Member) );
+			mMembers.resize( scratchStart );
+			if( indexSize ) {
+				uint32_t *index = reinterpret_cast<uint32_t*>( node->members + count );
+				for( uint32_t m = 0; m < count; ++m )
+					index[m] = m;
+				std::sort( index, index + count, MemberHashLess( node->members ) );
+			}
+		}
+	}
+
+	void error( const char *message )
+	{
+		size_t line = 1, column = 1;
+		for( const char *p = mBegin; p < mPos && p < mEnd; ++p ) {
+			if( *p == '\n' ) {
+				++line;
+				column = 1;
+			}
+			else
+				++column;
+		}
+		throw JsonDoc::ExcParse( message, line, column );
+	}
+
+	JsonDoc						*mDoc;
+	char						*mBegin, *mPos, *mEnd;
+	vector<JsonDoc::Node>		mElements;
+	vector<JsonDoc::Member>		mMembers;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+// JsonDoc
+JsonDocRef JsonDoc::create( DataSourceRef dataSource )
+{
+	Buffer &buffer = dataSource->getBuffer();
+	return create( buffer.getData(), buffer.getDataSize() );
+}
+
+JsonDocRef JsonDoc::create( const std::string &jsonString )
+{
+	return create( jsonString.c_str(), jsonString.size() );
+}
+
+JsonDocRef JsonDoc::create( const void *data, size_t size )
+{
+	JsonDocRef result( new JsonDoc() );
+	result->parse( reinterpret_cast<const char*>( data ), size );
+	return result;
+}
+
+JsonDoc::JsonDoc()
+	: mBlockPos( 0 ), mBlockEnd( 0 ), mArenaSize( 0 ), mRoot( 0 )
+{
+}
+
+JsonDoc::~JsonDoc()
+{
+	for( vector<char*>::iterator blockIt = mBlocks.begin(); blockIt != mBlocks.end(); ++blockIt )
+		delete [] *blockIt;
+}
+
+void* JsonDoc::allocate( size_t size )
+{
+	size = ( size + 7 ) & ~(size_t)7;
+	if( (size_t)( mBlockEnd - mBlockPos ) < size ) {
+		const size_t blockSize = std::max( size, ARENA_BLOCK_SIZE );
+		// new char[] is aligned for any fundamental type
+		char *block = new char[blockSize];
+		mBlocks.push_back( block );
+		mArenaSize += blockSize;
+		if( blockSize > ARENA_BLOCK_SIZE ) // an oversized allocation gets a block of its own
+			return block;
+		mBlockPos = block;
+		mBlockEnd = block + blockSize;
+	}
+	void *result = mBlockPos;
+	mBlockPos += size;
+	return result;
+}
+
+void JsonDoc::parse( const char *data, size_t size )
+{
+	// skip a UTF-8 byte order mark
+	if( size >= 3 && (uint8_t)data[0] == 0xEF && (uint8_t)data[1] == 0xBB && (uint8_t)data[2] == 0xBF ) {
+		data += 3;
+		size -= 3;
+	}
+
+	// the strings of the document live in this copy of the source
+	char *source = reinterpret_cast<char*>( allocate( size + 1 ) );
+	memcpy( source, data, size );
+	source[size] = 0;
+
+	mRoot = reinterpret_cast<Node*>( allocate( sizeof(Node) ) );
+	JsonDocParser parser( this, source, source + size );
+	parser.parseDocument( mRoot );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// JsonDoc::Value
+JsonDoc::Type JsonDoc::Value::getType() const
+{
+	return static_cast<Type>( mNode->type );
+}
+
+bool JsonDoc::Value::getBool() const
+{
+	if( mNode->type != TYPE_BOOL )
+		throw ExcNonConvertible( getType() );
+	return mNode->b;
+}
+
+int64_t JsonDoc::Value::getInt() const
+{
+	if( mNode->type == TYPE_INT )
+		return mNode->i;
+	else if( mNode->type == TYPE_DOUBLE && mNode->d == std::floor( mNode->d ) && std::fabs( mNode->d ) < 9.2233720368547758e18 )
+		return static_cast<int64_t>( mNode->d );
+	throw ExcNonConvertible( getType() );
+}
+
+double JsonDoc::Value::getDouble() const
+{
+	if( mNode->type == TYPE_DOUBLE )
+		return mNode->d;
+	else if( mNode->type == TYPE_INT )
+		return static_cast<double>( mNode->i );
+	throw ExcNonConvertible( getType() );
+}
+
+const char* JsonDoc::Value::getCString() const
+{
+	if( mNode->type != TYPE_STRING )
+		throw ExcNonConvertible( getType() );
+	return mNode->str;
+}
+
+size_t JsonDoc::Value::getStringLength() const
+{
+	if( mNode->type != TYPE_STRING )
+		throw ExcNonConvertible( getType() );
+	return mNode->size;
+}
+
+size_t JsonDoc::Value::size() const
+{
+	return ( mNode->type == TYPE_ARRAY || mNode->type == TYPE_OBJECT ) ? mNode->size : 0;
+}
+
+JsonDoc::Value JsonDoc::Value::operator[]( size_t index ) const
+{
+	if( index < mNode->size ) {
+		if( mNode->type == TYPE_ARRAY )
+			return Value( &mNode->elements[index] );
+		else if( mNode->type == TYPE_OBJECT )
+			return Value( &mNode->members[index].value );
+	}
+	throw ExcChildNotFound( toString( index ) );
+}
+
+JsonDoc::Value JsonDoc::Value::operator[]( const std::string &key ) const
+{
+	Value result = find( key.c_str(), key.size() );
+	if( ! result.isValid() )
+		throw ExcChildNotFound( key );
+	return result;
+}
+
+JsonDoc::Value JsonDoc::Value::operator[]( const char *key ) const
+{
+	Value result = find( key, strlen( key ) );
+	if( ! result.isValid() )
+		throw ExcChildNotFound( key );
+	return result;
+}
+
+JsonDoc::Value JsonDoc::Value::find( const char *key, size_t keyLength ) const
+{
+	if( mNode->type != TYPE_OBJECT )
+		return Value();
+
+	const Member *members = mNode->members;
+	const uint32_t count = mNode->size;
+	const uint32_t hash = hashKey( key, keyLength );
+	if( count <= SMALL_OBJECT_SIZE ) {
+		for( uint32_t m = 0; m < count; ++m )
+			if( members[m].keyHash == hash && members[m].keyLength == keyLength && memcmp( members[m].key, key, keyLength ) == 0 )
+				return Value( &members[m].value );
+		return Value();
+	}
+
+	// binary search of the hash-sorted index; equal hashes are ordered by position, so the first matching member is found
+	const uint32_t *index = reinterpret_cast<const uint32_t*>( members + count );
+	size_t lo = 0, hi = count;
+	while( lo < hi ) {
+		size_t mid = ( lo + hi ) / 2;
+		if( members[index[mid]].keyHash < hash )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for( ; lo < count && members[index[lo]].keyHash == hash; ++lo ) {
+		const Member &member = members[index[lo]];
+		if( member.keyLength == keyLength && memcmp( member.key, key, keyLength ) == 0 )
+			return Value( &member.value );
+	}
+	return Value();
+}
+
+const char* JsonDoc::Value::getKey( size_t index ) const
+{
+	if( mNode->type != TYPE_OBJECT || index >= mNode->size )
+		throw ExcChildNotFound( toString( index ) );
+	return mNode->members[index].key;
+}
+
+size_t JsonDoc::Value::getKeyLength( size_t index ) const
+{
+	if( mNode->type != TYPE_OBJECT || index >= mNode->size )
+		throw ExcChildNotFound( toString( index ) );
+	return mNode->members[index].keyLength;
+}
+
+JsonTree JsonDoc::Value::toJsonTree( const std::string &key ) const
+{
+	switch( mNode->type ) {
+		case TYPE_BOOL:		return JsonTree( key, mNode->b );
+		case TYPE_INT:		return JsonTree( key, mNode->i );
+		case TYPE_DOUBLE:	return JsonTree( key, mNode->d );
+		case TYPE_STRING:	return JsonTree( key, getString() );
+		case TYPE_ARRAY: {
+			JsonTree result = JsonTree::makeArray( key );
+			for( uint32_t e = 0; e < mNode->size; ++e )
+				result.pushBack( Value( &mNode->elements[e] ).toJsonTree() );
+			return result;
+		}
+		case TYPE_OBJECT: {
+			JsonTree result = JsonTree::makeObject( key );
+			for( uint32_t m = 0; m < mNode->size; ++m ) {
+				const Member &member = mNode->members[m];
+				result.pushBack( Value( &member.value ).toJsonTree( string( member.key, member.keyLength ) ) );
+			}
+			return result;
+		}
+		default: // JsonTree represents null values parsed by jsoncpp as empty strings
+			return JsonTree( key, "" );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Exceptions
+JsonDoc::ExcParse::ExcParse( const char *message, size_t line, size_t column ) throw()
+{
+	sprintf( mMessage, "JSON parse error at line %u, column %u: %s", (unsigned)line, (unsigned)column, message );
+}
+
+JsonDoc::ExcChildNotFound::ExcChildNotFound( const std::string &key ) throw()
+{
+	sprintf( mMessage, "Could not find child: %.2000s", key.c_str() );
+}
+
+JsonDoc::ExcNonConvertible::ExcNonConvertible( Type actualType ) throw()
+{
+	sprintf( mMessage, "Unable to convert value of type %s", typeName( actualType ) );
+}
+
+} // namespace cinder
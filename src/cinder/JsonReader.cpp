@@ -0,0 +1,438 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/JsonReader.h"
+#include "cinder/Utilities.h"
+
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+
+namespace cinder {
+
+namespace {
+
+void appendUtf8( uint32_t cp, std::string *dest )
+{
+	if( cp < 0x80 )
+		*dest += (char)cp;
+	else if( cp < 0x800 ) {
+		*dest += (char)( 0xC0 | ( cp >> 6 ) );
+		*dest += (char)( 0x80 | ( cp & 0x3F ) );
+	}
+	else if( cp < 0x10000 ) {
+		*dest += (char)( 0xE0 | ( cp >> 12 ) );
+		*dest += (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+		*dest += (char)( 0x80 | ( cp & 0x3F ) );
+	}
+	else {
+		*dest += (char)( 0xF0 | ( cp >> 18 ) );
+		*dest += (char)( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+		*dest += (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+		*dest += (char)( 0x80 | ( cp & 0x3F ) );
+	}
+}
+
+inline bool isDigit( char c )
+{
+	return c >= '0' && c <= '9';
+}
+
+} // anonymous namespace
+
+JsonReader::JsonReader( IStreamRef stream, size_t bufferSize, bool multipleRoots )
+	: mStream( stream ), mBuffer( std::max<size_t>( bufferSize, 16 ) ), mBufferOffset( 0 ), mMultipleRoots( multipleRoots ),
+	mExpect( EXPECT_ROOT ), mToken( TOKEN_NONE ), mBool( false ), mInt( 0 ), mDouble( 0 )
+{
+	mBufferBegin = mPos = mEnd = &mBuffer[0];
+}
+
+bool JsonReader::fill()
+{
+	if( mPos < mEnd )
+		return true;
+	mBufferOffset += mEnd - mBufferBegin;
+	size_t bytesRead = mStream->isEof() ? 0 : mStream->readDataAvailable( &mBuffer[0], mBuffer.size() );
+	mBufferBegin = mPos = &mBuffer[0];
+	mEnd = mPos + bytesRead;
+	return bytesRead > 0;
+}
+
+bool JsonReader::skipWhitespace()
+{
+	while( true ) {
+		while( mPos < mEnd && ( *mPos == ' ' || *mPos == '\n' || *mPos == '\r' || *mPos == '\t' ) )
+			++mPos;
+		if( mPos < mEnd )
+			return true;
+		if( ! fill() )
+			return false;
+	}
+}
+
+void JsonReader::error( const char *message ) const
+{
+	throw ExcParse( message, getOffset() );
+}
+
+JsonReader::Token JsonReader::next()
+{
+	while( true ) {
+		if( ! skipWhitespace() ) {
+			if( mExpect == EXPECT_NOTHING || ( mExpect == EXPECT_ROOT && mMultipleRoots ) )
+				return mToken = TOKEN_END_OF_DOCUMENT;
+			error( "unexpected end of input" );
+		}
+
+		const char c = *mPos;
+		switch( mExpect ) {
+			case EXPECT_ROOT:
+			case EXPECT_VALUE:
+				return mToken = readValue();
+			case EXPECT_VALUE_OR_END:
+				if( c == ']' )
+					return mToken = endContainer( c );
+				return mToken = readValue();
+			case EXPECT_KEY_OR_END:
+				if( c == '}' )
+					return mToken = endContainer( c );
+			// fall through
+			case EXPECT_KEY:
+				if( c != '"' )
+					error( "expected a string key" );
+				readString();
+				if( ! skipWhitespace() || *mPos != ':' )
+					error( "expected ':'" );
+				++mPos;
+				mExpect = EXPECT_VALUE;
+				return mToken = TOKEN_KEY;
+			case EXPECT_COMMA_OR_END:
+				if( c == ',' ) {
+					++mPos;
+					mExpect = ( mStack.back() == '{' ) ? EXPECT_KEY : EXPECT_VALUE;
+					continue;
+				}
+				return mToken = endContainer( c );
+			case EXPECT_NOTHING:
+				if( ! mMultipleRoots )
+					error( "unexpected characters after the root value" );
+				mExpect = EXPECT_ROOT;
+				continue;
+		}
+	}
+}
+
+JsonReader::Token JsonReader::endContainer( char closing )
+{
+	if( mStack.empty() || closing != ( ( mStack.back() == '{' ) ? '}' : ']' ) )
+		error( ( mStack.empty() || mStack.back() == '{' ) ? "expected ',' or '}'" : "expected ',' or ']'" );
+	++mPos;
+	mStack.pop_back();
+	afterValue();
+	return ( closing == '}' ) ? TOKEN_END_OBJECT : TOKEN_END_ARRAY;
+}
+
+void JsonReader::afterValue()
+{
+	mExpect = mStack.empty() ? EXPECT_NOTHING : EXPECT_COMMA_OR_END;
+}
+
+JsonReader::Token JsonReader::readValue()
+{
+	switch( *mPos ) {
+		case '{':
+			++mPos;
+			mStack.push_back( '{' );
+			mExpect = EXPECT_KEY_OR_END;
+			return TOKEN_START_OBJECT;
+		case '[':
+			++mPos;
+			mStack.push_back( '[' );
+			mExpect = EXPECT_VALUE_OR_END;
+			return TOKEN_START_ARRAY;
+		case '"':
+			readString();
+			afterValue();
+			return TOKEN_STRING;
+		case 't':
+			readLiteral( "true", 4 );
+			mBool = true;
+			afterValue();
+			return TOKEN_BOOL;
+		case 'f':
+			readLiteral( "false", 5 );
+			mBool = false;
+			afterValue();
+			return TOKEN_BOOL;
+		case 'n':
+			readLiteral( "null", 4 );
+			afterValue();
+			return TOKEN_NULL;
+		default: {
+			readNumber();
+			afterValue();
+			return ( mToken == TOKEN_INT ) ? TOKEN_INT : TOKEN_DOUBLE;
+		}
+	}
+}
+
+void JsonReader::readLiteral( const char *literal, size_t length )
+{
+	for( size_t i = 0; i < length; ++i ) {
+		if( ! fill() || *mPos != literal[i] )
+			error( "invalid value" );
+		++mPos;
+	}
+}
+
+void JsonReader::readNumber()
+{
+	// gather the token, which may straddle a buffer boundary, then validate it against the JSON grammar
+	mString.clear();
+	while( fill() && ( isDigit( *mPos ) || *mPos == '-' || *mPos == '+' || *mPos == '.' || *mPos == 'e' || *mPos == 'E' ) )
+		mString += *mPos++;
+
+	const char *begin = mString.c_str(), *end = begin + mString.size(), *p = begin;
+	bool isInteger = true;
+	if( p < end && *p == '-' )
+		++p;
+	if( p < end && *p == '0' )
+		++p;
+	else if( p < end && *p >= '1' && *p <= '9' )
+		while( p < end && isDigit( *p ) ) ++p;
+	else
+		error( "invalid value" );
+	if( p < end && *p == '.' ) {
+		isInteger = false;
+		if( ++p >= end || ! isDigit( *p ) )
+			error( "invalid number" );
+		while( p < end && isDigit( *p ) ) ++p;
+	}
+	if( p < end && ( *p == 'e' || *p == 'E' ) ) {
+		isInteger = false;
+		if( ++p < end && ( *p == '+' || *p == '-' ) )
+			++p;
+		if( p >= end || ! isDigit( *p ) )
+			error( "invalid number" );
+		while( p < end && isDigit( *p ) ) ++p;
+	}
+	if( p != end )
+		error( "invalid number" );
+
+	if( isInteger && parseNumber( begin, end, &mInt ) == end ) {
+		mDouble = static_cast<double>( mInt );
+		mToken = TOKEN_INT;
+	}
+	else { // fractional, or an integer too large for int64_t
+		parseNumber( begin, end, &mDouble );
+		mToken = TOKEN_DOUBLE;
+	}
+}
+
+uint32_t JsonReader::readHex4()
+{
+	uint32_t result = 0;
+	for( int i = 0; i < 4; ++i ) {
+		if( ! fill() )
+			error( "unterminated string" );
+		char c = *mPos++;
+		int v;
+		if( c >= '0' && c <= '9' ) v = c - '0';
+		else if( c >= 'a' && c <= 'f' ) v = c - 'a' + 10;
+		else if( c >= 'A' && c <= 'F' ) v = c - 'A' + 10;
+		else { error( "invalid \\u escape" ); v = 0; }
+		result = ( result << 4 ) | v;
+	}
+	return result;
+}
+
+void JsonReader::readString()
+{
+	++mPos; // opening quote
+	mString.clear();
+	while( true ) {
+		// copy runs of plain characters a buffer at a time
+		const char *runStart = mPos;
+		while( mPos < mEnd && *mPos != '"' && *mPos != '\\' && (uint8_t)*mPos >= 0x20 )
+			++mPos;
+		mString.append( runStart, mPos );
+
+		if( mPos == mEnd ) {
+			if( ! fill() )
+				error( "unterminated string" );
+			continue;
+		}
+		const char c = *mPos++;
+		if( c == '"' )
+			return;
+		else if( c == '\\' ) {
+			if( ! fill() )
+				error( "unterminated string" );
+			const char e = *mPos++;
+			switch( e ) {
+				case '"': case '\\': case '/': mString += e; break;
+				case 'b': mString += '\b'; break;
+				case 'f': mString += '\f'; break;
+				case 'n': mString += '\n'; break;
+				case 'r': mString += '\r'; break;
+				case 't': mString += '\t'; break;
+				case 'u': {
+					uint32_t cp = readHex4();
+					if( cp >= 0xD800 && cp <= 0xDBFF ) {
+						// a low surrogate must follow immediately; anything else leaves the high surrogate unpaired
+						if( fill() && *mPos == '\\' ) {
+							++mPos;
+							if( ! fill() || *mPos != 'u' )
+								error( "unpaired surrogate" );
+							++mPos;
+							uint32_t low = readHex4();
+							if( low < 0xDC00 || low > 0xDFFF )
+								error( "unpaired surrogate" );
+							cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+						}
+						else
+							cp = 0xFFFD;
+					}
+					else if( cp >= 0xDC00 && cp <= 0xDFFF )
+						cp = 0xFFFD;
+					appendUtf8( cp, &mString );
+				}
+				break;
+				default:
+					error( "invalid escape sequence" );
+			}
+		}
+		else
+			error( "control character in string" );
+	}
+}
+
+void JsonReader::skip()
+{
+	if( mToken == TOKEN_KEY ) {
+		Token value = next();
+		if( value != TOKEN_START_OBJECT && value != TOKEN_START_ARRAY )
+			return;
+	}
+	else if( mToken != TOKEN_START_OBJECT && mToken != TOKEN_START_ARRAY )
+		return;
+
+	// scan for the matching bracket without decoding anything; brackets inside strings are ignored
+	size_t depth = 1;
+	bool inString = false;
+	while( depth ) {
+		if( ! fill() )
+			error( "unexpected end of input" );
+		if( inString ) {
+			while( mPos < mEnd && *mPos != '"' && *mPos != '\\' )
+				++mPos;
+			if( mPos == mEnd )
+				continue;
+			if( *mPos++ == '\\' ) {
+				if( ! fill() )
+					error( "unterminated string" );
+				++mPos;
+			}
+			else
+				inString = false;
+		}
+		else {
+			for( ; mPos < mEnd; ++mPos ) {
+				const char c = *mPos;
+				if( c == '"' ) {
+					inString = true;
+					++mPos;
+					break;
+				}
+				else if( c == '{' || c == '[' )
+					++depth;
+				else if( c == '}' || c == ']' ) {
+					if( --depth == 0 )
+						break;
+				}
+			}
+		}
+	}
+
+	// leave the reader as though the end token had been read
+	mToken = ( *mPos == '}' ) ? TOKEN_END_OBJECT : TOKEN_END_ARRAY;
+	endContainer( *mPos );
+}
+
+bool JsonReader::getBool() const
+{
+	if( mToken != TOKEN_BOOL )
+		throw ExcNonConvertible();
+	return mBool;
+}
+
+int64_t JsonReader::getInt() const
+{
+	if( mToken != TOKEN_INT )
+		throw ExcNonConvertible();
+	return mInt;
+}
+
+double JsonReader::getDouble() const
+{
+	if( mToken != TOKEN_DOUBLE && mToken != TOKEN_INT )
+		throw ExcNonConvertible();
+	return mDouble;
+}
+
+const std::string& JsonReader::getString() const
+{
+	if( mToken != TOKEN_STRING && mToken != TOKEN_KEY )
+		throw ExcNonConvertible();
+	return mString;
+}
+
+bool JsonReader::parse( Handler &handler )
+{
+	while( true ) {
+		bool proceed = true;
+		switch( next() ) {
+			case TOKEN_START_OBJECT:	proceed = handler.startObject(); break;
+			case TOKEN_END_OBJECT:		proceed = handler.endObject(); break;
+			case TOKEN_START_ARRAY:		proceed = handler.startArray(); break;
+			case TOKEN_END_ARRAY:		proceed = handler.endArray(); break;
+			case TOKEN_KEY:				proceed = handler.key( mString ); break;
+			case TOKEN_NULL:			proceed = handler.nullValue(); break;
+			case TOKEN_BOOL:			proceed = handler.boolValue( mBool ); break;
+			case TOKEN_INT:				proceed = handler.intValue( mInt ); break;
+			case TOKEN_DOUBLE:			proceed = handler.doubleValue( mDouble ); break;
+			case TOKEN_STRING:			proceed = handler.stringValue( mString ); break;
+			default:
+				return true;
+		}
+		if( ! proceed )
+			return false;
+	}
+}
+
+JsonReader::ExcParse::ExcParse( const char *message, uint64_t offset ) throw()
+{
+	sprintf( mMessage, "JSON parse error at byte %llu: %s", (unsigned long long)offset, message );
+}
+
+} // namespace cinder
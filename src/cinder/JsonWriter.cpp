@@ -0,0 +1,405 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/JsonWriter.h"
+#include "cinder/Utilities.h"
+
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+
+namespace cinder {
+
+namespace {
+
+const size_t BUFFER_SIZE = 16 * 1024;
+const char *INDENT = "   ";
+
+// characters which must be escaped inside a JSON string
+inline bool needsEscape( uint8_t c )
+{
+	return c < 0x20 || c == '"' || c == '\\';
+}
+
+} // anonymous namespace
+
+JsonWriter::JsonWriter( OStreamRef stream, bool indented )
+	: mStream( stream ), mIndented( indented ), mHasValue( false ), mKeyPending( false )
+{
+	mBuffer.reserve( BUFFER_SIZE );
+}
+
+JsonWriter::~JsonWriter()
+{
+	try {
+		flush();
+	}
+	catch( ... ) {
+	}
+}
+
+void JsonWriter::flush()
+{
+	if( ! mBuffer.empty() ) {
+		mStream->writeData( &mBuffer[0], mBuffer.size() );
+		mBuffer.clear();
+	}
+}
+
+void JsonWriter::put( const char *data, size_t length )
+{
+	if( mBuffer.size() + length > mBuffer.capacity() ) {
+		flush();
+		if( length > mBuffer.capacity() ) {
+			mStream->writeData( data, length );
+			return;
+		}
+	}
+	mBuffer.insert( mBuffer.end(), data, data + length );
+}
+
+void JsonWriter::newLine()
+{
+	if( mIndented ) {
+		put( '\n' );
+		for( size_t i = 0; i < mStack.size(); ++i )
+			put( INDENT, 3 );
+	}
+}
+
+void JsonWriter::beginValue()
+{
+	if( mStack.empty() )
+		return;
+	if( mStack.back() == '{' ) {
+		if( ! mKeyPending )
+			throw ExcInvalidState( "object member written without a key" );
+		mKeyPending = false;
+	}
+	else {
+		if( mHasValue )
+			put( ',' );
+		newLine();
+		mHasValue = true;
+	}
+}
+
+void JsonWriter::endValue()
+{
+	// each root value is terminated by a newline, which also separates consecutive roots
+	if( mStack.empty() )
+		put( '\n' );
+	else
+		mHasValue = true;
+}
+
+JsonWriter& JsonWriter::startObject()
+{
+	beginValue();
+	put( '{' );
+	mStack.push_back( '{' );
+	mHasValue = false;
+	return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+	if( mStack.empty() || mStack.back() != '{' || mKeyPending )
+		throw ExcInvalidState( "endObject() without a matching startObject()" );
+	mStack.pop_back();
+	if( mHasValue )
+		newLine();
+	put( '}' );
+	endValue();
+	return *this;
+}
+
+JsonWriter& JsonWriter::startArray()
+{
+	beginValue();
+	put( '[' );
+	mStack.push_back( '[' );
+	mHasValue = false;
+	return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+	if( mStack.empty() || mStack.back() != '[' )
+		throw ExcInvalidState( "endArray() without a matching startArray()" );
+	mStack.pop_back();
+	if( mHasValue )
+		newLine();
+	put( ']' );
+	endValue();
+	return *this;
+}
+
+JsonWriter& JsonWriter::key( const std::string &key )
+{
+	return this->key( key.c_str(), key.size() );
+}
+
+JsonWriter& JsonWriter::key( const char *key )
+{
+	return this->key( key, strlen( key ) );
+}
+
+JsonWriter& JsonWriter::key( const char *key, size_t length )
+{
+	if( mStack.empty() || mStack.back() != '{' || mKeyPending )
+		throw ExcInvalidState( "key() outside of an object" );
+	if( mHasValue )
+		put( ',' );
+	newLine();
+	writeString( key, length );
+	if( mIndented )
+		put( " : ", 3 );
+	else
+		put( ':' );
+	mKeyPending = true;
+	mHasValue = true;
+	return *this;
+}
+
+JsonWriter& JsonWriter::nullValue()
+{
+	beginValue();
+	put( "null", 4 );
+	endValue();
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( bool value )
+{
+	beginValue();
+	if( value )
+		put( "true", 4 );
+	else
+		put( "false", 5 );
+	endValue();
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( int64_t value )
+{
+	char buffer[32];
+	size_t length = formatNumber( value, buffer );
+	beginValue();
+	put( buffer, length );
+	endValue();
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( uint64_t value )
+{
+	char buffer[32];
+	size_t length = formatNumber( value, buffer );
+	beginValue();
+	put( buffer, length );
+	endValue();
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( float value )
+{
+	char buffer[32];
+	writeReal( buffer, ( value == value && value - value == 0 ) ? formatNumber( value, buffer ) : 0 );
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( double value )
+{
+	char buffer[32];
+	writeReal( buffer, ( value == value && value - value == 0 ) ? formatNumber( value, buffer ) : 0 );
+	return *this;
+}
+
+void JsonWriter::writeReal( const char *formatted, size_t length )
+{
+	beginValue();
+	if( length == 0 ) // JSON has no representation of infinity or NaN
+		put( "null", 4 );
+	else {
+		put( formatted, length );
+		// keep integral reals recognizable as reals when read back, as JsonCpp does
+		if( ! memchr( formatted, '.', length ) && ! memchr( formatted, 'e', length ) && ! memchr( formatted, 'E', length ) )
+			put( ".0", 2 );
+	}
+	endValue();
+}
+
+JsonWriter& JsonWriter::value( const std::string &value )
+{
+	return this->value( value.c_str(), value.size() );
+}
+
+JsonWriter& JsonWriter::value( const char *value )
+{
+	return this->value( value, strlen( value ) );
+}
+
+JsonWriter& JsonWriter::value( const char *value, size_t length )
+{
+	beginValue();
+	writeString( value, length );
+	endValue();
+	return *this;
+}
+
+void JsonWriter::writeString( const char *str, size_t length )
+{
+	static const char hexDigits[] = "0123456789abcdef";
+	put( '"' );
+	const char *end = str + length;
+	while( str < end ) {
+		// copy runs of characters which need no escaping in one go
+		const char *runStart = str;
+		while( str < end && ! needsEscape( (uint8_t)*str ) )
+			++str;
+		if( str > runStart )
+			put( runStart, str - runStart );
+		if( str == end )
+			break;
+
+		const char c = *str++;
+		switch( c ) {
+			case '"': put( "\\\"", 2 ); break;
+			case '\\': put( "\\\\", 2 ); break;
+			case '\b': put( "\\b", 2 ); break;
+			case '\f': put( "\\f", 2 ); break;
+			case '\n': put( "\\n", 2 ); break;
+			case '\r': put( "\\r", 2 ); break;
+			case '\t': put( "\\t", 2 ); break;
+			default: {
+				const char escape[6] = { '\\', 'u', '0', '0', hexDigits[( c >> 4 ) & 0xF], hexDigits[c & 0xF] };
+				put( escape, 6 );
+			}
+		}
+	}
+	put( '"' );
+}
+
+JsonWriter& JsonWriter::write( const JsonTree &tree, bool createDocument )
+{
+	if( ! mStack.empty() && mStack.back() == '{' && ! mKeyPending )
+		key( tree.mKey );
+
+	if( createDocument && mStack.empty() && tree.mNodeType != JsonTree::NODE_NULL && tree.mNodeType != JsonTree::NODE_UNKNOWN ) {
+		startObject();
+		write( tree, false ); // takes the key from tree
+		return endObject();
+	}
+
+	switch( tree.mNodeType ) {
+		case JsonTree::NODE_ARRAY:
+			startArray();
+			for( JsonTree::ConstIter childIt = tree.mChildren.begin(); childIt != tree.mChildren.end(); ++childIt )
+				write( *childIt );
+			endArray();
+		break;
+		case JsonTree::NODE_OBJECT:
+			startObject();
+			for( JsonTree::ConstIter childIt = tree.mChildren.begin(); childIt != tree.mChildren.end(); ++childIt ) {
+				key( childIt->mKey );
+				write( *childIt );
+			}
+			endObject();
+		break;
+		case JsonTree::NODE_VALUE: {
+			// values are stored as strings; reparse numbers so that the output is always valid JSON
+			const char *begin = tree.mValue.c_str(), *end = begin + tree.mValue.size();
+			switch( tree.mValueType ) {
+				case JsonTree::VALUE_BOOL:
+					value( tree.mValue == "true" || tree.mValue == "1" );
+				break;
+				case JsonTree::VALUE_DOUBLE: {
+					double d = 0;
+					parseNumber( begin, end, &d );
+					value( d );
+				}
+				break;
+				case JsonTree::VALUE_INT: {
+					int64_t i = 0;
+					if( parseNumber( begin, end, &i ) == end )
+						value( i );
+					else
+						value( atof( begin ) );
+				}
+				break;
+				case JsonTree::VALUE_UINT: {
+					uint64_t u = 0;
+					if( parseNumber( begin, end, &u ) == end )
+						value( u );
+					else
+						value( atof( begin ) );
+				}
+				break;
+				default:
+					value( tree.mValue );
+				break;
+			}
+		}
+		break;
+		default:
+			nullValue();
+		break;
+	}
+	return *this;
+}
+
+JsonWriter& JsonWriter::write( const JsonDoc::Value &docValue )
+{
+	switch( docValue.getType() ) {
+		case JsonDoc::TYPE_BOOL:
+			return value( docValue.getBool() );
+		case JsonDoc::TYPE_INT:
+			return value( docValue.getInt() );
+		case JsonDoc::TYPE_DOUBLE:
+			return value( docValue.getDouble() );
+		case JsonDoc::TYPE_STRING:
+			return value( docValue.getCString(), docValue.getStringLength() );
+		case JsonDoc::TYPE_ARRAY:
+			startArray();
+			for( size_t i = 0; i < docValue.size(); ++i )
+				write( docValue[i] );
+			return endArray();
+		case JsonDoc::TYPE_OBJECT:
+			startObject();
+			for( size_t i = 0; i < docValue.size(); ++i ) {
+				key( docValue.getKey( i ), docValue.getKeyLength( i ) );
+				write( docValue[i] );
+			}
+			return endObject();
+		default:
+			return nullValue();
+	}
+}
+
+JsonWriter::ExcInvalidState::ExcInvalidState( const char *message ) throw()
+{
+	strncpy( mMessage, message, sizeof(mMessage) - 1 );
+	mMessage[sizeof(mMessage) - 1] = 0;
+}
+
+} // namespace cinder
@@ -21,6 +21,8 @@
 */
 
 #include "cinder/ObjLoader.h"
+#include "cinder/TaskPool.h"
+#include "cinder/Utilities.h"
 
 #include <boost/lexical_cast.hpp>
 using boost::lexical_cast;
@@ -28,28 +30,359 @@ using boost::lexical_cast;
 using std::ostringstream;
 
 #include <sstream>
+#include <algorithm>
+#include <cstring>
 using namespace std;
-using boost::make_tuple;
 
 namespace cinder {
 
+namespace {
+
+// files larger than this are split into chunks of about this size, which are parsed in parallel
+const size_t PARSE_CHUNK_SIZE = 1 << 20;
+
+// Per-face record of how parseFace() would have updated its Group's mHasTexCoords and mHasNormals
+enum {
+	FACE_HAS_VERTICES = 1,
+	// the value from the face's last vertex, which is what a Group's first face leaves behind
+	FACE_LAST_TEX_COORD = 2,
+	FACE_LAST_NORMAL = 4,
+	// a vertex had an empty texture coordinate index, which clears mHasTexCoords on any face
+	FACE_CLEARS_TEX_COORDS = 8,
+	// a vertex had a normal index, which sets mHasNormals on any face
+	FACE_SETS_NORMALS = 16,
+	// an index was negative, relative to the Group's base offsets
+	FACE_RELATIVE = 32
+};
+
+// A "g" or "usemtl" line, positioned by the number of faces and vertex attributes in the chunk which preceded it
+struct ParseCommand {
+	enum Type { GROUP, MATERIAL };
+
+	Type			mType;
+	size_t			mFace, mVertex, mTexCoord, mNormal;
+	std::string		mName;
+};
+
+struct ParseChunk {
+	const char					*mBegin, *mEnd;
+	vector<Vec3f>				mVertices, mNormals;
+	vector<Vec2f>				mTexCoords;
+	vector<ObjLoader::Face>		mFaces;
+	vector<uint8_t>				mFaceFlags;
+	vector<ParseCommand>		mCommands;
+};
+
+inline bool isBlank( char c )
+{
+	return c == ' ' || c == '\t';
+}
+
+inline const char* skipBlanks( const char *p, const char *end )
+{
+	while( p < end && isBlank( *p ) )
+		++p;
+	return p;
+}
+
+inline const char* findBlank( const char *p, const char *end )
+{
+	while( p < end && ! isBlank( *p ) )
+		++p;
+	return p;
+}
+
+inline bool tagEquals( const char *begin, const char *end, const char *tag )
+{
+	size_t length = strlen( tag );
+	return (size_t)( end - begin ) == length && memcmp( begin, tag, length ) == 0;
+}
+
+// Parses up to \a count numbers separated by blanks; missing values are left unchanged, as they were with operator>>
+void parseFloats( const char *p, const char *end, float *result, int count )
+{
+	for( int i = 0; i < count; ++i ) {
+		p = skipBlanks( p, end );
+		const char *parsed = parseNumber( p, end, &result[i] );
+		if( parsed == p )
+			break;
+		p = parsed;
+	}
+}
+
+// Parses an index which must be followed by \a end or a '/', and converts it from 1-based; negative indices are left relative
+int parseIndex( const char *begin, const char *end, uint8_t *flags )
+{
+	int result;
+	const char *parsed = parseNumber( begin, end, &result );
+	if( parsed == begin || ( parsed != end && *parsed != '/' ) )
+		throw boost::bad_lexical_cast();
+	if( result < 0 ) {
+		*flags |= FACE_RELATIVE;
+		return result;
+	}
+	return result - 1;
+}
+
+// Parses the "v/vt/vn" triples which follow the "f" of a face line
+void parseFace( const char *p, const char *end, bool includeUVs, ObjLoader::Face *result, uint8_t *flags )
+{
+	result->mNumVertices = 0;
+	result->mMaterial = 0;
+	*flags = 0;
+	bool lastTexCoord = false, lastNormal = false;
+	while( ( p = skipBlanks( p, end ) ) < end ) {
+		const char *endOfTriple = findBlank( p, end );
+		const char *firstSlash = std::find( p, endOfTriple, '/' );
+		const char *secondSlash = ( firstSlash < endOfTriple ) ? std::find( firstSlash + 1, endOfTriple, '/' ) : endOfTriple;
+
+		result->mVertexIndices.push_back( parseIndex( p, firstSlash, flags ) );
+
+		lastTexCoord = false;
+		if( includeUVs && firstSlash < endOfTriple ) {
+			if( secondSlash > firstSlash + 1 ) {
+				result->mTexCoordIndices.push_back( parseIndex( firstSlash + 1, secondSlash, flags ) );
+				lastTexCoord = true;
+			}
+			else
+				*flags |= FACE_CLEARS_TEX_COORDS;
+		}
+
+		lastNormal = false;
+		if( secondSlash < endOfTriple ) {
+			result->mNormalIndices.push_back( parseIndex( secondSlash + 1, endOfTriple, flags ) );
+			*flags |= FACE_SETS_NORMALS;
+			lastNormal = true;
+		}
+
+		p = endOfTriple;
+		result->mNumVertices++;
+	}
+
+	if( result->mNumVertices ) {
+		*flags |= FACE_HAS_VERTICES;
+		if( lastTexCoord )
+			*flags |= FACE_LAST_TEX_COORD;
+		if( lastNormal )
+			*flags |= FACE_LAST_NORMAL;
+	}
+}
+
+void parseChunk( ParseChunk *chunk, bool includeUVs )
+{
+	const char *p = chunk->mBegin, *end = chunk->mEnd;
+	while( p < end ) {
+		// lines end in LF, CR or CRLF, matching IStream::readLine()
+		const char *lineBegin = p, *lineEnd = p;
+		while( lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r' )
+			++lineEnd;
+		p = lineEnd + 1;
+		if( p < end && *lineEnd == '\r' && *p == '\n' )
+			++p;
+		if( lineBegin == lineEnd || *lineBegin == '#' )
+			continue;
+
+		const char *tagBegin = skipBlanks( lineBegin, lineEnd );
+		const char *tagEnd = findBlank( tagBegin, lineEnd );
+		if( tagEquals( tagBegin, tagEnd, "v" ) ) { // vertex
+			Vec3f v;
+			parseFloats( tagEnd, lineEnd, &v.x, 3 );
+			chunk->mVertices.push_back( v );
+		}
+		else if( tagEquals( tagBegin, tagEnd, "vt" ) ) { // vertex texture coordinates
+			if( includeUVs ) {
+				Vec2f tex;
+				parseFloats( tagEnd, lineEnd, &tex.x, 2 );
+				chunk->mTexCoords.push_back( tex );
+			}
+		}
+		else if( tagEquals( tagBegin, tagEnd, "vn" ) ) { // vertex normals
+			Vec3f v;
+			parseFloats( tagEnd, lineEnd, &v.x, 3 );
+			chunk->mNormals.push_back( v.normalized() );
+		}
+		else if( tagEquals( tagBegin, tagEnd, "f" ) ) { // face
+			chunk->mFaces.push_back( ObjLoader::Face() );
+			chunk->mFaceFlags.push_back( 0 );
+			parseFace( tagEnd, lineEnd, includeUVs, &chunk->mFaces.back(), &chunk->mFaceFlags.back() );
+		}
+		else if( tagEquals( tagBegin, tagEnd, "g" ) || tagEquals( tagBegin, tagEnd, "usemtl" ) ) { // group or material
+			ParseCommand command;
+			command.mFace = chunk->mFaces.size();
+			command.mVertex = chunk->mVertices.size();
+			command.mTexCoord = chunk->mTexCoords.size();
+			command.mNormal = chunk->mNormals.size();
+			if( *tagBegin == 'g' ) {
+				// the name is everything following the first space
+				command.mType = ParseCommand::GROUP;
+				const char *space = std::find( lineBegin, lineEnd, ' ' );
+				command.mName = ( space < lineEnd ) ? string( space + 1, lineEnd ) : string( lineBegin, lineEnd );
+			}
+			else {
+				command.mType = ParseCommand::MATERIAL;
+				const char *nameBegin = skipBlanks( tagEnd, lineEnd );
+				command.mName = string( nameBegin, findBlank( nameBegin, lineEnd ) );
+			}
+			chunk->mCommands.push_back( command );
+		}
+	}
+}
+
+struct ParseChunksFn {
+	ParseChunksFn( vector<ParseChunk> *chunks, bool includeUVs ) : mChunks( chunks ), mIncludeUVs( includeUVs ) {}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		for( size_t c = begin; c < end; ++c )
+			parseChunk( &(*mChunks)[c], mIncludeUVs );
+	}
+
+	vector<ParseChunk>	*mChunks;
+	bool				mIncludeUVs;
+};
+
+// Moves the chunk's faces [begin, end) onto the end of \a group, resolving relative indices and the Group's flags
+void appendFaces( ParseChunk *chunk, size_t begin, size_t end, ObjLoader::Group *group, const ObjLoader::Material *material )
+{
+	for( size_t f = begin; f < end; ++f ) {
+		ObjLoader::Face &face = chunk->mFaces[f];
+		uint8_t flags = chunk->mFaceFlags[f];
+		face.mMaterial = material;
+		if( flags & FACE_RELATIVE ) {
+			for( vector<int>::iterator indexIt = face.mVertexIndices.begin(); indexIt != face.mVertexIndices.end(); ++indexIt )
+				if( *indexIt < 0 ) *indexIt += group->mBaseVertexOffset;
+			for( vector<int>::iterator indexIt = face.mTexCoordIndices.begin(); indexIt != face.mTexCoordIndices.end(); ++indexIt )
+				if( *indexIt < 0 ) *indexIt += group->mBaseTexCoordOffset;
+			for( vector<int>::iterator indexIt = face.mNormalIndices.begin(); indexIt != face.mNormalIndices.end(); ++indexIt )
+				if( *indexIt < 0 ) *indexIt += group->mBaseNormalOffset;
+		}
+
+		if( group->mFaces.empty() ) {
+			if( flags & FACE_HAS_VERTICES ) {
+				group->mHasTexCoords = ( flags & FACE_LAST_TEX_COORD ) != 0;
+				group->mHasNormals = ( flags & FACE_LAST_NORMAL ) != 0;
+			}
+		}
+		else {
+			if( flags & FACE_CLEARS_TEX_COORDS )
+				group->mHasTexCoords = false;
+			if( flags & FACE_SETS_NORMALS )
+				group->mHasNormals = true;
+		}
+
+		// swapping avoids copying the index vectors where Face has no move constructor
+		group->mFaces.push_back( ObjLoader::Face() );
+		ObjLoader::Face &dest = group->mFaces.back();
+		dest.mNumVertices = face.mNumVertices;
+		dest.mMaterial = face.mMaterial;
+		dest.mVertexIndices.swap( face.mVertexIndices );
+		dest.mTexCoordIndices.swap( face.mTexCoordIndices );
+		dest.mNormalIndices.swap( face.mNormalIndices );
+	}
+}
+
+inline bool indicesInRange( const vector<int> &indices, size_t count )
+{
+	for( vector<int>::const_iterator indexIt = indices.begin(); indexIt != indices.end(); ++indexIt )
+		if( *indexIt < 0 || (size_t)*indexIt >= count )
+			return false;
+	return true;
+}
+
+} // anonymous namespace
+
+// Open-addressing hash table from up to three OBJ indices to a TriMesh vertex index, for deduplicating vertices.
+// Linear probing over a power-of-two table which is sized up front so that it rarely needs to grow.
+class ObjLoader::VertexIndexMap {
+  public:
+	//! Sized for \a numFaces faces; a closed triangle mesh has about half as many unique vertices as faces
+	VertexIndexMap( size_t numFaces )
+		: mSize( 0 )
+	{
+		size_t capacity = 64;
+		while( capacity < numFaces )
+			capacity *= 2;
+		allocate( capacity );
+	}
+
+	//! Returns the value for the key ( \a a, \a b, \a c ), first inserting \a value if the key is absent. Sets \a inserted accordingly.
+	int findOrInsert( int a, int b, int c, int value, bool *inserted )
+	{
+		for( size_t slot = hash( a, b, c ) & mMask; ; slot = ( slot + 1 ) & mMask ) {
+			Slot &s = mSlots[slot];
+			if( s.mValue < 0 ) {
+				s.mKey[0] = a; s.mKey[1] = b; s.mKey[2] = c;
+				s.mValue = value;
+				*inserted = true;
+				if( ++mSize * 4 > mSlots.size() * 3 )
+					grow();
+				return value;
+			}
+			if( s.mKey[0] == a && s.mKey[1] == b && s.mKey[2] == c ) {
+				*inserted = false;
+				return s.mValue;
+			}
+		}
+	}
+
+  private:
+	struct Slot {
+		int32_t		mKey[3];
+		// negative for an empty slot
+		int32_t		mValue;
+	};
+
+	static size_t hash( int a, int b, int c )
+	{
+		uint32_t h = (uint32_t)a * 0x9E3779B1u ^ (uint32_t)b * 0x85EBCA77u ^ (uint32_t)c * 0xC2B2AE3Du;
+		h ^= h >> 15;
+		h *= 0x2C1B3C6Du;
+		h ^= h >> 12;
+		return h;
+	}
+
+	void allocate( size_t capacity )
+	{
+		Slot empty;
+		empty.mKey[0] = empty.mKey[1] = empty.mKey[2] = 0;
+		empty.mValue = -1;
+		mSlots.assign( capacity, empty );
+		mMask = capacity - 1;
+	}
+
+	void grow()
+	{
+		vector<Slot> oldSlots;
+		oldSlots.swap( mSlots );
+		allocate( oldSlots.size() * 2 );
+		for( vector<Slot>::const_iterator slotIt = oldSlots.begin(); slotIt != oldSlots.end(); ++slotIt ) {
+			if( slotIt->mValue < 0 )
+				continue;
+			size_t slot = hash( slotIt->mKey[0], slotIt->mKey[1], slotIt->mKey[2] ) & mMask;
+			while( mSlots[slot].mValue >= 0 )
+				slot = ( slot + 1 ) & mMask;
+			mSlots[slot] = *slotIt;
+		}
+	}
+
+	vector<Slot>	mSlots;
+	size_t			mMask, mSize;
+};
+
 ObjLoader::ObjLoader( shared_ptr<IStream> stream, bool includeUVs )
-	: mStream( stream )
 {
-	parse( includeUVs );
+	parse( stream, includeUVs );
 }
 
 ObjLoader::ObjLoader( DataSourceRef dataSource, bool includeUVs )
-	: mStream( dataSource->createStream() )
 {
-	parse( includeUVs );
+	parse( dataSource, includeUVs );
 }
 
 ObjLoader::ObjLoader( DataSourceRef dataSource, DataSourceRef materialSource, bool includeUVs )
-    : mStream( dataSource->createStream() )
 {
     parseMaterial( materialSource->createStream() );
-    parse( includeUVs );
+    parse( dataSource, includeUVs );
 }
     
 ObjLoader::~ObjLoader()
@@ -89,134 +422,119 @@ void ObjLoader::parseMaterial( std::shared_ptr<IStream> material )
         mMaterials[m.mName] = m;
 }
 
-void ObjLoader::parse( bool includeUVs )
+void ObjLoader::parse( shared_ptr<IStream> stream, bool includeUVs )
 {
-	Group *currentGroup;
-	mGroups.push_back( Group() );
-	currentGroup = &mGroups[mGroups.size()-1];
-	currentGroup->mBaseVertexOffset = currentGroup->mBaseTexCoordOffset = currentGroup->mBaseNormalOffset = 0;
+	vector<char> data( (size_t)( stream->size() - stream->tell() ) );
+	if( ! data.empty() )
+		stream->readData( &data[0], data.size() );
+	parse( data.empty() ? 0 : &data[0], data.empty() ? 0 : &data[0] + data.size(), includeUVs );
+}
 
-    const Material *currentMaterial = 0;
-    
-	size_t lineNumber = 0;
-	while( ! mStream->isEof() ) {
-		lineNumber++;
-		string line = mStream->readLine(), tag;
-        if( line.empty() || line[0] == '#' )
-            continue;
-        
-		stringstream ss( line );
-		ss >> tag;
-		if( tag == "v" ) { // vertex
-			Vec3f v;
-			ss >> v.x >> v.y >> v.z;
-			mVertices.push_back( v );
+void ObjLoader::parse( DataSourceRef dataSource, bool includeUVs )
+{
+	if( dataSource->isFilePath() ) {
+		MappedFileRef mapped;
+		try {
+			mapped = MappedFile::create( dataSource->getFilePath() );
 		}
-		else if( tag == "vt" ) { // vertex texture coordinates
-			if( includeUVs ) {
-				Vec2f tex;
-				ss >> tex.x >> tex.y;
-				mTexCoords.push_back( tex );
-			}
+		catch( StreamExc & ) { // not an ordinary file, such as an Android asset; fall back to reading it
+		}
+		if( mapped ) {
+			const char *data = static_cast<const char*>( mapped->getData() );
+			parse( data, data + mapped->getSize(), includeUVs );
+			return;
 		}
-		else if( tag == "vn" ) { // vertex normals
-			Vec3f v;
-			ss >> v.x >> v.y >> v.z;
-			mNormals.push_back( v.normalized() );
-		}
-		else if( tag == "f" ) { // face
-			parseFace( currentGroup, currentMaterial, line, includeUVs );
-		}
-		else if( tag == "g" ) { // group
-			if( ! currentGroup->mFaces.empty() )
-				mGroups.push_back( Group() );
-			currentGroup = &mGroups[mGroups.size()-1];
-			currentGroup->mBaseVertexOffset = mVertices.size();
-			currentGroup->mBaseTexCoordOffset = mTexCoords.size();
-			currentGroup->mBaseNormalOffset = mNormals.size();
-			currentGroup->mName = line.substr( line.find( ' ' ) + 1 );
-		}
-        else if( tag == "usemtl") { // material
-            string tag;
-            ss >> tag;
-            std::map<std::string, Material>::const_iterator m = mMaterials.find(tag);
-            if( m != mMaterials.end() ) {
-                currentMaterial = &m->second;
-            }
-        }
 	}
+
+	Buffer buffer = dataSource->getBuffer();
+	const char *data = static_cast<const char*>( buffer.getData() );
+	parse( data, data + buffer.getDataSize(), includeUVs );
 }
 
-void ObjLoader::parseFace( Group *group, const Material *material, const std::string &s, bool includeUVs )
+void ObjLoader::parse( const char *begin, const char *end, bool includeUVs )
 {
-	ObjLoader::Face result;
-	result.mNumVertices = 0;
-    result.mMaterial = material;
-
-	size_t offset = 2; // account for "f "
-	size_t length = s.length();
-	while( offset < length ) {
-		size_t endOfTriple, firstSlashOffset, secondSlashOffset;
-	
-		while( s[offset] == ' ' )
-			++offset;
-	
-		// find the end of this triple "v/vt/vn"
-		endOfTriple = s.find( ' ', offset );
-		if( endOfTriple == string::npos ) endOfTriple = length;
-		firstSlashOffset = s.find( '/', offset );
-		if( firstSlashOffset != string::npos ) {
-			secondSlashOffset = s.find( '/', firstSlashOffset + 1 );
-			if( secondSlashOffset > endOfTriple ) secondSlashOffset = string::npos;
-		}
-		else
-			secondSlashOffset = string::npos;
-		
-		// process the vertex index
-		int vertexIndex = (firstSlashOffset != string::npos) ? 
-            lexical_cast<int>( s.substr( offset, firstSlashOffset - offset ) ) : 
-            lexical_cast<int>( s.substr( offset, endOfTriple - offset));
-        
-		if( vertexIndex < 0 )
-			result.mVertexIndices.push_back( group->mBaseVertexOffset + vertexIndex );
-		else
-			result.mVertexIndices.push_back( vertexIndex - 1 );
-			
-		// process the tex coord index
-		if( includeUVs && ( firstSlashOffset != string::npos ) ) {
-			size_t numSize = ( secondSlashOffset == string::npos ) ? ( endOfTriple - firstSlashOffset - 1 ) : secondSlashOffset - firstSlashOffset - 1;
-			if( numSize > 0 ) {
-				int texCoordIndex = lexical_cast<int>( s.substr( firstSlashOffset + 1, numSize ) );
-				if( texCoordIndex < 0 )
-					result.mTexCoordIndices.push_back( group->mBaseTexCoordOffset + texCoordIndex );
-				else
-					result.mTexCoordIndices.push_back( texCoordIndex - 1 );
-				if( group->mFaces.empty() )
-					group->mHasTexCoords = true;
+	// split into chunks which begin at the start of a line
+	vector<ParseChunk> chunks;
+	for( const char *chunkBegin = begin; chunkBegin < end; ) {
+		const char *chunkEnd = chunkBegin + std::min<size_t>( PARSE_CHUNK_SIZE, end - chunkBegin );
+		while( chunkEnd < end && chunkEnd[-1] != '\n' && chunkEnd[-1] != '\r' )
+			++chunkEnd;
+		chunks.push_back( ParseChunk() );
+		chunks.back().mBegin = chunkBegin;
+		chunks.back().mEnd = chunkEnd;
+		chunkBegin = chunkEnd;
+	}
+
+	TaskPool::getDefault().parallelFor( chunks.size(), 1, ParseChunksFn( &chunks, includeUVs ) );
+
+	// size everything up front; Groups are counted by replaying the "g" lines, which only start a new Group after a face
+	size_t numVertices = 0, numTexCoords = 0, numNormals = 0;
+	vector<size_t> groupFaces( 1, 0 );
+	for( vector<ParseChunk>::const_iterator chunkIt = chunks.begin(); chunkIt != chunks.end(); ++chunkIt ) {
+		numVertices += chunkIt->mVertices.size();
+		numTexCoords += chunkIt->mTexCoords.size();
+		numNormals += chunkIt->mNormals.size();
+		size_t face = 0;
+		for( vector<ParseCommand>::const_iterator commandIt = chunkIt->mCommands.begin(); commandIt != chunkIt->mCommands.end(); ++commandIt ) {
+			groupFaces.back() += commandIt->mFace - face;
+			face = commandIt->mFace;
+			if( commandIt->mType == ParseCommand::GROUP && groupFaces.back() )
+				groupFaces.push_back( 0 );
+		}
+		groupFaces.back() += chunkIt->mFaces.size() - face;
+	}
+	mVertices.reserve( mVertices.size() + numVertices );
+	mTexCoords.reserve( mTexCoords.size() + numTexCoords );
+	mNormals.reserve( mNormals.size() + numNormals );
+	mGroups.reserve( groupFaces.size() );
+
+	// merge the chunks in file order
+	mGroups.push_back( Group() );
+	Group *currentGroup = &mGroups.back();
+	currentGroup->mFaces.reserve( groupFaces[0] );
+	const Material *currentMaterial = 0;
+	for( vector<ParseChunk>::iterator chunkIt = chunks.begin(); chunkIt != chunks.end(); ++chunkIt ) {
+		size_t face = 0;
+		for( vector<ParseCommand>::const_iterator commandIt = chunkIt->mCommands.begin(); commandIt != chunkIt->mCommands.end(); ++commandIt ) {
+			appendFaces( &*chunkIt, face, commandIt->mFace, currentGroup, currentMaterial );
+			face = commandIt->mFace;
+			if( commandIt->mType == ParseCommand::GROUP ) {
+				if( ! currentGroup->mFaces.empty() ) {
+					mGroups.push_back( Group() );
+					mGroups.back().mFaces.reserve( groupFaces[mGroups.size() - 1] );
+				}
+				currentGroup = &mGroups.back();
+				currentGroup->mBaseVertexOffset = mVertices.size() + commandIt->mVertex;
+				currentGroup->mBaseTexCoordOffset = mTexCoords.size() + commandIt->mTexCoord;
+				currentGroup->mBaseNormalOffset = mNormals.size() + commandIt->mNormal;
+				currentGroup->mName = commandIt->mName;
+			}
+			else {
+				std::map<std::string, Material>::const_iterator m = mMaterials.find( commandIt->mName );
+				if( m != mMaterials.end() )
+					currentMaterial = &m->second;
 			}
-			else
-				group->mHasTexCoords = false;
 		}
-		else if( group->mFaces.empty() ) // if this is the first face, let's note that this group has no tex coords
-			group->mHasTexCoords = false;
-			
-		// process the normal index
-		if( secondSlashOffset != string::npos ) {
-			int normalIndex = lexical_cast<int>( s.substr( secondSlashOffset + 1, endOfTriple - secondSlashOffset - 1 ) );
-			if( normalIndex < 0 )
-				result.mNormalIndices.push_back( group->mBaseNormalOffset + normalIndex );
-			else
-				result.mNormalIndices.push_back( normalIndex - 1 );
-			group->mHasNormals = true;
+		appendFaces( &*chunkIt, face, chunkIt->mFaces.size(), currentGroup, currentMaterial );
+
+		mVertices.insert( mVertices.end(), chunkIt->mVertices.begin(), chunkIt->mVertices.end() );
+		mTexCoords.insert( mTexCoords.end(), chunkIt->mTexCoords.begin(), chunkIt->mTexCoords.end() );
+		mNormals.insert( mNormals.end(), chunkIt->mNormals.begin(), chunkIt->mNormals.end() );
+		// release each chunk as soon as it has been merged
+		vector<Face>().swap( chunkIt->mFaces );
+		vector<Vec3f>().swap( chunkIt->mVertices );
+		vector<Vec3f>().swap( chunkIt->mNormals );
+		vector<Vec2f>().swap( chunkIt->mTexCoords );
+	}
+
+	// faces may reference attributes defined later in the file, so indices can only be checked once everything is merged
+	for( vector<Group>::const_iterator groupIt = mGroups.begin(); groupIt != mGroups.end(); ++groupIt ) {
+		for( vector<Face>::const_iterator faceIt = groupIt->mFaces.begin(); faceIt != groupIt->mFaces.end(); ++faceIt ) {
+			if( ! ( indicesInRange( faceIt->mVertexIndices, mVertices.size() ) && indicesInRange( faceIt->mTexCoordIndices, mTexCoords.size() )
+					&& indicesInRange( faceIt->mNormalIndices, mNormals.size() ) ) )
+				throw ObjLoaderExcInvalidIndex();
 		}
-		else if( group->mFaces.empty() ) // if this is the first face, let's note that this group has no normals
-			group->mHasNormals = false;
-		
-		offset = endOfTriple + 1;
-		result.mNumVertices++;
 	}
-	
-	group->mFaces.push_back( result );
 }
 
 void ObjLoader::load( size_t groupIndex, TriMesh *destTriMesh, boost::tribool loadNormals, boost::tribool loadTexCoords, bool optimizeVertices )
@@ -237,19 +555,19 @@ void ObjLoader::load( size_t groupIndex, TriMesh *destTriMesh, boost::tribool lo
 		loadInternalNoOptimize( mGroups[groupIndex], destTriMesh, texCoords, normals );
 	}
 	else if( normals && texCoords ) {
-		map<VertexTriple,int> uniqueVerts;
+		VertexIndexMap uniqueVerts( mGroups[groupIndex].mFaces.size() );
 		loadInternalNormalsTextures( mGroups[groupIndex], uniqueVerts, destTriMesh );
 	}
 	else if( normals ) {
-		map<VertexPair,int> uniqueVerts;
+		VertexIndexMap uniqueVerts( mGroups[groupIndex].mFaces.size() );
 		loadInternalNormals( mGroups[groupIndex], uniqueVerts, destTriMesh );
 	}
 	else if( texCoords ) {
-		map<VertexPair,int> uniqueVerts;
+		VertexIndexMap uniqueVerts( mGroups[groupIndex].mFaces.size() );
 		loadInternalTextures( mGroups[groupIndex], uniqueVerts, destTriMesh );
 	}
 	else {
-		map<int,int> uniqueVerts;
+		vector<int> uniqueVerts( mVertices.size(), -1 );
 		loadInternal( mGroups[groupIndex], uniqueVerts, destTriMesh );
 	}
 
@@ -284,28 +602,32 @@ void ObjLoader::load( TriMesh *destTriMesh, boost::tribool loadNormals, boost::t
 	
 	}
 
+	size_t numFaces = 0;
+	for( vector<Group>::const_iterator groupIt = mGroups.begin(); groupIt != mGroups.end(); ++groupIt )
+		numFaces += groupIt->mFaces.size();
+
 	if( ! optimizeVertices ) {
 		for( vector<Group>::const_iterator groupIt = mGroups.begin(); groupIt != mGroups.end(); ++groupIt ) {
 			loadInternalNoOptimize( *groupIt, destTriMesh, texCoords, normals );
 		}	
 	}
 	else if( normals && texCoords ) {
-		map<VertexTriple,int> uniqueVerts;
+		VertexIndexMap uniqueVerts( numFaces );
 		for( vector<Group>::const_iterator groupIt = mGroups.begin(); groupIt != mGroups.end(); ++groupIt )
 			loadInternalNormalsTextures( *groupIt, uniqueVerts, destTriMesh );
 	}
 	else if( normals ) {
-		map<VertexPair,int> uniqueVerts;
+		VertexIndexMap uniqueVerts( numFaces );
 		for( vector<Group>::const_iterator groupIt = mGroups.begin(); groupIt != mGroups.end(); ++groupIt )
 			loadInternalNormals( *groupIt, uniqueVerts, destTriMesh );
 	}
 	else if( texCoords ) {
-		map<VertexPair,int> uniqueVerts;
+		VertexIndexMap uniqueVerts( numFaces );
 		for( vector<Group>::const_iterator groupIt = mGroups.begin(); groupIt != mGroups.end(); ++groupIt )
 			loadInternalTextures( *groupIt, uniqueVerts, destTriMesh );
 	}
 	else {
-		map<int,int> uniqueVerts;
+		vector<int> uniqueVerts( mVertices.size(), -1 );
 		for( vector<Group>::const_iterator groupIt = mGroups.begin(); groupIt != mGroups.end(); ++groupIt )
 			loadInternal( *groupIt, uniqueVerts, destTriMesh );
 	}
@@ -357,7 +679,7 @@ void ObjLoader::loadInternalNoOptimize( const Group &group, TriMesh *destTriMesh
 	}	
 }
 
-void ObjLoader::loadInternalNormalsTextures( const Group &group, map<VertexTriple,int> &uniqueVerts, TriMesh *destTriMesh )
+void ObjLoader::loadInternalNormalsTextures( const Group &group, VertexIndexMap &uniqueVerts, TriMesh *destTriMesh )
 {
     bool hasColors = mMaterials.size() > 0;
 	for( size_t f = 0; f < group.mFaces.size(); ++f ) {
@@ -391,9 +713,9 @@ void ObjLoader::loadInternalNormalsTextures( const Group &group, map<VertexTripl
 		faceIndices.reserve( group.mFaces[f].mNumVertices );
 		for( int v = 0; v < group.mFaces[f].mNumVertices; ++v ) {
 			if( ! forceUnique ) {
-				VertexTriple triple = make_tuple( group.mFaces[f].mVertexIndices[v], group.mFaces[f].mTexCoordIndices[v], group.mFaces[f].mNormalIndices[v] );
-				pair<map<VertexTriple,int>::iterator,bool> result = uniqueVerts.insert( make_pair( triple, destTriMesh->getVertices().size() ) );
-				if( result.second ) { // we've got a new, unique vertex here, so let's append it
+				bool inserted;
+				int index = uniqueVerts.findOrInsert( group.mFaces[f].mVertexIndices[v], group.mFaces[f].mTexCoordIndices[v], group.mFaces[f].mNormalIndices[v], (int)destTriMesh->getVertices().size(), &inserted );
+				if( inserted ) { // we've got a new, unique vertex here, so let's append it
 					destTriMesh->appendVertex( mVertices[group.mFaces[f].mVertexIndices[v]] );
 					destTriMesh->appendNormal( mNormals[group.mFaces[f].mNormalIndices[v]] );
 					destTriMesh->appendTexCoord( mTexCoords[group.mFaces[f].mTexCoordIndices[v]] );
@@ -401,7 +723,7 @@ void ObjLoader::loadInternalNormalsTextures( const Group &group, map<VertexTripl
                         destTriMesh->appendColorRgb( rgb );
 				}
 				// the unique ID of the vertex is appended for this vert
-				faceIndices.push_back( result.first->second );
+				faceIndices.push_back( index );
 			}
 			else { // have to force unique because this group lacks either normals or texCoords
 				faceIndices.push_back( destTriMesh->getVertices().size() );
@@ -427,7 +749,7 @@ void ObjLoader::loadInternalNormalsTextures( const Group &group, map<VertexTripl
 	}	
 }
 
-void ObjLoader::loadInternalNormals( const Group &group, map<VertexPair,int> &uniqueVerts, TriMesh *destTriMesh )
+void ObjLoader::loadInternalNormals( const Group &group, VertexIndexMap &uniqueVerts, TriMesh *destTriMesh )
 {
     bool hasColors = mMaterials.size() > 0;
 	for( size_t f = 0; f < group.mFaces.size(); ++f ) {
@@ -458,16 +780,16 @@ void ObjLoader::loadInternalNormals( const Group &group, map<VertexPair,int> &un
 		faceIndices.reserve( group.mFaces[f].mNumVertices );
 		for( int v = 0; v < group.mFaces[f].mNumVertices; ++v ) {
 			if( ! forceUnique ) {
-				VertexPair triple = make_tuple( group.mFaces[f].mVertexIndices[v], group.mFaces[f].mNormalIndices[v] );
-				pair<map<VertexPair,int>::iterator,bool> result = uniqueVerts.insert( make_pair( triple, destTriMesh->getVertices().size() ) );
-				if( result.second ) { // we've got a new, unique vertex here, so let's append it
+				bool inserted;
+				int index = uniqueVerts.findOrInsert( group.mFaces[f].mVertexIndices[v], group.mFaces[f].mNormalIndices[v], 0, (int)destTriMesh->getVertices().size(), &inserted );
+				if( inserted ) { // we've got a new, unique vertex here, so let's append it
 					destTriMesh->appendVertex( mVertices[group.mFaces[f].mVertexIndices[v]] );
 					destTriMesh->appendNormal( mNormals[group.mFaces[f].mNormalIndices[v]] );
                     if( hasColors )
                         destTriMesh->appendColorRgb( rgb );
 				}
 				// the unique ID of the vertex is appended for this vert
-				faceIndices.push_back( result.first->second );
+				faceIndices.push_back( index );
 			}
 			else { // have to force unique because this group lacks normals
 				faceIndices.push_back( destTriMesh->getVertices().size() );
@@ -489,7 +811,7 @@ void ObjLoader::loadInternalNormals( const Group &group, map<VertexPair,int> &un
 	}	
 }
 
-void ObjLoader::loadInternalTextures( const Group &group, map<VertexPair,int> &uniqueVerts, TriMesh *destTriMesh )
+void ObjLoader::loadInternalTextures( const Group &group, VertexIndexMap &uniqueVerts, TriMesh *destTriMesh )
 {
     bool hasColors = mMaterials.size() > 0;
 	for( size_t f = 0; f < group.mFaces.size(); ++f ) {
@@ -515,16 +837,16 @@ void ObjLoader::loadInternalTextures( const Group &group, map<VertexPair,int> &u
 		faceIndices.reserve( group.mFaces[f].mNumVertices );
 		for( int v = 0; v < group.mFaces[f].mNumVertices; ++v ) {
 			if( ! forceUnique ) {
-				VertexPair triple = make_tuple( group.mFaces[f].mVertexIndices[v], group.mFaces[f].mTexCoordIndices[v] );
-				pair<map<VertexPair,int>::iterator,bool> result = uniqueVerts.insert( make_pair( triple, destTriMesh->getVertices().size() ) );
-				if( result.second ) { // we've got a new, unique vertex here, so let's append it
+				bool inserted;
+				int index = uniqueVerts.findOrInsert( group.mFaces[f].mVertexIndices[v], group.mFaces[f].mTexCoordIndices[v], 0, (int)destTriMesh->getVertices().size(), &inserted );
+				if( inserted ) { // we've got a new, unique vertex here, so let's append it
 					destTriMesh->appendVertex( mVertices[group.mFaces[f].mVertexIndices[v]] );
 					destTriMesh->appendTexCoord( mTexCoords[group.mFaces[f].mTexCoordIndices[v]] );
                     if( hasColors )
                         destTriMesh->appendColorRgb( rgb );
 				}
 				// the unique ID of the vertex is appended for this vert
-				faceIndices.push_back( result.first->second );
+				faceIndices.push_back( index );
 			}
 			else { // have to force unique because this group lacks texCoords
 				faceIndices.push_back( destTriMesh->getVertices().size() );
@@ -546,7 +868,7 @@ void ObjLoader::loadInternalTextures( const Group &group, map<VertexPair,int> &u
 	}	
 }
 
-void ObjLoader::loadInternal( const Group &group, map<int,int> &uniqueVerts, TriMesh *destTriMesh )
+void ObjLoader::loadInternal( const Group &group, vector<int> &uniqueVerts, TriMesh *destTriMesh )
 {
     bool hasColors = mMaterials.size() > 0;
 	for( size_t f = 0; f < group.mFaces.size(); ++f ) {
@@ -567,14 +889,15 @@ void ObjLoader::loadInternal( const Group &group, map<int,int> &uniqueVerts, Tri
 		vector<int> faceIndices;
 		faceIndices.reserve( group.mFaces[f].mNumVertices );
 		for( int v = 0; v < group.mFaces[f].mNumVertices; ++v ) {
-			pair<map<int,int>::iterator,bool> result = uniqueVerts.insert( make_pair( group.mFaces[f].mVertexIndices[v], destTriMesh->getVertices().size() ) );
-			if( result.second ) { // we've got a new, unique vertex here, so let's append it
+			int &index = uniqueVerts[group.mFaces[f].mVertexIndices[v]];
+			if( index < 0 ) { // we've got a new, unique vertex here, so let's append it
+				index = (int)destTriMesh->getVertices().size();
 				destTriMesh->appendVertex( mVertices[group.mFaces[f].mVertexIndices[v]] );
                 if( hasColors )
                     destTriMesh->appendColorRgb( rgb );
 			}
 			// the unique ID of the vertex is appended for this vert
-			faceIndices.push_back( result.first->second );
+			faceIndices.push_back( index );
 		}
 
 		int triangles = faceIndices.size() - 2;
@@ -0,0 +1,404 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/Rasterizer.h"
+#include "cinder/TaskPool.h"
+#include "cinder/CinderMath.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace cinder {
+
+namespace {
+
+// rows per band; each band is rasterized independently into its own accumulation buffer
+const int32_t BAND_HEIGHT = 32;
+// below this many binned edges, rasterizing on the calling thread beats waking the TaskPool
+const size_t MIN_PARALLEL_EDGES = 2048;
+
+inline uint32_t div255( uint32_t v )
+{
+	return ( v + 128 + ( ( v + 128 ) >> 8 ) ) >> 8;
+}
+
+inline uint32_t toUnit8( float v )
+{
+	return (uint32_t)( constrain( v, 0.0f, 1.0f ) * 255 + 0.5f );
+}
+
+/* Adds the signed area \a edge covers between rows \a top and \a bottom to \a acc, a buffer of (bottom - top) rows of
+	\a stride floats. Summing a row of \a acc from left to right yields each pixel's coverage by the winding of the edges. */
+void accumulateEdge( float ex0, float ey0, float ex1, float ey1, int32_t top, int32_t bottom, int32_t width, float *acc, int32_t stride, int32_t *rowMin, int32_t *rowMax )
+{
+	float dir = 1;
+	if( ey0 > ey1 ) {
+		std::swap( ex0, ex1 );
+		std::swap( ey0, ey1 );
+		dir = -1;
+	}
+	float yTop = std::max( ey0, (float)top ), yBottom = std::min( ey1, (float)bottom );
+	if( yTop >= yBottom )
+		return;
+
+	float dxdy = ( ex1 - ex0 ) / ( ey1 - ey0 );
+	float x = ex0 + ( yTop - ey0 ) * dxdy;
+	int32_t yEnd = (int32_t)math<float>::ceil( yBottom );
+	for( int32_t y = (int32_t)yTop; y < yEnd; ++y ) {
+		float dy = std::min( (float)( y + 1 ), yBottom ) - std::max( (float)y, yTop );
+		float xNext = constrain( x + dxdy * dy, 0.0f, (float)width );
+		float d = dy * dir;
+		float *line = acc + ( y - top ) * stride;
+		float x0 = std::min( x, xNext ), x1 = std::max( x, xNext );
+		float x0Floor = math<float>::floor( x0 );
+		int32_t x0i = (int32_t)x0Floor;
+		int32_t x1i = (int32_t)math<float>::ceil( x1 );
+		if( x1i <= x0i + 1 ) {
+			// within a single pixel; split the area by the edge's mean x
+			float xm = 0.5f * ( x + xNext ) - x0Floor;
+			line[x0i] += d - d * xm;
+			line[x0i + 1] += d * xm;
+			x1i = x0i + 1;
+		}
+		else {
+			// crosses several pixels: a triangle in the first, trapezoids of constant slope between, a triangle in the last
+			float s = 1.0f / ( x1 - x0 );
+			float x0f = x0 - x0Floor;
+			float a0 = 0.5f * s * ( 1 - x0f ) * ( 1 - x0f );
+			float x1f = x1 - x1i + 1;
+			float am = 0.5f * s * x1f * x1f;
+			line[x0i] += d * a0;
+			if( x1i == x0i + 2 )
+				line[x0i + 1] += d * ( 1 - a0 - am );
+			else {
+				float a1 = s * ( 1.5f - x0f );
+				line[x0i + 1] += d * ( a1 - a0 );
+				for( int32_t xi = x0i + 2; xi < x1i - 1; ++xi )
+					line[xi] += d * s;
+				float a2 = a1 + ( x1i - x0i - 3 ) * s;
+				line[x1i - 1] += d * ( 1 - a2 - am );
+			}
+			line[x1i] += d * am;
+		}
+		rowMin[y - top] = std::min( rowMin[y - top], x0i );
+		rowMax[y - top] = std::max( rowMax[y - top], x1i );
+		x = xNext;
+	}
+}
+
+struct SolidFillFn {
+	SolidFillFn( Surface8u *surface, const ColorA &color )
+		: mData( surface->getData() ), mRowBytes( surface->getRowBytes() ), mPixelInc( surface->getPixelInc() ),
+		mRed( surface->getRedOffset() ), mGreen( surface->getGreenOffset() ), mBlue( surface->getBlueOffset() ),
+		mAlpha( surface->hasAlpha() ? surface->getAlphaOffset() : -1 )
+	{
+		float alpha = constrain( color.a, 0.0f, 1.0f );
+		mColor[0] = toUnit8( color.r * alpha );
+		mColor[1] = toUnit8( color.g * alpha );
+		mColor[2] = toUnit8( color.b * alpha );
+		mColor[3] = toUnit8( alpha );
+	}
+
+	void operator()( int32_t x, int32_t y, int32_t count, const float *coverage ) const
+	{
+		uint8_t *pixel = mData + y * mRowBytes + x * mPixelInc;
+		for( int32_t i = 0; i < count; ++i, pixel += mPixelInc ) {
+			uint32_t c = (uint32_t)( coverage[i] * 255 + 0.5f );
+			if( c == 0 )
+				continue;
+			uint32_t inverse = 255 - div255( mColor[3] * c );
+			pixel[mRed] = (uint8_t)( div255( mColor[0] * c ) + div255( pixel[mRed] * inverse ) );
+			pixel[mGreen] = (uint8_t)( div255( mColor[1] * c ) + div255( pixel[mGreen] * inverse ) );
+			pixel[mBlue] = (uint8_t)( div255( mColor[2] * c ) + div255( pixel[mBlue] * inverse ) );
+			if( mAlpha >= 0 )
+				pixel[mAlpha] = (uint8_t)( div255( mColor[3] * c ) + div255( pixel[mAlpha] * inverse ) );
+		}
+	}
+
+	uint8_t		*mData;
+	int32_t		mRowBytes, mPixelInc;
+	int32_t		mRed, mGreen, mBlue, mAlpha;
+	uint32_t	mColor[4];
+};
+
+struct MaskFillFn {
+	MaskFillFn( Channel8u *channel )
+		: mData( channel->getData() ), mRowBytes( channel->getRowBytes() ), mIncrement( channel->getIncrement() )
+	{}
+
+	void operator()( int32_t x, int32_t y, int32_t count, const float *coverage ) const
+	{
+		uint8_t *value = mData + y * mRowBytes + x * mIncrement;
+		for( int32_t i = 0; i < count; ++i, value += mIncrement ) {
+			uint32_t c = (uint32_t)( coverage[i] * 255 + 0.5f );
+			*value = (uint8_t)( c + div255( *value * ( 255 - c ) ) );
+		}
+	}
+
+	uint8_t		*mData;
+	int32_t		mRowBytes, mIncrement;
+};
+
+} // anonymous namespace
+
+struct RasterizeBandsFn {
+	RasterizeBandsFn( const Rasterizer *rasterizer, int32_t firstRow, const vector<uint32_t> &bandStarts, const vector<uint32_t> &bandEdges, const Rasterizer::SpanFn &spanFn, Triangulator::Winding winding )
+		: mRasterizer( rasterizer ), mFirstRow( firstRow ), mBandStarts( bandStarts ), mBandEdges( bandEdges ), mSpanFn( spanFn ), mWinding( winding )
+	{}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		mRasterizer->rasterizeBands( begin, end, mFirstRow, mBandStarts, mBandEdges, mSpanFn, mWinding );
+	}
+
+	const Rasterizer			*mRasterizer;
+	int32_t						mFirstRow;
+	const vector<uint32_t>		&mBandStarts, &mBandEdges;
+	const Rasterizer::SpanFn	&mSpanFn;
+	Triangulator::Winding			mWinding;
+};
+
+Rasterizer::Rasterizer( int32_t width, int32_t height )
+	: mWidth( std::max<int32_t>( width, 0 ) ), mHeight( std::max<int32_t>( height, 0 ) )
+{
+	clear();
+}
+
+void Rasterizer::clear()
+{
+	mEdges.clear();
+	mMinX = mMinY = numeric_limits<float>::max();
+	mMaxX = mMaxY = -numeric_limits<float>::max();
+}
+
+Area Rasterizer::getBounds() const
+{
+	if( mEdges.empty() )
+		return Area( 0, 0, 0, 0 );
+	return Area( (int32_t)math<float>::floor( mMinX ), (int32_t)math<float>::floor( mMinY ), std::min( mWidth, (int32_t)math<float>::ceil( mMaxX ) ), std::min( mHeight, (int32_t)math<float>::ceil( mMaxY ) ) );
+}
+
+float Rasterizer::calcAreaScale( const MatrixAffine2f &transform )
+{
+	Vec2f xAxis = transform.transformVec( Vec2f( 1, 0 ) );
+	Vec2f yAxis = transform.transformVec( Vec2f( 0, 1 ) );
+	return math<float>::abs( xAxis.x * yAxis.y - xAxis.y * yAxis.x );
+}
+
+void Rasterizer::addShape( const Shape2d &shape, const MatrixAffine2f &transform, float approximationScale )
+{
+	const vector<Path2d> &contours = shape.getContours();
+	for( vector<Path2d>::const_iterator contourIt = contours.begin(); contourIt != contours.end(); ++contourIt )
+		addPath( *contourIt, transform, approximationScale );
+}
+
+void Rasterizer::addPath( const Path2d &path, const MatrixAffine2f &transform, float approximationScale )
+{
+	// curves are subdivided before transforming, so scale the tolerance by the transform's magnification
+	float scale = approximationScale * math<float>::sqrt( calcAreaScale( transform ) );
+	if( path.empty() || scale <= 0 )
+		return;
+	vector<Vec2f> points = path.subdivide( scale );
+	addPolygon( &points[0], points.size(), transform );
+}
+
+void Rasterizer::addPolyLine( const PolyLine2f &polyLine, const MatrixAffine2f &transform )
+{
+	if( polyLine.size() )
+		addPolygon( &polyLine.getPoints()[0], polyLine.size(), transform );
+}
+
+void Rasterizer::addPolygon( const Vec2f *points, size_t numPoints, const MatrixAffine2f &transform )
+{
+	if( numPoints < 2 )
+		return;
+	Vec2f first = transform.transformPoint( points[0] ), prev = first;
+	for( size_t p = 1; p < numPoints; ++p ) {
+		Vec2f cur = transform.transformPoint( points[p] );
+		addLine( prev, cur );
+		prev = cur;
+	}
+	addLine( prev, first );
+}
+
+void Rasterizer::addLine( Vec2f p0, Vec2f p1 )
+{
+	// horizontal edges don't change the winding, and NaNs would poison the accumulation
+	if( ! ( p0.y != p1.y ) || p0.x != p0.x || p1.x != p1.x )
+		return;
+	float height = (float)mHeight, width = (float)mWidth;
+	if( ( p0.y <= 0 && p1.y <= 0 ) || ( p0.y >= height && p1.y >= height ) )
+		return;
+
+	// clip to the rows of the raster
+	float dxdy = ( p1.x - p0.x ) / ( p1.y - p0.y );
+	if( p0.y < 0 ) { p0.x -= p0.y * dxdy; p0.y = 0; }
+	if( p1.y < 0 ) { p1.x -= p1.y * dxdy; p1.y = 0; }
+	if( p0.y > height ) { p0.x += ( height - p0.y ) * dxdy; p0.y = height; }
+	if( p1.y > height ) { p1.x += ( height - p1.y ) * dxdy; p1.y = height; }
+
+	// split where the line crosses the left and right sides; the parts outside are flattened onto them, where they
+	// still contribute their winding to the pixels to their right
+	float splits[2];
+	int numSplits = 0;
+	for( int side = 0; side < 2; ++side ) {
+		float x = side ? width : 0;
+		if( ( p0.x < x ) != ( p1.x < x ) && p0.x != x && p1.x != x )
+			splits[numSplits++] = ( x - p0.x ) / ( p1.x - p0.x );
+	}
+	if( numSplits == 2 && splits[0] > splits[1] )
+		std::swap( splits[0], splits[1] );
+
+	Vec2f start = p0;
+	for( int s = 0; s < numSplits; ++s ) {
+		Vec2f split = p0 + ( p1 - p0 ) * splits[s];
+		addClippedLine( start, split );
+		start = split;
+	}
+	addClippedLine( start, p1 );
+}
+
+void Rasterizer::addClippedLine( const Vec2f &p0, const Vec2f &p1 )
+{
+	if( p0.y == p1.y )
+		return;
+	Edge edge;
+	edge.x0 = constrain( p0.x, 0.0f, (float)mWidth );
+	edge.y0 = p0.y;
+	edge.x1 = constrain( p1.x, 0.0f, (float)mWidth );
+	edge.y1 = p1.y;
+	mEdges.push_back( edge );
+
+	mMinX = std::min( mMinX, std::min( edge.x0, edge.x1 ) );
+	mMaxX = std::max( mMaxX, std::max( edge.x0, edge.x1 ) );
+	mMinY = std::min( mMinY, std::min( edge.y0, edge.y1 ) );
+	mMaxY = std::max( mMaxY, std::max( edge.y0, edge.y1 ) );
+}
+
+void Rasterizer::rasterize( const SpanFn &spanFn, Triangulator::Winding winding ) const
+{
+	if( mEdges.empty() || mWidth == 0 )
+		return;
+
+	// bin the edges into the bands they cross with a counting sort
+	int32_t firstRow = std::max<int32_t>( 0, (int32_t)mMinY ) / BAND_HEIGHT * BAND_HEIGHT;
+	int32_t lastRow = std::min<int32_t>( mHeight, (int32_t)math<float>::ceil( mMaxY ) );
+	if( lastRow <= firstRow )
+		return;
+	size_t numBands = ( lastRow - firstRow + BAND_HEIGHT - 1 ) / BAND_HEIGHT;
+	vector<uint32_t> bandStarts( numBands + 1, 0 );
+	for( vector<Edge>::const_iterator edgeIt = mEdges.begin(); edgeIt != mEdges.end(); ++edgeIt ) {
+		int32_t b0 = ( (int32_t)std::min( edgeIt->y0, edgeIt->y1 ) - firstRow ) / BAND_HEIGHT;
+		int32_t b1 = ( (int32_t)math<float>::ceil( std::max( edgeIt->y0, edgeIt->y1 ) ) - 1 - firstRow ) / BAND_HEIGHT;
+		for( int32_t b = b0; b <= std::min<int32_t>( b1, numBands - 1 ); ++b )
+			++bandStarts[b + 1];
+	}
+	for( size_t b = 0; b < numBands; ++b )
+		bandStarts[b + 1] += bandStarts[b];
+	vector<uint32_t> bandEdges( bandStarts.back() ), bandFill( bandStarts.begin(), bandStarts.end() - 1 );
+	for( size_t e = 0; e < mEdges.size(); ++e ) {
+		int32_t b0 = ( (int32_t)std::min( mEdges[e].y0, mEdges[e].y1 ) - firstRow ) / BAND_HEIGHT;
+		int32_t b1 = ( (int32_t)math<float>::ceil( std::max( mEdges[e].y0, mEdges[e].y1 ) ) - 1 - firstRow ) / BAND_HEIGHT;
+		for( int32_t b = b0; b <= std::min<int32_t>( b1, numBands - 1 ); ++b )
+			bandEdges[bandFill[b]++] = (uint32_t)e;
+	}
+
+	if( numBands > 1 && bandEdges.size() >= MIN_PARALLEL_EDGES )
+		TaskPool::getDefault().parallelFor( numBands, 1, RasterizeBandsFn( this, firstRow, bandStarts, bandEdges, spanFn, winding ) );
+	else
+		rasterizeBands( 0, numBands, firstRow, bandStarts, bandEdges, spanFn, winding );
+}
+
+void Rasterizer::rasterizeBands( size_t begin, size_t end, int32_t firstRow, const vector<uint32_t> &bandStarts, const vector<uint32_t> &bandEdges, const SpanFn &spanFn, Triangulator::Winding winding ) const
+{
+	// two extra columns absorb the area of edges lying on the right side
+	const int32_t stride = mWidth + 2;
+	vector<float> acc( stride * BAND_HEIGHT, 0.0f ), coverage( mWidth );
+	int32_t rowMin[BAND_HEIGHT], rowMax[BAND_HEIGHT];
+	for( size_t b = begin; b < end; ++b ) {
+		int32_t top = firstRow + (int32_t)b * BAND_HEIGHT;
+		int32_t bottom = std::min( top + BAND_HEIGHT, mHeight );
+		std::fill( rowMin, rowMin + BAND_HEIGHT, numeric_limits<int32_t>::max() );
+		std::fill( rowMax, rowMax + BAND_HEIGHT, -1 );
+		for( uint32_t e = bandStarts[b]; e < bandStarts[b + 1]; ++e ) {
+			const Edge &edge = mEdges[bandEdges[e]];
+			accumulateEdge( edge.x0, edge.y0, edge.x1, edge.y1, top, bottom, mWidth, &acc[0], stride, rowMin, rowMax );
+		}
+
+		for( int32_t row = 0; row < bottom - top; ++row ) {
+			if( rowMax[row] < 0 )
+				continue;
+			// only the span between the leftmost and rightmost edge can be covered, as closed outlines wind back to zero
+			float *line = &acc[row * stride];
+			int32_t x0 = rowMin[row], x1 = std::min( rowMax[row], mWidth - 1 );
+			float sum = 0;
+			if( winding == Triangulator::WINDING_NONZERO ) {
+				for( int32_t x = x0; x <= x1; ++x ) {
+					sum += line[x];
+					coverage[x - x0] = std::min( 1.0f, math<float>::abs( sum ) );
+				}
+			}
+			else if( winding == Triangulator::WINDING_ODD ) {
+				for( int32_t x = x0; x <= x1; ++x ) {
+					sum += line[x];
+					float c = math<float>::abs( sum );
+					c -= 2 * math<float>::floor( c * 0.5f );
+					coverage[x - x0] = ( c > 1 ) ? ( 2 - c ) : c;
+				}
+			}
+			else {
+				for( int32_t x = x0; x <= x1; ++x ) {
+					sum += line[x];
+					float c;
+					if( winding == Triangulator::WINDING_POSITIVE )
+						c = sum;
+					else if( winding == Triangulator::WINDING_NEGATIVE )
+						c = -sum;
+					else // WINDING_ABS_GEQ_TWO
+						c = math<float>::abs( sum ) - 1;
+					coverage[x - x0] = math<float>::clamp( c, 0, 1 );
+				}
+			}
+			std::fill( line + x0, line + rowMax[row] + 1, 0.0f );
+			if( x1 >= x0 )
+				spanFn( x0, top + row, x1 - x0 + 1, &coverage[0] );
+		}
+	}
+}
+
+void Rasterizer::fill( Surface8u *surface, const ColorA &color, Triangulator::Winding winding ) const
+{
+	if( surface->getWidth() < mWidth || surface->getHeight() < mHeight )
+		return;
+	rasterize( SolidFillFn( surface, color ), winding );
+}
+
+void Rasterizer::fill( Channel8u *channel, Triangulator::Winding winding ) const
+{
+	if( channel->getWidth() < mWidth || channel->getHeight() < mHeight )
+		return;
+	rasterize( MaskFillFn( channel ), winding );
+}
+
+} // namespace cinder
@@ -0,0 +1,321 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/SpatialHash.h"
+#include "cinder/TaskPool.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+using std::vector;
+
+namespace cinder {
+
+namespace {
+
+const uint32_t	MIN_BUCKETS = 64;
+// each chunk of points is grouped by a single task, and needs its own count of every group
+const size_t	MIN_CHUNK_POINTS = 16384;
+// points are first grouped by the high bits of their bucket, which bounds the counts each chunk keeps
+const uint32_t	MAX_GROUP_BITS = 10;
+const size_t	SORT_GROUPS_GRAIN_SIZE = 8;
+
+typedef std::pair<float, uint32_t>	DistanceIndex;
+
+struct InRadiusProc {
+	InRadiusProc( vector<uint32_t> *result ) : mResult( *result ) {}
+
+	void process( uint32_t id, float, float & ) { mResult.push_back( id ); }
+
+	vector<uint32_t>	&mResult;
+};
+
+//! Keeps the \a k nearest points seen in a max-heap, so the farthest of them is on top to be replaced
+class NearestHeap {
+  public:
+	NearestHeap( size_t k ) : mK( k ) { mHeap.reserve( k + 1 ); }
+
+	bool	isFull() const { return mHeap.size() == mK; }
+	//! Returns the squared distance which a point has to beat to be kept
+	float	getMaxDistSqrd() const { return isFull() ? mHeap.front().first : std::numeric_limits<float>::max(); }
+
+	void	push( float distSqrd, uint32_t index )
+	{
+		mHeap.push_back( DistanceIndex( distSqrd, index ) );
+		std::push_heap( mHeap.begin(), mHeap.end() );
+		if( mHeap.size() > mK ) {
+			std::pop_heap( mHeap.begin(), mHeap.end() );
+			mHeap.pop_back();
+		}
+	}
+
+	void	clear() { mHeap.clear(); }
+
+	void	getSorted( vector<uint32_t> *result, vector<float> *distancesSqrd )
+	{
+		std::sort_heap( mHeap.begin(), mHeap.end() );
+		result->resize( mHeap.size() );
+		for( size_t i = 0; i < mHeap.size(); ++i )
+			(*result)[i] = mHeap[i].second;
+		if( distancesSqrd ) {
+			distancesSqrd->resize( mHeap.size() );
+			for( size_t i = 0; i < mHeap.size(); ++i )
+				(*distancesSqrd)[i] = mHeap[i].first;
+		}
+	}
+
+  private:
+	size_t					mK;
+	vector<DistanceIndex>	mHeap;
+};
+
+size_t calcChunkBegin( size_t chunk, size_t numChunks, size_t numPoints )
+{
+	return (size_t)( (uint64_t)numPoints * chunk / numChunks );
+}
+
+} // anonymous namespace
+
+//! Finds the bucket of each point, counts each chunk's points per group and the range of cells each chunk spans
+struct SpatialHash::HashPointsFn {
+	HashPointsFn( SpatialHash *hash, const Vec3f *points, size_t numPoints, size_t numChunks, uint32_t groupShift )
+		: mHash( *hash ), mPoints( points ), mNumPoints( numPoints ), mNumChunks( numChunks ), mGroupShift( groupShift ) {}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		const size_t numGroups = ( mHash.mBucketMask >> mGroupShift ) + 1;
+		for( size_t chunk = begin; chunk < end; ++chunk ) {
+			uint32_t *counts = &mHash.mChunkCounts[chunk * numGroups];
+			std::fill( counts, counts + numGroups, 0 );
+			Cell minCell = { std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::max() };
+			Cell maxCell = { std::numeric_limits<int>::min(), std::numeric_limits<int>::min(), std::numeric_limits<int>::min() };
+			for( size_t p = calcChunkBegin( chunk, mNumChunks, mNumPoints ); p < calcChunkBegin( chunk + 1, mNumChunks, mNumPoints ); ++p ) {
+				const Cell cell = mHash.calcCell( mPoints[p] );
+				const uint32_t bucket = mHash.calcBucket( cell.x, cell.y, cell.z );
+				mHash.mPointBuckets[p] = bucket;
+				++counts[bucket >> mGroupShift];
+				minCell.x = std::min( minCell.x, cell.x ); minCell.y = std::min( minCell.y, cell.y ); minCell.z = std::min( minCell.z, cell.z );
+				maxCell.x = std::max( maxCell.x, cell.x ); maxCell.y = std::max( maxCell.y, cell.y ); maxCell.z = std::max( maxCell.z, cell.z );
+			}
+			mHash.mChunkMinCells[chunk] = minCell;
+			mHash.mChunkMaxCells[chunk] = maxCell;
+		}
+	}
+
+	SpatialHash		&mHash;
+	const Vec3f		*mPoints;
+	size_t			mNumPoints, mNumChunks;
+	uint32_t		mGroupShift;
+};
+
+//! Copies the index of each chunk's points to their place in the order by group, where each chunk's count has become the start of its points within the group
+struct SpatialHash::GroupPointsFn {
+	GroupPointsFn( SpatialHash *hash, size_t numPoints, size_t numChunks, uint32_t groupShift )
+		: mHash( *hash ), mNumPoints( numPoints ), mNumChunks( numChunks ), mGroupShift( groupShift ) {}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		const size_t numGroups = ( mHash.mBucketMask >> mGroupShift ) + 1;
+		for( size_t chunk = begin; chunk < end; ++chunk ) {
+			uint32_t *offsets = &mHash.mChunkCounts[chunk * numGroups];
+			for( size_t p = calcChunkBegin( chunk, mNumChunks, mNumPoints ); p < calcChunkBegin( chunk + 1, mNumChunks, mNumPoints ); ++p )
+				mHash.mGroupedPoints[offsets[mHash.mPointBuckets[p] >> mGroupShift]++] = (uint32_t)p;
+		}
+	}
+
+	SpatialHash		&mHash;
+	size_t			mNumPoints, mNumChunks;
+	uint32_t		mGroupShift;
+};
+
+//! Sorts the points of each group by bucket, which only touches the group's own range of buckets and keeps points within a bucket in their original order
+struct SpatialHash::SortGroupsFn {
+	SortGroupsFn( SpatialHash *hash, const Vec3f *points, const vector<uint32_t> &groupStarts, uint32_t groupShift )
+		: mHash( *hash ), mPoints( points ), mGroupStarts( groupStarts ), mGroupShift( groupShift ) {}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		uint32_t *bucketEnds = &mHash.mBucketStarts[0];
+		for( size_t group = begin; group < end; ++group ) {
+			const uint32_t firstBucket = (uint32_t)group << mGroupShift, lastBucket = firstBucket + ( 1u << mGroupShift );
+			const uint32_t groupBegin = mGroupStarts[group], groupEnd = mGroupStarts[group + 1];
+			std::fill( bucketEnds + firstBucket, bucketEnds + lastBucket, 0 );
+			for( uint32_t g = groupBegin; g < groupEnd; ++g )
+				++bucketEnds[mHash.mPointBuckets[mHash.mGroupedPoints[g]]];
+			uint32_t bucketEnd = groupBegin;
+			for( uint32_t bucket = firstBucket; bucket < lastBucket; ++bucket ) {
+				bucketEnd += bucketEnds[bucket];
+				bucketEnds[bucket] = bucketEnd;
+			}
+			// placing the points backwards from the end of each bucket leaves its start behind
+			for( uint32_t g = groupEnd; g > groupBegin; --g ) {
+				const uint32_t p = mHash.mGroupedPoints[g - 1];
+				const uint32_t sorted = --bucketEnds[mHash.mPointBuckets[p]];
+				mHash.mSortedPoints[sorted] = mPoints[p];
+				mHash.mSortedIndices[sorted] = p;
+			}
+		}
+	}
+
+	SpatialHash				&mHash;
+	const Vec3f				*mPoints;
+	const vector<uint32_t>	&mGroupStarts;
+	uint32_t				mGroupShift;
+};
+
+SpatialHash::SpatialHash( float cellSize )
+	: mCellSize( cellSize ), mInvCellSize( 1 / cellSize ), mBucketMask( 0 ), mBucketStarts( 2, 0 )
+{
+	Cell empty = { 0, 0, 0 };
+	mMinCell = mMaxCell = empty;
+}
+
+SpatialHash::SpatialHash( const std::vector<Vec3f> &points, float cellSize )
+	: mCellSize( cellSize ), mInvCellSize( 1 / cellSize ), mBucketMask( 0 ), mBucketStarts( 2, 0 )
+{
+	build( points );
+}
+
+void SpatialHash::build( const std::vector<Vec3f> &points )
+{
+	build( points.empty() ? 0 : &points[0], points.size() );
+}
+
+void SpatialHash::build( const Vec3f *points, size_t numPoints )
+{
+	mInvCellSize = 1 / mCellSize;
+	// about one point per bucket keeps collisions between cells rare without wasting memory on empty buckets
+	const uint32_t numBuckets = std::max( MIN_BUCKETS, nextPowerOf2( (uint32_t)numPoints ) );
+	mBucketMask = numBuckets - 1;
+
+	const uint32_t bucketBits = log2floor( numBuckets );
+	const uint32_t groupShift = ( bucketBits > MAX_GROUP_BITS ) ? bucketBits - MAX_GROUP_BITS : 0;
+	const size_t numGroups = numBuckets >> groupShift;
+
+	TaskPool &pool = TaskPool::getDefault();
+	const size_t numChunks = std::max<size_t>( 1, std::min( pool.getNumThreads(), numPoints / MIN_CHUNK_POINTS ) );
+	mPointBuckets.resize( numPoints );
+	mChunkCounts.resize( numChunks * numGroups );
+	mChunkMinCells.resize( numChunks );
+	mChunkMaxCells.resize( numChunks );
+	pool.parallelFor( numChunks, 1, HashPointsFn( this, points, numPoints, numChunks, groupShift ) );
+
+	// each chunk's count becomes where its points start, after those of every earlier group and of earlier chunks in the same group
+	vector<uint32_t> groupStarts( numGroups + 1 );
+	uint32_t start = 0;
+	for( size_t group = 0; group < numGroups; ++group ) {
+		groupStarts[group] = start;
+		for( size_t chunk = 0; chunk < numChunks; ++chunk ) {
+			const uint32_t count = mChunkCounts[chunk * numGroups + group];
+			mChunkCounts[chunk * numGroups + group] = start;
+			start += count;
+		}
+	}
+	groupStarts[numGroups] = start;
+
+	mGroupedPoints.resize( numPoints );
+	pool.parallelFor( numChunks, 1, GroupPointsFn( this, numPoints, numChunks, groupShift ) );
+
+	mBucketStarts.resize( numBuckets + 1 );
+	mBucketStarts[numBuckets] = (uint32_t)numPoints;
+	mSortedPoints.resize( numPoints );
+	mSortedIndices.resize( numPoints );
+	pool.parallelFor( numGroups, SORT_GROUPS_GRAIN_SIZE, SortGroupsFn( this, points, groupStarts, groupShift ) );
+
+	mMinCell = mChunkMinCells[0];
+	mMaxCell = mChunkMaxCells[0];
+	for( size_t chunk = 1; chunk < numChunks; ++chunk ) {
+		mMinCell.x = std::min( mMinCell.x, mChunkMinCells[chunk].x ); mMinCell.y = std::min( mMinCell.y, mChunkMinCells[chunk].y ); mMinCell.z = std::min( mMinCell.z, mChunkMinCells[chunk].z );
+		mMaxCell.x = std::max( mMaxCell.x, mChunkMaxCells[chunk].x ); mMaxCell.y = std::max( mMaxCell.y, mChunkMaxCells[chunk].y ); mMaxCell.z = std::max( mMaxCell.z, mChunkMaxCells[chunk].z );
+	}
+}
+
+void SpatialHash::findInRadius( const Vec3f &center, float radius, std::vector<uint32_t> *result ) const
+{
+	result->clear();
+	InRadiusProc proc( result );
+	lookup( center, radius, proc );
+}
+
+void SpatialHash::findKNearest( const Vec3f &point, size_t k, std::vector<uint32_t> *result, std::vector<float> *distancesSqrd ) const
+{
+	k = std::min( k, mSortedPoints.size() );
+	NearestHeap nearest( k );
+	if( k == 0 ) {
+		nearest.getSorted( result, distancesSqrd );
+		return;
+	}
+
+	// search shells of cells around the point's cell, one cell thicker at a time, until the nearest points found are closer than anything outside
+	const Cell center = calcCell( point );
+	size_t cellsVisited = 0;
+	for( int shell = 0; ; ++shell ) {
+		for( int z = center.z - shell; z <= center.z + shell; ++z ) {
+			for( int y = center.y - shell; y <= center.y + shell; ++y ) {
+				// on the faces of the shell every cell in the row is new, and inside it only the two at either end
+				const bool onFace = ( z == center.z - shell || z == center.z + shell || y == center.y - shell || y == center.y + shell );
+				const int step = ( onFace || shell == 0 ) ? 1 : 2 * shell;
+				for( int x = center.x - shell; x <= center.x + shell; x += step ) {
+					const uint32_t bucket = calcBucket( x, y, z );
+					for( uint32_t s = mBucketStarts[bucket]; s < mBucketStarts[bucket + 1]; ++s ) {
+						const float distSqrd = mSortedPoints[s].distanceSquared( point );
+						if( distSqrd < nearest.getMaxDistSqrd() && isInCell( s, x, y, z ) )
+							nearest.push( distSqrd, mSortedIndices[s] );
+					}
+					++cellsVisited;
+				}
+			}
+		}
+
+		// every point has been visited once the shells cover all the cells spanned by the points
+		if( center.x - shell <= mMinCell.x && center.y - shell <= mMinCell.y && center.z - shell <= mMinCell.z &&
+			center.x + shell >= mMaxCell.x && center.y + shell >= mMaxCell.y && center.z + shell >= mMaxCell.z )
+			break;
+
+		if( nearest.isFull() ) {
+			const float minX = std::min( point.x - ( center.x - shell ) * mCellSize, ( center.x + shell + 1 ) * mCellSize - point.x );
+			const float minY = std::min( point.y - ( center.y - shell ) * mCellSize, ( center.y + shell + 1 ) * mCellSize - point.y );
+			const float minZ = std::min( point.z - ( center.z - shell ) * mCellSize, ( center.z + shell + 1 ) * mCellSize - point.z );
+			const float outsideDist = std::min( minX, std::min( minY, minZ ) );
+			if( nearest.getMaxDistSqrd() <= outsideDist * outsideDist )
+				break;
+		}
+
+		// when the points are sparse relative to the cells, testing them all is cheaper than visiting more empty cells
+		if( cellsVisited > mSortedPoints.size() ) {
+			nearest.clear();
+			for( uint32_t s = 0; s < mSortedPoints.size(); ++s ) {
+				const float distSqrd = mSortedPoints[s].distanceSquared( point );
+				if( distSqrd < nearest.getMaxDistSqrd() )
+					nearest.push( distSqrd, mSortedIndices[s] );
+			}
+			break;
+		}
+	}
+
+	nearest.getSorted( result, distancesSqrd );
+}
+
+} // namespace cinder
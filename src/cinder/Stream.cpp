@@ -34,6 +34,15 @@
 #include <android/asset_manager.h>
 #endif
 
+#if defined( CINDER_MSW )
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
 using std::string;
 
 namespace cinder {
@@ -208,9 +217,11 @@ size_t IStreamFile::readDataImpl( void *t, size_t size )
 		fseek( mFile, static_cast<long>( mBufferOffset ), SEEK_SET );
 		mBufferFileOffset = mBufferOffset;
 		mBufferSize = fread( mBuffer.get(), 1, mDefaultBufferSize, mFile );
-		memcpy( t, mBuffer.get(), size );
-		mBufferOffset = mBufferFileOffset + size;
-		return size;
+		// near the end of the file the buffer may hold less than was asked for
+		const size_t bytesRead = std::min( size, mBufferSize );
+		memcpy( t, mBuffer.get(), bytesRead );
+		mBufferOffset = mBufferFileOffset + bytesRead;
+		return bytesRead;
 	}
 }
 
@@ -482,9 +493,11 @@ size_t IoStreamFile::readDataImpl( void *t, size_t size )
 		fseek( mFile, static_cast<long>( mBufferOffset ), SEEK_SET );
 		mBufferFileOffset = mBufferOffset;
 		mBufferSize = fread( mBuffer.get(), 1, mDefaultBufferSize, mFile );
-		memcpy( t, mBuffer.get(), size );
-		mBufferOffset = mBufferFileOffset + size;
-		return size;
+		// near the end of the file the buffer may hold less than was asked for
+		const size_t bytesRead = std::min( size, static_cast<size_t>( mBufferSize ) );
+		memcpy( t, mBuffer.get(), bytesRead );
+		mBufferOffset = mBufferFileOffset + bytesRead;
+		return bytesRead;
 	}
 }
 
@@ -601,6 +614,107 @@ void OStreamMem::IOWrite( const void *t, size_t size )
 	mOffset += size;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////
+// MappedFile
+namespace {
+
+// An IStreamMem which holds a reference to the MappedFile it reads from
+class IStreamMapped : public IStreamMem {
+  public:
+	IStreamMapped( const MappedFileRef &file, const void *data, size_t size )
+		: IStreamMem( data, size ), mFile( file )
+	{
+		setFileName( file->getFilePath() );
+	}
+
+  private:
+	MappedFileRef	mFile;
+};
+
+} // anonymous namespace
+
+MappedFileRef MappedFile::create( const fs::path &path, bool copyOnWrite )
+{
+	return MappedFileRef( new MappedFile( path, copyOnWrite ) );
+}
+
+#if defined( CINDER_MSW )
+MappedFile::MappedFile( const fs::path &path, bool copyOnWrite )
+	: mData( 0 ), mSize( 0 ), mFilePath( path ), mFileHandle( INVALID_HANDLE_VALUE ), mMappingHandle( NULL )
+{
+	mFileHandle = ::CreateFileW( expandPath( path ).wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if( mFileHandle == INVALID_HANDLE_VALUE )
+		throw StreamExc();
+
+	LARGE_INTEGER fileSize;
+	if( ! ::GetFileSizeEx( mFileHandle, &fileSize ) ) {
+		::CloseHandle( mFileHandle );
+		throw StreamExc();
+	}
+	mSize = static_cast<size_t>( fileSize.QuadPart );
+	if( mSize == 0 ) // empty files can't be mapped
+		return;
+
+	mMappingHandle = ::CreateFileMappingW( mFileHandle, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL );
+	if( mMappingHandle )
+		mData = ::MapViewOfFile( mMappingHandle, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0 );
+	if( ! mData ) {
+		if( mMappingHandle )
+			::CloseHandle( mMappingHandle );
+		::CloseHandle( mFileHandle );
+		throw StreamExc();
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if( mData )
+		::UnmapViewOfFile( mData );
+	if( mMappingHandle )
+		::CloseHandle( mMappingHandle );
+	::CloseHandle( mFileHandle );
+}
+
+#else
+MappedFile::MappedFile( const fs::path &path, bool copyOnWrite )
+	: mData( 0 ), mSize( 0 ), mFilePath( path )
+{
+	int fd = ::open( expandPath( path ).string().c_str(), O_RDONLY );
+	if( fd < 0 )
+		throw StreamExc();
+
+	struct stat fileInfo;
+	if( ::fstat( fd, &fileInfo ) != 0 ) {
+		::close( fd );
+		throw StreamExc();
+	}
+	mSize = static_cast<size_t>( fileInfo.st_size );
+	if( mSize > 0 ) {
+		void *data = ::mmap( 0, mSize, copyOnWrite ? ( PROT_READ | PROT_WRITE ) : PROT_READ, MAP_PRIVATE, fd, 0 );
+		if( data == MAP_FAILED ) {
+			::close( fd );
+			throw StreamExc();
+		}
+		mData = data;
+	}
+	// the mapping remains valid after the descriptor is closed
+	::close( fd );
+}
+
+MappedFile::~MappedFile()
+{
+	if( mData )
+		::munmap( mData, mSize );
+}
+#endif
+
+IStreamMemRef MappedFile::createStream( size_t offset, size_t size )
+{
+	if( offset > mSize || size > mSize - offset )
+		throw StreamExc();
+	return IStreamMemRef( new IStreamMapped( shared_from_this(), reinterpret_cast<const uint8_t*>( mData ) + offset, size ) );
+}
+
 /////////////////////////////////////////////////////////////////////
 
 IStreamFileRef loadFileStream( const fs::path &path )
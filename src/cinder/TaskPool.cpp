@@ -0,0 +1,149 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/TaskPool.h"
+
+#include <algorithm>
+
+namespace cinder {
+
+struct TaskPool::Job {
+	const std::function<void(size_t, size_t)>	*mFn;
+	size_t					mCount, mGrainSize, mNext;
+	size_t					mActiveWorkers;
+	std::exception_ptr		mException;
+	std::mutex				mMutex;
+};
+
+TaskPool::TaskPool( size_t numThreads )
+	: mJob( 0 ), mGeneration( 0 ), mQuit( false )
+{
+	if( numThreads == 0 )
+		numThreads = std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+	for( size_t t = 1; t < numThreads; ++t )
+		mWorkers.push_back( std::shared_ptr<std::thread>( new std::thread( std::bind( &TaskPool::workerLoop, this ) ) ) );
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mQuit = true;
+	}
+	mWakeCondition.notify_all();
+	for( size_t t = 0; t < mWorkers.size(); ++t )
+		mWorkers[t]->join();
+}
+
+TaskPool& TaskPool::getDefault()
+{
+	// never destroyed, so that parallelFor() stays usable from static destructors and detached threads
+	static TaskPool *sDefault = new TaskPool();
+	return *sDefault;
+}
+
+void TaskPool::runChunks( Job *job )
+{
+	while( true ) {
+		size_t begin;
+		{
+			std::lock_guard<std::mutex> lock( job->mMutex );
+			begin = job->mNext;
+			if( begin >= job->mCount )
+				return;
+			job->mNext += std::min( job->mGrainSize, job->mCount - begin );
+		}
+		try {
+			(*job->mFn)( begin, std::min( begin + job->mGrainSize, job->mCount ) );
+		}
+		catch( ... ) {
+			std::lock_guard<std::mutex> lock( job->mMutex );
+			if( ! job->mException )
+				job->mException = std::current_exception();
+			job->mNext = job->mCount;
+		}
+	}
+}
+
+void TaskPool::workerLoop()
+{
+	ThreadSetup threadSetup;
+	uint64_t lastGeneration = 0;
+	std::unique_lock<std::mutex> lock( mMutex );
+	while( true ) {
+		while( ! mQuit && ( ! mJob || mGeneration == lastGeneration ) )
+			mWakeCondition.wait( lock );
+		if( mQuit )
+			return;
+
+		lastGeneration = mGeneration;
+		Job *job = mJob;
+		++job->mActiveWorkers;
+		lock.unlock();
+		runChunks( job );
+		lock.lock();
+		if( --job->mActiveWorkers == 0 )
+			mDoneCondition.notify_all();
+	}
+}
+
+void TaskPool::parallelFor( size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &fn )
+{
+	if( count == 0 )
+		return;
+	grainSize = std::max<size_t>( grainSize, 1 );
+	// a single chunk, no workers or a busy pool all mean running here and now
+	if( count <= grainSize || mWorkers.empty() || ! mCallMutex.try_lock() ) {
+		for( size_t begin = 0; begin < count; begin += grainSize )
+			fn( begin, std::min( begin + grainSize, count ) );
+		return;
+	}
+
+	Job job;
+	job.mFn = &fn;
+	job.mCount = count;
+	job.mGrainSize = grainSize;
+	job.mNext = 0;
+	job.mActiveWorkers = 0;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mJob = &job;
+		++mGeneration;
+	}
+	mWakeCondition.notify_all();
+
+	runChunks( &job );
+
+	{
+		// workers which haven't picked the job up yet must not see it once it goes out of scope
+		std::unique_lock<std::mutex> lock( mMutex );
+		mJob = 0;
+		while( job.mActiveWorkers > 0 )
+			mDoneCondition.wait( lock );
+	}
+	mCallMutex.unlock();
+
+	if( job.mException )
+		std::rethrow_exception( job.mException );
+}
+
+} // namespace cinder
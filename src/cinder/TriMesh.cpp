@@ -21,17 +21,1064 @@
 */
 
 #include "cinder/TriMesh.h"
+#include "cinder/TaskPool.h"
+
+#include <cstring>
+#include <algorithm>
+#include <queue>
 
 using std::vector;
 
 namespace cinder {
 
+namespace {
+
+const char		MESH_MAGIC[4] = { 'C', 'I', 'T', 'M' };
+const size_t	BLOCK_ALIGNMENT = 64;
+const size_t	CHECKSUM_CHUNK_SIZE = 1 << 20;
+
+enum { BLOCK_VERTICES, BLOCK_NORMALS, BLOCK_COLORS_RGB, BLOCK_COLORS_RGBA, BLOCK_TEX_COORDS, BLOCK_INDICES, NUM_BLOCKS };
+enum { INDICES_RAW, INDICES_DELTA_VARINT };
+
+struct FileBlock {
+	uint64_t	offset;		// from the start of the file; a multiple of BLOCK_ALIGNMENT
+	uint64_t	size;		// in bytes, excluding padding
+	uint64_t	count;
+};
+
+// The version 2 header. The version comes first, where version 1 keeps it, and the blocks follow in order, each padded
+// with zeros to BLOCK_ALIGNMENT. All fields and attributes are little-endian.
+struct FileHeader {
+	uint8_t		version;
+	uint8_t		indexEncoding;
+	uint8_t		reserved0[2];
+	char		magic[4];
+	uint64_t	checksum;		// of everything following the header
+	uint64_t	fileSize;
+	FileBlock	blocks[NUM_BLOCKS];
+	uint8_t		reserved[24];
+};
+
+// Fletcher-style sums over 32-bit words. Sums of consecutive ranges can be combined, so large files are summed in parallel.
+struct Checksum {
+	Checksum() : a( 0 ), b( 0 ), numWords( 0 ) {}
+
+	uint64_t	get() const { return ( (uint64_t)b << 32 ) | a; }
+
+	uint32_t	a, b;
+	uint64_t	numWords;
+};
+
+Checksum combine( const Checksum &first, const Checksum &second )
+{
+	Checksum result;
+	result.a = first.a + second.a;
+	result.b = first.b + second.b + first.a * (uint32_t)second.numWords;
+	result.numWords = first.numWords + second.numWords;
+	return result;
+}
+
+// Extends \a sum over \a numWords words of zeros
+Checksum appendZeros( const Checksum &sum, uint64_t numWords )
+{
+	Checksum result( sum );
+	result.b += sum.a * (uint32_t)numWords;
+	result.numWords += numWords;
+	return result;
+}
+
+// Sums \a size bytes, treating a partial last word as padded with zeros
+Checksum checksumWords( const uint8_t *data, size_t size )
+{
+	Checksum result;
+	const size_t numWords = size / 4;
+	for( size_t w = 0; w < numWords; ++w ) {
+		uint32_t word;
+		memcpy( &word, data + w * 4, 4 );
+		result.a += word;
+		result.b += result.a;
+	}
+	result.numWords = numWords;
+
+	if( size % 4 ) {
+		uint32_t word = 0;
+		memcpy( &word, data + numWords * 4, size % 4 );
+		result.a += word;
+		result.b += result.a;
+		++result.numWords;
+	}
+
+	return result;
+}
+
+struct ChecksumChunksFn {
+	ChecksumChunksFn( const uint8_t *data, size_t size, vector<Checksum> *chunks ) : mData( data ), mSize( size ), mChunks( chunks ) {}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		for( size_t c = begin; c < end; ++c ) {
+			const size_t offset = c * CHECKSUM_CHUNK_SIZE;
+			(*mChunks)[c] = checksumWords( mData + offset, std::min( CHECKSUM_CHUNK_SIZE, mSize - offset ) );
+		}
+	}
+
+	const uint8_t		*mData;
+	size_t				mSize;
+	vector<Checksum>	*mChunks;
+};
+
+Checksum calcChecksum( const uint8_t *data, size_t size )
+{
+	vector<Checksum> chunks( ( size + CHECKSUM_CHUNK_SIZE - 1 ) / CHECKSUM_CHUNK_SIZE );
+	TaskPool::getDefault().parallelFor( chunks.size(), 1, ChecksumChunksFn( data, size, &chunks ) );
+
+	Checksum result;
+	for( vector<Checksum>::const_iterator chunkIt = chunks.begin(); chunkIt != chunks.end(); ++chunkIt )
+		result = combine( result, *chunkIt );
+	return result;
+}
+
+uint64_t alignBlockSize( uint64_t size )
+{
+	return ( size + BLOCK_ALIGNMENT - 1 ) & ~(uint64_t)( BLOCK_ALIGNMENT - 1 );
+}
+
+// Each index is stored as the zigzagged difference from its predecessor, in 7-bit groups with the high bit marking continuation
+void encodeIndices( const vector<uint32_t> &indices, vector<uint8_t> *result )
+{
+	result->reserve( indices.size() * 2 );
+	uint32_t previous = 0;
+	for( vector<uint32_t>::const_iterator indexIt = indices.begin(); indexIt != indices.end(); ++indexIt ) {
+		const int32_t delta = (int32_t)( *indexIt - previous );
+		uint32_t zigzag = ( (uint32_t)delta << 1 ) ^ (uint32_t)( delta >> 31 );
+		while( zigzag >= 0x80 ) {
+			result->push_back( (uint8_t)( zigzag | 0x80 ) );
+			zigzag >>= 7;
+		}
+		result->push_back( (uint8_t)zigzag );
+		previous = *indexIt;
+	}
+}
+
+// Returns false unless \a size bytes decode to exactly \a count indices
+bool decodeIndices( const uint8_t *data, size_t size, size_t count, uint32_t *result )
+{
+	const uint8_t *end = data + size;
+	uint32_t previous = 0;
+	for( size_t i = 0; i < count; ++i ) {
+		uint32_t zigzag = 0;
+		for( int shift = 0; ; shift += 7 ) {
+			if( data == end || shift > 28 )
+				return false;
+			const uint8_t byte = *data++;
+			zigzag |= (uint32_t)( byte & 0x7F ) << shift;
+			if( ! ( byte & 0x80 ) )
+				break;
+		}
+		previous += ( zigzag >> 1 ) ^ ( 0u - ( zigzag & 1 ) );
+		result[i] = previous;
+	}
+
+	return data == end;
+}
+
+template<typename T>
+void setBlock( FileBlock *block, const uint8_t **blockData, const vector<T> &elements )
+{
+	block->count = elements.size();
+	block->size = elements.size() * sizeof(T);
+	*blockData = elements.empty() ? 0 : reinterpret_cast<const uint8_t*>( &elements[0] );
+}
+
+template<typename T>
+const T* getBlock( const uint8_t *data, const FileBlock &block )
+{
+	return block.count ? reinterpret_cast<const T*>( data + block.offset ) : 0;
+}
+
+void writeVersion2( const TriMesh &mesh, OStreamRef out, bool compressIndices )
+{
+#if ! defined( CINDER_LITTLE_ENDIAN )
+	// attributes are stored in host order so that TriMeshView can use them in place
+	throw TriMeshExc();
+#endif
+	FileHeader header;
+	memset( &header, 0, sizeof(header) );
+	header.version = 2;
+	header.indexEncoding = compressIndices ? INDICES_DELTA_VARINT : INDICES_RAW;
+	memcpy( header.magic, MESH_MAGIC, 4 );
+
+	const uint8_t *blockData[NUM_BLOCKS];
+	setBlock( &header.blocks[BLOCK_VERTICES], &blockData[BLOCK_VERTICES], mesh.getVertices() );
+	setBlock( &header.blocks[BLOCK_NORMALS], &blockData[BLOCK_NORMALS], mesh.getNormals() );
+	setBlock( &header.blocks[BLOCK_COLORS_RGB], &blockData[BLOCK_COLORS_RGB], mesh.getColorsRGB() );
+	setBlock( &header.blocks[BLOCK_COLORS_RGBA], &blockData[BLOCK_COLORS_RGBA], mesh.getColorsRGBA() );
+	setBlock( &header.blocks[BLOCK_TEX_COORDS], &blockData[BLOCK_TEX_COORDS], mesh.getTexCoords() );
+	vector<uint8_t> encodedIndices;
+	if( compressIndices ) {
+		encodeIndices( mesh.getIndices(), &encodedIndices );
+		setBlock( &header.blocks[BLOCK_INDICES], &blockData[BLOCK_INDICES], encodedIndices );
+		header.blocks[BLOCK_INDICES].count = mesh.getNumIndices();
+	}
+	else
+		setBlock( &header.blocks[BLOCK_INDICES], &blockData[BLOCK_INDICES], mesh.getIndices() );
+
+	// lay the blocks out and sum them as they will appear in the file, padding included
+	uint64_t offset = sizeof(FileHeader);
+	Checksum sum;
+	for( int b = 0; b < NUM_BLOCKS; ++b ) {
+		FileBlock &block = header.blocks[b];
+		const uint64_t paddedSize = alignBlockSize( block.size );
+		block.offset = offset;
+		sum = combine( sum, calcChecksum( blockData[b], static_cast<size_t>( block.size ) ) );
+		sum = appendZeros( sum, paddedSize / 4 - ( block.size + 3 ) / 4 );
+		offset += paddedSize;
+	}
+	header.fileSize = offset;
+	header.checksum = sum.get();
+
+	static const uint8_t zeros[BLOCK_ALIGNMENT] = { 0 };
+	out->writeData( &header, sizeof(header) );
+	for( int b = 0; b < NUM_BLOCKS; ++b ) {
+		const size_t size = static_cast<size_t>( header.blocks[b].size );
+		if( size )
+			out->writeData( blockData[b], size );
+		if( alignBlockSize( size ) != size )
+			out->writeData( zeros, static_cast<size_t>( alignBlockSize( size ) - size ) );
+	}
+}
+
+const size_t MIN_SLICE_TRIANGLES = 1 << 16;
+const size_t REDUCE_GRAIN_SIZE = 4096;
+
+// Per-vertex sums from a slice of the triangles, covering only the vertices from \a first to \a last that the slice uses.
+// The first slice sums straight into the result instead. For a mesh with coherent indices each of the others spans a small
+// part of the vertices, so together they need not much more memory than the result.
+struct SliceSums {
+	SliceSums() : first( 0 ), last( 0 ) {}
+
+	void allocate( const vector<uint32_t> &indices, size_t beginTriangle, size_t endTriangle, size_t numArrays )
+	{
+		if( beginTriangle == endTriangle )
+			return;
+		const vector<uint32_t>::const_iterator begin = indices.begin() + beginTriangle * 3, end = indices.begin() + endTriangle * 3;
+		first = *std::min_element( begin, end );
+		last = *std::max_element( begin, end );
+		for( size_t a = 0; a < numArrays; ++a )
+			arrays[a].assign( last - first + 1, Vec3f::zero() );
+	}
+
+	bool	contains( uint32_t vertex ) const { return vertex >= first && vertex <= last && ! arrays[0].empty(); }
+
+	uint32_t		first, last;
+	vector<Vec3f>	arrays[2];
+};
+
+// Slices the triangles so that each thread of the default TaskPool scatters into its own SliceSums
+size_t calcNumSlices( size_t numTriangles )
+{
+	return std::max<size_t>( 1, std::min( TaskPool::getDefault().getNumThreads(), numTriangles / MIN_SLICE_TRIANGLES ) );
+}
+
+// Returns the angle between unit vectors \a a and \a b
+float angleBetween( const Vec3f &a, const Vec3f &b )
+{
+	return math<float>::acos( constrain( a.dot( b ), -1.0f, 1.0f ) );
+}
+
+struct ScatterNormalsFn {
+	ScatterNormalsFn( const vector<Vec3f> &vertices, const vector<uint32_t> &indices, size_t numTriangles, TriMesh::NormalWeighting weighting,
+					vector<SliceSums> *slices, vector<Vec3f> *normals )
+		: mVertices( vertices ), mIndices( indices ), mNumTriangles( numTriangles ), mWeighting( weighting ), mSlices( slices ), mNormals( normals )
+	{}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		for( size_t s = begin; s < end; ++s ) {
+			const size_t beginTriangle = mNumTriangles * s / mSlices->size(), endTriangle = mNumTriangles * ( s + 1 ) / mSlices->size();
+			Vec3f *sums = 0;
+			if( s == 0 ) {
+				mNormals->assign( mVertices.size(), Vec3f::zero() );
+				sums = mNormals->empty() ? 0 : &(*mNormals)[0];
+			}
+			else {
+				SliceSums &slice = (*mSlices)[s];
+				slice.allocate( mIndices, beginTriangle, endTriangle, 1 );
+				sums = slice.arrays[0].empty() ? 0 : &slice.arrays[0][0] - slice.first;
+			}
+			for( size_t t = beginTriangle; t < endTriangle; ++t ) {
+				const uint32_t i0 = mIndices[t * 3], i1 = mIndices[t * 3 + 1], i2 = mIndices[t * 3 + 2];
+				const Vec3f &v0 = mVertices[i0], &v1 = mVertices[i1], &v2 = mVertices[i2];
+				// the length of the cross product is twice the area
+				const Vec3f normal = ( v1 - v0 ).cross( v2 - v0 );
+				if( mWeighting == TriMesh::WEIGHT_AREA ) {
+					sums[i0] += normal; sums[i1] += normal; sums[i2] += normal;
+				}
+				else if( mWeighting == TriMesh::WEIGHT_ANGLE ) {
+					const Vec3f unit = normal.safeNormalized();
+					const Vec3f e01 = ( v1 - v0 ).safeNormalized(), e12 = ( v2 - v1 ).safeNormalized(), e20 = ( v0 - v2 ).safeNormalized();
+					sums[i0] += unit * angleBetween( e01, -e20 );
+					sums[i1] += unit * angleBetween( e12, -e01 );
+					sums[i2] += unit * angleBetween( e20, -e12 );
+				}
+				else {
+					const Vec3f unit = normal.safeNormalized();
+					sums[i0] += unit; sums[i1] += unit; sums[i2] += unit;
+				}
+			}
+		}
+	}
+
+	const vector<Vec3f>			&mVertices;
+	const vector<uint32_t>		&mIndices;
+	size_t						mNumTriangles;
+	TriMesh::NormalWeighting	mWeighting;
+	vector<SliceSums>			*mSlices;
+	vector<Vec3f>				*mNormals;
+};
+
+struct ReduceNormalsFn {
+	ReduceNormalsFn( const vector<SliceSums> &slices, vector<Vec3f> *normals ) : mSlices( slices ), mNormals( normals ) {}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		for( size_t v = begin; v < end; ++v ) {
+			Vec3f sum = (*mNormals)[v];
+			for( vector<SliceSums>::const_iterator sliceIt = mSlices.begin() + 1; sliceIt < mSlices.end(); ++sliceIt )
+				if( sliceIt->contains( (uint32_t)v ) )
+					sum += sliceIt->arrays[0][v - sliceIt->first];
+			(*mNormals)[v] = sum.safeNormalized();
+		}
+	}
+
+	const vector<SliceSums>		&mSlices;
+	vector<Vec3f>				*mNormals;
+};
+
+// Sums the direction of increasing u and v over each face, following Lengyel's method
+struct ScatterTangentsFn {
+	ScatterTangentsFn( const vector<Vec3f> &vertices, const vector<Vec2f> &texCoords, const vector<uint32_t> &indices, size_t numTriangles,
+					vector<SliceSums> *slices, vector<Vec3f> *tangents, vector<Vec3f> *bitangents )
+		: mVertices( vertices ), mTexCoords( texCoords ), mIndices( indices ), mNumTriangles( numTriangles ), mSlices( slices ),
+		mTangents( tangents ), mBitangents( bitangents )
+	{}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		for( size_t s = begin; s < end; ++s ) {
+			const size_t beginTriangle = mNumTriangles * s / mSlices->size(), endTriangle = mNumTriangles * ( s + 1 ) / mSlices->size();
+			Vec3f *tangents = 0, *bitangents = 0;
+			if( s == 0 ) {
+				mTangents->assign( mVertices.size(), Vec3f::zero() );
+				mBitangents->assign( mVertices.size(), Vec3f::zero() );
+				if( ! mVertices.empty() ) {
+					tangents = &(*mTangents)[0];
+					bitangents = &(*mBitangents)[0];
+				}
+			}
+			else {
+				SliceSums &slice = (*mSlices)[s];
+				slice.allocate( mIndices, beginTriangle, endTriangle, 2 );
+				if( ! slice.arrays[0].empty() ) {
+					tangents = &slice.arrays[0][0] - slice.first;
+					bitangents = &slice.arrays[1][0] - slice.first;
+				}
+			}
+			for( size_t t = beginTriangle; t < endTriangle; ++t ) {
+				const uint32_t i0 = mIndices[t * 3], i1 = mIndices[t * 3 + 1], i2 = mIndices[t * 3 + 2];
+				const Vec3f e1 = mVertices[i1] - mVertices[i0], e2 = mVertices[i2] - mVertices[i0];
+				const Vec2f d1 = mTexCoords[i1] - mTexCoords[i0], d2 = mTexCoords[i2] - mTexCoords[i0];
+				const float det = d1.x * d2.y - d2.x * d1.y;
+				if( det == 0 ) // degenerate mapping; contributes nothing
+					continue;
+				const Vec3f tangent = ( ( e1 * d2.y - e2 * d1.y ) / det ).safeNormalized();
+				const Vec3f bitangent = ( ( e2 * d1.x - e1 * d2.x ) / det ).safeNormalized();
+				tangents[i0] += tangent; tangents[i1] += tangent; tangents[i2] += tangent;
+				bitangents[i0] += bitangent; bitangents[i1] += bitangent; bitangents[i2] += bitangent;
+			}
+		}
+	}
+
+	const vector<Vec3f>		&mVertices;
+	const vector<Vec2f>		&mTexCoords;
+	const vector<uint32_t>	&mIndices;
+	size_t					mNumTriangles;
+	vector<SliceSums>		*mSlices;
+	vector<Vec3f>			*mTangents, *mBitangents;
+};
+
+struct ReduceTangentsFn {
+	ReduceTangentsFn( const vector<SliceSums> &slices, const vector<Vec3f> &normals, vector<Vec3f> *tangents, vector<Vec3f> *bitangents )
+		: mSlices( slices ), mNormals( normals ), mTangents( tangents ), mBitangents( bitangents )
+	{}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		for( size_t v = begin; v < end; ++v ) {
+			Vec3f tangent = (*mTangents)[v], bitangent = (*mBitangents)[v];
+			for( vector<SliceSums>::const_iterator sliceIt = mSlices.begin() + 1; sliceIt < mSlices.end(); ++sliceIt ) {
+				if( sliceIt->contains( (uint32_t)v ) ) {
+					tangent += sliceIt->arrays[0][v - sliceIt->first];
+					bitangent += sliceIt->arrays[1][v - sliceIt->first];
+				}
+			}
+			// Gram-Schmidt against the normal, then rebuild the bitangent so that the basis is orthonormal
+			const Vec3f &normal = mNormals[v];
+			tangent = ( tangent - normal * normal.dot( tangent ) ).safeNormalized();
+			const Vec3f cross = normal.cross( tangent );
+			(*mTangents)[v] = tangent;
+			(*mBitangents)[v] = ( cross.dot( bitangent ) < 0 ) ? -cross : cross;
+		}
+	}
+
+	const vector<SliceSums>		&mSlices;
+	const vector<Vec3f>			&mNormals;
+	vector<Vec3f>				*mTangents, *mBitangents;
+};
+
+// Tom Forsyth's scoring for the vertex cache optimizer, from "Linear-Speed Vertex Cache Optimisation"
+const float		CACHE_DECAY_POWER = 1.5f;
+const float		LAST_TRIANGLE_SCORE = 0.75f;
+const float		VALENCE_BOOST_SCALE = 2.0f;
+const float		VALENCE_BOOST_POWER = 0.5f;
+const size_t	MAX_SCORED_VALENCE = 32;
+
+class VertexCacheOptimizer {
+  public:
+	VertexCacheOptimizer( const vector<uint32_t> &indices, size_t numTriangles, size_t numVertices, size_t cacheSize )
+		: mIndices( indices ), mNumTriangles( numTriangles ), mCacheSize( std::max<size_t>( cacheSize, 4 ) ),
+		mOffsets( numVertices + 1, 0 ), mNumActive( numVertices, 0 ), mCachePositions( numVertices, -1 ), mVertexScores( numVertices ),
+		mTriangleScores( numTriangles, 0 ), mEmitted( numTriangles, false )
+	{
+		// the triangles using each vertex, in compressed sparse row form
+		for( size_t c = 0; c < numTriangles * 3; ++c )
+			++mNumActive[indices[c]];
+		for( size_t v = 0; v < numVertices; ++v )
+			mOffsets[v + 1] = mOffsets[v] + mNumActive[v];
+		mVertexTriangles.resize( numTriangles * 3 );
+		vector<uint32_t> next( mOffsets.begin(), mOffsets.end() - 1 );
+		for( size_t c = 0; c < numTriangles * 3; ++c )
+			mVertexTriangles[next[indices[c]]++] = static_cast<uint32_t>( c / 3 );
+
+		mCacheScores.resize( mCacheSize );
+		for( size_t p = 0; p < mCacheSize; ++p )
+			mCacheScores[p] = ( p < 3 ) ? LAST_TRIANGLE_SCORE : math<float>::pow( 1.0f - ( p - 3 ) / (float)( mCacheSize - 3 ), CACHE_DECAY_POWER );
+		mValenceScores.resize( MAX_SCORED_VALENCE + 1, 0 );
+		for( size_t valence = 1; valence <= MAX_SCORED_VALENCE; ++valence )
+			mValenceScores[valence] = VALENCE_BOOST_SCALE * math<float>::pow( (float)valence, -VALENCE_BOOST_POWER );
+
+		for( size_t v = 0; v < numVertices; ++v )
+			mVertexScores[v] = calcVertexScore( (uint32_t)v );
+		for( size_t t = 0; t < numTriangles; ++t )
+			mTriangleScores[t] = mVertexScores[indices[t * 3]] + mVertexScores[indices[t * 3 + 1]] + mVertexScores[indices[t * 3 + 2]];
+	}
+
+	void optimize( vector<uint32_t> *result )
+	{
+		result->resize( mNumTriangles * 3 );
+		// holds the cache after each triangle, which can briefly exceed mCacheSize by the triangle's 3 vertices
+		vector<uint32_t> cache, newCache;
+		cache.reserve( mCacheSize + 3 );
+		newCache.reserve( mCacheSize + 3 );
+
+		size_t scanPosition = 0;
+		int64_t best = mNumTriangles ? std::max_element( mTriangleScores.begin(), mTriangleScores.end() ) - mTriangleScores.begin() : -1;
+		for( size_t out = 0; best >= 0; ++out ) {
+			const uint32_t *triangle = &mIndices[best * 3];
+			std::copy( triangle, triangle + 3, result->begin() + out * 3 );
+			mEmitted[best] = true;
+			for( int k = 0; k < 3; ++k )
+				removeActiveTriangle( triangle[k], (uint32_t)best );
+
+			newCache.assign( triangle, triangle + 3 );
+			for( vector<uint32_t>::const_iterator cacheIt = cache.begin(); cacheIt != cache.end(); ++cacheIt )
+				if( *cacheIt != triangle[0] && *cacheIt != triangle[1] && *cacheIt != triangle[2] )
+					newCache.push_back( *cacheIt );
+			for( size_t p = 0; p < newCache.size(); ++p )
+				mCachePositions[newCache[p]] = ( p < mCacheSize ) ? (int)p : -1;
+
+			// rescore the vertices whose positions changed and the triangles using them, choosing the best of those triangles next
+			float bestScore = 0;
+			best = -1;
+			for( vector<uint32_t>::const_iterator cacheIt = newCache.begin(); cacheIt != newCache.end(); ++cacheIt ) {
+				const uint32_t v = *cacheIt;
+				const float score = calcVertexScore( v ), delta = score - mVertexScores[v];
+				mVertexScores[v] = score;
+				for( uint32_t i = mOffsets[v]; i < mOffsets[v] + mNumActive[v]; ++i ) {
+					const uint32_t t = mVertexTriangles[i];
+					mTriangleScores[t] += delta;
+					if( mTriangleScores[t] > bestScore ) {
+						bestScore = mTriangleScores[t];
+						best = t;
+					}
+				}
+			}
+			if( newCache.size() > mCacheSize )
+				newCache.resize( mCacheSize );
+			cache.swap( newCache );
+
+			// nothing in the cache has triangles left, so start again from the first remaining triangle
+			if( best < 0 ) {
+				while( scanPosition < mNumTriangles && mEmitted[scanPosition] )
+					++scanPosition;
+				if( scanPosition < mNumTriangles )
+					best = scanPosition;
+			}
+		}
+	}
+
+  private:
+	float calcVertexScore( uint32_t v ) const
+	{
+		if( mNumActive[v] == 0 )
+			return -1;
+		const float cacheScore = ( mCachePositions[v] >= 0 ) ? mCacheScores[mCachePositions[v]] : 0;
+		const float valenceScore = ( mNumActive[v] <= MAX_SCORED_VALENCE ) ? mValenceScores[mNumActive[v]] : VALENCE_BOOST_SCALE * math<float>::pow( (float)mNumActive[v], -VALENCE_BOOST_POWER );
+		return cacheScore + valenceScore;
+	}
+
+	void removeActiveTriangle( uint32_t v, uint32_t triangle )
+	{
+		uint32_t *begin = &mVertexTriangles[mOffsets[v]], *end = begin + mNumActive[v];
+		std::swap( *std::find( begin, end, triangle ), *( end - 1 ) );
+		--mNumActive[v];
+	}
+
+	const vector<uint32_t>	&mIndices;
+	size_t					mNumTriangles, mCacheSize;
+	vector<uint32_t>		mOffsets, mVertexTriangles, mNumActive;
+	vector<int>				mCachePositions;
+	vector<float>			mVertexScores, mTriangleScores, mCacheScores, mValenceScores;
+	vector<bool>			mEmitted;
+};
+
+// Simulates a FIFO vertex cache, in which a vertex stays for \a cacheSize misses after its own, numbered from 1
+class FifoCache {
+  public:
+	FifoCache( size_t numVertices, size_t cacheSize )
+		: mMissedAt( numVertices, 0 ), mMisses( 0 ), mCacheSize( cacheSize )
+	{}
+
+	//! Returns how many of the triangle's vertices miss the cache, adding them to it
+	int draw( const uint32_t *triangle )
+	{
+		int result = 0;
+		for( int k = 0; k < 3; ++k ) {
+			uint64_t &missedAt = mMissedAt[triangle[k]];
+			if( missedAt == 0 || mMisses - missedAt >= mCacheSize ) {
+				missedAt = ++mMisses;
+				++result;
+			}
+		}
+		return result;
+	}
+
+	//! Empties the cache
+	void reset() { mMisses += mCacheSize; }
+
+  private:
+	vector<uint64_t>	mMissedAt;
+	uint64_t			mMisses;
+	size_t				mCacheSize;
+};
+
+// the FIFO cache optimizeOverdraw() measures clusters with, a size typical of the hardware
+const size_t	OVERDRAW_CACHE_SIZE = 16;
+
+template<typename T>
+void remapAttribute( const vector<uint32_t> &order, size_t numVertices, vector<T> *attribute )
+{
+	if( attribute->size() != numVertices )
+		return;
+	vector<T> result( order.size() );
+	for( size_t v = 0; v < order.size(); ++v )
+		result[v] = (*attribute)[order[v]];
+	attribute->swap( result );
+}
+
+const uint32_t	ALL_PARTITIONS = 0xFFFFFFFF;
+const uint32_t	NO_PARTNER = 0xFFFFFFFF;
+const size_t	MIN_PARTITION_TRIANGLES = 1 << 15;
+// boundary planes are weighted by the square of their edge's length times this
+const double	BOUNDARY_WEIGHT = 10;
+// triangles may turn up to about 75 degrees from their original orientation, which rules out slivers standing on edge
+const float		MIN_NORMAL_COSINE = 0.25f;
+
+enum { VERTEX_INTERIOR, VERTEX_BORDER, VERTEX_SEAM, VERTEX_LOCKED };
+
+// Garland and Heckbert's quadric error metric: the weighted sum of squared distances to a set of planes, and the area of the faces contributing
+struct Quadric {
+	Quadric() : a2( 0 ), ab( 0 ), ac( 0 ), ad( 0 ), b2( 0 ), bc( 0 ), bd( 0 ), c2( 0 ), cd( 0 ), d2( 0 ), area( 0 ) {}
+	//! The plane through \a point with unit normal \a n, weighted by \a weight
+	Quadric( const Vec3d &n, const Vec3d &point, double weight, double area )
+		: area( area )
+	{
+		const double d = -n.dot( point );
+		a2 = weight * n.x * n.x; ab = weight * n.x * n.y; ac = weight * n.x * n.z; ad = weight * n.x * d;
+		b2 = weight * n.y * n.y; bc = weight * n.y * n.z; bd = weight * n.y * d;
+		c2 = weight * n.z * n.z; cd = weight * n.z * d;
+		d2 = weight * d * d;
+	}
+
+	void operator+=( const Quadric &rhs )
+	{
+		a2 += rhs.a2; ab += rhs.ab; ac += rhs.ac; ad += rhs.ad; b2 += rhs.b2; bc += rhs.bc; bd += rhs.bd; c2 += rhs.c2; cd += rhs.cd; d2 += rhs.d2;
+		area += rhs.area;
+	}
+
+	// Returns the root mean squared distance of \a p from the planes, weighted by area
+	float calcError( const Vec3f &p ) const
+	{
+		const double x = p.x, y = p.y, z = p.z;
+		const double sum = a2 * x * x + b2 * y * y + c2 * z * z + 2 * ( ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z ) + d2;
+		return (float)math<double>::sqrt( std::max( sum, 0.0 ) / std::max( area, 1e-20 ) );
+	}
+
+	double	a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+	double	area;
+};
+
+struct Collapse {
+	Collapse( float error, float lengthSquared, uint32_t from, uint32_t to, uint32_t version )
+		: error( error ), lengthSquared( lengthSquared ), from( from ), to( to ), version( version ) {}
+
+	// orders std::priority_queue by least error, then by shortest edge so that flat regions coarsen evenly rather than into fans
+	bool operator<( const Collapse &rhs ) const { return error > rhs.error || ( error == rhs.error && lengthSquared > rhs.lengthSquared ); }
+
+	float		error, lengthSquared;
+	uint32_t	from, to;
+	uint32_t	version;	// of \a from when this was calculated
+};
+
+// Simplifies a triangle mesh in place by half-edge collapses, which move one vertex onto a neighbor so that no new vertices or
+// attributes are needed. Where a seam splits the mesh into two boundaries that share positions, a vertex on it only moves
+// along the seam, together with its copy on the other side, so the seam stays closed. The vertices may be divided into partitions which are simplified concurrently. Vertices of triangles
+// spanning partitions are left alone until the partitions are cleared, so each partition reads and writes only its own
+// vertices and triangles, while every thread only reads the positions.
+class MeshSimplifier {
+  public:
+	MeshSimplifier( const vector<Vec3f> &positions, vector<uint32_t> *indices, size_t numTriangles )
+		: mPositions( positions ), mIndices( *indices ), mTriangleAlive( numTriangles, 1 ), mOriginalNormals( numTriangles, Vec3f::zero() ), mVertexTriangles( positions.size() ),
+		mQuadrics( positions.size() ), mKinds( positions.size(), VERTEX_INTERIOR ), mPartners( positions.size(), NO_PARTNER ), mPartitions( positions.size(), 0 ),
+		mPartitionLocked( positions.size(), 0 ), mVersions( positions.size(), 0 ), mQueued( positions.size(), 0 ), mRemoved( positions.size(), 0 )
+	{
+		for( size_t t = 0; t < numTriangles; ++t ) {
+			const uint32_t *triangle = &mIndices[t * 3];
+			if( triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0] ) {
+				mTriangleAlive[t] = 0;
+				continue;
+			}
+			for( int k = 0; k < 3; ++k )
+				mVertexTriangles[triangle[k]].push_back( static_cast<uint32_t>( t ) );
+		}
+
+		classifyVertices();
+		calcQuadrics();
+	}
+
+	bool	isTriangleAlive( size_t t ) const { return mTriangleAlive[t] != 0; }
+	size_t	countTriangles() const
+	{
+		return std::count( mTriangleAlive.begin(), mTriangleAlive.end(), 1 );
+	}
+
+	// Divides the vertices into \a numPartitions slabs holding similar numbers of vertices, across the longest axis of their bounds.
+	// Sets \a triangleCounts to the number of triangles each partition owns.
+	void partition( size_t numPartitions, vector<size_t> *triangleCounts )
+	{
+		Vec3f min( mPositions[0] ), max( mPositions[0] );
+		for( vector<Vec3f>::const_iterator posIt = mPositions.begin(); posIt != mPositions.end(); ++posIt ) {
+			min.x = std::min( min.x, posIt->x ); min.y = std::min( min.y, posIt->y ); min.z = std::min( min.z, posIt->z );
+			max.x = std::max( max.x, posIt->x ); max.y = std::max( max.y, posIt->y ); max.z = std::max( max.z, posIt->z );
+		}
+		const Vec3f size = max - min;
+		const int axis = ( size.x >= size.y && size.x >= size.z ) ? 0 : ( ( size.y >= size.z ) ? 1 : 2 );
+
+		vector<float> coords( mPositions.size() );
+		for( size_t v = 0; v < mPositions.size(); ++v )
+			coords[v] = mPositions[v][axis];
+		vector<float> splits;
+		for( size_t p = 1; p < numPartitions; ++p ) {
+			std::nth_element( coords.begin(), coords.begin() + coords.size() * p / numPartitions, coords.end() );
+			splits.push_back( coords[coords.size() * p / numPartitions] );
+		}
+		std::sort( splits.begin(), splits.end() );
+		for( size_t v = 0; v < mPositions.size(); ++v )
+			mPartitions[v] = static_cast<uint32_t>( std::upper_bound( splits.begin(), splits.end(), mPositions[v][axis] ) - splits.begin() );
+
+		triangleCounts->assign( numPartitions, 0 );
+		for( size_t t = 0; t < mTriangleAlive.size(); ++t ) {
+			if( ! mTriangleAlive[t] )
+				continue;
+			if( isOwned( t ) )
+				++(*triangleCounts)[mPartitions[mIndices[t * 3]]];
+			else
+				for( int k = 0; k < 3; ++k )
+					mPartitionLocked[mIndices[t * 3 + k]] = 1;
+		}
+	}
+
+	void clearPartitions()
+	{
+		std::fill( mPartitions.begin(), mPartitions.end(), 0 );
+		std::fill( mPartitionLocked.begin(), mPartitionLocked.end(), 0 );
+	}
+
+	// Collapses edges within \a partition, or everywhere for ALL_PARTITIONS, until its \a numTriangles come down to \a targetTriangles
+	// or the next collapse would exceed \a maxError
+	void simplify( uint32_t partition, size_t numTriangles, size_t targetTriangles, float maxError )
+	{
+		std::priority_queue<Collapse> queue;
+		Scratch scratch;
+		for( size_t v = 0; v < mPositions.size(); ++v )
+			if( isInPartition( (uint32_t)v, partition ) )
+				pushCollapse( (uint32_t)v, &queue, &scratch );
+
+		vector<uint32_t> ring, partnerRing;
+		while( numTriangles > targetTriangles && ! queue.empty() ) {
+			const Collapse collapse = queue.top();
+			queue.pop();
+			if( mRemoved[collapse.from] || collapse.version != mVersions[collapse.from] )
+				continue;
+			if( collapse.error > maxError )
+				break;
+			mQueued[collapse.from] = 0;
+			// the neighborhood of the target may have changed since
+			if( ! isCollapseValid( collapse.from, collapse.to, &scratch ) ) {
+				pushCollapse( collapse.from, &queue, &scratch );
+				continue;
+			}
+
+			// only the neighbors of the removed vertex see their links change, so only they may have gained a valid collapse.
+			// The target's quadric grew, so its queued collapse is stale, as is its partner's, whose error includes it.
+			findNeighbors( collapse.from, &ring );
+			numTriangles -= collapseEdge( collapse.from, collapse.to );
+			invalidate( collapse.to, &ring );
+			if( mKinds[collapse.from] == VERTEX_SEAM ) {
+				const uint32_t partner = mPartners[collapse.from], toPartner = mPartners[collapse.to];
+				findNeighbors( partner, &partnerRing );
+				ring.insert( ring.end(), partnerRing.begin(), partnerRing.end() );
+				numTriangles -= collapseEdge( partner, toPartner );
+				invalidate( toPartner, &ring );
+			}
+			for( vector<uint32_t>::const_iterator ringIt = ring.begin(); ringIt != ring.end(); ++ringIt )
+				if( ! mQueued[*ringIt] && isInPartition( *ringIt, partition ) )
+					pushCollapse( *ringIt, &queue, &scratch );
+		}
+	}
+
+  private:
+	// Per-thread working storage, so partitions can be simplified concurrently
+	struct Scratch {
+		vector<uint32_t>					ring, neighborsFrom, common;
+		vector<Collapse>					candidates;
+	};
+
+	// Forgets the queued collapse of \a v and its partner, adding the partner to \a ring so it is queued again
+	void invalidate( uint32_t v, vector<uint32_t> *ring )
+	{
+		++mVersions[v];
+		mQueued[v] = 0;
+		const uint32_t partner = mPartners[v];
+		if( partner != NO_PARTNER && ! mRemoved[partner] ) {
+			++mVersions[partner];
+			mQueued[partner] = 0;
+			ring->push_back( partner );
+		}
+	}
+
+	bool isOwned( size_t t ) const
+	{
+		const uint32_t *triangle = &mIndices[t * 3];
+		return mPartitions[triangle[0]] == mPartitions[triangle[1]] && mPartitions[triangle[1]] == mPartitions[triangle[2]];
+	}
+
+	bool isInPartition( uint32_t v, uint32_t partition ) const
+	{
+		return partition == ALL_PARTITIONS || ( mPartitions[v] == partition && ! mPartitionLocked[v] );
+	}
+
+	static bool contains( const uint32_t *triangle, uint32_t v )
+	{
+		return triangle[0] == v || triangle[1] == v || triangle[2] == v;
+	}
+
+	// Sorted, without duplicates
+	void findNeighbors( uint32_t v, vector<uint32_t> *result ) const
+	{
+		result->clear();
+		for( vector<uint32_t>::const_iterator triIt = mVertexTriangles[v].begin(); triIt != mVertexTriangles[v].end(); ++triIt )
+			for( int k = 0; k < 3; ++k )
+				if( mIndices[*triIt * 3 + k] != v )
+					result->push_back( mIndices[*triIt * 3 + k] );
+		std::sort( result->begin(), result->end() );
+		result->erase( std::unique( result->begin(), result->end() ), result->end() );
+	}
+
+	size_t countEdgeTriangles( uint32_t a, uint32_t b ) const
+	{
+		size_t result = 0;
+		for( vector<uint32_t>::const_iterator triIt = mVertexTriangles[a].begin(); triIt != mVertexTriangles[a].end(); ++triIt )
+			if( contains( &mIndices[*triIt * 3], b ) )
+				++result;
+		return result;
+	}
+
+	// Pairs up vertices sharing a position, and marks the boundary and seam vertices. A vertex is on a seam when it and its partner
+	// each lie on a boundary whose two edges lead to partnered vertices, and the partners of those are the other's neighbors.
+	// Locks non-manifold vertices, boundaries that touch themselves, and every other vertex sharing its position.
+	void classifyVertices()
+	{
+		vector<uint32_t> order( mPositions.size() );
+		for( size_t v = 0; v < order.size(); ++v )
+			order[v] = static_cast<uint32_t>( v );
+		std::sort( order.begin(), order.end(), PositionLess( mPositions ) );
+		for( size_t i = 0; i < order.size(); ) {
+			size_t run = 1;
+			while( i + run < order.size() && mPositions[order[i + run]] == mPositions[order[i]] )
+				++run;
+			if( run == 2 ) {
+				mPartners[order[i]] = order[i + 1];
+				mPartners[order[i + 1]] = order[i];
+			}
+			else if( run > 2 ) {
+				for( size_t j = i; j < i + run; ++j )
+					mKinds[order[j]] = VERTEX_LOCKED;
+			}
+			i += run;
+		}
+
+		// each neighbor appears once per triangle sharing the edge to it
+		vector<uint32_t> others;
+		vector<uint32_t> boundaryNeighbors( mPositions.size() * 2, NO_PARTNER );
+		for( size_t v = 0; v < mPositions.size(); ++v ) {
+			if( mKinds[v] == VERTEX_LOCKED )
+				continue;
+			others.clear();
+			for( vector<uint32_t>::const_iterator triIt = mVertexTriangles[v].begin(); triIt != mVertexTriangles[v].end(); ++triIt )
+				for( int k = 0; k < 3; ++k )
+					if( mIndices[*triIt * 3 + k] != v )
+						others.push_back( mIndices[*triIt * 3 + k] );
+			std::sort( others.begin(), others.end() );
+			size_t boundaryEdges = 0;
+			bool nonManifold = false;
+			for( size_t i = 0; i < others.size(); ) {
+				size_t run = 1;
+				while( i + run < others.size() && others[i + run] == others[i] )
+					++run;
+				if( run == 1 && boundaryEdges < 2 )
+					boundaryNeighbors[v * 2 + boundaryEdges] = others[i];
+				boundaryEdges += ( run == 1 ) ? 1 : 0;
+				nonManifold = nonManifold || run > 2;
+				i += run;
+			}
+			if( nonManifold || ( boundaryEdges != 0 && boundaryEdges != 2 ) )
+				mKinds[v] = VERTEX_LOCKED;
+			else if( boundaryEdges == 2 )
+				mKinds[v] = VERTEX_BORDER;
+		}
+
+		for( size_t v = 0; v < mPositions.size(); ++v ) {
+			const uint32_t partner = mPartners[v];
+			if( partner == NO_PARTNER )
+				continue;
+			bool seam = mKinds[v] == VERTEX_BORDER && mKinds[partner] != VERTEX_LOCKED;
+			for( int k = 0; k < 2 && seam; ++k ) {
+				const uint32_t neighborPartner = mPartners[boundaryNeighbors[v * 2 + k]];
+				seam = neighborPartner != NO_PARTNER && ( boundaryNeighbors[partner * 2] == neighborPartner || boundaryNeighbors[partner * 2 + 1] == neighborPartner );
+			}
+			// the partner is classified as well, and only becomes a seam vertex if it agrees
+			if( ! seam )
+				mKinds[v] = VERTEX_LOCKED;
+		}
+		for( size_t v = 0; v < mPositions.size(); ++v ) {
+			if( mPartners[v] != NO_PARTNER && mKinds[v] != VERTEX_LOCKED )
+				mKinds[v] = ( mKinds[mPartners[v]] == VERTEX_LOCKED ) ? VERTEX_LOCKED : VERTEX_SEAM;
+		}
+	}
+
+	void calcQuadrics()
+	{
+		for( size_t t = 0; t < mTriangleAlive.size(); ++t ) {
+			if( ! mTriangleAlive[t] )
+				continue;
+			const uint32_t *triangle = &mIndices[t * 3];
+			const Vec3d p[3] = { mPositions[triangle[0]], mPositions[triangle[1]], mPositions[triangle[2]] };
+			Vec3d normal = ( p[1] - p[0] ).cross( p[2] - p[0] );
+			const double length = normal.length();
+			if( length == 0 )
+				continue;
+			normal /= length;
+			mOriginalNormals[t] = normal;
+			const Quadric face( normal, p[0], length / 2, length / 2 );
+			for( int k = 0; k < 3; ++k )
+				mQuadrics[triangle[k]] += face;
+
+			// a plane perpendicular to the face keeps boundary vertices from drifting off the boundary
+			for( int k = 0; k < 3; ++k ) {
+				const uint32_t a = triangle[k], b = triangle[( k + 1 ) % 3];
+				if( countEdgeTriangles( a, b ) != 1 )
+					continue;
+				const Vec3d edge = p[( k + 1 ) % 3] - p[k];
+				const Quadric boundary( edge.cross( normal ).safeNormalized(), p[k], BOUNDARY_WEIGHT * edge.lengthSquared(), 0 );
+				mQuadrics[a] += boundary;
+				mQuadrics[b] += boundary;
+			}
+		}
+	}
+
+	// Moving \a from onto \a to must keep the mesh manifold, keep boundaries in place and not flip or fold any triangle
+	bool isValid( uint32_t from, uint32_t to, Scratch *scratch ) const
+	{
+		if( mRemoved[to] )
+			return false;
+		const size_t shared = countEdgeTriangles( from, to );
+		if( shared != ( ( mKinds[from] == VERTEX_INTERIOR ) ? 2 : 1 ) )
+			return false;
+
+		const Vec3f &fromPos = mPositions[from], &toPos = mPositions[to];
+		for( vector<uint32_t>::const_iterator triIt = mVertexTriangles[from].begin(); triIt != mVertexTriangles[from].end(); ++triIt ) {
+			const uint32_t *triangle = &mIndices[*triIt * 3];
+			if( contains( triangle, to ) )
+				continue;
+			const int k = ( triangle[0] == from ) ? 0 : ( ( triangle[1] == from ) ? 1 : 2 );
+			const Vec3f &a = mPositions[triangle[( k + 1 ) % 3]], &b = mPositions[triangle[( k + 2 ) % 3]];
+			const Vec3f newNormal = ( a - toPos ).cross( b - toPos );
+			if( newNormal.dot( ( a - fromPos ).cross( b - fromPos ) ) <= 0 || newNormal.dot( mOriginalNormals[*triIt] ) <= MIN_NORMAL_COSINE * newNormal.length() )
+				return false;
+		}
+
+		// the link condition: the only neighbors the two have in common are the opposite vertices of the triangles sharing the edge.
+		// Checked last and without sorting the target's neighbors, since the target may have many.
+		findNeighbors( from, &scratch->neighborsFrom );
+		vector<uint32_t> &common = scratch->common;
+		common.clear();
+		for( vector<uint32_t>::const_iterator triIt = mVertexTriangles[to].begin(); triIt != mVertexTriangles[to].end(); ++triIt ) {
+			for( int k = 0; k < 3; ++k ) {
+				const uint32_t v = mIndices[*triIt * 3 + k];
+				if( v != to && std::binary_search( scratch->neighborsFrom.begin(), scratch->neighborsFrom.end(), v ) )
+					common.push_back( v );
+			}
+		}
+		std::sort( common.begin(), common.end() );
+		return std::unique( common.begin(), common.end() ) - common.begin() == (ptrdiff_t)shared;
+	}
+
+	// A vertex on a seam collapses along with its partner, onto the partner of its target
+	bool isCollapseValid( uint32_t from, uint32_t to, Scratch *scratch ) const
+	{
+		if( mKinds[from] != VERTEX_SEAM )
+			return isValid( from, to, scratch );
+		const uint32_t partner = mPartners[from], toPartner = mPartners[to];
+		return toPartner != NO_PARTNER && ! mPartitionLocked[partner] && isValid( from, to, scratch ) && isValid( partner, toPartner, scratch );
+	}
+
+	// Queues the cheapest valid collapse of \a v, if it may move
+	void pushCollapse( uint32_t v, std::priority_queue<Collapse> *queue, Scratch *scratch )
+	{
+		if( mRemoved[v] || mKinds[v] == VERTEX_LOCKED || mPartitionLocked[v] )
+			return;
+
+		// a seam vertex's error covers the faces on both sides
+		Quadric quadric = mQuadrics[v];
+		if( mKinds[v] == VERTEX_SEAM )
+			quadric += mQuadrics[mPartners[v]];
+		vector<Collapse> &candidates = scratch->candidates;
+		candidates.clear();
+		findNeighbors( v, &scratch->ring );
+		for( vector<uint32_t>::const_iterator neighborIt = scratch->ring.begin(); neighborIt != scratch->ring.end(); ++neighborIt ) {
+			const Vec3f &to = mPositions[*neighborIt];
+			candidates.push_back( Collapse( quadric.calcError( to ), to.distanceSquared( mPositions[v] ), v, *neighborIt, mVersions[v] ) );
+		}
+		// Collapse sorts most expensive first
+		std::sort( candidates.begin(), candidates.end() );
+		for( vector<Collapse>::const_reverse_iterator candIt = candidates.rbegin(); candIt != candidates.rend(); ++candIt ) {
+			if( isCollapseValid( v, candIt->to, scratch ) ) {
+				queue->push( *candIt );
+				mQueued[v] = 1;
+				return;
+			}
+		}
+	}
+
+	// Returns the number of triangles removed
+	size_t collapseEdge( uint32_t from, uint32_t to )
+	{
+		size_t removed = 0;
+		vector<uint32_t> &fromTriangles = mVertexTriangles[from];
+		for( vector<uint32_t>::const_iterator triIt = fromTriangles.begin(); triIt != fromTriangles.end(); ++triIt ) {
+			uint32_t *triangle = &mIndices[*triIt * 3];
+			if( contains( triangle, to ) ) {
+				mTriangleAlive[*triIt] = 0;
+				++removed;
+				for( int k = 0; k < 3; ++k ) {
+					if( triangle[k] != from ) {
+						vector<uint32_t> &triangles = mVertexTriangles[triangle[k]];
+						triangles.erase( std::find( triangles.begin(), triangles.end(), *triIt ) );
+					}
+				}
+			}
+			else {
+				*std::find( triangle, triangle + 3, from ) = to;
+				mVertexTriangles[to].push_back( *triIt );
+			}
+		}
+
+		vector<uint32_t>().swap( fromTriangles );
+		mRemoved[from] = 1;
+		mQuadrics[to] += mQuadrics[from];
+		return removed;
+	}
+
+	struct PositionLess {
+		PositionLess( const vector<Vec3f> &positions ) : mPositions( positions ) {}
+		bool operator()( uint32_t a, uint32_t b ) const
+		{
+			const Vec3f &pa = mPositions[a], &pb = mPositions[b];
+			return pa.x < pb.x || ( pa.x == pb.x && ( pa.y < pb.y || ( pa.y == pb.y && pa.z < pb.z ) ) );
+		}
+		const vector<Vec3f>		&mPositions;
+	};
+
+	const vector<Vec3f>			&mPositions;
+	vector<uint32_t>			&mIndices;
+	vector<uint8_t>				mTriangleAlive;
+	vector<Vec3f>				mOriginalNormals;
+	vector<vector<uint32_t> >	mVertexTriangles;
+	vector<Quadric>				mQuadrics;
+	vector<uint8_t>				mKinds;
+	vector<uint32_t>			mPartners;	// the other vertex at the same position, if there is exactly one
+	vector<uint32_t>			mPartitions;
+	vector<uint8_t>				mPartitionLocked;
+	vector<uint32_t>			mVersions;
+	vector<uint8_t>				mQueued, mRemoved;
+};
+
+struct SimplifyPartitionFn {
+	SimplifyPartitionFn( MeshSimplifier *simplifier, const vector<size_t> &counts, const vector<size_t> &targets, float maxError )
+		: mSimplifier( simplifier ), mCounts( counts ), mTargets( targets ), mMaxError( maxError ) {}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		for( size_t partition = begin; partition < end; ++partition )
+			mSimplifier->simplify( static_cast<uint32_t>( partition ), mCounts[partition], mTargets[partition], mMaxError );
+	}
+
+	MeshSimplifier			*mSimplifier;
+	const vector<size_t>	&mCounts, &mTargets;
+	float					mMaxError;
+};
+
+} // anonymous namespace
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 // TriMesh
 void TriMesh::clear()
 {
 	mVertices.clear();
 	mNormals.clear();
+	mTangents.clear();
+	mBitangents.clear();
 	mColorsRGB.clear();
 	mColorsRGBA.clear();
 	mTexCoords.clear();
@@ -146,6 +1193,10 @@ void TriMesh::read( DataSourceRef dataSource )
 
 	uint8_t versionNumber;
 	in->read( &versionNumber );
+	if( versionNumber == 2 ) {
+		TriMeshView::create( dataSource, true )->copyTo( this );
+		return;
+	}
 	
 	uint32_t numVertices, numNormals, numTexCoords, numIndices;
 	in->readLittle( &numVertices );
@@ -178,9 +1229,15 @@ void TriMesh::read( DataSourceRef dataSource )
 	}
 }
 
-void TriMesh::write( DataTargetRef dataTarget ) const
+void TriMesh::write( DataTargetRef dataTarget, const WriteOptions &options ) const
 {
 	OStreamRef out = dataTarget->getStream();
+	if( options.getVersion() == 2 ) {
+		writeVersion2( *this, out, options.getCompressIndices() );
+		return;
+	}
+	else if( options.getVersion() != 1 )
+		throw TriMeshExc();
 	
 	const uint8_t versionNumber = 1;
 	out->write( versionNumber );
@@ -207,30 +1264,319 @@ void TriMesh::write( DataTargetRef dataTarget ) const
 	}
 }
 
-void TriMesh::recalculateNormals()
+void TriMesh::recalculateNormals( NormalWeighting weighting )
+{
+	const size_t numTriangles = getNumTriangles();
+	vector<SliceSums> slices( calcNumSlices( numTriangles ) );
+	TaskPool::getDefault().parallelFor( slices.size(), 1, ScatterNormalsFn( mVertices, mIndices, numTriangles, weighting, &slices, &mNormals ) );
+	TaskPool::getDefault().parallelFor( mVertices.size(), REDUCE_GRAIN_SIZE, ReduceNormalsFn( slices, &mNormals ) );
+}
+
+void TriMesh::recalculateTangents()
+{
+	if( mTexCoords.size() < mVertices.size() ) {
+		mTangents.clear();
+		mBitangents.clear();
+		return;
+	}
+	if( mNormals.size() != mVertices.size() )
+		recalculateNormals();
+
+	const size_t numTriangles = getNumTriangles();
+	vector<SliceSums> slices( calcNumSlices( numTriangles ) );
+	TaskPool::getDefault().parallelFor( slices.size(), 1, ScatterTangentsFn( mVertices, mTexCoords, mIndices, numTriangles, &slices, &mTangents, &mBitangents ) );
+	TaskPool::getDefault().parallelFor( mVertices.size(), REDUCE_GRAIN_SIZE, ReduceTangentsFn( slices, mNormals, &mTangents, &mBitangents ) );
+}
+
+void TriMesh::optimizeIndexOrder( size_t cacheSize )
+{
+	const size_t numTriangles = getNumTriangles();
+	vector<uint32_t> result;
+	VertexCacheOptimizer( mIndices, numTriangles, mVertices.size(), cacheSize ).optimize( &result );
+	// a trailing partial triangle is kept as is
+	result.insert( result.end(), mIndices.begin() + numTriangles * 3, mIndices.end() );
+	mIndices.swap( result );
+}
+
+void TriMesh::optimizeOverdraw( float threshold )
+{
+	const size_t numTriangles = getNumTriangles();
+	if( numTriangles == 0 )
+		return;
+	const uint32_t *indices = &mIndices[0];
+
+	// the cache optimizer restarts wherever a triangle misses on all three vertices, which divides the mesh into runs
+	FifoCache cache( mVertices.size(), OVERDRAW_CACHE_SIZE );
+	vector<size_t> runs;
+	for( size_t t = 0; t < numTriangles; ++t )
+		if( cache.draw( &indices[t * 3] ) == 3 || t == 0 )
+			runs.push_back( t );
+	runs.push_back( numTriangles );
+
+	// split each run into clusters, ending a cluster as soon as its miss ratio comes within threshold of the whole run's
+	vector<size_t> clusters;
+	for( size_t r = 0; r + 1 < runs.size(); ++r ) {
+		const size_t begin = runs[r], end = runs[r + 1];
+		cache.reset();
+		size_t runMisses = 0;
+		for( size_t t = begin; t < end; ++t )
+			runMisses += cache.draw( &indices[t * 3] );
+		const float targetRatio = threshold * runMisses / (float)( end - begin );
+
+		clusters.push_back( begin );
+		cache.reset();
+		size_t misses = 0, triangles = 0;
+		for( size_t t = begin; t < end; ++t ) {
+			misses += cache.draw( &indices[t * 3] );
+			++triangles;
+			if( misses <= targetRatio * triangles ) {
+				clusters.push_back( t + 1 );
+				cache.reset();
+				misses = triangles = 0;
+			}
+		}
+		// what's left at the end of a run is usually too short to have a good ratio, so it joins the cluster before it
+		if( clusters.back() != begin )
+			clusters.pop_back();
+	}
+	clusters.push_back( numTriangles );
+
+	// clusters facing away from the centroid are the likeliest to occlude the rest, so they sort first
+	Vec3d meshCentroid = Vec3d::zero();
+	for( size_t c = 0; c < numTriangles * 3; ++c )
+		meshCentroid += Vec3d( mVertices[indices[c]] );
+	meshCentroid /= (double)( numTriangles * 3 );
+
+	const size_t numClusters = clusters.size() - 1;
+	vector<std::pair<float, uint32_t> > order( numClusters );
+	for( size_t k = 0; k < numClusters; ++k ) {
+		Vec3f centroid = Vec3f::zero(), normal = Vec3f::zero();
+		float area = 0;
+		for( size_t t = clusters[k]; t < clusters[k + 1]; ++t ) {
+			const Vec3f &a = mVertices[indices[t * 3]], &b = mVertices[indices[t * 3 + 1]], &c = mVertices[indices[t * 3 + 2]];
+			const Vec3f faceNormal = ( b - a ).cross( c - a );
+			const float faceArea = faceNormal.length();
+			centroid += ( a + b + c ) * ( faceArea / 3 );
+			normal += faceNormal;
+			area += faceArea;
+		}
+		if( area > 0 )
+			centroid /= area;
+		normal.safeNormalize();
+		order[k] = std::make_pair( -( centroid - Vec3f( meshCentroid ) ).dot( normal ), static_cast<uint32_t>( k ) );
+	}
+	std::sort( order.begin(), order.end() );
+
+	vector<uint32_t> result;
+	result.reserve( mIndices.size() );
+	for( size_t k = 0; k < numClusters; ++k )
+		result.insert( result.end(), mIndices.begin() + clusters[order[k].second] * 3, mIndices.begin() + clusters[order[k].second + 1] * 3 );
+	// a trailing partial triangle is kept as is
+	result.insert( result.end(), mIndices.begin() + numTriangles * 3, mIndices.end() );
+	mIndices.swap( result );
+}
+
+void TriMesh::optimizeVertexOrder()
+{
+	const uint32_t UNUSED = 0xFFFFFFFF;
+	vector<uint32_t> newIndices( mVertices.size(), UNUSED ), order;
+	order.reserve( mVertices.size() );
+	for( vector<uint32_t>::iterator indexIt = mIndices.begin(); indexIt != mIndices.end(); ++indexIt ) {
+		if( newIndices[*indexIt] == UNUSED ) {
+			newIndices[*indexIt] = static_cast<uint32_t>( order.size() );
+			order.push_back( *indexIt );
+		}
+		*indexIt = newIndices[*indexIt];
+	}
+	for( size_t v = 0; v < mVertices.size(); ++v )
+		if( newIndices[v] == UNUSED )
+			order.push_back( static_cast<uint32_t>( v ) );
+
+	remapVertices( order );
+}
+
+void TriMesh::simplify( size_t targetTriangles, float maxError )
+{
+	const size_t numTriangles = getNumTriangles();
+	if( numTriangles <= targetTriangles )
+		return;
+
+	mIndices.resize( numTriangles * 3 );
+	MeshSimplifier simplifier( mVertices, &mIndices, numTriangles );
+
+	// each partition is brought down in proportion to its share of the triangles, leaving the seams between them for the final pass
+	const size_t numPartitions = std::min<size_t>( TaskPool::getDefault().getNumThreads(), numTriangles / MIN_PARTITION_TRIANGLES );
+	if( numPartitions > 1 ) {
+		vector<size_t> counts, targets( numPartitions );
+		simplifier.partition( numPartitions, &counts );
+		for( size_t p = 0; p < numPartitions; ++p )
+			targets[p] = static_cast<size_t>( counts[p] * ( targetTriangles / (double)numTriangles ) );
+		TaskPool::getDefault().parallelFor( numPartitions, 1, SimplifyPartitionFn( &simplifier, counts, targets, maxError ) );
+		simplifier.clearPartitions();
+	}
+	simplifier.simplify( ALL_PARTITIONS, simplifier.countTriangles(), targetTriangles, maxError );
+
+	// compact the surviving triangles, then drop the vertices they no longer use
+	size_t out = 0;
+	for( size_t t = 0; t < numTriangles; ++t ) {
+		if( simplifier.isTriangleAlive( t ) ) {
+			for( int k = 0; k < 3; ++k )
+				mIndices[out + k] = mIndices[t * 3 + k];
+			out += 3;
+		}
+	}
+	mIndices.resize( out );
+
+	const uint32_t UNUSED = 0xFFFFFFFF;
+	vector<uint32_t> newIndices( mVertices.size(), UNUSED ), order;
+	for( vector<uint32_t>::const_iterator indexIt = mIndices.begin(); indexIt != mIndices.end(); ++indexIt )
+		newIndices[*indexIt] = 0;
+	for( size_t v = 0; v < mVertices.size(); ++v ) {
+		if( newIndices[v] != UNUSED ) {
+			newIndices[v] = static_cast<uint32_t>( order.size() );
+			order.push_back( static_cast<uint32_t>( v ) );
+		}
+	}
+	for( vector<uint32_t>::iterator indexIt = mIndices.begin(); indexIt != mIndices.end(); ++indexIt )
+		*indexIt = newIndices[*indexIt];
+
+	remapVertices( order );
+}
+
+void TriMesh::remapVertices( const vector<uint32_t> &order )
+{
+	const size_t numVertices = mVertices.size();
+	remapAttribute( order, numVertices, &mVertices );
+	remapAttribute( order, numVertices, &mNormals );
+	remapAttribute( order, numVertices, &mTangents );
+	remapAttribute( order, numVertices, &mBitangents );
+	remapAttribute( order, numVertices, &mColorsRGB );
+	remapAttribute( order, numVertices, &mColorsRGBA );
+	remapAttribute( order, numVertices, &mTexCoords );
+}
+
+float TriMesh::calcCacheMissRatio( size_t cacheSize ) const
+{
+	const size_t numTriangles = getNumTriangles();
+	if( numTriangles == 0 || cacheSize == 0 )
+		return 0;
+
+	FifoCache cache( mVertices.size(), cacheSize );
+	uint64_t misses = 0;
+	for( size_t t = 0; t < numTriangles; ++t )
+		misses += cache.draw( &mIndices[t * 3] );
+
+	return misses / (float)numTriangles;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+// TriMeshView
+TriMeshViewRef TriMeshView::create( const fs::path &path, bool verifyChecksum )
+{
+	TriMeshViewRef result( new TriMeshView() );
+	try {
+		result->mMappedFile = MappedFile::create( path );
+	}
+	catch( StreamExc & ) {
+		throw TriMeshExcInvalidFile();
+	}
+	result->parse( reinterpret_cast<const uint8_t*>( result->mMappedFile->getData() ), result->mMappedFile->getSize(), verifyChecksum );
+	return result;
+}
+
+TriMeshViewRef TriMeshView::create( DataSourceRef dataSource, bool verifyChecksum )
 {
-	mNormals.assign( mVertices.size(), Vec3f::zero() );
+	if( dataSource->isFilePath() )
+		return create( dataSource->getFilePath(), verifyChecksum );
 
-	size_t n = getNumTriangles();
-	for( size_t i = 0; i < n; ++i ) {
-		uint32_t index0 = mIndices[i * 3];
-		uint32_t index1 = mIndices[i * 3 + 1];
-		uint32_t index2 = mIndices[i * 3 + 2];
+	TriMeshViewRef result( new TriMeshView() );
+	result->mBuffer = dataSource->getBuffer();
+	if( ! result->mBuffer )
+		throw TriMeshExcInvalidFile();
+	result->parse( reinterpret_cast<const uint8_t*>( result->mBuffer.getData() ), result->mBuffer.getDataSize(), verifyChecksum );
+	return result;
+}
 
-		Vec3f v0 = mVertices[ index0 ];
-		Vec3f v1 = mVertices[ index1 ];
-		Vec3f v2 = mVertices[ index2 ];
+TriMeshView::TriMeshView()
+	: mVertices( 0 ), mNormals( 0 ), mColorsRGB( 0 ), mColorsRGBA( 0 ), mTexCoords( 0 ), mIndices( 0 ),
+	mNumVertices( 0 ), mNumNormals( 0 ), mNumColorsRGB( 0 ), mNumColorsRGBA( 0 ), mNumTexCoords( 0 ), mNumIndices( 0 )
+{
+}
 
-		Vec3f e0 = v1 - v0;
-		Vec3f e1 = v2 - v0;
-		Vec3f normal = e0.cross(e1).normalized();
+void TriMeshView::parse( const uint8_t *data, size_t size, bool verifyChecksum )
+{
+#if ! defined( CINDER_LITTLE_ENDIAN )
+	throw TriMeshExc();
+#endif
+	FileHeader header;
+	if( size < sizeof(header) )
+		throw TriMeshExcInvalidFile();
+	memcpy( &header, data, sizeof(header) );
+	if( header.version != 2 || memcmp( header.magic, MESH_MAGIC, 4 ) != 0 || header.fileSize != size || header.indexEncoding > INDICES_DELTA_VARINT )
+		throw TriMeshExcInvalidFile();
+
+	static const size_t elementSizes[NUM_BLOCKS] = { sizeof(Vec3f), sizeof(Vec3f), sizeof(Color), sizeof(ColorA), sizeof(Vec2f), sizeof(uint32_t) };
+	for( int b = 0; b < NUM_BLOCKS; ++b ) {
+		const FileBlock &block = header.blocks[b];
+		if( block.offset < sizeof(FileHeader) || block.offset % BLOCK_ALIGNMENT || block.offset > size || block.size > size - block.offset )
+			throw TriMeshExcInvalidFile();
+		// every encoded index takes at least one byte
+		const size_t elementSize = ( b == BLOCK_INDICES && header.indexEncoding == INDICES_DELTA_VARINT ) ? 1 : elementSizes[b];
+		if( block.count > block.size / elementSize || ( elementSize > 1 && block.size != block.count * elementSize ) )
+			throw TriMeshExcInvalidFile();
+	}
+
+	if( verifyChecksum && calcChecksum( data + sizeof(FileHeader), size - sizeof(FileHeader) ).get() != header.checksum )
+		throw TriMeshExcInvalidFile();
 
-		mNormals[ index0 ] += normal;
-		mNormals[ index1 ] += normal;
-		mNormals[ index2 ] += normal;
+	mVertices = getBlock<Vec3f>( data, header.blocks[BLOCK_VERTICES] );
+	mNormals = getBlock<Vec3f>( data, header.blocks[BLOCK_NORMALS] );
+	mColorsRGB = getBlock<Color>( data, header.blocks[BLOCK_COLORS_RGB] );
+	mColorsRGBA = getBlock<ColorA>( data, header.blocks[BLOCK_COLORS_RGBA] );
+	mTexCoords = getBlock<Vec2f>( data, header.blocks[BLOCK_TEX_COORDS] );
+	mNumVertices = static_cast<size_t>( header.blocks[BLOCK_VERTICES].count );
+	mNumNormals = static_cast<size_t>( header.blocks[BLOCK_NORMALS].count );
+	mNumColorsRGB = static_cast<size_t>( header.blocks[BLOCK_COLORS_RGB].count );
+	mNumColorsRGBA = static_cast<size_t>( header.blocks[BLOCK_COLORS_RGBA].count );
+	mNumTexCoords = static_cast<size_t>( header.blocks[BLOCK_TEX_COORDS].count );
+	mNumIndices = static_cast<size_t>( header.blocks[BLOCK_INDICES].count );
+
+	const FileBlock &indices = header.blocks[BLOCK_INDICES];
+	if( header.indexEncoding == INDICES_DELTA_VARINT ) {
+		mDecodedIndices.resize( mNumIndices );
+		if( ! decodeIndices( data + indices.offset, static_cast<size_t>( indices.size ), mNumIndices, mDecodedIndices.empty() ? 0 : &mDecodedIndices[0] ) )
+			throw TriMeshExcInvalidFile();
+		mIndices = mDecodedIndices.empty() ? 0 : &mDecodedIndices[0];
 	}
+	else
+		mIndices = getBlock<uint32_t>( data, indices );
+}
 
-	std::for_each( mNormals.begin(), mNormals.end(), std::mem_fun_ref(&Vec3f::normalize) );
+AxisAlignedBox3f TriMeshView::calcBoundingBox() const
+{
+	if( ! mNumVertices )
+		return AxisAlignedBox3f( Vec3f::zero(), Vec3f::zero() );
+
+	Vec3f min( mVertices[0] ), max( mVertices[0] );
+	for( size_t i = 1; i < mNumVertices; ++i ) {
+		const Vec3f &v = mVertices[i];
+		min.x = std::min( min.x, v.x ); max.x = std::max( max.x, v.x );
+		min.y = std::min( min.y, v.y ); max.y = std::max( max.y, v.y );
+		min.z = std::min( min.z, v.z ); max.z = std::max( max.z, v.z );
+	}
+
+	return AxisAlignedBox3f( min, max );
+}
+
+void TriMeshView::copyTo( TriMesh *mesh ) const
+{
+	mesh->clear();
+	mesh->appendVertices( mVertices, mNumVertices );
+	mesh->appendNormals( mNormals, mNumNormals );
+	mesh->appendColorsRgb( mColorsRGB, mNumColorsRGB );
+	mesh->appendColorsRgba( mColorsRGBA, mNumColorsRGBA );
+	mesh->appendTexCoords( mTexCoords, mNumTexCoords );
+	mesh->appendIndices( mIndices, mNumIndices );
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////
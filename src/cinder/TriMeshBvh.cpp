@@ -0,0 +1,743 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/TriMeshBvh.h"
+#include "cinder/TaskPool.h"
+
+#include <algorithm>
+
+using std::vector;
+
+namespace cinder {
+
+namespace {
+
+const uint32_t	MAX_LEAF_SIZE = 8;
+const int		NUM_BINS = 16;
+// the cost of visiting a node, relative to intersecting a triangle
+const float		TRAVERSAL_COST = 1.0f;
+// deeper nodes are split at the median, which bounds the depth of the hierarchy and so the size of the traversal stacks
+const int		MAX_SAH_DEPTH = 64;
+const int		MAX_DEPTH = 128;
+// subtrees smaller than this are built by a single task
+const size_t	MIN_TASK_TRIANGLES = 4096;
+const size_t	BOUNDS_GRAIN_SIZE = 4096;
+const size_t	PACKET_SIZE = 8;
+const size_t	PACKETS_GRAIN_SIZE = 16;
+
+struct Bounds {
+	Bounds() : mMin( std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() ), mMax( -mMin ) {}
+
+	void include( const Vec3f &p )
+	{
+		mMin.x = std::min( mMin.x, p.x ); mMin.y = std::min( mMin.y, p.y ); mMin.z = std::min( mMin.z, p.z );
+		mMax.x = std::max( mMax.x, p.x ); mMax.y = std::max( mMax.y, p.y ); mMax.z = std::max( mMax.z, p.z );
+	}
+
+	void include( const Bounds &rhs )
+	{
+		include( rhs.mMin );
+		include( rhs.mMax );
+	}
+
+	//! Half the surface area, which is all the surface area heuristic needs
+	float calcHalfArea() const
+	{
+		if( mMin.x > mMax.x )
+			return 0;
+		const Vec3f size = mMax - mMin;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	Vec3f	mMin, mMax;
+};
+
+struct CalcTriangleBoundsFn {
+	CalcTriangleBoundsFn( const TriMesh &mesh, vector<Bounds> *bounds, vector<Vec3f> *centroids )
+		: mMesh( mesh ), mBounds( *bounds ), mCentroids( *centroids ) {}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		for( size_t t = begin; t < end; ++t ) {
+			Vec3f a, b, c;
+			mMesh.getTriangleVertices( t, &a, &b, &c );
+			mBounds[t].include( a );
+			mBounds[t].include( b );
+			mBounds[t].include( c );
+			mCentroids[t] = ( a + b + c ) / 3.0f;
+		}
+	}
+
+	const TriMesh	&mMesh;
+	vector<Bounds>	&mBounds;
+	vector<Vec3f>	&mCentroids;
+};
+
+struct CentroidLess {
+	CentroidLess( const vector<Vec3f> &centroids, int axis ) : mCentroids( centroids ), mAxis( axis ) {}
+	bool operator()( uint32_t a, uint32_t b ) const { return mCentroids[a][mAxis] < mCentroids[b][mAxis]; }
+
+	const vector<Vec3f>		&mCentroids;
+	int						mAxis;
+};
+
+struct InLowerBins {
+	InLowerBins( const vector<Vec3f> &centroids, int axis, float min, float scale, int bin )
+		: mCentroids( centroids ), mAxis( axis ), mMin( min ), mScale( scale ), mBin( bin ) {}
+	bool operator()( uint32_t t ) const { return std::min( NUM_BINS - 1, (int)( ( mCentroids[t][mAxis] - mMin ) * mScale ) ) < mBin; }
+
+	const vector<Vec3f>		&mCentroids;
+	int						mAxis;
+	float					mMin, mScale;
+	int						mBin;
+};
+
+// unlike std::min() and std::max(), these return values rather than references, which lets loops over them vectorize
+inline float minf( float a, float b ) { return ( a < b ) ? a : b; }
+inline float maxf( float a, float b ) { return ( a > b ) ? a : b; }
+
+// Returns the distance at which the ray enters the box, or the maximum float if it misses it or enters beyond \a maxDistance
+inline float intersectBox( const Vec3f &min, const Vec3f &max, const Vec3f &origin, const Vec3f &invDirection, float maxDistance )
+{
+	const float x0 = ( min.x - origin.x ) * invDirection.x, x1 = ( max.x - origin.x ) * invDirection.x;
+	const float y0 = ( min.y - origin.y ) * invDirection.y, y1 = ( max.y - origin.y ) * invDirection.y;
+	const float z0 = ( min.z - origin.z ) * invDirection.z, z1 = ( max.z - origin.z ) * invDirection.z;
+	const float enter = std::max( std::max( std::min( x0, x1 ), std::min( y0, y1 ) ), std::max( std::min( z0, z1 ), 0.0f ) );
+	const float exit = std::min( std::min( std::max( x0, x1 ), std::max( y0, y1 ) ), std::min( std::max( z0, z1 ), maxDistance ) );
+	return ( enter <= exit ) ? enter : std::numeric_limits<float>::max();
+}
+
+// Moller and Trumbore's algorithm, as in Ray::calcTriangleIntersection() but with the edges precomputed.
+// Written so that NaNs from degenerate triangles fail the tests.
+inline bool intersectTriangle( const Vec3f &vert0, const Vec3f &edge1, const Vec3f &edge2, const Vec3f &origin, const Vec3f &direction,
+	float maxDistance, float *distance, float *u, float *v )
+{
+	const Vec3f pvec = direction.cross( edge2 );
+	const float invDet = 1.0f / edge1.dot( pvec );
+	const Vec3f tvec = origin - vert0;
+	*u = tvec.dot( pvec ) * invDet;
+	if( ! ( *u >= 0 && *u <= 1 ) )
+		return false;
+	const Vec3f qvec = tvec.cross( edge1 );
+	*v = direction.dot( qvec ) * invDet;
+	if( ! ( *v >= 0 && *u + *v <= 1 ) )
+		return false;
+	*distance = edge2.dot( qvec ) * invDet;
+	return *distance >= 0 && *distance < maxDistance;
+}
+
+struct BoxOverlaps {
+	BoxOverlaps( const AxisAlignedBox3f &box ) : mMin( box.getMin() ), mMax( box.getMax() ), mCenter( box.getCenter() ), mHalfSize( box.getSize() * 0.5f ) {}
+
+	bool overlapsBox( const Vec3f &min, const Vec3f &max ) const
+	{
+		return min.x <= mMax.x && max.x >= mMin.x && min.y <= mMax.y && max.y >= mMin.y && min.z <= mMax.z && max.z >= mMin.z;
+	}
+
+	// Akenine-Moller's separating axis test, against the box's faces, the triangle's plane and the cross products of their edges
+	bool overlapsTriangle( const Vec3f &a, const Vec3f &b, const Vec3f &c ) const
+	{
+		const Vec3f v[3] = { a - mCenter, b - mCenter, c - mCenter };
+		const Vec3f edges[3] = { v[1] - v[0], v[2] - v[1], v[0] - v[2] };
+		for( int axis = 0; axis < 3; ++axis ) {
+			if( std::min( std::min( v[0][axis], v[1][axis] ), v[2][axis] ) > mHalfSize[axis] || std::max( std::max( v[0][axis], v[1][axis] ), v[2][axis] ) < -mHalfSize[axis] )
+				return false;
+		}
+		if( separates( edges[0].cross( edges[1] ), v ) )
+			return false;
+		for( int axis = 0; axis < 3; ++axis ) {
+			Vec3f unit = Vec3f::zero();
+			unit[axis] = 1;
+			for( int e = 0; e < 3; ++e )
+				if( separates( unit.cross( edges[e] ), v ) )
+					return false;
+		}
+		return true;
+	}
+
+	bool separates( const Vec3f &axis, const Vec3f v[3] ) const
+	{
+		const float p0 = axis.dot( v[0] ), p1 = axis.dot( v[1] ), p2 = axis.dot( v[2] );
+		const float radius = mHalfSize.x * math<float>::abs( axis.x ) + mHalfSize.y * math<float>::abs( axis.y ) + mHalfSize.z * math<float>::abs( axis.z );
+		return std::min( std::min( p0, p1 ), p2 ) > radius || std::max( std::max( p0, p1 ), p2 ) < -radius;
+	}
+
+	Vec3f	mMin, mMax, mCenter, mHalfSize;
+};
+
+struct SphereOverlaps {
+	SphereOverlaps( const Sphere &sphere ) : mCenter( sphere.getCenter() ), mRadiusSquared( sphere.getRadius() * sphere.getRadius() ) {}
+
+	bool overlapsBox( const Vec3f &min, const Vec3f &max ) const
+	{
+		Vec3f closest( std::min( std::max( mCenter.x, min.x ), max.x ), std::min( std::max( mCenter.y, min.y ), max.y ), std::min( std::max( mCenter.z, min.z ), max.z ) );
+		return closest.distanceSquared( mCenter ) <= mRadiusSquared;
+	}
+
+	bool overlapsTriangle( const Vec3f &a, const Vec3f &b, const Vec3f &c ) const
+	{
+		return closestPointOnTriangle( a, b, c ).distanceSquared( mCenter ) <= mRadiusSquared;
+	}
+
+	// from Ericson's "Real-Time Collision Detection", classifying the center by the Voronoi regions of the triangle
+	Vec3f closestPointOnTriangle( const Vec3f &a, const Vec3f &b, const Vec3f &c ) const
+	{
+		const Vec3f ab = b - a, ac = c - a, ap = mCenter - a;
+		const float d1 = ab.dot( ap ), d2 = ac.dot( ap );
+		if( d1 <= 0 && d2 <= 0 )
+			return a;
+		const Vec3f bp = mCenter - b;
+		const float d3 = ab.dot( bp ), d4 = ac.dot( bp );
+		if( d3 >= 0 && d4 <= d3 )
+			return b;
+		const float vc = d1 * d4 - d3 * d2;
+		if( vc <= 0 && d1 >= 0 && d3 <= 0 )
+			return a + ab * ( d1 / ( d1 - d3 ) );
+		const Vec3f cp = mCenter - c;
+		const float d5 = ab.dot( cp ), d6 = ac.dot( cp );
+		if( d6 >= 0 && d5 <= d6 )
+			return c;
+		const float vb = d5 * d2 - d1 * d6;
+		if( vb <= 0 && d2 >= 0 && d6 <= 0 )
+			return a + ac * ( d2 / ( d2 - d6 ) );
+		const float va = d3 * d6 - d5 * d4;
+		if( va <= 0 && ( d4 - d3 ) >= 0 && ( d5 - d6 ) >= 0 )
+			return b + ( c - b ) * ( ( d4 - d3 ) / ( ( d4 - d3 ) + ( d5 - d6 ) ) );
+		const float sum = va + vb + vc;
+		if( sum == 0 )
+			return a;
+		return a + ab * ( vb / sum ) + ac * ( vc / sum );
+	}
+
+	Vec3f	mCenter;
+	float	mRadiusSquared;
+};
+
+struct FrustumOverlaps {
+	FrustumOverlaps( const Frustumf &frustum ) : mFrustum( frustum ) {}
+
+	bool overlapsBox( const Vec3f &min, const Vec3f &max ) const
+	{
+		return mFrustum.intersects( AxisAlignedBox3f( min, max ) );
+	}
+
+	bool overlapsTriangle( const Vec3f &a, const Vec3f &b, const Vec3f &c ) const
+	{
+		Bounds bounds;
+		bounds.include( a );
+		bounds.include( b );
+		bounds.include( c );
+		return overlapsBox( bounds.mMin, bounds.mMax );
+	}
+
+	const Frustumf	&mFrustum;
+};
+
+} // anonymous namespace
+
+// Builds subtrees into separate arrays so that they can be built concurrently, then joins them depth first
+struct TriMeshBvh::Builder {
+	// A node above the subtrees, whose children are other TopNodes or, for a subtree, its index in mSubtrees
+	struct TopNode {
+		Bounds		mBounds;
+		uint32_t	mChildren[2];
+		uint32_t	mSubtree;
+	};
+
+	struct Subtree {
+		uint32_t			mBegin, mEnd;
+		int					mDepth;
+		vector<BvhNode>		mNodes;
+	};
+
+	struct BuildSubtreesFn {
+		BuildSubtreesFn( Builder *builder ) : mBuilder( builder ) {}
+
+		void operator()( size_t begin, size_t end ) const
+		{
+			for( size_t s = begin; s < end; ++s ) {
+				Subtree &subtree = mBuilder->mSubtrees[s];
+				mBuilder->buildSubtree( subtree.mBegin, subtree.mEnd, subtree.mDepth, &subtree.mNodes );
+			}
+		}
+
+		Builder		*mBuilder;
+	};
+
+	Builder( const TriMesh &mesh, vector<uint32_t> *order )
+		: mBounds( mesh.getNumTriangles() ), mCentroids( mesh.getNumTriangles() ), mOrder( *order )
+	{
+		TaskPool::getDefault().parallelFor( mesh.getNumTriangles(), BOUNDS_GRAIN_SIZE, CalcTriangleBoundsFn( mesh, &mBounds, &mCentroids ) );
+		mOrder.resize( mesh.getNumTriangles() );
+		for( size_t t = 0; t < mOrder.size(); ++t )
+			mOrder[t] = static_cast<uint32_t>( t );
+	}
+
+	void build( vector<BvhNode> *result )
+	{
+		const size_t numTriangles = mOrder.size();
+		mMaxSubtreeTriangles = std::max( MIN_TASK_TRIANGLES, numTriangles / ( TaskPool::getDefault().getNumThreads() * 4 ) );
+		buildTop( 0, static_cast<uint32_t>( numTriangles ), 0 );
+		TaskPool::getDefault().parallelFor( mSubtrees.size(), 1, BuildSubtreesFn( this ) );
+
+		result->clear();
+		result->reserve( 2 * ( numTriangles / 2 + 1 ) );
+		join( 0, result );
+	}
+
+	// Divides [begin, end) until its parts are small enough for a single task
+	uint32_t buildTop( uint32_t begin, uint32_t end, int depth )
+	{
+		const uint32_t result = static_cast<uint32_t>( mTopNodes.size() );
+		mTopNodes.push_back( TopNode() );
+		uint32_t middle = end;
+		if( end - begin > mMaxSubtreeTriangles )
+			middle = split( begin, end, depth, &mTopNodes[result].mBounds );
+		if( middle == end ) {
+			mTopNodes[result].mSubtree = static_cast<uint32_t>( mSubtrees.size() );
+			mSubtrees.push_back( Subtree() );
+			mSubtrees.back().mBegin = begin;
+			mSubtrees.back().mEnd = end;
+			mSubtrees.back().mDepth = depth;
+		}
+		else {
+			mTopNodes[result].mSubtree = NO_TRIANGLE;
+			const uint32_t first = buildTop( begin, middle, depth + 1 );
+			const uint32_t second = buildTop( middle, end, depth + 1 );
+			mTopNodes[result].mChildren[0] = first;
+			mTopNodes[result].mChildren[1] = second;
+		}
+		return result;
+	}
+
+	// Appends the subtree beneath \a topNode to \a result depth first, returning the index of its root
+	uint32_t join( uint32_t topNode, vector<BvhNode> *result )
+	{
+		const uint32_t index = static_cast<uint32_t>( result->size() );
+		const TopNode &top = mTopNodes[topNode];
+		if( top.mSubtree != NO_TRIANGLE ) {
+			const vector<BvhNode> &nodes = mSubtrees[top.mSubtree].mNodes;
+			for( vector<BvhNode>::const_iterator nodeIt = nodes.begin(); nodeIt != nodes.end(); ++nodeIt ) {
+				result->push_back( *nodeIt );
+				if( nodeIt->mCount == 0 )
+					result->back().mFirst += index;
+			}
+		}
+		else {
+			BvhNode node;
+			node.mMin = top.mBounds.mMin;
+			node.mMax = top.mBounds.mMax;
+			node.mCount = 0;
+			result->push_back( node );
+			join( top.mChildren[0], result );
+			const uint32_t second = join( top.mChildren[1], result );
+			(*result)[index].mFirst = second;
+		}
+		return index;
+	}
+
+	// Appends the hierarchy over [begin, end) to \a nodes depth first, returning the index of its root
+	uint32_t buildSubtree( uint32_t begin, uint32_t end, int depth, vector<BvhNode> *nodes ) const
+	{
+		const uint32_t result = static_cast<uint32_t>( nodes->size() );
+		Bounds bounds;
+		const uint32_t middle = split( begin, end, depth, &bounds );
+		BvhNode node;
+		node.mMin = bounds.mMin;
+		node.mMax = bounds.mMax;
+		node.mFirst = begin;
+		node.mCount = end - begin;
+		nodes->push_back( node );
+		if( middle != end ) {
+			buildSubtree( begin, middle, depth + 1, nodes );
+			const uint32_t second = buildSubtree( middle, end, depth + 1, nodes );
+			(*nodes)[result].mFirst = second;
+			(*nodes)[result].mCount = 0;
+		}
+		return result;
+	}
+
+	/* Calculates the bounds of the triangles in [begin, end) and reorders them into two halves, choosing the split with the least
+	   cost by the surface area heuristic among evenly spaced planes across their centroids. Returns the start of the second half,
+	   or \a end if the triangles are best left as a leaf. */
+	uint32_t split( uint32_t begin, uint32_t end, int depth, Bounds *bounds ) const
+	{
+		Bounds centroidBounds;
+		for( uint32_t i = begin; i < end; ++i ) {
+			bounds->include( mBounds[mOrder[i]] );
+			centroidBounds.include( mCentroids[mOrder[i]] );
+		}
+		const uint32_t count = end - begin;
+		if( count == 1 )
+			return end;
+
+		const Vec3f centroidSize = centroidBounds.mMax - centroidBounds.mMin;
+		const int longestAxis = ( centroidSize.x >= centroidSize.y && centroidSize.x >= centroidSize.z ) ? 0 : ( ( centroidSize.y >= centroidSize.z ) ? 1 : 2 );
+		if( centroidSize[longestAxis] <= 0 )
+			return ( count <= MAX_LEAF_SIZE ) ? end : begin + count / 2;
+		if( depth >= MAX_SAH_DEPTH )
+			return splitMedian( begin, end, longestAxis );
+
+		float bestCost = std::numeric_limits<float>::max();
+		int bestAxis = 0, bestBin = 0;
+		for( int axis = 0; axis < 3; ++axis ) {
+			if( centroidSize[axis] <= 0 )
+				continue;
+			Bounds bins[NUM_BINS];
+			uint32_t counts[NUM_BINS] = { 0 };
+			const float scale = NUM_BINS / centroidSize[axis];
+			for( uint32_t i = begin; i < end; ++i ) {
+				const uint32_t t = mOrder[i];
+				const int bin = std::min( NUM_BINS - 1, (int)( ( mCentroids[t][axis] - centroidBounds.mMin[axis] ) * scale ) );
+				bins[bin].include( mBounds[t] );
+				++counts[bin];
+			}
+
+			// sweep from the right recording the cost of the right side of each plane, then from the left adding the left side's
+			float costs[NUM_BINS];
+			Bounds right;
+			uint32_t rightCount = 0;
+			for( int bin = NUM_BINS - 1; bin > 0; --bin ) {
+				right.include( bins[bin] );
+				rightCount += counts[bin];
+				costs[bin] = right.calcHalfArea() * rightCount;
+			}
+			Bounds left;
+			uint32_t leftCount = 0;
+			for( int bin = 1; bin < NUM_BINS; ++bin ) {
+				left.include( bins[bin - 1] );
+				leftCount += counts[bin - 1];
+				const float cost = costs[bin] + left.calcHalfArea() * leftCount;
+				if( leftCount > 0 && leftCount < count && cost < bestCost ) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = bin;
+				}
+			}
+		}
+
+		const float area = bounds->calcHalfArea();
+		const float splitCost = TRAVERSAL_COST + ( ( area > 0 ) ? bestCost / area : 0 );
+		if( count <= MAX_LEAF_SIZE && splitCost >= count )
+			return end;
+		if( bestCost == std::numeric_limits<float>::max() )
+			return splitMedian( begin, end, longestAxis );
+
+		const InLowerBins inLowerBins( mCentroids, bestAxis, centroidBounds.mMin[bestAxis], NUM_BINS / centroidSize[bestAxis], bestBin );
+		return static_cast<uint32_t>( std::partition( mOrder.begin() + begin, mOrder.begin() + end, inLowerBins ) - mOrder.begin() );
+	}
+
+	uint32_t splitMedian( uint32_t begin, uint32_t end, int axis ) const
+	{
+		if( end - begin <= MAX_LEAF_SIZE )
+			return end;
+		const uint32_t middle = begin + ( end - begin ) / 2;
+		std::nth_element( mOrder.begin() + begin, mOrder.begin() + middle, mOrder.begin() + end, CentroidLess( mCentroids, axis ) );
+		return middle;
+	}
+
+	vector<Bounds>		mBounds;
+	vector<Vec3f>		mCentroids;
+	vector<uint32_t>	&mOrder;
+	size_t				mMaxSubtreeTriangles;
+	vector<TopNode>		mTopNodes;
+	vector<Subtree>		mSubtrees;
+};
+
+struct TriMeshBvh::RaycastPacketsFn {
+	RaycastPacketsFn( const TriMeshBvh &bvh, const vector<Ray> &rays, float maxDistance, vector<Hit> *results )
+		: mBvh( bvh ), mRays( rays ), mMaxDistance( maxDistance ), mResults( *results ) {}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		for( size_t packet = begin; packet < end; ++packet ) {
+			const size_t first = packet * PACKET_SIZE;
+			mBvh.raycastPacket( &mRays[first], std::min( PACKET_SIZE, mRays.size() - first ), mMaxDistance, &mResults[first] );
+		}
+	}
+
+	const TriMeshBvh	&mBvh;
+	const vector<Ray>	&mRays;
+	float				mMaxDistance;
+	vector<Hit>			&mResults;
+};
+
+TriMeshBvh::TriMeshBvh( const TriMesh &mesh )
+{
+	if( mesh.getNumTriangles() == 0 )
+		return;
+
+	Builder( mesh, &mTriangleIndices ).build( &mBvhNodes );
+
+	mTriangles.resize( mTriangleIndices.size() );
+	for( size_t t = 0; t < mTriangles.size(); ++t ) {
+		Vec3f a, b, c;
+		mesh.getTriangleVertices( mTriangleIndices[t], &a, &b, &c );
+		mTriangles[t].mVert0 = a;
+		mTriangles[t].mEdge1 = b - a;
+		mTriangles[t].mEdge2 = c - a;
+	}
+}
+
+bool TriMeshBvh::raycast( const Ray &ray, Hit *result, float maxDistance ) const
+{
+	if( mBvhNodes.empty() )
+		return false;
+
+	const Vec3f &origin = ray.getOrigin(), &direction = ray.getDirection(), &invDirection = ray.getInverseDirection();
+	float nearest = maxDistance;
+	uint32_t nearestTriangle = NO_TRIANGLE;
+	float nearestU = 0, nearestV = 0;
+
+	// nodes are pushed with the distances at which the ray enters them, and skipped if something nearer has been hit since
+	uint32_t stack[MAX_DEPTH];
+	float stackDistances[MAX_DEPTH];
+	int stackSize = 0;
+	const float rootDistance = intersectBox( mBvhNodes[0].mMin, mBvhNodes[0].mMax, origin, invDirection, nearest );
+	if( rootDistance != std::numeric_limits<float>::max() ) {
+		stack[stackSize] = 0;
+		stackDistances[stackSize++] = rootDistance;
+	}
+	while( stackSize > 0 ) {
+		--stackSize;
+		if( stackDistances[stackSize] > nearest )
+			continue;
+		const BvhNode &bvhNode = mBvhNodes[stack[stackSize]];
+		if( bvhNode.mCount ) {
+			for( uint32_t t = bvhNode.mFirst; t < bvhNode.mFirst + bvhNode.mCount; ++t ) {
+				float distance, u, v;
+				if( intersectTriangle( mTriangles[t].mVert0, mTriangles[t].mEdge1, mTriangles[t].mEdge2, origin, direction, nearest, &distance, &u, &v ) ) {
+					nearest = distance;
+					nearestTriangle = t;
+					nearestU = u;
+					nearestV = v;
+				}
+			}
+		}
+		else {
+			// the nearer child is pushed last so that it's visited first
+			uint32_t children[2] = { (uint32_t)( &bvhNode - &mBvhNodes[0] ) + 1, bvhNode.mFirst };
+			float distances[2];
+			for( int c = 0; c < 2; ++c )
+				distances[c] = intersectBox( mBvhNodes[children[c]].mMin, mBvhNodes[children[c]].mMax, origin, invDirection, nearest );
+			if( distances[0] < distances[1] ) {
+				std::swap( children[0], children[1] );
+				std::swap( distances[0], distances[1] );
+			}
+			for( int c = 0; c < 2; ++c ) {
+				if( distances[c] != std::numeric_limits<float>::max() ) {
+					stack[stackSize] = children[c];
+					stackDistances[stackSize++] = distances[c];
+				}
+			}
+		}
+	}
+
+	if( nearestTriangle == NO_TRIANGLE )
+		return false;
+	result->mTriangle = mTriangleIndices[nearestTriangle];
+	result->mDistance = nearest;
+	result->mU = nearestU;
+	result->mV = nearestV;
+	return true;
+}
+
+bool TriMeshBvh::raycastAny( const Ray &ray, float maxDistance ) const
+{
+	if( mBvhNodes.empty() )
+		return false;
+
+	const Vec3f &origin = ray.getOrigin(), &direction = ray.getDirection(), &invDirection = ray.getInverseDirection();
+	uint32_t stack[MAX_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while( stackSize > 0 ) {
+		const BvhNode &bvhNode = mBvhNodes[stack[--stackSize]];
+		if( intersectBox( bvhNode.mMin, bvhNode.mMax, origin, invDirection, maxDistance ) == std::numeric_limits<float>::max() )
+			continue;
+		if( bvhNode.mCount ) {
+			for( uint32_t t = bvhNode.mFirst; t < bvhNode.mFirst + bvhNode.mCount; ++t ) {
+				float distance, u, v;
+				if( intersectTriangle( mTriangles[t].mVert0, mTriangles[t].mEdge1, mTriangles[t].mEdge2, origin, direction, maxDistance, &distance, &u, &v ) )
+					return true;
+			}
+		}
+		else {
+			stack[stackSize++] = bvhNode.mFirst;
+			stack[stackSize++] = (uint32_t)( &bvhNode - &mBvhNodes[0] ) + 1;
+		}
+	}
+
+	return false;
+}
+
+size_t TriMeshBvh::raycast( const vector<Ray> &rays, vector<Hit> *results, float maxDistance ) const
+{
+	results->assign( rays.size(), Hit() );
+	if( mBvhNodes.empty() )
+		return 0;
+
+	TaskPool::getDefault().parallelFor( ( rays.size() + PACKET_SIZE - 1 ) / PACKET_SIZE, PACKETS_GRAIN_SIZE, RaycastPacketsFn( *this, rays, maxDistance, results ) );
+	size_t result = 0;
+	for( vector<Hit>::const_iterator hitIt = results->begin(); hitIt != results->end(); ++hitIt )
+		result += hitIt->isHit() ? 1 : 0;
+	return result;
+}
+
+void TriMeshBvh::raycastPacket( const Ray *rays, size_t numRays, float maxDistance, Hit *results ) const
+{
+	// the rays are stored as structures of arrays, so that the loops across the packet vectorize. Unused lanes get a negative
+	// nearest distance, which no node or triangle can beat.
+	float originX[PACKET_SIZE], originY[PACKET_SIZE], originZ[PACKET_SIZE];
+	float dirX[PACKET_SIZE], dirY[PACKET_SIZE], dirZ[PACKET_SIZE];
+	float invX[PACKET_SIZE], invY[PACKET_SIZE], invZ[PACKET_SIZE];
+	float nearest[PACKET_SIZE], nearestU[PACKET_SIZE], nearestV[PACKET_SIZE];
+	uint32_t nearestTriangle[PACKET_SIZE];
+	for( size_t r = 0; r < PACKET_SIZE; ++r ) {
+		const Ray &ray = rays[( r < numRays ) ? r : 0];
+		originX[r] = ray.getOrigin().x; originY[r] = ray.getOrigin().y; originZ[r] = ray.getOrigin().z;
+		dirX[r] = ray.getDirection().x; dirY[r] = ray.getDirection().y; dirZ[r] = ray.getDirection().z;
+		invX[r] = ray.getInverseDirection().x; invY[r] = ray.getInverseDirection().y; invZ[r] = ray.getInverseDirection().z;
+		nearest[r] = ( r < numRays ) ? maxDistance : -1.0f;
+		nearestU[r] = nearestV[r] = 0;
+		nearestTriangle[r] = NO_TRIANGLE;
+	}
+
+	uint32_t stack[MAX_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while( stackSize > 0 ) {
+		const BvhNode &bvhNode = mBvhNodes[stack[--stackSize]];
+		int anyEnters = 0;
+		for( size_t r = 0; r < PACKET_SIZE; ++r ) {
+			const float x0 = ( bvhNode.mMin.x - originX[r] ) * invX[r], x1 = ( bvhNode.mMax.x - originX[r] ) * invX[r];
+			const float y0 = ( bvhNode.mMin.y - originY[r] ) * invY[r], y1 = ( bvhNode.mMax.y - originY[r] ) * invY[r];
+			const float z0 = ( bvhNode.mMin.z - originZ[r] ) * invZ[r], z1 = ( bvhNode.mMax.z - originZ[r] ) * invZ[r];
+			const float enter = maxf( maxf( minf( x0, x1 ), minf( y0, y1 ) ), maxf( minf( z0, z1 ), 0.0f ) );
+			const float exit = minf( minf( maxf( x0, x1 ), maxf( y0, y1 ) ), minf( maxf( z0, z1 ), nearest[r] ) );
+			anyEnters |= ( enter <= exit ) ? 1 : 0;
+		}
+		if( ! anyEnters )
+			continue;
+
+		if( bvhNode.mCount ) {
+			for( uint32_t t = bvhNode.mFirst; t < bvhNode.mFirst + bvhNode.mCount; ++t ) {
+				const Triangle &triangle = mTriangles[t];
+				const Vec3f &vert0 = triangle.mVert0, &edge1 = triangle.mEdge1, &edge2 = triangle.mEdge2;
+				for( size_t r = 0; r < PACKET_SIZE; ++r ) {
+					const float pX = dirY[r] * edge2.z - dirZ[r] * edge2.y, pY = dirZ[r] * edge2.x - dirX[r] * edge2.z, pZ = dirX[r] * edge2.y - dirY[r] * edge2.x;
+					const float invDet = 1.0f / ( edge1.x * pX + edge1.y * pY + edge1.z * pZ );
+					const float tX = originX[r] - vert0.x, tY = originY[r] - vert0.y, tZ = originZ[r] - vert0.z;
+					const float u = ( tX * pX + tY * pY + tZ * pZ ) * invDet;
+					const float qX = tY * edge1.z - tZ * edge1.y, qY = tZ * edge1.x - tX * edge1.z, qZ = tX * edge1.y - tY * edge1.x;
+					const float v = ( dirX[r] * qX + dirY[r] * qY + dirZ[r] * qZ ) * invDet;
+					const float distance = ( edge2.x * qX + edge2.y * qY + edge2.z * qZ ) * invDet;
+					// bitwise rather than logical ands, which would be branches
+					const bool hit = ( u >= 0 ) & ( v >= 0 ) & ( u + v <= 1 ) & ( distance >= 0 ) & ( distance < nearest[r] );
+					nearest[r] = hit ? distance : nearest[r];
+					nearestU[r] = hit ? u : nearestU[r];
+					nearestV[r] = hit ? v : nearestV[r];
+					nearestTriangle[r] = hit ? t : nearestTriangle[r];
+				}
+			}
+		}
+		else {
+			// visit first the child whose center is nearer along the first ray
+			const uint32_t first = (uint32_t)( &bvhNode - &mBvhNodes[0] ) + 1;
+			const Vec3f direction( dirX[0], dirY[0], dirZ[0] );
+			const float firstDistance = direction.dot( mBvhNodes[first].mMin + mBvhNodes[first].mMax );
+			const float secondDistance = direction.dot( mBvhNodes[bvhNode.mFirst].mMin + mBvhNodes[bvhNode.mFirst].mMax );
+			stack[stackSize++] = ( firstDistance < secondDistance ) ? bvhNode.mFirst : first;
+			stack[stackSize++] = ( firstDistance < secondDistance ) ? first : bvhNode.mFirst;
+		}
+	}
+
+	for( size_t r = 0; r < numRays; ++r ) {
+		if( nearestTriangle[r] != NO_TRIANGLE ) {
+			results[r].mTriangle = mTriangleIndices[nearestTriangle[r]];
+			results[r].mDistance = nearest[r];
+			results[r].mU = nearestU[r];
+			results[r].mV = nearestV[r];
+		}
+	}
+}
+
+vector<uint32_t> TriMeshBvh::findTriangles( const AxisAlignedBox3f &box ) const
+{
+	vector<uint32_t> result;
+	collectTriangles( BoxOverlaps( box ), &result );
+	return result;
+}
+
+vector<uint32_t> TriMeshBvh::findTriangles( const Sphere &sphere ) const
+{
+	vector<uint32_t> result;
+	collectTriangles( SphereOverlaps( sphere ), &result );
+	return result;
+}
+
+vector<uint32_t> TriMeshBvh::findTriangles( const Frustumf &frustum ) const
+{
+	vector<uint32_t> result;
+	collectTriangles( FrustumOverlaps( frustum ), &result );
+	return result;
+}
+
+template<typename Overlaps>
+void TriMeshBvh::collectTriangles( const Overlaps &overlaps, vector<uint32_t> *result ) const
+{
+	if( mBvhNodes.empty() )
+		return;
+
+	uint32_t stack[MAX_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while( stackSize > 0 ) {
+		const BvhNode &bvhNode = mBvhNodes[stack[--stackSize]];
+		if( ! overlaps.overlapsBox( bvhNode.mMin, bvhNode.mMax ) )
+			continue;
+		if( bvhNode.mCount ) {
+			for( uint32_t t = bvhNode.mFirst; t < bvhNode.mFirst + bvhNode.mCount; ++t ) {
+				const Triangle &triangle = mTriangles[t];
+				if( overlaps.overlapsTriangle( triangle.mVert0, triangle.mVert0 + triangle.mEdge1, triangle.mVert0 + triangle.mEdge2 ) )
+					result->push_back( mTriangleIndices[t] );
+			}
+		}
+		else {
+			stack[stackSize++] = bvhNode.mFirst;
+			stack[stackSize++] = (uint32_t)( &bvhNode - &mBvhNodes[0] ) + 1;
+		}
+	}
+
+	std::sort( result->begin(), result->end() );
+}
+
+AxisAlignedBox3f TriMeshBvh::getBoundingBox() const
+{
+	if( mBvhNodes.empty() )
+		return AxisAlignedBox3f( Vec3f::zero(), Vec3f::zero() );
+	return AxisAlignedBox3f( mBvhNodes[0].mMin, mBvhNodes[0].mMax );
+}
+
+} // namespace cinder
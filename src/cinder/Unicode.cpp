@@ -1,5 +1,18 @@
 #include "cinder/Unicode.h"
 #include <cstring>
+#include <algorithm>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && ( _M_IX86_FP >= 2 ) )
+	#define CINDER_UNICODE_SSE2
+	#include <emmintrin.h>
+	#if defined( __SSSE3__ ) || defined( __AVX__ )
+		#define CINDER_UNICODE_SSSE3
+		#include <tmmintrin.h>
+	#endif
+#elif defined( __ARM_NEON__ ) || defined( __ARM_NEON )
+	#define CINDER_UNICODE_NEON
+	#include <arm_neon.h>
+#endif
 
 extern "C" {
 #include "linebreak.h"
@@ -10,19 +23,251 @@ using namespace std;
 
 namespace cinder {
 
+namespace {
+
+const uint32_t REPLACEMENT_CHAR = 0xFFFD;
+
+// Returns the length of the run of ASCII bytes at the start of \a s, up to \a length
+size_t asciiRunLength( const uint8_t *s, size_t length )
+{
+	size_t i = 0;
+#if defined( CINDER_UNICODE_SSE2 )
+	for( ; i + 16 <= length; i += 16 ) {
+		int mask = _mm_movemask_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( s + i ) ) );
+		if( mask ) {
+			while( ( mask & 1 ) == 0 ) {
+				mask >>= 1;
+				++i;
+			}
+			return i;
+		}
+	}
+#elif defined( CINDER_UNICODE_NEON )
+	for( ; i + 16 <= length; i += 16 ) {
+		uint64x2_t high = vreinterpretq_u64_u8( vandq_u8( vld1q_u8( s + i ), vdupq_n_u8( 0x80 ) ) );
+		if( ( vgetq_lane_u64( high, 0 ) | vgetq_lane_u64( high, 1 ) ) != 0 )
+			break;
+	}
+#else
+	for( ; i + 8 <= length; i += 8 ) {
+		uint64_t word;
+		memcpy( &word, s + i, 8 );
+		if( word & 0x8080808080808080ULL )
+			break;
+	}
+#endif
+	while( i < length && s[i] < 0x80 )
+		++i;
+	return i;
+}
+
+// Strict decoder: advances \a *i past one well-formed sequence, or past a single byte returning REPLACEMENT_CHAR
+inline uint32_t decodeUtf8( const uint8_t *s, size_t length, size_t *i )
+{
+	uint8_t lead = s[*i];
+	if( lead < 0x80 ) {
+		++*i;
+		return lead;
+	}
+
+	size_t remaining = length - *i;
+	uint32_t cp;
+	size_t count;
+	uint32_t minCp;
+	if( lead >= 0xC2 && lead <= 0xDF ) { cp = lead & 0x1F; count = 2; minCp = 0x80; }
+	else if( lead >= 0xE0 && lead <= 0xEF ) { cp = lead & 0x0F; count = 3; minCp = 0x800; }
+	else if( lead >= 0xF0 && lead <= 0xF4 ) { cp = lead & 0x07; count = 4; minCp = 0x10000; }
+	else {
+		++*i;
+		return REPLACEMENT_CHAR;
+	}
+
+	if( remaining < count ) {
+		++*i;
+		return REPLACEMENT_CHAR;
+	}
+	for( size_t c = 1; c < count; ++c ) {
+		uint8_t cont = s[*i + c];
+		if( ( cont & 0xC0 ) != 0x80 ) {
+			++*i;
+			return REPLACEMENT_CHAR;
+		}
+		cp = ( cp << 6 ) | ( cont & 0x3F );
+	}
+	if( cp < minCp || cp > 0x10FFFF || ( cp >= 0xD800 && cp <= 0xDFFF ) ) {
+		++*i;
+		return REPLACEMENT_CHAR;
+	}
+
+	*i += count;
+	return cp;
+}
+
+inline char* encodeUtf8( uint32_t cp, char *out )
+{
+	if( cp < 0x80 )
+		*out++ = (char)cp;
+	else if( cp < 0x800 ) {
+		*out++ = (char)( 0xC0 | ( cp >> 6 ) );
+		*out++ = (char)( 0x80 | ( cp & 0x3F ) );
+	}
+	else if( cp < 0x10000 ) {
+		*out++ = (char)( 0xE0 | ( cp >> 12 ) );
+		*out++ = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+		*out++ = (char)( 0x80 | ( cp & 0x3F ) );
+	}
+	else {
+		*out++ = (char)( 0xF0 | ( cp >> 18 ) );
+		*out++ = (char)( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+		*out++ = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+		*out++ = (char)( 0x80 | ( cp & 0x3F ) );
+	}
+	return out;
+}
+
+bool isValidUtf8Scalar( const uint8_t *s, size_t length )
+{
+	size_t i = 0;
+	while( i < length ) {
+		i += asciiRunLength( s + i, length - i );
+		if( i == length )
+			break;
+		size_t start = i;
+		if( decodeUtf8( s, length, &i ) == REPLACEMENT_CHAR && ( i - start ) == 1 )
+			return false;
+	}
+	return true;
+}
+
+#if defined( CINDER_UNICODE_SSSE3 )
+// Lookup-table validation after Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte".
+// Each byte is classified against its predecessor through three nibble lookups; any surviving bit is an error.
+const uint8_t TOO_SHORT		= 1 << 0;
+const uint8_t TOO_LONG		= 1 << 1;
+const uint8_t OVERLONG_3	= 1 << 2;
+const uint8_t TOO_LARGE		= 1 << 3;
+const uint8_t SURROGATE		= 1 << 4;
+const uint8_t OVERLONG_2	= 1 << 5;
+const uint8_t TOO_LARGE_1000	= 1 << 6;
+const uint8_t OVERLONG_4	= 1 << 6;
+const uint8_t TWO_CONTS		= 1 << 7;
+const uint8_t CARRY			= TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+inline __m128i checkUtf8Block( __m128i input, __m128i prevInput )
+{
+	const __m128i lowNibble = _mm_set1_epi8( 0x0F );
+	__m128i prev1 = _mm_alignr_epi8( input, prevInput, 15 );
+	__m128i prev2 = _mm_alignr_epi8( input, prevInput, 14 );
+	__m128i prev3 = _mm_alignr_epi8( input, prevInput, 13 );
+
+	const __m128i byte1HighTable = _mm_setr_epi8(
+		TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+		TOO_SHORT | OVERLONG_2,
+		TOO_SHORT,
+		TOO_SHORT | OVERLONG_3 | SURROGATE,
+		(char)( TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4 ) );
+	const __m128i byte1LowTable = _mm_setr_epi8(
+		(char)( CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4 ),
+		(char)( CARRY | OVERLONG_2 ),
+		(char)CARRY, (char)CARRY,
+		(char)( CARRY | TOO_LARGE ),
+		(char)( CARRY | TOO_LARGE | TOO_LARGE_1000 ), (char)( CARRY | TOO_LARGE | TOO_LARGE_1000 ), (char)( CARRY | TOO_LARGE | TOO_LARGE_1000 ),
+		(char)( CARRY | TOO_LARGE | TOO_LARGE_1000 ), (char)( CARRY | TOO_LARGE | TOO_LARGE_1000 ), (char)( CARRY | TOO_LARGE | TOO_LARGE_1000 ), (char)( CARRY | TOO_LARGE | TOO_LARGE_1000 ),
+		(char)( CARRY | TOO_LARGE | TOO_LARGE_1000 ),
+		(char)( CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE ),
+		(char)( CARRY | TOO_LARGE | TOO_LARGE_1000 ), (char)( CARRY | TOO_LARGE | TOO_LARGE_1000 ) );
+	const __m128i byte2HighTable = _mm_setr_epi8(
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		(char)( TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4 ),
+		(char)( TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE ),
+		(char)( TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE ),
+		(char)( TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE ),
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT );
+
+	__m128i byte1High = _mm_shuffle_epi8( byte1HighTable, _mm_and_si128( _mm_srli_epi16( prev1, 4 ), lowNibble ) );
+	__m128i byte1Low = _mm_shuffle_epi8( byte1LowTable, _mm_and_si128( prev1, lowNibble ) );
+	__m128i byte2High = _mm_shuffle_epi8( byte2HighTable, _mm_and_si128( _mm_srli_epi16( input, 4 ), lowNibble ) );
+	__m128i specialCases = _mm_and_si128( _mm_and_si128( byte1High, byte1Low ), byte2High );
+
+	// third and fourth bytes of multi-byte sequences must be continuations; only they are left with the high bit set
+	__m128i isThirdByte = _mm_subs_epu8( prev2, _mm_set1_epi8( (char)( 0xE0 - 0x80 ) ) );
+	__m128i isFourthByte = _mm_subs_epu8( prev3, _mm_set1_epi8( (char)( 0xF0 - 0x80 ) ) );
+	__m128i must23 = _mm_and_si128( _mm_or_si128( isThirdByte, isFourthByte ), _mm_set1_epi8( (char)0x80 ) );
+	return _mm_xor_si128( must23, specialCases );
+}
+
+// Flags a multi-byte sequence left unfinished at the end of \a input
+inline __m128i isIncompleteUtf8( __m128i input )
+{
+	const __m128i maxValue = _mm_setr_epi8( -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)( 0xF0 - 1 ), (char)( 0xE0 - 1 ), (char)( 0xC0 - 1 ) );
+	return _mm_subs_epu8( input, maxValue );
+}
+
+bool isValidUtf8Simd( const uint8_t *s, size_t length )
+{
+	__m128i error = _mm_setzero_si128();
+	__m128i prevInput = _mm_setzero_si128();
+	__m128i prevIncomplete = _mm_setzero_si128();
+
+	size_t i = 0;
+	for( ; i + 16 <= length; i += 16 ) {
+		__m128i input = _mm_loadu_si128( reinterpret_cast<const __m128i*>( s + i ) );
+		if( _mm_movemask_epi8( input ) == 0 ) { // ASCII; only a sequence left open by the previous block can fail
+			error = _mm_or_si128( error, prevIncomplete );
+			prevIncomplete = _mm_setzero_si128();
+		}
+		else {
+			error = _mm_or_si128( error, checkUtf8Block( input, prevInput ) );
+			prevIncomplete = isIncompleteUtf8( input );
+		}
+		prevInput = input;
+	}
+
+	// the tail is padded with zeros, which also terminates any sequence still open
+	uint8_t tail[16] = { 0 };
+	memcpy( tail, s + i, length - i );
+	error = _mm_or_si128( error, checkUtf8Block( _mm_loadu_si128( reinterpret_cast<const __m128i*>( tail ) ), prevInput ) );
+
+	return _mm_movemask_epi8( _mm_cmpeq_epi8( error, _mm_setzero_si128() ) ) == 0xFFFF;
+}
+#endif
+
+} // anonymous namespace
+
 size_t stringLengthUtf8( const char *str, size_t lengthInBytes )
 {
-	size_t result = 0;
-	size_t nextByte = 0;
 	if( lengthInBytes == 0 )
 		lengthInBytes = strlen( str );
-	while( nextCharUtf8( (const char*)str, &nextByte, lengthInBytes ) != 0xFFFF )
+
+	const uint8_t *s = reinterpret_cast<const uint8_t*>( str );
+	size_t result = 0;
+	size_t nextByte = 0;
+	while( nextByte < lengthInBytes ) {
+		// every ASCII byte is one character
+		size_t run = asciiRunLength( s + nextByte, lengthInBytes - nextByte );
+		result += run;
+		nextByte += run;
+		if( nextByte == lengthInBytes )
+			break;
+		if( lb_get_next_char_utf8( s, lengthInBytes, &nextByte ) == 0xFFFF )
+			break;
 		++result;
-	return result;	
+	}
+	return result;
 }
 
 uint32_t nextCharUtf8( const char *str, size_t *inOutByte, size_t lengthInBytes )
 {
+	if( lengthInBytes && *inOutByte >= lengthInBytes )
+		return 0xFFFF;
+
+	uint8_t c = static_cast<uint8_t>( str[*inOutByte] );
+	if( c < 0x80 && ( lengthInBytes || c != 0 ) ) {
+		++*inOutByte;
+		return c;
+	}
+
 	if( lengthInBytes == 0 )
 		lengthInBytes = strlen( str );
 	return lb_get_next_char_utf8( (const utf8_t*)str, lengthInBytes, inOutByte );
@@ -32,15 +277,199 @@ size_t advanceCharUtf8( const char *str, size_t numChars, size_t lengthInBytes )
 {
 	if( lengthInBytes == 0 )
 		lengthInBytes = strlen( str );
+	const uint8_t *s = reinterpret_cast<const uint8_t*>( str );
 	size_t nextByte = 0;
-	for( size_t curChar = 0; curChar < numChars; ++curChar ) {
-		if( lb_get_next_char_utf8( (const utf8_t*)str, lengthInBytes, &nextByte ) == 0xFFFF )
+	size_t curChar = 0;
+	while( curChar < numChars ) {
+		size_t run = std::min( asciiRunLength( s + nextByte, lengthInBytes - nextByte ), numChars - curChar );
+		curChar += run;
+		nextByte += run;
+		if( curChar == numChars )
 			break;
+		if( lb_get_next_char_utf8( s, lengthInBytes, &nextByte ) == 0xFFFF )
+			break;
+		++curChar;
 	}
 	
 	return nextByte;
 }
 
+bool isValidUtf8( const char *str, size_t lengthInBytes )
+{
+	if( lengthInBytes == 0 )
+		lengthInBytes = strlen( str );
+#if defined( CINDER_UNICODE_SSSE3 )
+	return isValidUtf8Simd( reinterpret_cast<const uint8_t*>( str ), lengthInBytes );
+#else
+	return isValidUtf8Scalar( reinterpret_cast<const uint8_t*>( str ), lengthInBytes );
+#endif
+}
+
+size_t convertUtf8ToUtf16( const char *src, size_t lengthInBytes, uint16_t *dest )
+{
+	const uint8_t *s = reinterpret_cast<const uint8_t*>( src );
+	uint16_t *out = dest;
+	size_t i = 0;
+	while( i < lengthInBytes ) {
+#if defined( CINDER_UNICODE_SSE2 )
+		while( i + 16 <= lengthInBytes ) {
+			__m128i input = _mm_loadu_si128( reinterpret_cast<const __m128i*>( s + i ) );
+			if( _mm_movemask_epi8( input ) )
+				break;
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( out ), _mm_unpacklo_epi8( input, _mm_setzero_si128() ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( out + 8 ), _mm_unpackhi_epi8( input, _mm_setzero_si128() ) );
+			i += 16;
+			out += 16;
+		}
+#elif defined( CINDER_UNICODE_NEON )
+		while( i + 16 <= lengthInBytes ) {
+			uint8x16_t input = vld1q_u8( s + i );
+			uint64x2_t high = vreinterpretq_u64_u8( vandq_u8( input, vdupq_n_u8( 0x80 ) ) );
+			if( ( vgetq_lane_u64( high, 0 ) | vgetq_lane_u64( high, 1 ) ) != 0 )
+				break;
+			vst1q_u16( out, vmovl_u8( vget_low_u8( input ) ) );
+			vst1q_u16( out + 8, vmovl_u8( vget_high_u8( input ) ) );
+			i += 16;
+			out += 16;
+		}
+#endif
+		while( i < lengthInBytes && s[i] < 0x80 )
+			*out++ = s[i++];
+		if( i == lengthInBytes )
+			break;
+		uint32_t cp = decodeUtf8( s, lengthInBytes, &i );
+		if( cp >= 0x10000 ) {
+			cp -= 0x10000;
+			*out++ = (uint16_t)( 0xD800 + ( cp >> 10 ) );
+			*out++ = (uint16_t)( 0xDC00 + ( cp & 0x3FF ) );
+		}
+		else
+			*out++ = (uint16_t)cp;
+	}
+	return out - dest;
+}
+
+size_t convertUtf8ToUtf32( const char *src, size_t lengthInBytes, uint32_t *dest )
+{
+	const uint8_t *s = reinterpret_cast<const uint8_t*>( src );
+	uint32_t *out = dest;
+	size_t i = 0;
+	while( i < lengthInBytes ) {
+#if defined( CINDER_UNICODE_SSE2 )
+		while( i + 16 <= lengthInBytes ) {
+			__m128i input = _mm_loadu_si128( reinterpret_cast<const __m128i*>( s + i ) );
+			if( _mm_movemask_epi8( input ) )
+				break;
+			__m128i lo = _mm_unpacklo_epi8( input, _mm_setzero_si128() );
+			__m128i hi = _mm_unpackhi_epi8( input, _mm_setzero_si128() );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( out ), _mm_unpacklo_epi16( lo, _mm_setzero_si128() ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( out + 4 ), _mm_unpackhi_epi16( lo, _mm_setzero_si128() ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( out + 8 ), _mm_unpacklo_epi16( hi, _mm_setzero_si128() ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( out + 12 ), _mm_unpackhi_epi16( hi, _mm_setzero_si128() ) );
+			i += 16;
+			out += 16;
+		}
+#elif defined( CINDER_UNICODE_NEON )
+		while( i + 16 <= lengthInBytes ) {
+			uint8x16_t input = vld1q_u8( s + i );
+			uint64x2_t high = vreinterpretq_u64_u8( vandq_u8( input, vdupq_n_u8( 0x80 ) ) );
+			if( ( vgetq_lane_u64( high, 0 ) | vgetq_lane_u64( high, 1 ) ) != 0 )
+				break;
+			uint16x8_t lo = vmovl_u8( vget_low_u8( input ) );
+			uint16x8_t hi = vmovl_u8( vget_high_u8( input ) );
+			vst1q_u32( out, vmovl_u16( vget_low_u16( lo ) ) );
+			vst1q_u32( out + 4, vmovl_u16( vget_high_u16( lo ) ) );
+			vst1q_u32( out + 8, vmovl_u16( vget_low_u16( hi ) ) );
+			vst1q_u32( out + 12, vmovl_u16( vget_high_u16( hi ) ) );
+			i += 16;
+			out += 16;
+		}
+#endif
+		while( i < lengthInBytes && s[i] < 0x80 )
+			*out++ = s[i++];
+		if( i == lengthInBytes )
+			break;
+		*out++ = decodeUtf8( s, lengthInBytes, &i );
+	}
+	return out - dest;
+}
+
+size_t convertUtf16ToUtf8( const uint16_t *src, size_t length, char *dest )
+{
+	char *out = dest;
+	size_t i = 0;
+	while( i < length ) {
+#if defined( CINDER_UNICODE_SSE2 )
+		while( i + 8 <= length ) {
+			__m128i input = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) );
+			// any unit >= 0x80 has a bit set outside the low seven
+			if( _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( input, _mm_set1_epi16( (short)0xFF80 ) ), _mm_setzero_si128() ) ) != 0xFFFF )
+				break;
+			_mm_storel_epi64( reinterpret_cast<__m128i*>( out ), _mm_packus_epi16( input, input ) );
+			i += 8;
+			out += 8;
+		}
+#elif defined( CINDER_UNICODE_NEON )
+		while( i + 8 <= length ) {
+			uint16x8_t input = vld1q_u16( src + i );
+			uint64x2_t high = vreinterpretq_u64_u16( vandq_u16( input, vdupq_n_u16( 0xFF80 ) ) );
+			if( ( vgetq_lane_u64( high, 0 ) | vgetq_lane_u64( high, 1 ) ) != 0 )
+				break;
+			vst1_u8( reinterpret_cast<uint8_t*>( out ), vmovn_u16( input ) );
+			i += 8;
+			out += 8;
+		}
+#endif
+		while( i < length && src[i] < 0x80 )
+			*out++ = (char)src[i++];
+		if( i == length )
+			break;
+
+		uint32_t cp = src[i++];
+		if( cp >= 0xD800 && cp <= 0xDBFF ) {
+			if( i < length && src[i] >= 0xDC00 && src[i] <= 0xDFFF )
+				cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( src[i++] - 0xDC00 );
+			else
+				cp = REPLACEMENT_CHAR;
+		}
+		else if( cp >= 0xDC00 && cp <= 0xDFFF )
+			cp = REPLACEMENT_CHAR;
+		out = encodeUtf8( cp, out );
+	}
+	return out - dest;
+}
+
+size_t convertUtf32ToUtf8( const uint32_t *src, size_t length, char *dest )
+{
+	char *out = dest;
+	size_t i = 0;
+	while( i < length ) {
+#if defined( CINDER_UNICODE_SSE2 )
+		while( i + 8 <= length ) {
+			__m128i lo = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) );
+			__m128i hi = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i + 4 ) );
+			__m128i highBits = _mm_and_si128( _mm_or_si128( lo, hi ), _mm_set1_epi32( (int)0xFFFFFF80 ) );
+			if( _mm_movemask_epi8( _mm_cmpeq_epi32( highBits, _mm_setzero_si128() ) ) != 0xFFFF )
+				break;
+			__m128i packed = _mm_packs_epi32( lo, hi );
+			_mm_storel_epi64( reinterpret_cast<__m128i*>( out ), _mm_packus_epi16( packed, packed ) );
+			i += 8;
+			out += 8;
+		}
+#endif
+		while( i < length && src[i] < 0x80 )
+			*out++ = (char)src[i++];
+		if( i == length )
+			break;
+
+		uint32_t cp = src[i++];
+		if( cp > 0x10FFFF || ( cp >= 0xD800 && cp <= 0xDFFF ) )
+			cp = REPLACEMENT_CHAR;
+		out = encodeUtf8( cp, out );
+	}
+	return out - dest;
+}
+
 namespace {
 bool shouldBreak( char code )
 {
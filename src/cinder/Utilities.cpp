@@ -26,6 +26,7 @@
 
 #include "cinder/Cinder.h"
 #include "cinder/Utilities.h"
+#include "cinder/Unicode.h"
 
 
 #if defined( CINDER_COCOA_TOUCH )
@@ -51,6 +52,11 @@
 #endif
 
 #include <vector>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <typeinfo>
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -282,21 +288,17 @@ string loadString( DataSourceRef dataSource )
 wstring toUtf16( const string &utf8 )
 {
 #if defined( CINDER_MSW )
-	int wideSize = ::MultiByteToWideChar( CP_UTF8, 0, utf8.c_str(), -1, NULL, 0 );
-	if( wideSize == ERROR_NO_UNICODE_TRANSLATION ) {
+	// like MultiByteToWideChar() with a length of -1, stop at the first NUL
+	size_t utf8Length = strlen( utf8.c_str() );
+	if( utf8Length == 0 )
+		return wstring();
+	if( ! isValidUtf8( utf8.c_str(), utf8Length ) )
 		throw std::exception( "Invalid UTF-8 sequence." );
-	}
-	else if( wideSize == 0 ) {
-		throw std::exception( "Error in UTF-8 to UTF-16 conversion." );
-	}
 
-	vector<wchar_t> resultString( wideSize );
-	int convResult = ::MultiByteToWideChar( CP_UTF8, 0, utf8.c_str(), -1, &resultString[0], wideSize );
-	if( convResult != wideSize ) {
-		throw std::exception( "Error in UTF-8 to UTF-16 conversion." );
-	}
-
-	return wstring( &resultString[0] );
+	wstring result( utf8Length, 0 );
+	size_t length = convertUtf8ToUtf16( utf8.c_str(), utf8Length, reinterpret_cast<uint16_t*>( &result[0] ) );
+	result.resize( length );
+	return result;
 #elif defined( CINDER_COCOA )
 	NSString *utf8NS = [NSString stringWithCString:utf8.c_str() encoding:NSUTF8StringEncoding];
 	return wstring( reinterpret_cast<const wchar_t*>( [utf8NS cStringUsingEncoding:NSUTF16LittleEndianStringEncoding] ) );
@@ -306,26 +308,303 @@ wstring toUtf16( const string &utf8 )
 string toUtf8( const wstring &utf16 )
 {
 #if defined( CINDER_MSW )
-	int utf8Size = ::WideCharToMultiByte( CP_UTF8, 0, utf16.c_str(), -1, NULL, 0, NULL, NULL );
-	if( utf8Size == 0 ) {
-		throw std::exception( "Error in UTF-16 to UTF-8 conversion." );
+	// like WideCharToMultiByte() with a length of -1, stop at the first NUL; unpaired surrogates become U+FFFD as they do there
+	size_t utf16Length = wcslen( utf16.c_str() );
+	if( utf16Length == 0 )
+		return string();
+
+	string result( utf16Length * 3, 0 );
+	size_t length = convertUtf16ToUtf8( reinterpret_cast<const uint16_t*>( utf16.c_str() ), utf16Length, &result[0] );
+	result.resize( length );
+	return result;
+#elif defined( CINDER_COCOA )
+	NSString *utf16NS = [NSString stringWithCString:reinterpret_cast<const char*>( utf16.c_str() ) encoding:NSUTF16LittleEndianStringEncoding];
+	return string( [utf16NS cStringUsingEncoding:NSUTF8StringEncoding] );	
+#endif
+}
+#endif
+
+namespace {
+
+// Accumulates digits into an unsigned 64-bit value, rejecting anything above \a limit
+template<typename T>
+const char* parseInteger( const char *begin, const char *end, T *result )
+{
+	const char *p = begin;
+	bool negative = false;
+	if( p != end && ( *p == '-' || *p == '+' ) ) {
+		negative = ( *p == '-' );
+		++p;
 	}
+	if( negative && ! std::numeric_limits<T>::is_signed )
+		return begin;
+
+	const uint64_t limit = negative ? uint64_t( std::numeric_limits<T>::max() ) + 1 : uint64_t( std::numeric_limits<T>::max() );
+	const char *digitsBegin = p;
+	uint64_t value = 0;
+	for( ; p != end && (unsigned)( *p - '0' ) < 10; ++p ) {
+		unsigned digit = *p - '0';
+		if( value > ( limit - digit ) / 10 )
+			return begin;
+		value = value * 10 + digit;
+	}
+	if( p == digitsBegin )
+		return begin;
+
+	*result = negative ? T( 0 - value ) : T( value );
+	return p;
+}
+
+bool matchesNoCase( const char *p, const char *end, const char *word )
+{
+	for( ; *word; ++p, ++word )
+		if( p == end || ( *p | 0x20 ) != *word )
+			return false;
+	return true;
+}
 
-	vector<char> resultString( utf8Size );
+// Parses a floating-point number. Values with at most 19 significant digits and a small exponent are computed exactly
+// in \a Real (Clinger's fast path); anything else is handed to strtod(), which rounds correctly.
+template<typename Real>
+const char* parseReal( const char *begin, const char *end, Real *result )
+{
+	static const double sPowersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	// largest exactly representable mantissa and power of 10 for Real
+	const uint64_t maxExactMantissa = uint64_t( 1 ) << std::numeric_limits<Real>::digits;
+	const int maxExactPower = ( std::numeric_limits<Real>::digits > 24 ) ? 22 : 10;
+
+	const char *p = begin;
+	bool negative = false;
+	if( p != end && ( *p == '-' || *p == '+' ) ) {
+		negative = ( *p == '-' );
+		++p;
+	}
 
-	int convResult = ::WideCharToMultiByte( CP_UTF8, 0, utf16.c_str(), -1, &resultString[0], utf8Size, NULL, NULL );
+	if( p != end && ( ( *p | 0x20 ) == 'i' || ( *p | 0x20 ) == 'n' ) ) {
+		if( matchesNoCase( p, end, "infinity" ) )
+			p += 8;
+		else if( matchesNoCase( p, end, "inf" ) )
+			p += 3;
+		else if( matchesNoCase( p, end, "nan" ) ) {
+			*result = std::numeric_limits<Real>::quiet_NaN();
+			return p + 3;
+		}
+		else
+			return begin;
+		*result = negative ? -std::numeric_limits<Real>::infinity() : std::numeric_limits<Real>::infinity();
+		return p;
+	}
 
-	if( convResult != utf8Size ) {
-		throw std::exception( "Error in UTF-16 to UTF-8 conversion." );
+	uint64_t mantissa = 0;
+	int significantDigits = 0, exponent = 0;
+	bool anyDigits = false, truncated = false;
+	for( ; p != end && (unsigned)( *p - '0' ) < 10; ++p ) {
+		anyDigits = true;
+		if( significantDigits < 19 ) {
+			mantissa = mantissa * 10 + ( *p - '0' );
+			if( mantissa )
+				++significantDigits;
+		}
+		else {
+			++exponent;
+			truncated |= ( *p != '0' );
+		}
+	}
+	if( p != end && *p == '.' ) {
+		++p;
+		for( ; p != end && (unsigned)( *p - '0' ) < 10; ++p ) {
+			anyDigits = true;
+			if( significantDigits < 19 ) {
+				mantissa = mantissa * 10 + ( *p - '0' );
+				if( mantissa )
+					++significantDigits;
+				--exponent;
+			}
+			else
+				truncated |= ( *p != '0' );
+		}
+	}
+	if( ! anyDigits )
+		return begin;
+
+	// the exponent is only consumed if it is well-formed
+	if( p != end && ( *p | 0x20 ) == 'e' ) {
+		const char *expBegin = p++;
+		bool expNegative = false;
+		if( p != end && ( *p == '-' || *p == '+' ) ) {
+			expNegative = ( *p == '-' );
+			++p;
+		}
+		if( p != end && (unsigned)( *p - '0' ) < 10 ) {
+			int expValue = 0;
+			for( ; p != end && (unsigned)( *p - '0' ) < 10; ++p )
+				if( expValue < 100000 )
+					expValue = expValue * 10 + ( *p - '0' );
+			exponent += expNegative ? -expValue : expValue;
+		}
+		else
+			p = expBegin;
 	}
 
-	return string( &resultString[0] );
-#elif defined( CINDER_COCOA )
-	NSString *utf16NS = [NSString stringWithCString:reinterpret_cast<const char*>( utf16.c_str() ) encoding:NSUTF16LittleEndianStringEncoding];
-	return string( [utf16NS cStringUsingEncoding:NSUTF8StringEncoding] );	
-#endif
+	if( ! truncated && mantissa <= maxExactMantissa && exponent >= -maxExactPower && exponent <= maxExactPower ) {
+		Real value = (Real)mantissa;
+		if( exponent < 0 )
+			value /= (Real)sPowersOf10[-exponent];
+		else
+			value *= (Real)sPowersOf10[exponent];
+		*result = negative ? -value : value;
+		return p;
+	}
+	if( mantissa == 0 && ! truncated ) {
+		*result = negative ? -Real( 0 ) : Real( 0 );
+		return p;
+	}
+
+	char stackBuffer[64];
+	std::vector<char> heapBuffer;
+	char *buffer = stackBuffer;
+	size_t length = p - begin;
+	if( length >= sizeof(stackBuffer) ) {
+		heapBuffer.resize( length + 1 );
+		buffer = &heapBuffer[0];
+	}
+	memcpy( buffer, begin, length );
+	buffer[length] = 0;
+	*result = (Real)strtod( buffer, NULL );
+	return p;
 }
-#endif
+
+template<typename Real>
+size_t formatReal( Real value, char *buffer, int minPrecision, int maxPrecision )
+{
+	if( value != value ) {
+		memcpy( buffer, "nan", 4 );
+		return 3;
+	}
+	else if( value == std::numeric_limits<Real>::infinity() ) {
+		memcpy( buffer, "inf", 4 );
+		return 3;
+	}
+	else if( value == -std::numeric_limits<Real>::infinity() ) {
+		memcpy( buffer, "-inf", 5 );
+		return 4;
+	}
+
+	// the first precision whose output parses back to the same value is the shortest representation
+	int length = 0;
+	for( int precision = minPrecision; precision <= maxPrecision; ++precision ) {
+		length = sprintf( buffer, "%.*g", precision, (double)value );
+		Real parsed;
+		if( parseReal( buffer, buffer + length, &parsed ) == buffer + length && parsed == value )
+			break;
+	}
+	return length;
+}
+
+template<typename T, typename Wide>
+bool tryParseInteger( const std::string &s, T *result )
+{
+	const char *end = s.c_str() + s.size();
+	Wide wide;
+	if( s.empty() || parseNumber( s.c_str(), end, &wide ) != end )
+		return false;
+	if( wide < Wide( std::numeric_limits<T>::min() ) || wide > Wide( std::numeric_limits<T>::max() ) )
+		return false;
+	*result = T( wide );
+	return true;
+}
+
+template<typename Real>
+bool tryParseReal( const std::string &s, Real *result )
+{
+	const char *end = s.c_str() + s.size();
+	return ( ! s.empty() ) && ( parseReal( s.c_str(), end, result ) == end );
+}
+
+template<typename T>
+T fromStringOrThrow( bool success, const T &value )
+{
+	if( ! success )
+		throw boost::bad_lexical_cast( typeid(std::string), typeid(T) );
+	return value;
+}
+
+} // anonymous namespace
+
+const char* parseNumber( const char *begin, const char *end, int32_t *result )		{ return parseInteger( begin, end, result ); }
+const char* parseNumber( const char *begin, const char *end, uint32_t *result )		{ return parseInteger( begin, end, result ); }
+const char* parseNumber( const char *begin, const char *end, int64_t *result )		{ return parseInteger( begin, end, result ); }
+const char* parseNumber( const char *begin, const char *end, uint64_t *result )		{ return parseInteger( begin, end, result ); }
+const char* parseNumber( const char *begin, const char *end, float *result )		{ return parseReal( begin, end, result ); }
+const char* parseNumber( const char *begin, const char *end, double *result )		{ return parseReal( begin, end, result ); }
+
+size_t formatNumber( uint64_t value, char *buffer )
+{
+	char digits[20];
+	size_t numDigits = 0;
+	do {
+		digits[numDigits++] = char( '0' + value % 10 );
+		value /= 10;
+	} while( value );
+
+	for( size_t i = 0; i < numDigits; ++i )
+		buffer[i] = digits[numDigits - 1 - i];
+	buffer[numDigits] = 0;
+	return numDigits;
+}
+
+size_t formatNumber( int64_t value, char *buffer )
+{
+	if( value < 0 ) {
+		*buffer = '-';
+		return 1 + formatNumber( uint64_t( 0 ) - uint64_t( value ), buffer + 1 );
+	}
+	return formatNumber( uint64_t( value ), buffer );
+}
+
+size_t formatNumber( float value, char *buffer )
+{
+	return formatReal( value, buffer, 6, std::numeric_limits<float>::digits10 + 3 );
+}
+
+size_t formatNumber( double value, char *buffer )
+{
+	return formatReal( value, buffer, 15, std::numeric_limits<double>::digits10 + 2 );
+}
+
+template<> std::string toString( const short &t )				{ char buffer[32]; return std::string( buffer, formatNumber( int64_t( t ), buffer ) ); }
+template<> std::string toString( const unsigned short &t )		{ char buffer[32]; return std::string( buffer, formatNumber( uint64_t( t ), buffer ) ); }
+template<> std::string toString( const int &t )					{ char buffer[32]; return std::string( buffer, formatNumber( int64_t( t ), buffer ) ); }
+template<> std::string toString( const unsigned int &t )		{ char buffer[32]; return std::string( buffer, formatNumber( uint64_t( t ), buffer ) ); }
+template<> std::string toString( const long &t )				{ char buffer[32]; return std::string( buffer, formatNumber( int64_t( t ), buffer ) ); }
+template<> std::string toString( const unsigned long &t )		{ char buffer[32]; return std::string( buffer, formatNumber( uint64_t( t ), buffer ) ); }
+template<> std::string toString( const long long &t )			{ char buffer[32]; return std::string( buffer, formatNumber( int64_t( t ), buffer ) ); }
+template<> std::string toString( const unsigned long long &t )	{ char buffer[32]; return std::string( buffer, formatNumber( uint64_t( t ), buffer ) ); }
+template<> std::string toString( const float &t )				{ char buffer[32]; return std::string( buffer, formatNumber( t, buffer ) ); }
+template<> std::string toString( const double &t )				{ char buffer[32]; return std::string( buffer, formatNumber( t, buffer ) ); }
+
+template<> bool tryFromString( const std::string &s, short *result )				{ return tryParseInteger<short, int64_t>( s, result ); }
+template<> bool tryFromString( const std::string &s, unsigned short *result )		{ return tryParseInteger<unsigned short, uint64_t>( s, result ); }
+template<> bool tryFromString( const std::string &s, int *result )					{ return tryParseInteger<int, int64_t>( s, result ); }
+template<> bool tryFromString( const std::string &s, unsigned int *result )			{ return tryParseInteger<unsigned int, uint64_t>( s, result ); }
+template<> bool tryFromString( const std::string &s, long *result )					{ return tryParseInteger<long, int64_t>( s, result ); }
+template<> bool tryFromString( const std::string &s, unsigned long *result )		{ return tryParseInteger<unsigned long, uint64_t>( s, result ); }
+template<> bool tryFromString( const std::string &s, long long *result )			{ return tryParseInteger<long long, int64_t>( s, result ); }
+template<> bool tryFromString( const std::string &s, unsigned long long *result )	{ return tryParseInteger<unsigned long long, uint64_t>( s, result ); }
+template<> bool tryFromString( const std::string &s, float *result )				{ return tryParseReal( s, result ); }
+template<> bool tryFromString( const std::string &s, double *result )				{ return tryParseReal( s, result ); }
+
+template<> short fromString( const std::string &s )					{ short v = 0; bool ok = tryFromString( s, &v ); return fromStringOrThrow( ok, v ); }
+template<> unsigned short fromString( const std::string &s )		{ unsigned short v = 0; bool ok = tryFromString( s, &v ); return fromStringOrThrow( ok, v ); }
+template<> int fromString( const std::string &s )					{ int v = 0; bool ok = tryFromString( s, &v ); return fromStringOrThrow( ok, v ); }
+template<> unsigned int fromString( const std::string &s )			{ unsigned int v = 0; bool ok = tryFromString( s, &v ); return fromStringOrThrow( ok, v ); }
+template<> long fromString( const std::string &s )					{ long v = 0; bool ok = tryFromString( s, &v ); return fromStringOrThrow( ok, v ); }
+template<> unsigned long fromString( const std::string &s )			{ unsigned long v = 0; bool ok = tryFromString( s, &v ); return fromStringOrThrow( ok, v ); }
+template<> long long fromString( const std::string &s )				{ long long v = 0; bool ok = tryFromString( s, &v ); return fromStringOrThrow( ok, v ); }
+template<> unsigned long long fromString( const std::string &s )	{ unsigned long long v = 0; bool ok = tryFromString( s, &v ); return fromStringOrThrow( ok, v ); }
+template<> float fromString( const std::string &s )					{ float v = 0; bool ok = tryFromString( s, &v ); return fromStringOrThrow( ok, v ); }
+template<> double fromString( const std::string &s )				{ double v = 0; bool ok = tryFromString( s, &v ); return fromStringOrThrow( ok, v ); }
 
 void sleep( float milliseconds )
 {
@@ -26,6 +26,14 @@
 #include "cinder/Utilities.h"
 #include <boost/algorithm/string.hpp>
 
+#if defined( _MSC_VER ) && ( _MSC_VER >= 1600 ) || defined( _LIBCPP_VERSION )
+	#include <unordered_map>
+	using std::unordered_map;
+#else
+	#include <boost/unordered_map.hpp>
+	using boost::unordered_map;
+#endif
+
 #include "rapidxml/rapidxml.hpp"
 #include "rapidxml/rapidxml_print.hpp"
 
@@ -45,8 +53,49 @@ bool tagsMatch( const std::string &tag1, const std::string &tag2, bool caseSensi
 	else
 		return false;
 }
+
+inline char toLowerAscii( char c )
+{
+	return ( c >= 'A' && c <= 'Z' ) ? ( c - 'A' + 'a' ) : c;
+}
+
+// nodes with fewer children than this are scanned rather than indexed
+const size_t CHILD_INDEX_THRESHOLD = 16;
 } // anonymous namespace
 
+struct XmlTree::ChildIndex {
+	// children in document order, keyed by case-folded tag
+	unordered_map<string, vector<XmlTree*> >	mByTag;
+};
+
+XmlTree::Query::Query( const std::string &path, bool caseSensitive, char separator )
+	: mPath( path ), mCaseSensitive( caseSensitive )
+{
+	shared_ptr<vector<Component> > components( new vector<Component>() );
+	vector<string> tags = split( path, separator );
+	for( vector<string>::const_iterator tagIt = tags.begin(); tagIt != tags.end(); ++tagIt ) {
+		if( tagIt->empty() )
+			continue;
+		components->push_back( Component() );
+		components->back().mTag = *tagIt;
+		components->back().mLowerTag.resize( tagIt->size() );
+		std::transform( tagIt->begin(), tagIt->end(), components->back().mLowerTag.begin(), toLowerAscii );
+	}
+	mComponents = components;
+}
+
+bool XmlTree::Query::Component::matches( const std::string &tag, bool caseSensitive ) const
+{
+	if( caseSensitive )
+		return tag == mTag;
+	if( tag.size() != mLowerTag.size() )
+		return false;
+	for( size_t i = 0; i < tag.size(); ++i )
+		if( toLowerAscii( tag[i] ) != mLowerTag[i] )
+			return false;
+	return true;
+}
+
 XmlTree::ConstIter::ConstIter( const Container *sequence )
 {
 	mSequenceStack.push_back( sequence );
@@ -60,26 +109,33 @@ XmlTree::ConstIter::ConstIter( const Container *sequence, Container::const_itera
 }
 
 XmlTree::ConstIter::ConstIter( const XmlTree &root, const string &filterPath, bool caseSensitive, char separator )
-	: mCaseSensitive( caseSensitive )
+	: mFilter( filterPath, caseSensitive, separator )
 {
-	mFilter = split( filterPath, separator );
+	init( root );
+}
 
-	// we ignore a leading separator so that "/one/two" is equivalent to "one/two"
-	if( ( ! filterPath.empty() ) && ( filterPath[0] == separator ) && ( ! mFilter.empty() ) )
-		mFilter.erase( mFilter.begin() );
+XmlTree::ConstIter::ConstIter( const XmlTree &root, const Query &filter )
+	: mFilter( filter )
+{
+	init( root );
+}
 
-	if( mFilter.empty() ) { // empty filter means nothing matches
+void XmlTree::ConstIter::init( const XmlTree &root )
+{
+	// empty components are ignored, so "/one/two" is equivalent to "one/two"
+	if( mFilter.size() == 0 ) { // empty filter means nothing matches
 		setToEnd( &root.getChildren() );
 		return;
 	}	
 
-	for( vector<string>::const_iterator filterComp = mFilter.begin(); filterComp != mFilter.end(); ++filterComp ) {
+	const vector<Query::Component> &filter = *mFilter.mComponents;
+	for( vector<Query::Component>::const_iterator filterComp = filter.begin(); filterComp != filter.end(); ++filterComp ) {
 		if( mIterStack.empty() ) // first item
 			mSequenceStack.push_back( &root.getChildren() );
 		else
-			mSequenceStack.push_back( &(*mIterStack.back())->getChildren() );
+			mSequenceStack.push_back( &static_cast<const XmlTree&>( **mIterStack.back() ).getChildren() );
 		
-		Container::const_iterator child = findNextChildNamed( *mSequenceStack.back(), mSequenceStack.back()->begin(), *filterComp, mCaseSensitive );
+		Container::const_iterator child = findNextChildNamed( *mSequenceStack.back(), mSequenceStack.back()->begin(), *filterComp, mFilter.isCaseSensitive() );
 		if( child != (mSequenceStack.back())->end() )
 			mIterStack.push_back( child );
 		else { // failed to find an item that matches this part of the filter; mark as finished and return
@@ -107,11 +163,11 @@ void XmlTree::ConstIter::increment()
 {
 	++mIterStack.back();
 	
-	if( ! mFilter.empty() ) {
+	if( mFilter.size() ) {
 	
 		bool found = false;
 		do {
-			Container::const_iterator next = findNextChildNamed( *mSequenceStack.back(), mIterStack.back(), mFilter[mSequenceStack.size()-1], mCaseSensitive );
+			Container::const_iterator next = findNextChildNamed( *mSequenceStack.back(), mIterStack.back(), (*mFilter.mComponents)[mSequenceStack.size()-1], mFilter.isCaseSensitive() );
 			if( next == mSequenceStack.back()->end() ) { // we've finished this part of the sequence stack
 				if( mSequenceStack.size() > 1 ) { // we might already be done, in which case incrementing would be bad
 					mIterStack.pop_back();
@@ -123,8 +179,9 @@ void XmlTree::ConstIter::increment()
 			}
 			else if( mSequenceStack.size() < mFilter.size() ) { // we're not on a leaf, so push this onto the stack
 				mIterStack[mIterStack.size()-1] = next;
-				mSequenceStack.push_back( &(*next)->getChildren() );
-				mIterStack.push_back( (*next)->getChildren().begin() );
+				const Container &children = static_cast<const XmlTree&>( **next ).getChildren();
+				mSequenceStack.push_back( &children );
+				mIterStack.push_back( children.begin() );
 			}
 			else {
 				mIterStack[mIterStack.size()-1] = next;
@@ -146,9 +203,17 @@ XmlTree::Container::const_iterator XmlTree::findNextChildNamed( const Container
 	return result;
 }
 
+XmlTree::Container::const_iterator XmlTree::findNextChildNamed( const Container &sequence, Container::const_iterator firstCandidate, const Query::Component &component, bool caseSensitive )
+{
+	Container::const_iterator result = firstCandidate;
+	while( result != sequence.end() && ! component.matches( (*result)->getTag(), caseSensitive ) )
+		++result;
+	return result;
+}
+
 XmlTree::XmlTree( const XmlTree &rhs )
 	: mNodeType( rhs.mNodeType ), mTag( rhs.mTag ), mValue( rhs.mValue ), mDocType( rhs.mDocType ),
-	 mParent( 0 ), mAttributes( rhs.mAttributes )
+	 mParent( 0 ), mAttributes( rhs.mAttributes ), mChildrenExposed( false )
 {
 	for( XmlTree::ConstIter childIt = rhs.begin(); childIt != rhs.end(); ++childIt ) {
 		mChildren.push_back( unique_ptr<XmlTree>( new XmlTree( *childIt ) ) );
@@ -162,10 +227,12 @@ XmlTree& XmlTree::operator=( const XmlTree &rhs )
 	mTag = rhs.mTag;
 	mValue = rhs.mValue;
 	mDocType = rhs.mDocType;
-	mParent = 0;
+	if( mParent ) // our tag may have changed; we keep our place among our parent's children
+		mParent->mChildIndex.reset();
 	mAttributes = rhs.mAttributes;
 
 	mChildren.clear();
+	mChildIndex.reset();
 
 	for( XmlTree::ConstIter childIt = rhs.begin(); childIt != rhs.end(); ++childIt ) {
 		mChildren.push_back( unique_ptr<XmlTree>( new XmlTree( *childIt ) ) );
@@ -176,6 +243,7 @@ XmlTree& XmlTree::operator=( const XmlTree &rhs )
 }
 
 XmlTree::XmlTree( const std::string &xmlString, ParseOptions parseOptions )
+	: mParent( 0 ), mChildrenExposed( false )
 {
 	std::string strCopy( xmlString );
 	rapidxml::xml_document<> doc;    // character type defaults to char
@@ -189,7 +257,8 @@ XmlTree::XmlTree( const std::string &xmlString, ParseOptions parseOptions )
 
 void parseItem( const rapidxml::xml_node<> &node, XmlTree *parent, XmlTree *result, const XmlTree::ParseOptions &options )
 {
-	*result = XmlTree( node.name(), node.value(), parent );
+	*result = XmlTree( node.name(), node.value() );
+	result->mParent = parent;
 	for( const rapidxml::xml_node<> *item = node.first_node(); item; item = item->next_sibling() ) {
 		XmlTree::NodeType type;
 		switch( item->type() ) {
@@ -224,9 +293,9 @@ void parseItem( const rapidxml::xml_node<> &node, XmlTree *parent, XmlTree *resu
 				continue;
 		}
 		
-		result->getChildren().push_back( unique_ptr<XmlTree>( new XmlTree ) );
-		parseItem( *item, result, result->getChildren().back().get(), options );
-		result->getChildren().back()->setNodeType( type );
+		result->mChildren.push_back( unique_ptr<XmlTree>( new XmlTree ) );
+		parseItem( *item, result, result->mChildren.back().get(), options );
+		result->mChildren.back()->setNodeType( type );
 	}
 
 	for( rapidxml::xml_attribute<> *attr = node.first_attribute(); attr; attr = attr->next_attribute() )
@@ -272,6 +341,24 @@ XmlTree& XmlTree::getChild( const string &relativePath, bool caseSensitive, char
 		throw ExcChildNotFound( *this, relativePath );
 }
 
+const XmlTree& XmlTree::getChild( const Query &query ) const
+{
+	XmlTree* child = getNodePtr( query );
+	if( child )
+		return *child;
+	else
+		throw ExcChildNotFound( *this, query.getPath() );
+}
+
+XmlTree& XmlTree::getChild( const Query &query )
+{
+	XmlTree* child = getNodePtr( query );
+	if( child )
+		return *child;
+	else
+		throw ExcChildNotFound( *this, query.getPath() );
+}
+
 const XmlTree::Attr& XmlTree::getAttribute( const string &attrName ) const
 {
 	for( list<Attr>::const_iterator attrIt = mAttributes.begin(); attrIt != mAttributes.end(); ++attrIt )
@@ -322,6 +409,7 @@ string	XmlTree::getPath( char separator ) const
 
 void XmlTree::push_back( const XmlTree &newChild )
 {
+	mChildIndex.reset();
 	mChildren.push_back( unique_ptr<XmlTree>( new XmlTree( newChild ) ) );
 	mChildren.back()->mParent = this;
 }
@@ -334,8 +422,8 @@ XmlTree* XmlTree::getNodePtr( const string &relativePath, bool caseSensitive, ch
 	for( vector<string>::const_iterator pathIt = pathComponents.begin(); pathIt != pathComponents.end(); ++pathIt ) {
 		if( pathIt->empty() )
 			continue;
-		Container::const_iterator node = XmlTree::findNextChildNamed( curNode->getChildren(), curNode->getChildren().begin(), *pathIt, caseSensitive )	;
-		if( node != curNode->getChildren().end() )
+		Container::const_iterator node = XmlTree::findNextChildNamed( curNode->mChildren, curNode->mChildren.begin(), *pathIt, caseSensitive )	;
+		if( node != curNode->mChildren.end() )
 			curNode = const_cast<XmlTree*>( node->get() );
 		else
 			return 0;
@@ -344,6 +432,42 @@ XmlTree* XmlTree::getNodePtr( const string &relativePath, bool caseSensitive, ch
 	return curNode;
 }
 
+XmlTree* XmlTree::getNodePtr( const Query &query ) const
+{
+	XmlTree *curNode = const_cast<XmlTree*>( this );
+	for( size_t c = 0; c < query.size() && curNode; ++c )
+		curNode = curNode->findChildNamed( (*query.mComponents)[c], query.isCaseSensitive() );
+	return curNode;
+}
+
+XmlTree* XmlTree::findChildNamed( const Query::Component &component, bool caseSensitive ) const
+{
+	if( mChildren.size() < CHILD_INDEX_THRESHOLD || mChildrenExposed ) {
+		Container::const_iterator child = findNextChildNamed( mChildren, mChildren.begin(), component, caseSensitive );
+		return ( child != mChildren.end() ) ? child->get() : 0;
+	}
+
+	if( ! mChildIndex ) {
+		shared_ptr<ChildIndex> index( new ChildIndex );
+		string lowerTag;
+		for( Container::const_iterator child = mChildren.begin(); child != mChildren.end(); ++child ) {
+			const string &tag = (*child)->getTag();
+			lowerTag.resize( tag.size() );
+			std::transform( tag.begin(), tag.end(), lowerTag.begin(), toLowerAscii );
+			index->mByTag[lowerTag].push_back( child->get() );
+		}
+		mChildIndex = index;
+	}
+
+	unordered_map<string, vector<XmlTree*> >::const_iterator bucket = mChildIndex->mByTag.find( component.mLowerTag );
+	if( bucket == mChildIndex->mByTag.end() )
+		return 0;
+	for( vector<XmlTree*>::const_iterator child = bucket->second.begin(); child != bucket->second.end(); ++child )
+		if( component.matches( (*child)->getTag(), caseSensitive ) )
+			return *child;
+	return 0;
+}
+
 void XmlTree::appendRapidXmlNode( rapidxml::xml_document<char> &doc, rapidxml::xml_node<char> *parent ) const
 {
 	rapidxml::node_type type;
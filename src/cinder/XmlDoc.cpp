@@ -0,0 +1,298 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/XmlDoc.h"
+#include "cinder/Utilities.h"
+
+#include "rapidxml/rapidxml.hpp"
+
+#include <cstdio>
+
+using namespace std;
+
+namespace cinder {
+
+namespace {
+
+// names and values are left unterminated so that a mapped file is only written to where entities are translated
+const int PARSE_FLAGS = rapidxml::parse_no_string_terminators | rapidxml::parse_doctype_node;
+
+inline char toLowerAscii( char c )
+{
+	return ( c >= 'A' && c <= 'Z' ) ? ( c - 'A' + 'a' ) : c;
+}
+
+template<typename T>
+T parseStringRef( const XmlDoc::StringRef &s )
+{
+	T result = 0;
+	const char *end = s.data() + s.size();
+	if( s.empty() || parseNumber( s.data(), end, &result ) != end )
+		throw boost::bad_lexical_cast();
+	return result;
+}
+
+} // anonymous namespace
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// XmlDoc::StringRef
+
+bool XmlDoc::StringRef::equalsIgnoreCase( const StringRef &rhs ) const
+{
+	if( mSize != rhs.mSize )
+		return false;
+	for( size_t i = 0; i < mSize; ++i )
+		if( toLowerAscii( mData[i] ) != toLowerAscii( rhs.mData[i] ) )
+			return false;
+	return true;
+}
+
+template<> float	XmlDoc::StringRef::as<float>() const { return parseStringRef<float>( *this ); }
+template<> double	XmlDoc::StringRef::as<double>() const { return parseStringRef<double>( *this ); }
+template<> int32_t	XmlDoc::StringRef::as<int32_t>() const { return parseStringRef<int32_t>( *this ); }
+template<> uint32_t	XmlDoc::StringRef::as<uint32_t>() const { return parseStringRef<uint32_t>( *this ); }
+template<> int64_t	XmlDoc::StringRef::as<int64_t>() const { return parseStringRef<int64_t>( *this ); }
+template<> uint64_t	XmlDoc::StringRef::as<uint64_t>() const { return parseStringRef<uint64_t>( *this ); }
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// XmlDoc::Attr
+
+XmlDoc::StringRef XmlDoc::Attr::getName() const
+{
+	return StringRef( mAttr->name(), mAttr->name_size() );
+}
+
+XmlDoc::StringRef XmlDoc::Attr::getValue() const
+{
+	return StringRef( mAttr->value(), mAttr->value_size() );
+}
+
+XmlDoc::Attr XmlDoc::Attr::next() const
+{
+	return Attr( mAttr->next_attribute() );
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// XmlDoc::Node
+
+XmlTree::NodeType XmlDoc::Node::getNodeType() const
+{
+	switch( mNode->type() ) {
+		case rapidxml::node_document: return XmlTree::NODE_DOCUMENT;
+		case rapidxml::node_element: return XmlTree::NODE_ELEMENT;
+		case rapidxml::node_data: return XmlTree::NODE_DATA;
+		case rapidxml::node_cdata: return XmlTree::NODE_CDATA;
+		case rapidxml::node_comment: return XmlTree::NODE_COMMENT;
+		default: return XmlTree::NODE_UNKNOWN;
+	}
+}
+
+XmlDoc::StringRef XmlDoc::Node::getTag() const
+{
+	if( mNode->type() != rapidxml::node_element )
+		return StringRef();
+	return StringRef( mNode->name(), mNode->name_size() );
+}
+
+XmlDoc::StringRef XmlDoc::Node::getValue() const
+{
+	return StringRef( mNode->value(), mNode->value_size() );
+}
+
+XmlDoc::Node XmlDoc::Node::getParent() const
+{
+	return Node( mNode->parent(), mDoc );
+}
+
+XmlDoc::Node XmlDoc::Node::skipIgnored( const rapidxml::xml_node<char> *node, const char *tag, size_t tagLength, bool caseSensitive ) const
+{
+	const bool ignoreData = mDoc->mParseOptions.getIgnoreDataChildren();
+	while( node ) {
+		rapidxml::node_type type = node->type();
+		if( type == rapidxml::node_element || type == rapidxml::node_cdata || type == rapidxml::node_comment || ( type == rapidxml::node_data && ! ignoreData ) )
+			break;
+		node = node->next_sibling( tagLength ? tag : 0, tagLength, caseSensitive );
+	}
+	return Node( node, mDoc );
+}
+
+XmlDoc::Node XmlDoc::Node::firstChild( const char *tag, size_t tagLength, bool caseSensitive ) const
+{
+	return skipIgnored( mNode->first_node( tagLength ? tag : 0, tagLength, caseSensitive ), tag, tagLength, caseSensitive );
+}
+
+XmlDoc::Node XmlDoc::Node::nextSibling( const char *tag, size_t tagLength, bool caseSensitive ) const
+{
+	return skipIgnored( mNode->next_sibling( tagLength ? tag : 0, tagLength, caseSensitive ), tag, tagLength, caseSensitive );
+}
+
+XmlDoc::Node XmlDoc::Node::findChild( const std::string &relativePath, bool caseSensitive, char separator ) const
+{
+	Node result = *this;
+	const char *p = relativePath.c_str(), *end = p + relativePath.size();
+	while( p < end && result ) {
+		const char *componentEnd = p;
+		while( componentEnd < end && *componentEnd != separator )
+			++componentEnd;
+		if( componentEnd > p )
+			result = result.firstChild( p, componentEnd - p, caseSensitive );
+		p = componentEnd + 1;
+	}
+	return result;
+}
+
+XmlDoc::Node XmlDoc::Node::getChild( const std::string &relativePath, bool caseSensitive, char separator ) const
+{
+	Node result = findChild( relativePath, caseSensitive, separator );
+	if( ! result )
+		throw ExcChildNotFound( relativePath );
+	return result;
+}
+
+XmlDoc::Attr XmlDoc::Node::firstAttribute() const
+{
+	return Attr( mNode->first_attribute() );
+}
+
+XmlDoc::Attr XmlDoc::Node::getAttribute( const std::string &attrName ) const
+{
+	if( attrName.empty() )
+		return Attr();
+	return Attr( mNode->first_attribute( attrName.c_str(), attrName.size() ) );
+}
+
+XmlTree XmlDoc::Node::toXmlTree() const
+{
+	// mirrors the conversion XmlTree performs when parsing, including collapsing CDATA into the parent's value
+	const XmlTree::ParseOptions &options = mDoc->mParseOptions;
+	XmlTree result( getTag().str(), getValue().str(), 0, getNodeType() );
+	if( isDocument() )
+		result.setDocType( mDoc->getDocType().str() );
+
+	for( Node child = firstChild(); child; child = child.nextSibling() ) {
+		if( child.getNodeType() == XmlTree::NODE_CDATA && options.getCollapseCData() )
+			result.setValue( result.getValue() + child.getValue().str() );
+		else
+			result.push_back( child.toXmlTree() );
+	}
+
+	for( Attr attr = firstAttribute(); attr; attr = attr.next() )
+		result.setAttribute( attr.getName().str(), attr.getValue().str() );
+
+	return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// XmlDoc
+
+XmlDoc::XmlDoc( const XmlTree::ParseOptions &parseOptions )
+	: mParseOptions( parseOptions )
+{
+}
+
+XmlDoc::~XmlDoc()
+{
+}
+
+XmlDocRef XmlDoc::create( DataSourceRef dataSource, XmlTree::ParseOptions parseOptions )
+{
+	XmlDocRef result( new XmlDoc( parseOptions ) );
+
+	// RapidXML requires a terminating null. The bytes following a mapped file are zero-filled to the end of its last page,
+	// so the file can be mapped unless its size is an exact multiple of the page size.
+	if( dataSource->isFilePath() ) {
+		MappedFileRef mapped;
+		try {
+			mapped = MappedFile::create( dataSource->getFilePath(), true );
+		}
+		catch( StreamExc & ) { // not an ordinary file, such as an Android asset; fall back to reading it
+		}
+		if( mapped && mapped->getSize() % 4096 != 0 ) {
+			result->mMappedFile = mapped;
+			result->parse( static_cast<char*>( mapped->getData() ) );
+			return result;
+		}
+	}
+
+	Buffer buffer = dataSource->getBuffer();
+	result->mText.resize( buffer.getDataSize() + 1 );
+	if( buffer.getDataSize() )
+		memcpy( &result->mText[0], buffer.getData(), buffer.getDataSize() );
+	result->mText.back() = 0;
+	result->parse( &result->mText[0] );
+	return result;
+}
+
+XmlDocRef XmlDoc::create( const std::string &xmlString, XmlTree::ParseOptions parseOptions )
+{
+	XmlDocRef result( new XmlDoc( parseOptions ) );
+	result->mText.assign( xmlString.c_str(), xmlString.c_str() + xmlString.size() + 1 );
+	result->parse( &result->mText[0] );
+	return result;
+}
+
+void XmlDoc::parse( char *text )
+{
+	mDocument.reset( new rapidxml::xml_document<char>() );
+	try {
+		if( mParseOptions.getParseComments() )
+			mDocument->parse<PARSE_FLAGS | rapidxml::parse_comment_nodes>( text );
+		else
+			mDocument->parse<PARSE_FLAGS>( text );
+	}
+	catch( rapidxml::parse_error &exc ) {
+		throw ExcParse( exc.what(), exc.where<char>() - text );
+	}
+}
+
+XmlDoc::Node XmlDoc::getRoot() const
+{
+	return Node( mDocument.get(), this );
+}
+
+XmlDoc::StringRef XmlDoc::getDocType() const
+{
+	for( const rapidxml::xml_node<char> *node = mDocument->first_node(); node; node = node->next_sibling() )
+		if( node->type() == rapidxml::node_doctype )
+			return StringRef( node->value(), node->value_size() );
+	return StringRef();
+}
+
+XmlDoc::ExcParse::ExcParse( const char *message, size_t offset ) throw()
+{
+	sprintf( mMessage, "XML parse error at byte %lu: ", (unsigned long)offset );
+	strncat( mMessage, message, sizeof(mMessage) - strlen( mMessage ) - 1 );
+}
+
+XmlDoc::ExcChildNotFound::ExcChildNotFound( const string &childPath ) throw()
+{
+	sprintf( mMessage, "Could not find child: " );
+	strncat( mMessage, childPath.c_str(), sizeof(mMessage) - strlen( mMessage ) - 1 );
+}
+
+XmlDoc::ExcAttrNotFound::ExcAttrNotFound( const string &attrName ) throw()
+{
+	sprintf( mMessage, "Could not find attribute: " );
+	strncat( mMessage, attrName.c_str(), sizeof(mMessage) - strlen( mMessage ) - 1 );
+}
+
+} // namespace cinder
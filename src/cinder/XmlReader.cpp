@@ -0,0 +1,527 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/XmlReader.h"
+
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+
+namespace cinder {
+
+namespace {
+
+inline bool isWhitespace( char c )
+{
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isNameEnd( char c )
+{
+	return isWhitespace( c ) || c == '>' || c == '/' || c == '=' || c == '<' || c == '?';
+}
+
+void appendUtf8( uint32_t cp, std::string *dest )
+{
+	if( cp < 0x80 )
+		*dest += (char)cp;
+	else if( cp < 0x800 ) {
+		*dest += (char)( 0xC0 | ( cp >> 6 ) );
+		*dest += (char)( 0x80 | ( cp & 0x3F ) );
+	}
+	else if( cp < 0x10000 ) {
+		*dest += (char)( 0xE0 | ( cp >> 12 ) );
+		*dest += (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+		*dest += (char)( 0x80 | ( cp & 0x3F ) );
+	}
+	else {
+		*dest += (char)( 0xF0 | ( cp >> 18 ) );
+		*dest += (char)( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+		*dest += (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+		*dest += (char)( 0x80 | ( cp & 0x3F ) );
+	}
+}
+
+// decodes the body of a character or predefined entity reference, returning false if it is neither
+bool decodeEntity( const char *name, size_t length, std::string *result )
+{
+	if( length >= 2 && name[0] == '#' ) {
+		uint32_t cp = 0;
+		size_t i = 1;
+		const bool hex = ( name[1] == 'x' || name[1] == 'X' );
+		if( hex )
+			++i;
+		if( i == length )
+			return false;
+		for( ; i < length; ++i ) {
+			char c = name[i];
+			uint32_t digit;
+			if( c >= '0' && c <= '9' ) digit = c - '0';
+			else if( hex && c >= 'a' && c <= 'f' ) digit = c - 'a' + 10;
+			else if( hex && c >= 'A' && c <= 'F' ) digit = c - 'A' + 10;
+			else return false;
+			cp = cp * ( hex ? 16 : 10 ) + digit;
+			if( cp > 0x10FFFF )
+				return false;
+		}
+		appendUtf8( cp, result );
+		return true;
+	}
+
+	static const struct { const char *name; size_t length; char value; } predefined[] = {
+		{ "lt", 2, '<' }, { "gt", 2, '>' }, { "amp", 3, '&' }, { "quot", 4, '"' }, { "apos", 4, '\'' }
+	};
+	for( size_t e = 0; e < sizeof(predefined) / sizeof(predefined[0]); ++e ) {
+		if( length == predefined[e].length && memcmp( name, predefined[e].name, length ) == 0 ) {
+			*result += predefined[e].value;
+			return true;
+		}
+	}
+	return false;
+}
+
+} // anonymous namespace
+
+XmlReader::XmlReader( IStreamRef stream, size_t bufferSize )
+	: mStream( stream ), mBuffer( std::max<size_t>( bufferSize, 16 ) ), mBufferOffset( 0 ), mEvent( EVENT_NONE ),
+	mEmptyElement( false ), mPendingEnd( false ), mRootClosed( false ), mDepth( 0 ), mNumAttributes( 0 )
+{
+	mBufferBegin = mPos = mEnd = &mBuffer[0];
+}
+
+bool XmlReader::fill()
+{
+	if( mPos < mEnd )
+		return true;
+	mBufferOffset += mEnd - mBufferBegin;
+	size_t bytesRead = mStream->isEof() ? 0 : mStream->readDataAvailable( &mBuffer[0], mBuffer.size() );
+	mBufferBegin = mPos = &mBuffer[0];
+	mEnd = mPos + bytesRead;
+	// skip a UTF-8 byte order mark at the start of the stream; it still counts toward getOffset()
+	if( mBufferOffset == 0 && bytesRead >= 3 && memcmp( mPos, "\xEF\xBB\xBF", 3 ) == 0 )
+		mPos += 3;
+	return mPos < mEnd;
+}
+
+int XmlReader::peek()
+{
+	return fill() ? (uint8_t)*mPos : -1;
+}
+
+int XmlReader::get()
+{
+	return fill() ? (uint8_t)*mPos++ : -1;
+}
+
+void XmlReader::expect( char c, const char *message )
+{
+	if( get() != (uint8_t)c )
+		error( message );
+}
+
+void XmlReader::error( const char *message ) const
+{
+	throw ExcParse( message, getOffset() );
+}
+
+bool XmlReader::skipWhitespace()
+{
+	bool skipped = false;
+	while( fill() ) {
+		const char *start = mPos;
+		while( mPos < mEnd && isWhitespace( *mPos ) )
+			++mPos;
+		skipped = skipped || mPos > start;
+		if( mPos < mEnd )
+			break;
+	}
+	return skipped;
+}
+
+void XmlReader::skipPast( const char *terminator, size_t length )
+{
+	// matches the terminator across buffer boundaries; after a mismatch falls back to the longest prefix of the terminator which is still matched
+	size_t matched = 0;
+	while( matched < length ) {
+		if( matched == 0 ) {
+			if( ! fill() )
+				error( "unexpected end of input" );
+			const char *found = (const char*)memchr( mPos, terminator[0], mEnd - mPos );
+			if( ! found ) {
+				mPos = mEnd;
+				continue;
+			}
+			mPos = found + 1;
+			matched = 1;
+			continue;
+		}
+
+		int c = get();
+		if( c < 0 )
+			error( "unexpected end of input" );
+		if( c == (uint8_t)terminator[matched] ) {
+			++matched;
+			continue;
+		}
+		// the text just seen is terminator[0, matched) followed by c; keep the longest suffix of it that is a prefix of the terminator
+		size_t next = matched;
+		for( ; next > 0; --next ) {
+			if( (uint8_t)terminator[next - 1] != c )
+				continue;
+			if( memcmp( terminator, terminator + matched - next + 1, next - 1 ) == 0 )
+				break;
+		}
+		matched = next;
+	}
+}
+
+void XmlReader::readName( std::string *result )
+{
+	result->clear();
+	while( fill() ) {
+		const char *start = mPos;
+		while( mPos < mEnd && ! isNameEnd( *mPos ) )
+			++mPos;
+		result->append( start, mPos );
+		if( mPos < mEnd )
+			break;
+	}
+	if( result->empty() )
+		error( "expected a name" );
+}
+
+void XmlReader::readEntity( std::string *result )
+{
+	// called after the '&'; unrecognized references are kept literally
+	char name[16];
+	size_t length = 0;
+	int c;
+	while( length < sizeof(name) && ( c = peek() ) >= 0 && c != ';' && c != '<' && c != '&' && ! isWhitespace( (char)c ) ) {
+		name[length++] = (char)c;
+		++mPos;
+	}
+	if( peek() == ';' && decodeEntity( name, length, result ) ) {
+		++mPos;
+		return;
+	}
+	*result += '&';
+	result->append( name, length );
+}
+
+void XmlReader::readText()
+{
+	mText.clear();
+	bool whitespaceOnly = true;
+	while( fill() ) {
+		const char *start = mPos;
+		while( mPos < mEnd && *mPos != '<' && *mPos != '&' ) {
+			whitespaceOnly = whitespaceOnly && isWhitespace( *mPos );
+			++mPos;
+		}
+		mText.append( start, mPos );
+		if( mPos == mEnd )
+			continue;
+		if( *mPos == '<' )
+			break;
+		++mPos;
+		readEntity( &mText );
+		whitespaceOnly = false;
+	}
+	if( whitespaceOnly )
+		mText.clear();
+}
+
+void XmlReader::readAttributeValue( char quote, std::string *result )
+{
+	result->clear();
+	while( true ) {
+		if( ! fill() )
+			error( "unterminated attribute value" );
+		const char *start = mPos;
+		while( mPos < mEnd && *mPos != quote && *mPos != '&' && *mPos != '<' )
+			++mPos;
+		result->append( start, mPos );
+		if( mPos == mEnd )
+			continue;
+		const char c = *mPos++;
+		if( c == quote )
+			return;
+		else if( c == '&' )
+			readEntity( result );
+		else
+			error( "'<' in attribute value" );
+	}
+}
+
+void XmlReader::pushElement()
+{
+	if( mStack.size() <= mDepth )
+		mStack.push_back( std::string() );
+	mStack[mDepth++] = mName;
+}
+
+void XmlReader::readStartTag()
+{
+	if( mRootClosed )
+		error( "multiple root elements" );
+	readName( &mName );
+	while( true ) {
+		skipWhitespace();
+		int c = peek();
+		if( c < 0 )
+			error( "unexpected end of input" );
+		else if( c == '>' ) {
+			++mPos;
+			break;
+		}
+		else if( c == '/' ) {
+			++mPos;
+			expect( '>', "expected '>'" );
+			mEmptyElement = mPendingEnd = true;
+			break;
+		}
+
+		if( mAttributes.size() <= mNumAttributes )
+			mAttributes.push_back( std::pair<std::string, std::string>() );
+		std::pair<std::string, std::string> &attr = mAttributes[mNumAttributes];
+		readName( &attr.first );
+		skipWhitespace();
+		expect( '=', "expected '='" );
+		skipWhitespace();
+		int quote = get();
+		if( quote != '"' && quote != '\'' )
+			error( "expected a quoted attribute value" );
+		readAttributeValue( (char)quote, &attr.second );
+		++mNumAttributes;
+	}
+	pushElement();
+	mEvent = EVENT_START_ELEMENT;
+}
+
+void XmlReader::readEndTag()
+{
+	readName( &mName );
+	skipWhitespace();
+	expect( '>', "expected '>'" );
+	if( mDepth == 0 || mStack[mDepth - 1] != mName )
+		error( "mismatched end tag" );
+	if( --mDepth == 0 )
+		mRootClosed = true;
+	mEvent = EVENT_END_ELEMENT;
+}
+
+bool XmlReader::readMarkup()
+{
+	// called after the '<'; returns false for markup which produces no event
+	int c = peek();
+	if( c == '/' ) {
+		++mPos;
+		readEndTag();
+		return true;
+	}
+	else if( c == '?' ) {
+		skipPast( "?>", 2 );
+		return false;
+	}
+	else if( c == '!' ) {
+		++mPos;
+		c = peek();
+		if( c == '-' ) {
+			++mPos;
+			expect( '-', "malformed comment" );
+			skipPast( "-->", 3 );
+			return false;
+		}
+		else if( c == '[' ) {
+			const char *cdata = "[CDATA[";
+			for( size_t i = 0; i < 7; ++i )
+				expect( cdata[i], "malformed CDATA section" );
+			if( mDepth == 0 )
+				error( "CDATA outside the root element" );
+			mText.clear();
+			// collect up to the terminator; the "]]" matched so far is held back until it is known not to end the section
+			size_t brackets = 0;
+			while( true ) {
+				int d = get();
+				if( d < 0 )
+					error( "unterminated CDATA section" );
+				if( d == ']' )
+					++brackets;
+				else if( d == '>' && brackets >= 2 ) {
+					mText.append( brackets - 2, ']' );
+					break;
+				}
+				else {
+					mText.append( brackets, ']' );
+					brackets = 0;
+					mText += (char)d;
+				}
+			}
+			mEvent = EVENT_CDATA;
+			return true;
+		}
+		else { // DOCTYPE, which may carry an internal subset in brackets
+			int nesting = 0;
+			while( true ) {
+				int d = get();
+				if( d < 0 )
+					error( "unterminated DOCTYPE" );
+				if( d == '[' )
+					++nesting;
+				else if( d == ']' )
+					--nesting;
+				else if( d == '>' && nesting <= 0 )
+					break;
+			}
+			return false;
+		}
+	}
+	else {
+		readStartTag();
+		return true;
+	}
+}
+
+XmlReader::Event XmlReader::next()
+{
+	mNumAttributes = 0;
+	if( mPendingEnd ) {
+		mPendingEnd = false;
+		if( --mDepth == 0 )
+			mRootClosed = true;
+		return mEvent = EVENT_END_ELEMENT;
+	}
+	mEmptyElement = false;
+
+	while( true ) {
+		int c = peek();
+		if( c < 0 ) {
+			if( mDepth )
+				error( "unexpected end of input inside an element" );
+			return mEvent = EVENT_END_OF_DOCUMENT;
+		}
+		else if( c == '<' ) {
+			++mPos;
+			if( readMarkup() )
+				return mEvent;
+		}
+		else {
+			readText();
+			if( mText.empty() )
+				continue;
+			if( mDepth == 0 )
+				error( "text outside the root element" );
+			return mEvent = EVENT_TEXT;
+		}
+	}
+}
+
+void XmlReader::skip()
+{
+	if( mEvent != EVENT_START_ELEMENT )
+		return;
+	if( mPendingEnd ) {
+		next();
+		return;
+	}
+
+	// scan for the matching end tag without decoding anything
+	size_t depth = 1;
+	while( depth ) {
+		if( ! fill() )
+			error( "unexpected end of input inside an element" );
+		const char *found = (const char*)memchr( mPos, '<', mEnd - mPos );
+		if( ! found ) {
+			mPos = mEnd;
+			continue;
+		}
+		mPos = found + 1;
+
+		int c = peek();
+		if( c == '/' ) {
+			skipPast( ">", 1 );
+			--depth;
+		}
+		else if( c == '?' )
+			skipPast( "?>", 2 );
+		else if( c == '!' ) {
+			++mPos;
+			c = peek();
+			if( c == '-' )
+				skipPast( "-->", 3 );
+			else if( c == '[' )
+				skipPast( "]]>", 3 );
+			else
+				skipPast( ">", 1 );
+		}
+		else {
+			// a start tag; '>' may appear inside quoted attribute values
+			char quote = 0, last = 0;
+			while( true ) {
+				int d = get();
+				if( d < 0 )
+					error( "unexpected end of input inside an element" );
+				if( quote ) {
+					if( d == quote )
+						quote = 0;
+				}
+				else if( d == '"' || d == '\'' )
+					quote = (char)d;
+				else if( d == '>' )
+					break;
+				if( ! isWhitespace( (char)d ) )
+					last = (char)d;
+			}
+			if( last != '/' )
+				++depth;
+		}
+	}
+
+	mName = mStack[--mDepth];
+	if( mDepth == 0 )
+		mRootClosed = true;
+	mNumAttributes = 0;
+	mEvent = EVENT_END_ELEMENT;
+}
+
+const std::string* XmlReader::findAttribute( const std::string &name ) const
+{
+	for( size_t i = 0; i < mNumAttributes; ++i )
+		if( mAttributes[i].first == name )
+			return &mAttributes[i].second;
+	return 0;
+}
+
+const std::string& XmlReader::getAttributeValue( const std::string &name ) const
+{
+	static const std::string empty;
+	const std::string *value = findAttribute( name );
+	return value ? *value : empty;
+}
+
+XmlReader::ExcParse::ExcParse( const char *message, uint64_t offset ) throw()
+{
+	sprintf( mMessage, "XML parse error at byte %llu: %s", (unsigned long long)offset, message );
+}
+
+} // namespace cinder
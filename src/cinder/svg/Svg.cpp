@@ -23,10 +23,12 @@
 */
 
 #include "cinder/svg/Svg.h"
+#include "cinder/svg/SvgNodeIndex.h"
 #include "cinder/Utilities.h"
 #include "cinder/ImageIo.h"
 #include "cinder/Base64.h"
 #include "cinder/Text.h"
+#include "cinder/TaskPool.h"
 
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
@@ -96,43 +98,37 @@ bool isNumeric( char c )
 	return ( c >= '0' && c <= '9' ) || c == '.' || c == '-' || c == 'e' || c == 'E' || c == '+';
 }
 
+// whitespace and commas separate numbers in path data, point lists and transforms
+inline bool isSeparator( char c )
+{
+	return c == ' ' || c == ',' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+}
+
+inline const char* skipSeparators( const char *s )
+{
+	while( isSeparator( *s ) )
+		++s;
+	return s;
+}
+
 float parseFloat( const char **sInOut )
 {
-	char temp[256];
-	size_t i = 0;
-	const char *s = *sInOut;
-	while( *s && (isspace(*s) || *s == ',') )
-		s++;
-	if( ! s )
-		throw PathParseExc();
-	if( isNumeric( *s ) ) {
-		while( *s == '-' || *s == '+' ) {
-			if( i < sizeof(temp) )
-				temp[i++] = *s;
-			s++;
-		}
-		bool parsingExponent = false;
-		bool seenDecimal = false;
-		while( *s && ( parsingExponent || (*s != '-' && *s != '+')) && isNumeric(*s) ) {
-			if( *s == '.' && seenDecimal )
-				break;
-			else if( *s == '.' )
-				seenDecimal = true;
-			if( i < sizeof(temp) )
-				temp[i++] = *s;
-			if( *s == 'e' || *s == 'E' )
-				parsingExponent = true;
-			else
-				parsingExponent = false;
-			s++;
-		}
-		temp[i] = 0;
-		float result = (float)atof( temp );
-		*sInOut = s;
-		return result;
-	}
-	else
+	const char *s = skipSeparators( *sInOut );
+	if( ! isNumeric( *s ) )
 		throw FloatParseExc();
+	// bound the token so parseNumber() can't run past the terminator; it stops at the real end of the number,
+	// which lets adjacent numbers such as "1.5-2" or ".5.5" split the same way they always have
+	const char *end = s + 1;
+	while( isNumeric( *end ) )
+		++end;
+	double result;
+	const char *parsed = parseNumber( s, end, &result );
+	if( parsed == s ) { // a lone sign or decimal point; atof() used to read these as zero
+		*sInOut = end;
+		return 0;
+	}
+	*sInOut = parsed;
+	return (float)result;
 }
 
 // parses float from comma-separated parenthetical list
@@ -145,7 +141,7 @@ vector<float> parseFloatList( const char **c )
 	(*c)++;
 	do {
 		result.push_back( parseFloat( c ) );
-		while( **c && ( **c == ',' || isspace( **c ) ) ) (*c)++;
+		*c = skipSeparators( *c );
 	} while( **c && **c != ')' );
 	
 	// get rid of trailing closing paren
@@ -165,7 +161,7 @@ vector<Value> parseValueList( const char **c, bool requireParens = true )
 	}
 	do {
 		result.push_back( Value::parse( c ) );
-		while( **c && ( **c == ',' || isspace( **c ) ) ) (*c)++;
+		*c = skipSeparators( *c );
 	} while( **c && **c != ')' );
 	
 	// get rid of trailing closing paren
@@ -1326,47 +1322,9 @@ void ellipticalArc( Shape2d &path, float x1, float y1, float x2, float y2, float
     }
 }
 
-static const char* getNextPathItem(const char* s, char it[64] )
-{
-	int i = 0;
-	it[0] = '\0';
-	// Skip white spaces and commas
-	while( *s && (isspace(*s) || *s == ',') )
-		s++;
-	if( ! *s )
-		return s;
-	if( isNumeric(*s) ) {
-		while( *s == '-' || *s == '+' ) {
-			if( i < 63 )
-				it[i++] = *s;
-			s++;
-		}
-		bool parsingExponent = false;
-		while( *s && ( parsingExponent || (*s != '-' && *s != '+')) && isNumeric(*s) ) {
-			if( i < 63 )
-				it[i++] = *s;
-			if( *s == 'e' || *s == 'E' )
-				parsingExponent = true;
-			else
-				parsingExponent = false;
-			s++;
-		}
-		it[i] = '\0';
-	}
-	else {
-		it[0] = *s++;
-		it[1] = '\0';
-		return s;
-	}
-
-	return s;
-}
-
 char readNextCommand( const char **sInOut )
 {
-	const char *s = *sInOut;
-	while( *s && (isspace(*s) || *s == ',') )
-		s++;
+	const char *s = skipSeparators( *sInOut );
 	*sInOut = s + 1;
 	return *s;
 }
@@ -1382,9 +1340,7 @@ bool readFlag( const char **sInOut )
 
 bool nextItemIsFloat( const char *s )
 {
-	while( *s && (isspace(*s) || *s == ',') )
-		s++;
-	return isNumeric( *s );
+	return isNumeric( *skipSeparators( s ) );
 }
 
 Shape2d parsePath( const std::string &p )
@@ -1638,20 +1594,12 @@ Shape2d	Rect::getShape() const
 vector<Vec2f> parsePointList( const std::string &p )
 {
 	vector<Vec2f> result;
-	
-	if( ! p.empty() ) {
-		char item[64];
-		const char *s = p.c_str();
-		bool odd = false;
-		float lastVal;
-		while( *s ) {
-			s = getNextPathItem( s, item );
-			if( ! odd )
-				lastVal = (float)atof( item );
-			else
-				result.push_back( Vec2f( lastVal, (float)atof( item ) ) );
-			odd = ! odd;
-		}
+	const char *s = p.c_str();
+	while( nextItemIsFloat( s ) ) {
+		float x = parseFloat( &s );
+		if( ! nextItemIsFloat( s ) ) // odd number of coordinates; the last one is dropped
+			break;
+		result.push_back( Vec2f( x, parseFloat( &s ) ) );
 	}
 
 	return result;
@@ -1730,35 +1678,44 @@ Group::~Group()
 void Group::parse( const XmlTree &xml )
 {
 	for( XmlTree::ConstIter treeIt = xml.begin(); treeIt != xml.end(); ++treeIt ) {
-		if( treeIt->getTag() == "g" )
-			mChildren.push_back( new Group( this, *treeIt ) );
-		else if( treeIt->getTag() == "path" )
-			mChildren.push_back( new Path( this, *treeIt ) );
-		else if( treeIt->getTag() == "polygon" )
-			mChildren.push_back( new Polygon( this, *treeIt ) );
-		else if( treeIt->getTag() == "polyline" )
-			mChildren.push_back( new Polyline( this, *treeIt ) );
-		else if( treeIt->getTag() == "line" )
-			mChildren.push_back( new Line( this, *treeIt ) );
-		else if( treeIt->getTag() == "rect" )
-			mChildren.push_back( new Rect( this, *treeIt ) );
-		else if( treeIt->getTag() == "circle" )
-			mChildren.push_back( new Circle( this, *treeIt ) );
-		else if( treeIt->getTag() == "ellipse" )
-			mChildren.push_back( new Ellipse( this, *treeIt ) );
-		else if( treeIt->getTag() == "use" )
-			mChildren.push_back( new Use( this, *treeIt ) );
-		else if( treeIt->getTag() == "defs" )
+		if( treeIt->getTag() == "defs" )
 			mDefs = shared_ptr<Group>( new Group( this, *treeIt ) );
-		else if( treeIt->getTag() == "image" )
-			mChildren.push_back( new Image( this, *treeIt ) );
-		else if( treeIt->getTag() == "linearGradient" )
-			mChildren.push_back( new LinearGradient( this, *treeIt ) );
-		else if( treeIt->getTag() == "radialGradient" )
-			mChildren.push_back( new RadialGradient( this, *treeIt ) );
-		else if( treeIt->getTag() == "text" )
-			mChildren.push_back( new Text( this, *treeIt ) );
-	}
+		else if( Node *child = createChild( *treeIt ) )
+			mChildren.push_back( child );
+	}
+}
+
+Node* Group::createChild( const XmlTree &xml )
+{
+	const string &tag = xml.getTag();
+	if( tag == "g" )
+		return new Group( this, xml );
+	else if( tag == "path" )
+		return new Path( this, xml );
+	else if( tag == "polygon" )
+		return new Polygon( this, xml );
+	else if( tag == "polyline" )
+		return new Polyline( this, xml );
+	else if( tag == "line" )
+		return new Line( this, xml );
+	else if( tag == "rect" )
+		return new Rect( this, xml );
+	else if( tag == "circle" )
+		return new Circle( this, xml );
+	else if( tag == "ellipse" )
+		return new Ellipse( this, xml );
+	else if( tag == "use" )
+		return new Use( this, xml );
+	else if( tag == "image" )
+		return new Image( this, xml );
+	else if( tag == "linearGradient" )
+		return new LinearGradient( this, xml );
+	else if( tag == "radialGradient" )
+		return new RadialGradient( this, xml );
+	else if( tag == "text" )
+		return new Text( this, xml );
+	else
+		return 0;
 }
 
 const Node* Group::findNodeByIdContains( const std::string &idPartial, bool recurse ) const
@@ -2310,9 +2267,86 @@ void Doc::loadDoc( DataSourceRef source, fs::path filePath )
 
 	// we can't parse the group w/o having parsed the viewBox, dimensions, etc, so we have to do this manually:
 	if( xml.hasChild( "switch" ) )		// when saved with "preserve Illustrator editing capabilities", svg data is inside a "switch"
-		Group::parse( xml.getChild( "switch" ) );
+		parseTopLevel( xml.getChild( "switch" ) );
 	else
-		Group::parse( xml );
+		parseTopLevel( xml );
+}
+
+namespace {
+// Whether nothing in the subtree refers to other elements by id or loads images through the Doc. Such a subtree can be
+// built before its earlier siblings exist, and concurrently with other self-contained subtrees.
+bool isSelfContained( const XmlTree &xml )
+{
+	if( xml.getTag() == "use" || xml.getTag() == "image" )
+		return false;
+	for( list<XmlTree::Attr>::const_iterator attIt = xml.getAttributes().begin(); attIt != xml.getAttributes().end(); ++attIt ) {
+		if( attIt->getName() == "xlink:href" || attIt->getValue().find( "url(" ) != string::npos )
+			return false;
+	}
+	for( XmlTree::ConstIter childIt = xml.begin(); childIt != xml.end(); ++childIt ) {
+		if( ! isSelfContained( *childIt ) )
+			return false;
+	}
+	return true;
+}
+
+struct GroupBuilder {
+	GroupBuilder( const Doc *doc, const vector<const XmlTree*> &elements, const vector<size_t> &indices, vector<Node*> *nodes )
+		: mDoc( doc ), mElements( elements ), mIndices( indices ), mNodes( nodes )
+	{}
+
+	void operator()( size_t begin, size_t end ) const
+	{
+		for( size_t i = begin; i < end; ++i ) {
+			size_t element = mIndices[i];
+			try {
+				(*mNodes)[element] = new Group( mDoc, *mElements[element] );
+			}
+			catch( ... ) { // left empty, so the serial pass rebuilds it and the exception surfaces in document order
+			}
+		}
+	}
+
+	const Doc						*mDoc;
+	const vector<const XmlTree*>	&mElements;
+	const vector<size_t>			&mIndices;
+	vector<Node*>					*mNodes;
+};
+
+} // anonymous namespace
+
+void Doc::parseTopLevel( const XmlTree &xml )
+{
+	// Self-contained top-level groups are built on the TaskPool up front. Everything else is then built serially in
+	// document order, just as Group::parse() would, so references between elements resolve exactly as before.
+	vector<const XmlTree*> elements;
+	vector<size_t> parallelElements;
+	for( XmlTree::ConstIter treeIt = xml.begin(); treeIt != xml.end(); ++treeIt ) {
+		if( treeIt->getTag() == "g" && isSelfContained( *treeIt ) )
+			parallelElements.push_back( elements.size() );
+		elements.push_back( &*treeIt );
+	}
+
+	vector<Node*> prebuilt( elements.size(), (Node*)0 );
+	if( parallelElements.size() > 1 )
+		TaskPool::getDefault().parallelFor( parallelElements.size(), 1, GroupBuilder( this, elements, parallelElements, &prebuilt ) );
+
+	size_t e = 0;
+	try {
+		for( ; e < elements.size(); ++e ) {
+			if( prebuilt[e] )
+				mChildren.push_back( prebuilt[e] );
+			else if( elements[e]->getTag() == "defs" )
+				mDefs = shared_ptr<Group>( new Group( this, *elements[e] ) );
+			else if( Node *child = createChild( *elements[e] ) )
+				mChildren.push_back( child );
+		}
+	}
+	catch( ... ) {
+		for( ; e < elements.size(); ++e )
+			delete prebuilt[e];
+		throw;
+	}
 }
 
 shared_ptr<Surface8u> Doc::loadImage( fs::path relativePath )
@@ -2338,6 +2372,23 @@ Node* Doc::nodeUnderPoint( const Vec2f &pt )
 	return Group::nodeUnderPoint( pt, MatrixAffine2f::identity() );
 }
 
+vector<Node*> Doc::findNodesAt( const Vec2f &pt ) const
+{
+	return getNodeIndex().findNodesAt( pt );
+}
+
+vector<Node*> Doc::findNodesIntersecting( const Rectf &rect ) const
+{
+	return getNodeIndex().findNodesIntersecting( rect );
+}
+
+const NodeIndex& Doc::getNodeIndex() const
+{
+	if( ! mNodeIndex )
+		mNodeIndex = shared_ptr<NodeIndex>( new NodeIndex( *this ) );
+	return *mNodeIndex;
+}
+
 void Doc::renderSelf( Renderer &renderer ) const
 {
 	Group::renderSelf( renderer );
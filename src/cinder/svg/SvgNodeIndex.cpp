@@ -0,0 +1,189 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/svg/SvgNodeIndex.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace cinder { namespace svg {
+
+namespace {
+
+const uint32_t MAX_LEAF_SIZE = 8;
+// the hierarchy is split at the median, so its depth is bounded by log2 of the number of Nodes
+const int MAX_DEPTH = 64;
+
+struct CenterXLess {
+	template<typename T>
+	bool operator()( const T &a, const T &b ) const { return a.mBounds.x1 + a.mBounds.x2 < b.mBounds.x1 + b.mBounds.x2; }
+};
+
+struct CenterYLess {
+	template<typename T>
+	bool operator()( const T &a, const T &b ) const { return a.mBounds.y1 + a.mBounds.y2 < b.mBounds.y1 + b.mBounds.y2; }
+};
+
+struct OrderLess {
+	template<typename T>
+	bool operator()( const T *a, const T *b ) const { return a->mOrder < b->mOrder; }
+};
+
+struct OrderGreater {
+	template<typename T>
+	bool operator()( const T *a, const T *b ) const { return a->mOrder > b->mOrder; }
+};
+
+} // anonymous namespace
+
+NodeIndex::NodeIndex( const Group &root )
+{
+	addNodes( root, root.getTransformAbsolute() );
+	if( ! mEntries.empty() ) {
+		mBvhNodes.reserve( 2 * ( mEntries.size() / MAX_LEAF_SIZE + 1 ) );
+		build( 0, (uint32_t)mEntries.size() );
+	}
+}
+
+void NodeIndex::addNodes( const Group &group, const MatrixAffine2f &transform )
+{
+	for( list<Node*>::const_iterator childIt = group.getChildren().begin(); childIt != group.getChildren().end(); ++childIt ) {
+		// mirrors Group::renderSelf(): display:none hides a whole subtree, while a hidden Group's children may make themselves visible
+		if( (*childIt)->isDisplayNone() )
+			continue;
+		MatrixAffine2f childTransform = (*childIt)->specifiesTransform() ? ( transform * (*childIt)->getTransform() ) : transform;
+		const Group *childGroup = dynamic_cast<const Group*>( *childIt );
+		if( childGroup )
+			addNodes( *childGroup, childTransform );
+		else if( (*childIt)->isVisible() && ! dynamic_cast<const Gradient*>( *childIt ) ) {
+			Entry entry;
+			entry.mNode = *childIt;
+			entry.mOrder = (uint32_t)mEntries.size();
+			entry.mBounds = (*childIt)->getBoundingBox().transformCopy( childTransform );
+			entry.mInverseTransform = childTransform.invertCopy();
+			mEntries.push_back( entry );
+		}
+	}
+}
+
+uint32_t NodeIndex::build( uint32_t begin, uint32_t end )
+{
+	uint32_t result = (uint32_t)mBvhNodes.size();
+	mBvhNodes.push_back( BvhNode() );
+
+	Rectf bounds = mEntries[begin].mBounds;
+	Vec2f center = mEntries[begin].mBounds.getCenter();
+	Rectf centerBounds( center, center );
+	for( uint32_t e = begin + 1; e < end; ++e ) {
+		bounds.include( mEntries[e].mBounds );
+		centerBounds.include( mEntries[e].mBounds.getCenter() );
+	}
+	mBvhNodes[result].mBounds = bounds;
+
+	if( end - begin <= MAX_LEAF_SIZE ) {
+		mBvhNodes[result].mFirst = begin;
+		mBvhNodes[result].mCount = end - begin;
+		return result;
+	}
+
+	// split at the median center along the wider axis; the first child immediately follows its parent
+	uint32_t middle = begin + ( end - begin ) / 2;
+	if( centerBounds.getWidth() >= centerBounds.getHeight() )
+		std::nth_element( mEntries.begin() + begin, mEntries.begin() + middle, mEntries.begin() + end, CenterXLess() );
+	else
+		std::nth_element( mEntries.begin() + begin, mEntries.begin() + middle, mEntries.begin() + end, CenterYLess() );
+	build( begin, middle );
+	uint32_t second = build( middle, end );
+	mBvhNodes[result].mFirst = second;
+	mBvhNodes[result].mCount = 0;
+	return result;
+}
+
+vector<Node*> NodeIndex::findNodesAt( const Vec2f &pt ) const
+{
+	vector<const Entry*> hits;
+	if( ( ! mBvhNodes.empty() ) && mBvhNodes[0].mBounds.contains( pt ) ) {
+		uint32_t stack[MAX_DEPTH];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+		while( stackSize > 0 ) {
+			const BvhNode &bvhNode = mBvhNodes[stack[--stackSize]];
+			if( bvhNode.mCount ) {
+				for( uint32_t e = bvhNode.mFirst; e < bvhNode.mFirst + bvhNode.mCount; ++e ) {
+					const Entry &entry = mEntries[e];
+					if( entry.mBounds.contains( pt ) && entry.mNode->containsPoint( entry.mInverseTransform.transformPoint( pt ) ) )
+						hits.push_back( &entry );
+				}
+			}
+			else {
+				uint32_t first = (uint32_t)( &bvhNode - &mBvhNodes[0] ) + 1;
+				if( mBvhNodes[first].mBounds.contains( pt ) )
+					stack[stackSize++] = first;
+				if( mBvhNodes[bvhNode.mFirst].mBounds.contains( pt ) )
+					stack[stackSize++] = bvhNode.mFirst;
+			}
+		}
+	}
+
+	std::sort( hits.begin(), hits.end(), OrderGreater() );
+	vector<Node*> result( hits.size() );
+	for( size_t h = 0; h < hits.size(); ++h )
+		result[h] = hits[h]->mNode;
+	return result;
+}
+
+vector<Node*> NodeIndex::findNodesIntersecting( const Rectf &rect ) const
+{
+	Rectf query = rect.canonicalized();
+	vector<const Entry*> hits;
+	if( ( ! mBvhNodes.empty() ) && mBvhNodes[0].mBounds.intersects( query ) ) {
+		uint32_t stack[MAX_DEPTH];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+		while( stackSize > 0 ) {
+			const BvhNode &bvhNode = mBvhNodes[stack[--stackSize]];
+			if( bvhNode.mCount ) {
+				for( uint32_t e = bvhNode.mFirst; e < bvhNode.mFirst + bvhNode.mCount; ++e )
+					if( mEntries[e].mBounds.intersects( query ) )
+						hits.push_back( &mEntries[e] );
+			}
+			else {
+				uint32_t first = (uint32_t)( &bvhNode - &mBvhNodes[0] ) + 1;
+				if( mBvhNodes[first].mBounds.intersects( query ) )
+					stack[stackSize++] = first;
+				if( mBvhNodes[bvhNode.mFirst].mBounds.intersects( query ) )
+					stack[stackSize++] = bvhNode.mFirst;
+			}
+		}
+	}
+
+	std::sort( hits.begin(), hits.end(), OrderLess() );
+	vector<Node*> result( hits.size() );
+	for( size_t h = 0; h < hits.size(); ++h )
+		result[h] = hits[h]->mNode;
+	return result;
+}
+
+} } // namespace cinder::svg
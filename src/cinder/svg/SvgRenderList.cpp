@@ -0,0 +1,390 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/svg/SvgRenderList.h"
+#include "cinder/Triangulate.h"
+
+#include <algorithm>
+#include <typeinfo>
+
+using namespace std;
+
+namespace cinder { namespace svg {
+
+namespace {
+
+// Only nodes of these types are flattened into contours; everything else is replayed through renderSelf()
+bool isShape( const Node &node )
+{
+	const std::type_info &type = typeid(node);
+	return type == typeid(Path) || type == typeid(Polygon) || type == typeid(Polyline) || type == typeid(Rect)
+			|| type == typeid(Circle) || type == typeid(Ellipse) || type == typeid(Line);
+}
+
+// The inherited style pushed onto a Renderer before drawing an Item
+void pushItemStyle( Renderer &renderer, const RenderList::Item &item, const vector<Paint> &paints )
+{
+	renderer.pushMatrix( item.mTransform );
+	renderer.pushStyle( item.mNode->getStyle() );
+	renderer.pushFill( paints[item.mFill] );
+	renderer.pushStroke( paints[item.mStroke] );
+	renderer.pushFillOpacity( item.mFillOpacity );
+	renderer.pushStrokeOpacity( item.mStrokeOpacity );
+	renderer.pushStrokeWidth( item.mStrokeWidth );
+	renderer.pushFillRule( item.mFillRule );
+	renderer.pushLineCap( item.mLineCap );
+	renderer.pushLineJoin( item.mLineJoin );
+}
+
+void popItemStyle( Renderer &renderer, const RenderList::Item &item )
+{
+	renderer.popLineJoin();
+	renderer.popLineCap();
+	renderer.popFillRule();
+	renderer.popStrokeWidth();
+	renderer.popStrokeOpacity();
+	renderer.popFillOpacity();
+	renderer.popStroke();
+	renderer.popFill();
+	renderer.popStyle( item.mNode->getStyle() );
+	renderer.popMatrix();
+}
+
+} // anonymous namespace
+
+RenderList::RenderList()
+	: mRoot( 0 ), mApproximationScale( 1.0f ), mTessellateFills( true )
+{
+}
+
+RenderList::RenderList( const Node &root, float approximationScale, bool tessellateFills )
+	: mRoot( &root ), mApproximationScale( approximationScale ), mTessellateFills( tessellateFills )
+{
+	// the first two paints are always the fill and stroke the root inherits
+	const Node *parent = root.getParent();
+	mPaints.push_back( parent ? parent->getFill() : Style::getFillDefault() );
+	mPaints.push_back( parent ? parent->getStroke() : Style::getStrokeDefault() );
+
+	vector<const Node*> activeUses;
+	compileNode( root, makeRootItem(), false, &activeUses, &mItems );
+}
+
+void RenderList::invalidate( const Node &node )
+{
+	mDirty.push_back( &node );
+}
+
+void RenderList::update()
+{
+	if( mDirty.empty() )
+		return;
+
+	std::sort( mDirty.begin(), mDirty.end() );
+	mDirty.erase( std::unique( mDirty.begin(), mDirty.end() ), mDirty.end() );
+
+	// Copy the list, recompiling the subtree of any Item whose Node is dirty. A Node instantiated by a Use can appear more than once.
+	vector<Item> result;
+	result.reserve( mItems.size() );
+	vector<size_t> ancestors, ancestorEnds, resultAncestors; // enclosing Items in mItems, where their subtrees end, and their copies in result
+	vector<const Node*> activeUses;
+	for( size_t i = 0; i < mItems.size(); ) {
+		while( ( ! ancestors.empty() ) && ancestorEnds.back() <= i ) {
+			ancestors.pop_back();
+			ancestorEnds.pop_back();
+			resultAncestors.pop_back();
+		}
+
+		const Item &item = mItems[i];
+		if( std::binary_search( mDirty.begin(), mDirty.end(), item.mNode ) ) {
+			activeUses.clear();
+			for( size_t a = 0; a < ancestors.size(); ++a )
+				if( mItems[ancestors[a]].mType == USE )
+					activeUses.push_back( mItems[ancestors[a]].mNode );
+			// the root and a Use's referenced Node are drawn regardless of their visibility
+			bool checkVisibility = ( ! ancestors.empty() ) && mItems[ancestors.back()].mType != USE;
+
+			size_t first = result.size();
+			compileNode( *item.mNode, ancestors.empty() ? makeRootItem() : mItems[ancestors.back()], checkVisibility, &activeUses, &result );
+			int32_t delta = (int32_t)( result.size() - first ) - (int32_t)item.mSubtreeSize;
+			for( size_t a = 0; a < resultAncestors.size(); ++a )
+				result[resultAncestors[a]].mSubtreeSize += delta;
+			i += item.mSubtreeSize;
+		}
+		else {
+			if( item.mSubtreeSize > 1 ) {
+				ancestors.push_back( i );
+				ancestorEnds.push_back( i + item.mSubtreeSize );
+				resultAncestors.push_back( result.size() );
+			}
+			result.push_back( item );
+			++i;
+		}
+	}
+
+	mItems.swap( result );
+	mDirty.clear();
+	compactGeometry();
+}
+
+void RenderList::render( Renderer &renderer ) const
+{
+	vector<size_t> groupEnds;
+	for( size_t i = 0; i < mItems.size(); ++i ) {
+		while( ( ! groupEnds.empty() ) && groupEnds.back() == i ) {
+			renderer.popGroup();
+			groupEnds.pop_back();
+		}
+
+		const Item &item = mItems[i];
+		switch( item.mType ) {
+			case GROUP:
+				renderer.pushGroup( static_cast<const Group&>( *item.mNode ), item.mGroupOpacity );
+				groupEnds.push_back( i + item.mSubtreeSize );
+			break;
+			case SHAPE:
+			case OTHER:
+				pushItemStyle( renderer, item, mPaints );
+				item.mNode->renderSelf( renderer );
+				popItemStyle( renderer, item );
+			break;
+			default:
+			break;
+		}
+	}
+
+	for( size_t g = 0; g < groupEnds.size(); ++g )
+		renderer.popGroup();
+}
+
+RenderList::Item RenderList::makeRootItem() const
+{
+	Item result;
+	result.mNode = 0;
+	result.mType = GROUP;
+	result.mSubtreeSize = 0;
+	result.mGroupOpacity = 1;
+	result.mFirstContour = result.mNumContours = 0;
+	result.mFirstFillVertex = result.mNumFillVertices = 0;
+	result.mFill = 0;
+	result.mStroke = 1;
+	const Node *parent = mRoot->getParent();
+	if( parent ) {
+		result.mTransform = parent->getTransformAbsolute();
+		result.mFillOpacity = parent->getFillOpacity();
+		result.mStrokeOpacity = parent->getStrokeOpacity();
+		result.mStrokeWidth = parent->getStrokeWidth();
+		result.mFillRule = parent->getFillRule();
+		result.mLineCap = parent->getLineCap();
+		result.mLineJoin = parent->getLineJoin();
+	}
+	else {
+		result.mTransform.setToIdentity();
+		result.mFillOpacity = Style::getFillOpacityDefault();
+		result.mStrokeOpacity = Style::getStrokeOpacityDefault();
+		result.mStrokeWidth = Style::getStrokeWidthDefault();
+		result.mFillRule = Style::getFillRuleDefault();
+		result.mLineCap = Style::getLineCapDefault();
+		result.mLineJoin = Style::getLineJoinDefault();
+	}
+	return result;
+}
+
+// Appends the Items for \a node's subtree to \a result, mirroring Group::renderSelf() and Style::startRender()
+void RenderList::compileNode( const Node &node, const Item &parent, bool checkVisibility, vector<const Node*> *activeUses, vector<Item> *result )
+{
+	Item item = parent;
+	item.mNode = &node;
+	item.mSubtreeSize = 1;
+	item.mGroupOpacity = 1;
+	item.mFirstContour = item.mNumContours = 0;
+	item.mFirstFillVertex = item.mNumFillVertices = 0;
+
+	const Style &style = node.getStyle();
+	if( checkVisibility && ( style.isDisplayNone() || ( ( ! node.isVisible() ) && typeid(node) != typeid(Group) ) ) ) {
+		item.mType = SKIPPED;
+		result->push_back( item );
+		return;
+	}
+
+	if( node.specifiesTransform() )
+		item.mTransform = parent.mTransform * node.getTransform();
+	if( style.specifiesFill() ) {
+		item.mFill = (uint32_t)mPaints.size();
+		mPaints.push_back( style.getFill() );
+	}
+	if( style.specifiesStroke() ) {
+		item.mStroke = (uint32_t)mPaints.size();
+		mPaints.push_back( style.getStroke() );
+	}
+	if( style.specifiesOpacity() ) {
+		if( node.isDrawable() )
+			item.mFillOpacity = item.mStrokeOpacity = style.getOpacity();
+	}
+	else {
+		if( style.specifiesFillOpacity() )
+			item.mFillOpacity = style.getFillOpacity();
+		if( style.specifiesStrokeOpacity() )
+			item.mStrokeOpacity = style.getStrokeOpacity();
+	}
+	if( style.specifiesStrokeWidth() )
+		item.mStrokeWidth = style.getStrokeWidth();
+	if( style.specifiesFillRule() )
+		item.mFillRule = style.getFillRule();
+	if( style.specifiesLineCap() )
+		item.mLineCap = style.getLineCap();
+	if( style.specifiesLineJoin() )
+		item.mLineJoin = style.getLineJoin();
+
+	size_t index = result->size();
+	if( const Group *group = dynamic_cast<const Group*>( &node ) ) {
+		item.mType = GROUP;
+		item.mGroupOpacity = style.getOpacity();
+		result->push_back( item );
+		const list<Node*> &children = group->getChildren();
+		for( list<Node*>::const_iterator childIt = children.begin(); childIt != children.end(); ++childIt )
+			compileNode( **childIt, item, true, activeUses, result );
+	}
+	else if( const Use *use = dynamic_cast<const Use*>( &node ) ) {
+		item.mType = USE;
+		result->push_back( item );
+		// a Use which (indirectly) references itself draws nothing the second time around
+		const Node *referenced = use->getReferenced();
+		if( referenced && std::find( activeUses->begin(), activeUses->end(), &node ) == activeUses->end() ) {
+			activeUses->push_back( &node );
+			compileNode( *referenced, item, false, activeUses, result );
+			activeUses->pop_back();
+		}
+	}
+	else if( dynamic_cast<const Gradient*>( &node ) ) {
+		item.mType = SKIPPED;
+		result->push_back( item );
+	}
+	else if( isShape( node ) ) {
+		item.mType = SHAPE;
+		compileShape( node, &item );
+		result->push_back( item );
+	}
+	else {
+		item.mType = OTHER;
+		result->push_back( item );
+	}
+
+	(*result)[index].mSubtreeSize = (uint32_t)( result->size() - index );
+}
+
+void RenderList::compileShape( const Node &node, Item *item )
+{
+	// subdivide finely enough for the node's absolute scale
+	Vec2f xAxis = item->mTransform.transformVec( Vec2f( 1, 0 ) );
+	Vec2f yAxis = item->mTransform.transformVec( Vec2f( 0, 1 ) );
+	float scale = mApproximationScale * math<float>::sqrt( math<float>::abs( xAxis.x * yAxis.y - xAxis.y * yAxis.x ) );
+	if( scale <= 0 )
+		return;
+
+	Shape2d shape = node.getShape();
+	item->mFirstContour = (uint32_t)mContours.size();
+	const vector<Path2d> &paths = shape.getContours();
+	for( vector<Path2d>::const_iterator pathIt = paths.begin(); pathIt != paths.end(); ++pathIt ) {
+		vector<Vec2f> points = pathIt->subdivide( scale );
+		if( points.empty() )
+			continue;
+		// subdivide() repeats the first point of every segment; drop the duplicates
+		Contour contour;
+		contour.mFirstPoint = (uint32_t)mPoints.size();
+		mPoints.push_back( points[0] );
+		for( size_t p = 1; p < points.size(); ++p )
+			if( points[p] != mPoints.back() )
+				mPoints.push_back( points[p] );
+		contour.mNumPoints = (uint32_t)( mPoints.size() - contour.mFirstPoint );
+		mContours.push_back( contour );
+	}
+	item->mNumContours = (uint32_t)( mContours.size() - item->mFirstContour );
+
+	item->mFirstFillVertex = (uint32_t)mFillVertices.size();
+	if( mTessellateFills && item->mNumContours && ( ! mPaints[item->mFill].isNone() ) && typeid(node) != typeid(Line) ) {
+		Triangulator triangulator;
+		for( uint32_t c = item->mFirstContour; c < item->mFirstContour + item->mNumContours; ++c ) {
+			const Vec2f *first = &mPoints[mContours[c].mFirstPoint];
+			triangulator.addPolyLine( PolyLine2f( vector<Vec2f>( first, first + mContours[c].mNumPoints ) ) );
+		}
+		TriMesh2d mesh = triangulator.calcMesh( ( item->mFillRule == FILL_RULE_NONZERO ) ? Triangulator::WINDING_NONZERO : Triangulator::WINDING_ODD );
+		const vector<Vec2f> &vertices = mesh.getVertices();
+		const vector<uint32_t> &indices = mesh.getIndices();
+		for( size_t i = 0; i < indices.size(); ++i )
+			mFillVertices.push_back( vertices[indices[i]] );
+	}
+	item->mNumFillVertices = (uint32_t)( mFillVertices.size() - item->mFirstFillVertex );
+}
+
+// Recompiled subtrees leave their old geometry and paints behind; reclaim them once they outweigh what's in use
+void RenderList::compactGeometry()
+{
+	size_t livePoints = 0, liveFillVertices = 0;
+	for( vector<Item>::const_iterator itemIt = mItems.begin(); itemIt != mItems.end(); ++itemIt ) {
+		for( uint32_t c = itemIt->mFirstContour; c < itemIt->mFirstContour + itemIt->mNumContours; ++c )
+			livePoints += mContours[c].mNumPoints;
+		liveFillVertices += itemIt->mNumFillVertices;
+	}
+	if( mPoints.size() + mFillVertices.size() <= 2 * ( livePoints + liveFillVertices ) + 1024 )
+		return;
+
+	vector<Paint> paints( mPaints.begin(), mPaints.begin() + 2 );
+	vector<Contour> contours;
+	vector<Vec2f> points, fillVertices;
+	points.reserve( livePoints );
+	fillVertices.reserve( liveFillVertices );
+	vector<uint32_t> paintMap( mPaints.size(), 0xFFFFFFFF );
+	paintMap[0] = 0;
+	paintMap[1] = 1;
+	for( vector<Item>::iterator itemIt = mItems.begin(); itemIt != mItems.end(); ++itemIt ) {
+		uint32_t *paintIndices[2] = { &itemIt->mFill, &itemIt->mStroke };
+		for( int p = 0; p < 2; ++p ) {
+			if( paintMap[*paintIndices[p]] == 0xFFFFFFFF ) {
+				paintMap[*paintIndices[p]] = (uint32_t)paints.size();
+				paints.push_back( mPaints[*paintIndices[p]] );
+			}
+			*paintIndices[p] = paintMap[*paintIndices[p]];
+		}
+
+		uint32_t firstContour = (uint32_t)contours.size();
+		for( uint32_t c = itemIt->mFirstContour; c < itemIt->mFirstContour + itemIt->mNumContours; ++c ) {
+			Contour contour = mContours[c];
+			points.insert( points.end(), mPoints.begin() + contour.mFirstPoint, mPoints.begin() + contour.mFirstPoint + contour.mNumPoints );
+			contour.mFirstPoint = (uint32_t)( points.size() - contour.mNumPoints );
+			contours.push_back( contour );
+		}
+		itemIt->mFirstContour = firstContour;
+
+		uint32_t firstFillVertex = (uint32_t)fillVertices.size();
+		fillVertices.insert( fillVertices.end(), mFillVertices.begin() + itemIt->mFirstFillVertex, mFillVertices.begin() + itemIt->mFirstFillVertex + itemIt->mNumFillVertices );
+		itemIt->mFirstFillVertex = firstFillVertex;
+	}
+
+	mPaints.swap( paints );
+	mContours.swap( contours );
+	mPoints.swap( points );
+	mFillVertices.swap( fillVertices );
+}
+
+} } // namespace cinder::svg
@@ -0,0 +1,501 @@
+/*
+ Copyright (c) 2012, The Cinder Project
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+	* Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/svg/SvgSurface.h"
+#include "cinder/ip/Fill.h"
+#include "cinder/CinderMath.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace cinder {
+
+namespace {
+
+// SVG's default stroke-miterlimit
+const float MITER_LIMIT = 4.0f;
+
+inline uint32_t div255( uint32_t v )
+{
+	return ( v + 128 + ( ( v + 128 ) >> 8 ) ) >> 8;
+}
+
+// packs a premultiplied color as r, g, b, a from the low byte up
+inline uint32_t packPremultiplied( float r, float g, float b, float a )
+{
+	a = constrain( a, 0.0f, 1.0f );
+	return (uint32_t)( constrain( r, 0.0f, 1.0f ) * a * 255 + 0.5f ) | ( (uint32_t)( constrain( g, 0.0f, 1.0f ) * a * 255 + 0.5f ) << 8 )
+		| ( (uint32_t)( constrain( b, 0.0f, 1.0f ) * a * 255 + 0.5f ) << 16 ) | ( (uint32_t)( a * 255 + 0.5f ) << 24 );
+}
+
+inline uint32_t packPremultiplied( const ColorA8u &color, float opacity )
+{
+	return packPremultiplied( color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f * opacity );
+}
+
+// Fills \a result with 256 samples of \a paint's color stops
+void buildGradient( const svg::Paint &paint, float opacity, vector<uint32_t> *result )
+{
+	result->resize( 256 );
+	size_t numStops = paint.getNumColors();
+	size_t stop = 0;
+	for( int i = 0; i < 256; ++i ) {
+		float t = i / 255.0f;
+		while( stop + 1 < numStops && paint.getOffset( stop + 1 ) <= t )
+			++stop;
+		const ColorA8u &c0 = paint.getColor( stop );
+		if( stop + 1 >= numStops || t <= paint.getOffset( stop ) ) {
+			(*result)[i] = packPremultiplied( c0, opacity );
+			continue;
+		}
+		const ColorA8u &c1 = paint.getColor( stop + 1 );
+		float s = ( t - paint.getOffset( stop ) ) / ( paint.getOffset( stop + 1 ) - paint.getOffset( stop ) );
+		(*result)[i] = packPremultiplied( lerp<float>( c0.r, c1.r, s ) / 255, lerp<float>( c0.g, c1.g, s ) / 255, lerp<float>( c0.b, c1.b, s ) / 255,
+											lerp<float>( c0.a, c1.a, s ) / 255 * opacity );
+	}
+}
+
+// Composites a solid color, gradient or image through the coverage produced by Rasterizer::rasterize()
+struct PaintFillFn {
+	enum { SOLID, LINEAR, RADIAL, IMAGE };
+
+	PaintFillFn( Surface8u *target )
+		: mData( target->getData() ), mRowBytes( target->getRowBytes() ), mPixelInc( target->getPixelInc() ),
+		mRed( target->getRedOffset() ), mGreen( target->getGreenOffset() ), mBlue( target->getBlueOffset() ),
+		mAlpha( target->hasAlpha() ? target->getAlphaOffset() : -1 ), mType( SOLID ), mSolid( 0 ), mColors( 0 ), mImage( 0 )
+	{
+		mDeviceToPaint.setToIdentity();
+	}
+
+	void operator()( int32_t x, int32_t y, int32_t count, const float *coverage ) const
+	{
+		uint8_t *pixel = mData + y * mRowBytes + x * mPixelInc;
+		Vec2f paintPos = mDeviceToPaint.transformPoint( Vec2f( x + 0.5f, y + 0.5f ) );
+		Vec2f paintStep = mDeviceToPaint.transformVec( Vec2f( 1, 0 ) );
+		for( int32_t i = 0; i < count; ++i, pixel += mPixelInc, paintPos += paintStep ) {
+			uint32_t c = (uint32_t)( coverage[i] * 255 + 0.5f );
+			if( c == 0 )
+				continue;
+			uint32_t color = shade( paintPos );
+			uint32_t alpha = div255( ( color >> 24 ) * c );
+			if( alpha == 0 )
+				continue;
+			uint32_t inverse = 255 - alpha;
+			pixel[mRed] = (uint8_t)( div255( ( color & 0xFF ) * c ) + div255( pixel[mRed] * inverse ) );
+			pixel[mGreen] = (uint8_t)( div255( ( ( color >> 8 ) & 0xFF ) * c ) + div255( pixel[mGreen] * inverse ) );
+			pixel[mBlue] = (uint8_t)( div255( ( ( color >> 16 ) & 0xFF ) * c ) + div255( pixel[mBlue] * inverse ) );
+			if( mAlpha >= 0 )
+				pixel[mAlpha] = (uint8_t)( alpha + div255( pixel[mAlpha] * inverse ) );
+		}
+	}
+
+	uint32_t shade( const Vec2f &p ) const
+	{
+		switch( mType ) {
+			case LINEAR:
+				return mColors[toIndex( ( p - mCoords0 ).dot( mAxis ) )];
+			case RADIAL: {
+				// solve for the circle, interpolated from the focal point to the outer circle, which passes through p
+				Vec2f q = p - mCoords1;
+				float qd = q.dot( mAxis ), qq = q.dot( q );
+				float t = ( math<float>::abs( mRadialA ) > 1.0e-6f ) ? ( ( qd - math<float>::sqrt( std::max( 0.0f, qd * qd - mRadialA * qq ) ) ) / mRadialA )
+								: ( ( qd > 0 ) ? ( qq / ( 2 * qd ) ) : 1.0f );
+				return mColors[toIndex( t )];
+			}
+			case IMAGE:
+				return sampleImage( p );
+			default:
+				return mSolid;
+		}
+	}
+
+	static size_t toIndex( float t )
+	{
+		return (size_t)( constrain( t, 0.0f, 1.0f ) * 255 + 0.5f );
+	}
+
+	uint32_t sampleImage( const Vec2f &p ) const
+	{
+		// bilinear filtering, clamped at the edges
+		float u = p.x - 0.5f, v = p.y - 0.5f;
+		int32_t maxX = mImage->getWidth() - 1, maxY = mImage->getHeight() - 1;
+		int32_t x0 = constrain<int32_t>( (int32_t)math<float>::floor( u ), 0, maxX ), y0 = constrain<int32_t>( (int32_t)math<float>::floor( v ), 0, maxY );
+		int32_t x1 = std::min( x0 + 1, maxX ), y1 = std::min( y0 + 1, maxY );
+		float fx = constrain( u - x0, 0.0f, 1.0f ), fy = constrain( v - y0, 0.0f, 1.0f );
+		const uint8_t *samples[4] = { mImage->getData( Vec2i( x0, y0 ) ), mImage->getData( Vec2i( x1, y0 ) ), mImage->getData( Vec2i( x0, y1 ) ), mImage->getData( Vec2i( x1, y1 ) ) };
+		float weights[4] = { ( 1 - fx ) * ( 1 - fy ), fx * ( 1 - fy ), ( 1 - fx ) * fy, fx * fy };
+		bool hasAlpha = mImage->hasAlpha();
+		float r = 0, g = 0, b = 0, a = 0;
+		for( int s = 0; s < 4; ++s ) {
+			// the image is unpremultiplied, so weight each sample by its alpha
+			float w = weights[s] * ( hasAlpha ? samples[s][mImage->getAlphaOffset()] / 255.0f : 1.0f );
+			r += samples[s][mImage->getRedOffset()] * w;
+			g += samples[s][mImage->getGreenOffset()] * w;
+			b += samples[s][mImage->getBlueOffset()] * w;
+			a += w;
+		}
+		if( a <= 0 )
+			return 0;
+		return packPremultiplied( r / ( a * 255 ), g / ( a * 255 ), b / ( a * 255 ), a * mOpacity );
+	}
+
+	uint8_t				*mData;
+	int32_t				mRowBytes, mPixelInc;
+	int32_t				mRed, mGreen, mBlue, mAlpha;
+
+	int					mType;
+	uint32_t			mSolid;
+	const uint32_t		*mColors;
+	MatrixAffine2f		mDeviceToPaint;
+	Vec2f				mCoords0, mCoords1, mAxis;
+	float				mRadialA, mOpacity;
+	const Surface8u		*mImage;
+};
+
+// Adds a polygon with positive orientation, so that overlapping stroke pieces union under the nonzero rule
+void addStrokePiece( Rasterizer *rasterizer, Vec2f *points, size_t numPoints, const MatrixAffine2f &transform )
+{
+	float area = 0;
+	for( size_t p = 0; p < numPoints; ++p )
+		area += points[p].x * points[( p + 1 ) % numPoints].y - points[( p + 1 ) % numPoints].x * points[p].y;
+	if( area < 0 )
+		std::reverse( points, points + numPoints );
+	rasterizer->addPolygon( points, numPoints, transform );
+}
+
+void addStrokeDisc( Rasterizer *rasterizer, const Vec2f &center, float radius, float pixelScale, const MatrixAffine2f &transform )
+{
+	int segments = constrain<int>( (int)( radius * pixelScale ) + 8, 8, 64 );
+	Vec2f points[64];
+	for( int s = 0; s < segments; ++s ) {
+		float angle = s * 2 * (float)M_PI / segments;
+		points[s] = center + Vec2f( math<float>::cos( angle ), math<float>::sin( angle ) ) * radius;
+	}
+	addStrokePiece( rasterizer, points, segments, transform );
+}
+
+// Adds the outline of a stroke of \a shape as overlapping pieces: a quad per segment, plus joins and caps
+void addStroke( Rasterizer *rasterizer, const Shape2d &shape, const MatrixAffine2f &transform, float approximationScale, float width, svg::LineCap lineCap, svg::LineJoin lineJoin )
+{
+	float pixelScale = math<float>::sqrt( Rasterizer::calcAreaScale( transform ) );
+	float halfWidth = width / 2;
+	if( pixelScale <= 0 || halfWidth <= 0 )
+		return;
+
+	const vector<Path2d> &contours = shape.getContours();
+	for( vector<Path2d>::const_iterator contourIt = contours.begin(); contourIt != contours.end(); ++contourIt ) {
+		if( contourIt->empty() )
+			continue;
+		vector<Vec2f> subdivided = contourIt->subdivide( approximationScale * pixelScale );
+		vector<Vec2f> points;
+		points.reserve( subdivided.size() );
+		for( vector<Vec2f>::const_iterator ptIt = subdivided.begin(); ptIt != subdivided.end(); ++ptIt )
+			if( points.empty() || *ptIt != points.back() )
+				points.push_back( *ptIt );
+		bool closed = contourIt->isClosed();
+		if( closed && points.size() > 1 && points.back() == points.front() )
+			points.pop_back();
+		size_t numPoints = points.size();
+		if( numPoints < 2 )
+			continue;
+
+		size_t numSegments = closed ? numPoints : numPoints - 1;
+		for( size_t s = 0; s < numSegments; ++s ) {
+			const Vec2f &a = points[s], &b = points[( s + 1 ) % numPoints];
+			Vec2f dir = ( b - a ).normalized();
+			Vec2f normal( -dir.y * halfWidth, dir.x * halfWidth );
+			Vec2f quad[4] = { a + normal, b + normal, b - normal, a - normal };
+			addStrokePiece( rasterizer, quad, 4, transform );
+		}
+
+		for( size_t p = closed ? 0 : 1; p < ( closed ? numPoints : numPoints - 1 ); ++p ) {
+			const Vec2f &cur = points[p];
+			Vec2f d0 = ( cur - points[( p + numPoints - 1 ) % numPoints] ).normalized();
+			Vec2f d1 = ( points[( p + 1 ) % numPoints] - cur ).normalized();
+			float cross = d0.x * d1.y - d0.y * d1.x;
+			if( math<float>::abs( cross ) < 1.0e-6f && d0.dot( d1 ) > 0 )
+				continue;
+			if( lineJoin == svg::LINE_JOIN_ROUND ) {
+				addStrokeDisc( rasterizer, cur, halfWidth, pixelScale, transform );
+				continue;
+			}
+			// the join fills the gap on the outside of the turn
+			float side = ( cross > 0 ) ? -1.0f : 1.0f;
+			Vec2f n0 = Vec2f( -d0.y, d0.x ) * side, n1 = Vec2f( -d1.y, d1.x ) * side;
+			Vec2f a = cur + n0 * halfWidth, b = cur + n1 * halfWidth;
+			Vec2f miterDir = n0 + n1;
+			float cosHalfAngle = ( miterDir.lengthSquared() > 0 ) ? miterDir.normalized().dot( n0 ) : 0;
+			if( lineJoin == svg::LINE_JOIN_MITER && cosHalfAngle > 1.0f / MITER_LIMIT ) {
+				Vec2f miter[4] = { cur, a, cur + miterDir.normalized() * ( halfWidth / cosHalfAngle ), b };
+				addStrokePiece( rasterizer, miter, 4, transform );
+			}
+			else {
+				Vec2f bevel[3] = { cur, a, b };
+				addStrokePiece( rasterizer, bevel, 3, transform );
+			}
+		}
+
+		if( ! closed ) {
+			for( int end = 0; end < 2; ++end ) {
+				const Vec2f &cur = end ? points[numPoints - 1] : points[0];
+				Vec2f outward = ( end ? ( cur - points[numPoints - 2] ) : ( cur - points[1] ) ).normalized();
+				if( lineCap == svg::LINE_CAP_ROUND )
+					addStrokeDisc( rasterizer, cur, halfWidth, pixelScale, transform );
+				else if( lineCap == svg::LINE_CAP_SQUARE ) {
+					Vec2f normal( -outward.y * halfWidth, outward.x * halfWidth );
+					Vec2f square[4] = { cur + normal, cur + normal + outward * halfWidth, cur - normal + outward * halfWidth, cur - normal };
+					addStrokePiece( rasterizer, square, 4, transform );
+				}
+			}
+		}
+	}
+}
+
+} // anonymous namespace
+
+SvgRendererSurface::SvgRendererSurface( Surface8u *surface, float approximationScale )
+	: svg::Renderer(), mSurface( surface ), mApproximationScale( approximationScale ), mRasterizer( surface->getWidth(), surface->getHeight() )
+{
+	mMatrixStack.push_back( MatrixAffine2f::identity() );
+	mFillStack.push_back( svg::Paint( Color::black() ) );
+	mStrokeStack.push_back( svg::Paint() );
+	mFillOpacityStack.push_back( 1.0f );
+	mStrokeOpacityStack.push_back( 1.0f );
+	mStrokeWidthStack.push_back( 1.0f );
+	mFillRuleStack.push_back( svg::FILL_RULE_NONZERO );
+	mLineCapStack.push_back( svg::LINE_CAP_BUTT );
+	mLineJoinStack.push_back( svg::LINE_JOIN_MITER );
+}
+
+void SvgRendererSurface::pushGroup( const svg::Group &/*group*/, float opacity )
+{
+	Layer layer;
+	layer.mOpacity = opacity;
+	layer.mBounds = Area( 0, 0, 0, 0 );
+	if( opacity < 1.0f ) {
+		layer.mSurface = Surface8u( mSurface->getWidth(), mSurface->getHeight(), true, SurfaceChannelOrder::RGBA );
+		ip::fill( &layer.mSurface, ColorA8u( 0, 0, 0, 0 ) );
+		layer.mSurface.setPremultiplied( true );
+	}
+	mLayers.push_back( layer );
+}
+
+void SvgRendererSurface::popGroup()
+{
+	Layer layer = mLayers.back();
+	mLayers.pop_back();
+	if( ( ! layer.mSurface ) || layer.mBounds.calcArea() <= 0 )
+		return;
+
+	// composite what the group drew onto the layer beneath, scaled by the group's opacity
+	Layer *parent = getTargetLayer();
+	Surface8u *target = parent ? &parent->mSurface : mSurface;
+	if( parent ) {
+		if( parent->mBounds.calcArea() > 0 )
+			parent->mBounds.include( layer.mBounds );
+		else
+			parent->mBounds = layer.mBounds;
+	}
+	uint32_t opacity = (uint32_t)( constrain( layer.mOpacity, 0.0f, 1.0f ) * 255 + 0.5f );
+	int32_t srcInc = layer.mSurface.getPixelInc(), dstInc = target->getPixelInc();
+	int32_t dstAlpha = target->hasAlpha() ? target->getAlphaOffset() : -1;
+	for( int32_t y = layer.mBounds.y1; y < layer.mBounds.y2; ++y ) {
+		const uint8_t *src = layer.mSurface.getData( Vec2i( layer.mBounds.x1, y ) );
+		uint8_t *dst = target->getData( Vec2i( layer.mBounds.x1, y ) );
+		for( int32_t x = layer.mBounds.x1; x < layer.mBounds.x2; ++x, src += srcInc, dst += dstInc ) {
+			uint32_t alpha = div255( src[3] * opacity );
+			if( alpha == 0 )
+				continue;
+			uint32_t inverse = 255 - alpha;
+			dst[target->getRedOffset()] = (uint8_t)( div255( src[0] * opacity ) + div255( dst[target->getRedOffset()] * inverse ) );
+			dst[target->getGreenOffset()] = (uint8_t)( div255( src[1] * opacity ) + div255( dst[target->getGreenOffset()] * inverse ) );
+			dst[target->getBlueOffset()] = (uint8_t)( div255( src[2] * opacity ) + div255( dst[target->getBlueOffset()] * inverse ) );
+			if( dstAlpha >= 0 )
+				dst[dstAlpha] = (uint8_t)( alpha + div255( dst[dstAlpha] * inverse ) );
+		}
+	}
+}
+
+SvgRendererSurface::Layer* SvgRendererSurface::getTargetLayer()
+{
+	for( vector<Layer>::reverse_iterator layerIt = mLayers.rbegin(); layerIt != mLayers.rend(); ++layerIt )
+		if( layerIt->mSurface )
+			return &*layerIt;
+	return 0;
+}
+
+void SvgRendererSurface::drawPath( const svg::Path &path )
+{
+	fillAndStroke( path, path.getShape2d(), true );
+}
+
+void SvgRendererSurface::drawPolyline( const svg::Polyline &polyline )
+{
+	fillAndStroke( polyline, polyline.getShape(), true );
+}
+
+void SvgRendererSurface::drawPolygon( const svg::Polygon &polygon )
+{
+	fillAndStroke( polygon, polygon.getShape(), true );
+}
+
+void SvgRendererSurface::drawLine( const svg::Line &line )
+{
+	fillAndStroke( line, line.getShape(), false );
+}
+
+void SvgRendererSurface::drawRect( const svg::Rect &rect )
+{
+	fillAndStroke( rect, rect.getShape(), true );
+}
+
+void SvgRendererSurface::drawCircle( const svg::Circle &circle )
+{
+	fillAndStroke( circle, circle.getShape(), true );
+}
+
+void SvgRendererSurface::drawEllipse( const svg::Ellipse &ellipse )
+{
+	fillAndStroke( ellipse, ellipse.getShape(), true );
+}
+
+void SvgRendererSurface::drawImage( const svg::Image &image )
+{
+	std::shared_ptr<Surface8u> surface = image.getSurface();
+	const Rectf &rect = image.getRect();
+	if( ( ! surface ) || ( ! *surface ) || rect.getWidth() <= 0 || rect.getHeight() <= 0 || mMatrixStack.back().isSingular() )
+		return;
+
+	mRasterizer.clear();
+	Vec2f corners[4] = { rect.getUpperLeft(), rect.getUpperRight(), rect.getLowerRight(), rect.getLowerLeft() };
+	mRasterizer.addPolygon( corners, 4, mMatrixStack.back() );
+	if( mRasterizer.isEmpty() )
+		return;
+
+	Layer *layer = getTargetLayer();
+	PaintFillFn fillFn( layer ? &layer->mSurface : mSurface );
+	fillFn.mType = PaintFillFn::IMAGE;
+	fillFn.mImage = surface.get();
+	fillFn.mOpacity = mFillOpacityStack.back();
+	fillFn.mDeviceToPaint = MatrixAffine2f::makeScale( Vec2f( surface->getWidth() / rect.getWidth(), surface->getHeight() / rect.getHeight() ) )
+								* MatrixAffine2f::makeTranslate( -rect.getUpperLeft() ) * mMatrixStack.back().invertCopy();
+	if( layer ) {
+		if( layer->mBounds.calcArea() > 0 )
+			layer->mBounds.include( mRasterizer.getBounds() );
+		else
+			layer->mBounds = mRasterizer.getBounds();
+	}
+	mRasterizer.rasterize( fillFn );
+}
+
+void SvgRendererSurface::fillAndStroke( const svg::Node &node, const Shape2d &shape, bool fill )
+{
+	const MatrixAffine2f &transform = mMatrixStack.back();
+	if( fill && ( ! mFillStack.back().isNone() ) ) {
+		mRasterizer.clear();
+		mRasterizer.addShape( shape, transform, mApproximationScale );
+		fillRasterizer( node, mFillStack.back(), mFillOpacityStack.back(), ( mFillRuleStack.back() == svg::FILL_RULE_EVENODD ) ? Triangulator::WINDING_ODD : Triangulator::WINDING_NONZERO );
+	}
+	if( ! mStrokeStack.back().isNone() ) {
+		mRasterizer.clear();
+		addStroke( &mRasterizer, shape, transform, mApproximationScale, mStrokeWidthStack.back(), mLineCapStack.back(), mLineJoinStack.back() );
+		fillRasterizer( node, mStrokeStack.back(), mStrokeOpacityStack.back(), Triangulator::WINDING_NONZERO );
+	}
+}
+
+void SvgRendererSurface::fillRasterizer( const svg::Node &node, const svg::Paint &paint, float opacity, Triangulator::Winding winding )
+{
+	if( mRasterizer.isEmpty() )
+		return;
+
+	Layer *layer = getTargetLayer();
+	PaintFillFn fillFn( layer ? &layer->mSurface : mSurface );
+	if( paint.isLinearGradient() || paint.isRadialGradient() ) {
+		if( mMatrixStack.back().isSingular() )
+			return;
+		// maps pixels back to the gradient's own coordinate system
+		MatrixAffine2f deviceToPaint = mMatrixStack.back().invertCopy();
+		if( paint.useObjectBoundingBox() ) {
+			Rectf bounds = node.getBoundingBox();
+			Vec2f scale( ( bounds.getWidth() != 0 ) ? ( 1 / bounds.getWidth() ) : 0, ( bounds.getHeight() != 0 ) ? ( 1 / bounds.getHeight() ) : 0 );
+			deviceToPaint = MatrixAffine2f::makeScale( scale ) * MatrixAffine2f::makeTranslate( -bounds.getUpperLeft() ) * deviceToPaint;
+		}
+		if( paint.specifiesTransform() )
+			deviceToPaint = paint.getTransform().invertCopy() * deviceToPaint;
+		fillFn.mDeviceToPaint = deviceToPaint;
+
+		buildGradient( paint, opacity, &mGradientColors );
+		fillFn.mColors = &mGradientColors[0];
+		fillFn.mCoords0 = paint.getCoords0();
+		fillFn.mCoords1 = paint.getCoords1();
+		if( paint.isLinearGradient() ) {
+			fillFn.mType = PaintFillFn::LINEAR;
+			Vec2f axis = paint.getCoords1() - paint.getCoords0();
+			fillFn.mAxis = ( axis.lengthSquared() > 0 ) ? ( axis / axis.lengthSquared() ) : Vec2f::zero();
+		}
+		else {
+			fillFn.mType = PaintFillFn::RADIAL;
+			// a focal point outside of the circle is moved onto it
+			float radius = paint.getRadius();
+			Vec2f focalToCenter = paint.getCoords0() - paint.getCoords1();
+			if( focalToCenter.length() > radius * 0.99f ) {
+				focalToCenter = focalToCenter.safeNormalized() * radius * 0.99f;
+				fillFn.mCoords1 = paint.getCoords0() - focalToCenter;
+			}
+			fillFn.mAxis = focalToCenter;
+			fillFn.mRadialA = focalToCenter.dot( focalToCenter ) - radius * radius;
+		}
+	}
+	else
+		fillFn.mSolid = packPremultiplied( paint.getColor(), opacity );
+
+	if( layer ) {
+		if( layer->mBounds.calcArea() > 0 )
+			layer->mBounds.include( mRasterizer.getBounds() );
+		else
+			layer->mBounds = mRasterizer.getBounds();
+	}
+	mRasterizer.rasterize( fillFn, winding );
+}
+
+namespace svg {
+
+Surface8u renderToSurface( const Doc &doc, const Vec2i &size )
+{
+	Vec2i surfaceSize = ( size.x > 0 && size.y > 0 ) ? size : doc.getSize();
+	Surface8u result( std::max( surfaceSize.x, 1 ), std::max( surfaceSize.y, 1 ), true );
+	ip::fill( &result, ColorA8u( 0, 0, 0, 0 ) );
+	result.setPremultiplied( true );
+
+	SvgRendererSurface renderer( &result );
+	if( doc.getWidth() > 0 && doc.getHeight() > 0 )
+		renderer.pushMatrix( MatrixAffine2f::makeScale( Vec2f( surfaceSize ) / Vec2f( doc.getSize() ) ) );
+	doc.render( renderer );
+	return result;
+}
+
+} // namespace svg
+
+} // namespace cinder
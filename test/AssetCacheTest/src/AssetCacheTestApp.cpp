@@ -0,0 +1,129 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/AssetCache.h"
+#include "cinder/Utilities.h"
+
+#include <cstdio>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+class AssetCacheTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+DataSourceRef textSource( const std::string &text, const std::string &filePathHint )
+{
+	// the Buffer refers to text, which outlives the DataSource in every test below
+	return DataSourceBuffer::create( Buffer( const_cast<char*>( text.c_str() ), text.size() ), filePathHint );
+}
+
+fs::path onlyEntry( const fs::path &directory )
+{
+	fs::path result;
+	for( fs::directory_iterator it( directory ), end; it != end; ++it ) {
+		if( it->path().extension() == ".ciac" ) {
+			assert( result.empty() );
+			result = it->path();
+		}
+	}
+	assert( ! result.empty() );
+	return result;
+}
+
+void truncateFile( const fs::path &path, size_t size )
+{
+	Buffer contents = loadStreamBuffer( loadFileStream( path ) );
+	FILE *f = fopen( path.string().c_str(), "wb" );
+	fwrite( contents.getData(), std::min( size, contents.getDataSize() ), 1, f );
+	fclose( f );
+}
+
+void flipByte( const fs::path &path, size_t offset )
+{
+	FILE *f = fopen( path.string().c_str(), "r+b" );
+	fseek( f, (long)offset, SEEK_SET );
+	int c = fgetc( f );
+	fseek( f, (long)offset, SEEK_SET );
+	fputc( c ^ 0xFF, f );
+	fclose( f );
+}
+
+bool sameMesh( const TriMesh &a, const TriMesh &b )
+{
+	return a.getVertices() == b.getVertices() && a.getIndices() == b.getIndices()
+		&& a.getNormals() == b.getNormals() && a.getTexCoords() == b.getTexCoords();
+}
+
+void AssetCacheTestApp::setup()
+{
+	fs::path directory = getTemporaryDirectory() / "AssetCacheTest";
+	AssetCacheRef cache = AssetCache::create( directory );
+	cache->clear();
+
+	// raw entries round trip and are keyed by both the data and the options
+	const string payload = "the quick brown fox jumps over the lazy dog";
+	uint64_t key = AssetCache::calcKey( payload.c_str(), payload.size(), "raw" );
+	assert( key != AssetCache::calcKey( payload.c_str(), payload.size(), "raw2" ) );
+	assert( key != AssetCache::calcKey( payload.c_str(), payload.size() - 1, "raw" ) );
+	assert( ! cache->find( key ) );
+	cache->store( key, payload.c_str(), payload.size() );
+	IStreamRef found = cache->find( key );
+	assert( found && found->size() == (off_t)payload.size() );
+	Buffer foundData = loadStreamBuffer( found );
+	assert( string( (const char*)foundData.getData(), foundData.getDataSize() ) == payload );
+	found.reset();
+
+	// an entry that is truncated or has a damaged header is a miss, and a later store replaces it
+	fs::path entryPath = onlyEntry( directory );
+	truncateFile( entryPath, 70 );
+	assert( ! cache->find( key ) );
+	cache->store( key, payload.c_str(), payload.size() );
+	assert( cache->find( key ) );
+	flipByte( entryPath, 0 );
+	assert( ! cache->find( key ) );
+	cache->clear();
+
+	// loadObj() returns the same mesh from the source and from the cache
+	const string obj =	"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+						"vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+						"vn 0 0 1\n"
+						"f 1/1/1 2/2/1 3/3/1\nf 1/1/1 3/3/1 4/4/1\n";
+	TriMesh loaded = cache->loadObj( textSource( obj, "quad.obj" ) );
+	assert( loaded.getNumVertices() == 4 && loaded.getNumIndices() == 6 );
+	TriMesh cached = cache->loadObj( textSource( obj, "quad.obj" ) );
+	assert( sameMesh( loaded, cached ) );
+	// different load options are a different entry
+	TriMesh positionsOnly = cache->loadObj( textSource( obj, "quad.obj" ), false, false );
+	assert( positionsOnly.getNormals().empty() && positionsOnly.getTexCoords().empty() );
+
+	// a damaged TriMesh payload falls back to the source
+	cache->clear();
+	cache->loadObj( textSource( obj, "quad.obj" ) );
+	entryPath = onlyEntry( directory );
+	truncateFile( entryPath, 64 + 16 );
+	assert( sameMesh( cache->loadObj( textSource( obj, "quad.obj" ) ), loaded ) );
+	assert( sameMesh( cache->loadObj( textSource( obj, "quad.obj" ) ), loaded ) );
+
+	// loadSvgMesh() as well
+	cache->clear();
+	const string svg = "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"100\" height=\"100\">"
+						"<rect x=\"10\" y=\"10\" width=\"50\" height=\"20\" fill=\"red\"/></svg>";
+	TriMesh2d shapes = cache->loadSvgMesh( textSource( svg, "rect.svg" ) );
+	assert( shapes.getNumVertices() > 0 && shapes.getNumIndices() > 0 );
+	TriMesh2d cachedShapes = cache->loadSvgMesh( textSource( svg, "rect.svg" ) );
+	assert( cachedShapes.getVertices() == shapes.getVertices() && cachedShapes.getIndices() == shapes.getIndices() );
+
+	cache->clear();
+	app::console() << "Tests passed" << std::endl;
+}
+
+void AssetCacheTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) ); 
+}
+
+CINDER_APP_BASIC( AssetCacheTestApp, RendererGl )
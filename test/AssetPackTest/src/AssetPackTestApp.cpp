@@ -0,0 +1,186 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/AssetPack.h"
+#include "cinder/Utilities.h"
+
+#include <cstdio>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+class AssetPackTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+Buffer makeBuffer( const std::string &s )
+{
+	Buffer result( s.size() );
+	if( ! s.empty() )
+		memcpy( result.getData(), s.c_str(), s.size() );
+	return result;
+}
+
+std::string toString( const Buffer &b )
+{
+	return std::string( (const char*)b.getData(), b.getDataSize() );
+}
+
+std::string readStream( IStreamRef stream )
+{
+	std::string result( (size_t)stream->size(), 0 );
+	if( ! result.empty() )
+		stream->readData( &result[0], result.size() );
+	assert( stream->isEof() );
+	return result;
+}
+
+void writeFile( const fs::path &path, const std::string &contents )
+{
+	FILE *f = fopen( path.string().c_str(), "wb" );
+	fwrite( contents.c_str(), contents.size(), 1, f );
+	fclose( f );
+}
+
+std::string readFile( const fs::path &path )
+{
+	return toString( loadStreamBuffer( loadFileStream( path ) ) );
+}
+
+template<typename EXC>
+bool throws( const fs::path &path, bool memoryMap )
+{
+	try {
+		AssetPack::create( path, memoryMap );
+	}
+	catch( EXC & ) {
+		return true;
+	}
+	return false;
+}
+
+void checkPack( AssetPackRef pack, const std::map<std::string,std::string> &expected )
+{
+	assert( pack->getNumEntries() == expected.size() );
+	for( std::map<std::string,std::string>::const_iterator it = expected.begin(); it != expected.end(); ++it ) {
+		int index = pack->findEntry( it->first );
+		assert( index >= 0 && pack->getEntryName( index ) == it->first );
+		assert( pack->getEntrySize( index ) == it->second.size() );
+		assert( toString( pack->loadBuffer( index ) ) == it->second );
+		assert( readStream( pack->createStream( it->first ) ) == it->second );
+		assert( toString( DataSourcePack::create( pack, it->first )->getBuffer() ) == it->second );
+	}
+	assert( ! pack->contains( "missing" ) && pack->findEntry( "" ) < 0 );
+	bool threw = false;
+	try {
+		pack->createStream( "missing" );
+	}
+	catch( AssetPackExcEntryNotFound & ) {
+		threw = true;
+	}
+	assert( threw );
+}
+
+void AssetPackTestApp::setup()
+{
+	fs::path dir = getTemporaryDirectory();
+	fs::path packPath = dir / "AssetPackTest.pack";
+	fs::path filePath = dir / "AssetPackTest.txt";
+
+	std::map<std::string,std::string> expected;
+	std::string compressible;
+	for( int i = 0; i < 10000; ++i )
+		compressible += "abcabcabc";
+	std::string random;
+	uint32_t seed = 1;
+	for( int i = 0; i < 1000; ++i ) {
+		seed = seed * 1103515245 + 12345;
+		random += (char)( seed >> 16 );
+	}
+	expected["compressible.txt"] = compressible;
+	expected["random.bin"] = random;
+	expected["stored.txt"] = "not compressed";
+	expected["empty"] = "";
+	expected["null buffer"] = "";
+	expected["from file.txt"] = "file contents";
+	expected["replaced"] = "second";
+	writeFile( filePath, expected["from file.txt"] );
+
+	AssetPackWriter writer;
+	writer.addBuffer( "compressible.txt", makeBuffer( compressible ), true );
+	writer.addBuffer( "random.bin", makeBuffer( random ), true );	// stored uncompressed since zlib can't shrink it
+	writer.addBuffer( "stored.txt", makeBuffer( expected["stored.txt"] ) );
+	writer.addBuffer( "empty", makeBuffer( "" ), true );
+	writer.addBuffer( "null buffer", Buffer() );
+	writer.addFile( "from file.txt", filePath );
+	writer.addBuffer( "replaced", makeBuffer( "first" ) );
+	writer.addBuffer( "replaced", makeBuffer( "second" ) );
+	assert( writer.getNumEntries() == expected.size() );
+	writer.write( packPath );
+
+	// round trip through each way of opening a pack
+	AssetPackRef mapped = AssetPack::create( packPath );
+	checkPack( mapped, expected );
+	assert( mapped->isEntryCompressed( mapped->findEntry( "compressible.txt" ) ) );
+	assert( ! mapped->isEntryCompressed( mapped->findEntry( "random.bin" ) ) );
+	assert( ! mapped->isEntryCompressed( mapped->findEntry( "stored.txt" ) ) );
+	// uncompressed entries of a mapped pack are aligned
+	size_t stored = mapped->findEntry( "stored.txt" );
+	assert( (size_t)mapped->loadBuffer( stored ).getData() % AssetPack::ENTRY_ALIGNMENT == 0 );
+	mapped.reset();
+	checkPack( AssetPack::create( packPath, false ), expected );
+	checkPack( AssetPack::create( loadFileStream( packPath ) ), expected );
+
+	// an empty pack
+	fs::path emptyPath = dir / "AssetPackTestEmpty.pack";
+	AssetPackWriter().write( emptyPath );
+	checkPack( AssetPack::create( emptyPath ), std::map<std::string,std::string>() );
+
+	// damaged packs are rejected when they are opened
+	const std::string original = readFile( packPath );
+	fs::path damagedPath = dir / "AssetPackTestDamaged.pack";
+	std::string damaged = original;
+	damaged[0] = 'X';
+	writeFile( damagedPath, damaged );
+	assert( throws<AssetPackExcInvalidFile>( damagedPath, true ) && throws<AssetPackExcInvalidFile>( damagedPath, false ) );
+	writeFile( damagedPath, original.substr( 0, 40 ) );
+	assert( throws<AssetPackExcInvalidFile>( damagedPath, true ) && throws<AssetPackExcInvalidFile>( damagedPath, false ) );
+	writeFile( damagedPath, original.substr( 0, original.size() - 1 ) );
+	assert( throws<AssetPackExcInvalidFile>( damagedPath, true ) && throws<AssetPackExcInvalidFile>( damagedPath, false ) );
+
+	// a damaged compressed entry is reported when it is read
+	AssetPackRef pack = AssetPack::create( packPath );
+	size_t compressed = pack->findEntry( "compressible.txt" );
+	pack.reset();
+	// it is the first entry, written directly after the 64 byte header and the index
+	std::string compressedEntry = original;
+	uint64_t indexSize;
+	memcpy( &indexSize, &original[16], sizeof(indexSize) );
+	compressedEntry[64 + (size_t)indexSize + 10] ^= 0xFF;
+	writeFile( damagedPath, compressedEntry );
+	pack = AssetPack::create( damagedPath );
+	bool threw = false;
+	try {
+		pack->loadBuffer( compressed );
+	}
+	catch( AssetPackExcInvalidFile & ) {
+		threw = true;
+	}
+	assert( threw );
+	pack.reset();
+
+	fs::remove( packPath );
+	fs::remove( emptyPath );
+	fs::remove( damagedPath );
+	fs::remove( filePath );
+	app::console() << "Tests passed" << std::endl;
+}
+
+void AssetPackTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) ); 
+}
+
+CINDER_APP_BASIC( AssetPackTestApp, RendererGl )
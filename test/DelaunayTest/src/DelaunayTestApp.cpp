@@ -0,0 +1,207 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Delaunay.h"
+#include "cinder/Rand.h"
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Checks that DelaunayTriangulator's triangulations of random points, grids with many cocircular points, and outlines
+// which nest and cross are valid and Delaunay, and reports how long a million points take
+class DelaunayTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const size_t	NUM_POINTS = 20000;
+const size_t	NUM_BENCHMARK_POINTS = 1000000;
+const int		GRID_SIZE = 100;
+
+double calcArea( const Vec2f &a, const Vec2f &b, const Vec2f &c )
+{
+	return ( ( (double)b.x - a.x ) * ( (double)c.y - a.y ) - ( (double)b.y - a.y ) * ( (double)c.x - a.x ) ) / 2;
+}
+
+double incircle( const Vec2f &a, const Vec2f &b, const Vec2f &c, const Vec2f &d )
+{
+	const double adx = a.x - d.x, ady = a.y - d.y, bdx = b.x - d.x, bdy = b.y - d.y, cdx = c.x - d.x, cdy = c.y - d.y;
+	return ( adx * adx + ady * ady ) * ( bdx * cdy - cdx * bdy ) + ( bdx * bdx + bdy * bdy ) * ( cdx * ady - adx * cdy ) + ( cdx * cdx + cdy * cdy ) * ( adx * bdy - bdx * ady );
+}
+
+double calcTotalArea( const TriMesh2d &mesh )
+{
+	double result = 0;
+	for( size_t t = 0; t < mesh.getNumTriangles(); ++t ) {
+		Vec2f a, b, c;
+		mesh.getTriangleVertices( t, &a, &b, &c );
+		result += calcArea( a, b, c );
+	}
+	return result;
+}
+
+/* Checks that every triangle is counterclockwise, that each edge is shared by at most two triangles in opposite directions,
+   and that the vertex opposite each shared edge lies outside the other triangle's circumcircle, by more than \a tolerance
+   times the scale of the determinant, unless the edge is one of \a outlineEdges. Returns the edges which aren't shared. */
+vector<pair<uint32_t, uint32_t> > checkTriangulation( const TriMesh2d &mesh, double tolerance, const vector<pair<uint32_t, uint32_t> > &outlineEdges = vector<pair<uint32_t, uint32_t> >() )
+{
+	const vector<uint32_t> &indices = mesh.getIndices();
+	const vector<Vec2f> &vertices = mesh.getVertices();
+	map<pair<uint32_t, uint32_t>, uint32_t> opposite;
+	for( size_t t = 0; t < mesh.getNumTriangles(); ++t ) {
+		assert( calcArea( vertices[indices[3 * t]], vertices[indices[3 * t + 1]], vertices[indices[3 * t + 2]] ) > 0 );
+		for( int i = 0; i < 3; ++i ) {
+			const pair<uint32_t, uint32_t> edge( indices[3 * t + i], indices[3 * t + ( i + 1 ) % 3] );
+			assert( opposite.find( edge ) == opposite.end() );
+			opposite[edge] = indices[3 * t + ( i + 2 ) % 3];
+		}
+	}
+
+	vector<pair<uint32_t, uint32_t> > result;
+	for( map<pair<uint32_t, uint32_t>, uint32_t>::const_iterator it = opposite.begin(); it != opposite.end(); ++it ) {
+		map<pair<uint32_t, uint32_t>, uint32_t>::const_iterator twin = opposite.find( make_pair( it->first.second, it->first.first ) );
+		if( twin == opposite.end() ) {
+			result.push_back( it->first );
+			continue;
+		}
+		if( find( outlineEdges.begin(), outlineEdges.end(), it->first ) != outlineEdges.end() || find( outlineEdges.begin(), outlineEdges.end(), twin->first ) != outlineEdges.end() )
+			continue;
+		const Vec2f &a = vertices[it->first.first], &b = vertices[it->first.second], &c = vertices[it->second], &d = vertices[twin->second];
+		const double scale = ( a - d ).lengthSquared() * ( b - d ).length() * ( c - d ).length();
+		assert( incircle( a, b, c, d ) <= tolerance * scale );
+	}
+	return result;
+}
+
+//! Returns the edges of the outlines of \a mesh, which are those of only one triangle
+vector<pair<uint32_t, uint32_t> > findBoundary( const TriMesh2d &mesh )
+{
+	return checkTriangulation( mesh, numeric_limits<double>::max() );
+}
+
+bool hasEdge( const TriMesh2d &mesh, const Vec2f &a, const Vec2f &b )
+{
+	for( size_t t = 0; t < mesh.getNumTriangles(); ++t ) {
+		for( int i = 0; i < 3; ++i ) {
+			const Vec2f &from = mesh.getVertices()[mesh.getIndices()[3 * t + i]], &to = mesh.getVertices()[mesh.getIndices()[3 * t + ( i + 1 ) % 3]];
+			if( ( from == a && to == b ) || ( from == b && to == a ) )
+				return true;
+		}
+	}
+	return false;
+}
+
+PolyLine2f makeRectangle( float x0, float y0, float x1, float y1 )
+{
+	PolyLine2f result;
+	result.push_back( Vec2f( x0, y0 ) );
+	result.push_back( Vec2f( x1, y0 ) );
+	result.push_back( Vec2f( x1, y1 ) );
+	result.push_back( Vec2f( x0, y1 ) );
+	return result;
+}
+
+} // anonymous namespace
+
+void DelaunayTestApp::setup()
+{
+	Rand rand( 1 );
+
+	// random points: the hull is convex and every other edge is locally Delaunay
+	vector<Vec2f> points;
+	for( size_t p = 0; p < NUM_POINTS; ++p )
+		points.push_back( Vec2f( rand.nextFloat( -100, 100 ), rand.nextFloat( -100, 100 ) ) );
+	TriMesh2d mesh = DelaunayTriangulator( points ).calcMesh();
+	assert( mesh.getNumVertices() == NUM_POINTS );
+	vector<pair<uint32_t, uint32_t> > hull = checkTriangulation( mesh, 1e-10 );
+	assert( mesh.getNumTriangles() == 2 * NUM_POINTS - hull.size() - 2 );
+	for( size_t h = 0; h < hull.size(); ++h )
+		for( size_t p = 0; p < NUM_POINTS; ++p )
+			assert( calcArea( points[hull[h].first], points[hull[h].second], points[p] ) >= 0 );
+
+	// a grid, where each square's four corners are cocircular and its rows collinear, added twice so every point has a duplicate
+	vector<Vec2f> grid;
+	for( int y = 0; y < GRID_SIZE; ++y )
+		for( int x = 0; x < GRID_SIZE; ++x )
+			grid.push_back( Vec2f( x, y ) );
+	DelaunayTriangulator gridTriangulator( grid );
+	gridTriangulator.addPoints( grid );
+	mesh = gridTriangulator.calcMesh();
+	assert( mesh.getNumVertices() == grid.size() * 2 );
+	assert( mesh.getNumTriangles() == 2 * ( GRID_SIZE - 1 ) * ( GRID_SIZE - 1 ) );
+	checkTriangulation( mesh, 0 );
+	assert( calcTotalArea( mesh ) == ( GRID_SIZE - 1 ) * ( GRID_SIZE - 1 ) );
+
+	// points which are all collinear have no triangles
+	vector<Vec2f> line;
+	for( int p = 0; p < 100; ++p )
+		line.push_back( Vec2f( p * 0.5f, p * 0.25f ) );
+	assert( DelaunayTriangulator( line ).calcMesh().getNumTriangles() == 0 );
+
+	// a square with a square hole, and random points inside it, keeps the outlines as edges and only fills between them
+	Shape2d shape;
+	shape.moveTo( Vec2f( 0, 0 ) ); shape.lineTo( Vec2f( 100, 0 ) ); shape.lineTo( Vec2f( 100, 100 ) ); shape.lineTo( Vec2f( 0, 100 ) ); shape.close();
+	shape.moveTo( Vec2f( 30, 30 ) ); shape.lineTo( Vec2f( 30, 70 ) ); shape.lineTo( Vec2f( 70, 70 ) ); shape.lineTo( Vec2f( 70, 30 ) ); shape.close();
+	DelaunayTriangulator holeTriangulator( shape );
+	vector<Vec2f> interior;
+	for( int p = 0; p < 2000; ++p )
+		interior.push_back( Vec2f( rand.nextFloat( -10, 110 ), rand.nextFloat( -10, 110 ) ) );
+	holeTriangulator.addPoints( interior );
+	mesh = holeTriangulator.calcMesh();
+	assert( math<double>::abs( calcTotalArea( mesh ) - ( 100 * 100 - 40 * 40 ) ) < 1e-6 );
+	assert( hasEdge( mesh, Vec2f( 0, 0 ), Vec2f( 100, 0 ) ) && hasEdge( mesh, Vec2f( 30, 70 ), Vec2f( 70, 70 ) ) );
+	for( size_t t = 0; t < mesh.getNumTriangles(); ++t ) {
+		Vec2f a, b, c;
+		mesh.getTriangleVertices( t, &a, &b, &c );
+		const Vec2f centroid = ( a + b + c ) / 3;
+		assert( centroid.x > 0 && centroid.x < 100 && centroid.y > 0 && centroid.y < 100 && ! ( centroid.x > 30 && centroid.x < 70 && centroid.y > 30 && centroid.y < 70 ) );
+	}
+	assert( findBoundary( mesh ).size() == 8 );
+	// the result matches Triangulator's area, with no slivers along the outlines
+	assert( math<double>::abs( calcTotalArea( Triangulator( shape ).calcMesh() ) - calcTotalArea( mesh ) ) < 1e-6 );
+
+	// outlines which cross are split where they meet, and the winding rule decides which of the regions they form are kept
+	DelaunayTriangulator crossing;
+	crossing.addPolyLine( makeRectangle( 0, 0, 10, 10 ) );
+	crossing.addPolyLine( makeRectangle( 5, 5, 15, 15 ) );
+	mesh = crossing.calcMesh( Triangulator::WINDING_ODD );
+	assert( mesh.getNumVertices() == 10 );
+	assert( math<double>::abs( calcTotalArea( mesh ) - ( 100 + 100 - 2 * 25 ) ) < 1e-6 );
+	assert( math<double>::abs( calcTotalArea( crossing.calcMesh( Triangulator::WINDING_NONZERO ) ) - ( 100 + 100 - 25 ) ) < 1e-6 );
+	assert( math<double>::abs( calcTotalArea( crossing.calcMesh( Triangulator::WINDING_ABS_GEQ_TWO ) ) - 25 ) < 1e-6 );
+
+	// a star whose outline crosses itself, with its points perturbed so that crossings fall off the grid of floats
+	PolyLine2f star;
+	for( int p = 0; p < 7; ++p ) {
+		const float angle = p * 3 * 2 * (float)M_PI / 7;
+		star.push_back( Vec2f( math<float>::cos( angle ), math<float>::sin( angle ) ) * 50 + Vec2f( rand.nextFloat( 0.01f ), rand.nextFloat( 0.01f ) ) );
+	}
+	DelaunayTriangulator starTriangulator( star );
+	mesh = starTriangulator.calcMesh( Triangulator::WINDING_NONZERO );
+	assert( mesh.getNumVertices() == 7 + 14 );
+	checkTriangulation( mesh, numeric_limits<double>::max() );
+	assert( math<double>::abs( calcTotalArea( mesh ) - calcTotalArea( Triangulator( star ).calcMesh( Triangulator::WINDING_NONZERO ) ) ) < 1e-2 );
+
+	vector<Vec2f> benchmark;
+	for( size_t p = 0; p < NUM_BENCHMARK_POINTS; ++p )
+		benchmark.push_back( Vec2f( rand.nextFloat( 1000 ), rand.nextFloat( 1000 ) ) );
+	Timer t( true );
+	mesh = DelaunayTriangulator( benchmark ).calcMesh();
+	console() << "Triangulated " << NUM_BENCHMARK_POINTS << " points in " << t.getSeconds() * 1000 << "ms, " << mesh.getNumTriangles() << " triangles" << std::endl;
+
+	console() << "Tests passed" << std::endl;
+}
+
+void DelaunayTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( DelaunayTestApp, RendererGl )
@@ -1,5 +1,8 @@
 #include "cinder/app/AppBasic.h"
 #include "cinder/Json.h"
+#include "cinder/JsonDoc.h"
+#include "cinder/JsonReader.h"
+#include "cinder/JsonWriter.h"
 #include "Resources.h"
 
 class JsonTestApp : public ci::app::AppBasic 
@@ -17,6 +20,39 @@ using namespace ci;
 using namespace ci::app;
 using namespace std;
 
+// Flattens every token of \a stream into a string, reading \a bufferSize bytes at a time
+string readTokens( IStreamRef stream, size_t bufferSize )
+{
+	JsonReader reader( stream, bufferSize );
+	string result;
+	while( reader.next() != JsonReader::TOKEN_END_OF_DOCUMENT ) {
+		result += toString( reader.getToken() ) + " ";
+		if( reader.getToken() == JsonReader::TOKEN_KEY || reader.getToken() == JsonReader::TOKEN_STRING )
+			result += reader.getString() + " ";
+	}
+	return result;
+}
+
+string writeCompact( const JsonTree &tree )
+{
+	OStreamMemRef stream = OStreamMem::create();
+	{
+		JsonWriter writer( stream, false );
+		writer.write( tree );
+	}
+	return string( static_cast<const char*>( stream->getBuffer() ), static_cast<size_t>( stream->tell() ) );
+}
+
+string writeCompact( const JsonDoc::Value &value )
+{
+	OStreamMemRef stream = OStreamMem::create();
+	{
+		JsonWriter writer( stream, false );
+		writer.write( value );
+	}
+	return string( static_cast<const char*>( stream->getBuffer() ), static_cast<size_t>( stream->tell() ) );
+}
+
 void JsonTestApp::draw()
 {
     gl::clear();
@@ -86,7 +122,117 @@ void JsonTestApp::setup()
 	JsonTree test64( "int64", int64_t( math<int64_t>::pow( 2, 64 ) ) - 1 );
 	console() << test64;
 	console() << test64.getValue() << endl;
-	
+
+	// a Query normalizes brackets and quotes as getChild() does
+	{
+		JsonTree queryDoc( loadResource( RES_JSON ) );
+		JsonTree::Query bracketQuery( "library['albums'][0].tracks[1]['title']" ), dotQuery( "library.albums.0.tracks.1.title" );
+		assert( &queryDoc.getChild( bracketQuery ) == &queryDoc.getChild( dotQuery ) );
+		assert( &queryDoc.getChild( bracketQuery ) == &queryDoc.getChild( "library.albums[0].tracks[1].title" ) );
+		assert( bracketQuery.getPath() == "library['albums'][0].tracks[1]['title']" );
+		assert( ! queryDoc.hasChild( JsonTree::Query( "library.albums[99]" ) ) );
+	}
+
+	// keys match case-insensitively by default, finding the first match, and exactly when asked, both when a node's
+	// children are scanned and when there are enough of them to be indexed
+	for( int indexed = 0; indexed < 2; ++indexed ) {
+		JsonTree object = JsonTree::makeObject();
+		const int numItems = indexed ? 40 : 4;
+		for( int i = 0; i < numItems; ++i )
+			object.pushBack( JsonTree( "Item" + toString( i ), i ) );
+		object.pushBack( JsonTree( "Dup", 100 ) );
+		object.pushBack( JsonTree( "dup", 101 ) );
+
+		JsonTree::Query item3( "item3" ), item3Exact( "item3", true ), item3ExactUpper( "Item3", true );
+		JsonTree::Query dup( "DUP" ), dupExact( "dup", true ), last( toString( numItems + 1 ) );
+		assert( object.getChild( item3 ).getValue<int>() == 3 );
+		assert( ! object.hasChild( item3Exact ) );
+		assert( object.getChild( item3ExactUpper ).getValue<int>() == 3 );
+		assert( object.getChild( dup ).getValue<int>() == 100 );
+		assert( object.getChild( dupExact ).getValue<int>() == 101 );
+		assert( object.getChild( last ).getValue<int>() == 101 );
+		if( ! indexed )
+			continue;
+
+		// the index follows every change to the children, including a child being assigned a new key
+		JsonTree::Query added( "added" ), afterLast( toString( numItems + 2 ) ), item0( "Item0" ), first( "0" );
+		object.pushBack( JsonTree( "Added", 200 ) );
+		assert( object.getChild( added ).getValue<int>() == 200 );
+		assert( object.getChild( afterLast ).getValue<int>() == 200 );
+
+		object.removeChild( 0 );
+		assert( ! object.hasChild( item0 ) );
+		assert( object.getChild( first ).getValue<int>() == 1 );
+
+		JsonTree::Query item5( "item5" ), replaced( "replaced" );
+		assert( object.getChild( item5 ).getValue<int>() == 5 );
+		object.replaceChild( 4, JsonTree( "Replaced", 300 ) );
+		assert( ! object.hasChild( item5 ) );
+		assert( object.getChild( replaced ).getValue<int>() == 300 );
+
+		JsonTree::Query item9( "item9" ), renamed( "renamed" );
+		assert( object.getChild( item9 ).getValue<int>() == 9 );
+		object.getChild( item9 ) = JsonTree( "Renamed", 400 );
+		assert( ! object.hasChild( item9 ) );
+		assert( object.getChild( renamed ).getValue<int>() == 400 );
+		assert( object.getChild( JsonTree::Query( "8" ) ).getValue<int>() == 400 );
+	}
+
+	JsonDocRef arenaDoc = JsonDoc::create( loadResource( RES_JSON ) );
+	JsonDoc::Value arenaTracks = arenaDoc->getRoot()["library"]["albums"][0]["tracks"];
+	for( size_t i = 0; i < arenaTracks.size(); ++i )
+		console() << arenaTracks[i]["id"].getInt() << ": " << arenaTracks[i]["title"].getCString() << endl;
+	console() << arenaDoc->toJsonTree();
+
+	// stream every title out of the document, skipping the rest unparsed
+	JsonReader reader( loadResource( RES_JSON )->createStream(), 16 );
+	while( reader.next() != JsonReader::TOKEN_END_OF_DOCUMENT ) {
+		if( reader.getToken() == JsonReader::TOKEN_KEY ) {
+			if( reader.getString() == "title" ) {
+				reader.next();
+				console() << "title: " << reader.getString() << endl;
+			}
+			else if( reader.getString() == "musician" )
+				reader.skip();
+		}
+	}
+
+	// a file read through a buffer smaller than the file stream's own ends where the file does, whatever the buffer size
+	{
+		Buffer json( loadResource( RES_JSON ) );
+		const string expected = readTokens( IStreamMem::create( json.getData(), json.getDataSize() ), json.getDataSize() + 16 );
+		const fs::path path = getTemporaryDirectory() / "JsonTest.json";
+		writeFileStream( path )->writeData( json.getData(), json.getDataSize() );
+		const size_t bufferSizes[] = { 16, 17, 100, 1000, 2048, 4096 };
+		for( size_t i = 0; i < sizeof(bufferSizes) / sizeof(bufferSizes[0]); ++i )
+			assert( readTokens( loadFileStream( path ), bufferSizes[i] ) == expected );
+		fs::remove( path );
+	}
+
+	// JsonWriter keeps members in insertion order, breaks lines with "\n" and writes empty containers as {} and []
+	JsonTree ordered = JsonTree::makeObject();
+	ordered.pushBack( JsonTree( "zebra", 1 ) );
+	ordered.pushBack( JsonTree( "apple", string( "a\"b\n" ) ) );
+	ordered.pushBack( JsonTree::makeObject( "emptyObject" ) );
+	ordered.pushBack( JsonTree::makeArray( "emptyArray" ) );
+	assert( writeCompact( ordered ) == "{\"zebra\":1,\"apple\":\"a\\\"b\\n\",\"emptyObject\":{},\"emptyArray\":[]}\n" );
+	assert( ordered.serialize() == "{\n   \"zebra\" : 1,\n   \"apple\" : \"a\\\"b\\n\",\n   \"emptyObject\" : {},\n   \"emptyArray\" : []\n}\n" );
+
+	// keys and strings with embedded nulls are written whole
+	JsonDocRef nullsDoc = JsonDoc::create( string( "{\"a\\u0000b\":[1,2.5,\"c\\u0000d\",{}],\"e\":null}" ) );
+	assert( nullsDoc->getRoot().getKeyLength( 0 ) == 3 );
+	assert( writeCompact( nullsDoc->getRoot() ) == "{\"a\\u0000b\":[1,2.5,\"c\\u0000d\",{}],\"e\":null}\n" );
+
+	// unbalanced calls are rejected
+	bool threw = false;
+	try {
+		JsonWriter writer( OStreamMem::create() );
+		writer.startObject().value( 1 );
+	}
+	catch( JsonWriter::ExcInvalidState & ) {
+		threw = true;
+	}
+	assert( threw );
 }
 
 void JsonTestApp::mouseDown( MouseEvent event )
@@ -0,0 +1,112 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/KdTree.h"
+#include "cinder/Rand.h"
+#include "cinder/Timer.h"
+
+#include <algorithm>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Checks KdTree's nearest and k nearest neighbor searches, one at a time and in batches, against testing every point,
+// and reports how fast a tree over a million points builds and answers batches of queries
+class KdTreeTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const size_t	NUM_POINTS = 20000;
+const size_t	NUM_BENCHMARK_POINTS = 1000000;
+const size_t	K = 8;
+
+template<typename T>
+vector<float> findKNearestAll( const vector<T> &points, const T &point, size_t k )
+{
+	vector<float> result;
+	for( size_t p = 0; p < points.size(); ++p )
+		result.push_back( points[p].distanceSquared( point ) );
+	sort( result.begin(), result.end() );
+	result.resize( min( k, result.size() ) );
+	return result;
+}
+
+template<typename T>
+void checkKNearest( const KdTree<T, sizeof(T) / sizeof(float)> &tree, const vector<T> &points, const vector<T> &queries )
+{
+	vector<uint32_t> indices, batchIndices;
+	vector<float> distances, batchDistances;
+	tree.findKNearest( queries, K, &batchIndices, &batchDistances );
+	assert( batchIndices.size() == queries.size() * K && batchDistances.size() == queries.size() * K );
+	for( size_t q = 0; q < queries.size(); ++q ) {
+		tree.findKNearest( queries[q], K, &indices, &distances );
+		assert( distances == findKNearestAll( points, queries[q], K ) );
+		for( size_t n = 0; n < K; ++n ) {
+			assert( points[indices[n]].distanceSquared( queries[q] ) == distances[n] );
+			assert( batchIndices[q * K + n] == indices[n] && batchDistances[q * K + n] == distances[n] );
+		}
+	}
+}
+
+} // anonymous namespace
+
+void KdTreeTestApp::setup()
+{
+	Rand rand( 1 );
+	vector<Vec3f> points, queries;
+	for( size_t p = 0; p < NUM_POINTS; ++p )
+		points.push_back( rand.nextVec3f() * rand.nextFloat( 2 ) - Vec3f( 0.5f, 0.5f, 0.5f ) );
+	for( int q = 0; q < 500; ++q )
+		queries.push_back( ( q % 2 ) ? points[rand.nextInt( NUM_POINTS )] : rand.nextVec3f() * 3 );
+
+	KdTree<Vec3f> tree( points );
+	checkKNearest( tree, points, queries );
+
+	// the single nearest neighbor agrees with the k nearest
+	vector<uint32_t> indices;
+	vector<float> distances;
+	for( size_t q = 0; q < queries.size(); ++q ) {
+		float p[3] = { queries[q].x, queries[q].y, queries[q].z }, nearest[3];
+		uint32_t index;
+		tree.findNearest( p, nearest, &index );
+		tree.findKNearest( queries[q], 1, &indices, &distances );
+		assert( points[index].distanceSquared( queries[q] ) == distances[0] );
+	}
+
+	// asking for more neighbors than there are points returns all of them
+	tree.findKNearest( Vec3f::zero(), NUM_POINTS * 2, &indices );
+	sort( indices.begin(), indices.end() );
+	assert( indices.size() == NUM_POINTS && indices.front() == 0 && indices.back() == NUM_POINTS - 1 && unique( indices.begin(), indices.end() ) == indices.end() );
+
+	vector<Vec2f> points2d, queries2d;
+	for( size_t p = 0; p < NUM_POINTS; ++p )
+		points2d.push_back( rand.nextVec2f() * rand.nextFloat( 2 ) );
+	for( int q = 0; q < 500; ++q )
+		queries2d.push_back( rand.nextVec2f() * 3 );
+	KdTree<Vec2f, 2> tree2d( points2d );
+	checkKNearest( tree2d, points2d, queries2d );
+
+	vector<Vec3f> benchmark;
+	for( size_t p = 0; p < NUM_BENCHMARK_POINTS; ++p )
+		benchmark.push_back( rand.nextVec3f() * rand.nextFloat() );
+	Timer t( true );
+	KdTree<Vec3f> benchmarkTree( benchmark );
+	console() << "Built over " << NUM_BENCHMARK_POINTS << " points in " << t.getSeconds() * 1000 << "ms" << std::endl;
+
+	t.start();
+	benchmarkTree.findKNearest( benchmark, K, &indices );
+	console() << "Batch of " << K << " nearest: " << benchmark.size() / t.getSeconds() / 1e6 << "M queries/s" << std::endl;
+
+	console() << "Tests passed" << std::endl;
+}
+
+void KdTreeTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( KdTreeTestApp, RendererGl )
@@ -0,0 +1,140 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/ObjLoader.h"
+#include "cinder/Timer.h"
+#include "cinder/Utilities.h"
+
+#include <boost/tuple/tuple_comparison.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <new>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Times ObjLoader parsing and ObjLoader::load() on a generated million-vertex grid, and compares the vertex deduplication
+// against the std::map it replaced. Peak heap usage is tracked by replacing the global operator new and delete.
+class ObjLoaderBenchmarkApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const int GRID_SIZE = 1000;
+
+// the loader allocates from TaskPool threads too
+std::atomic<size_t> sHeapBytes( 0 ), sPeakHeapBytes( 0 );
+
+void resetPeak()
+{
+	sPeakHeapBytes = sHeapBytes.load();
+}
+
+// heap growth beyond \a baseline since the last resetPeak(), in megabytes
+double peakMegabytes( size_t baseline )
+{
+	return ( sPeakHeapBytes - baseline ) / ( 1024.0 * 1024.0 );
+}
+
+fs::path writeGridObj()
+{
+	fs::path path = getTemporaryDirectory() / "ObjLoaderBenchmark.obj";
+	ofstream out( path.string().c_str(), ios::binary );
+	for( int y = 0; y < GRID_SIZE; ++y )
+		for( int x = 0; x < GRID_SIZE; ++x )
+			out << "v " << x * 0.01f << " " << math<float>::sin( x * 0.1f ) * math<float>::cos( y * 0.1f ) << " " << y * 0.01f << "\n";
+	for( int y = 0; y < GRID_SIZE; ++y )
+		for( int x = 0; x < GRID_SIZE; ++x )
+			out << "vt " << x / (float)GRID_SIZE << " " << y / (float)GRID_SIZE << "\n";
+	for( int y = 0; y < GRID_SIZE; ++y )
+		for( int x = 0; x < GRID_SIZE; ++x )
+			out << "vn 0 1 0\n";
+	for( int y = 0; y < GRID_SIZE - 1; ++y ) {
+		for( int x = 0; x < GRID_SIZE - 1; ++x ) {
+			int a = y * GRID_SIZE + x + 1, b = a + 1, c = a + GRID_SIZE, d = c + 1;
+			out << "f " << a << "/" << a << "/" << a << " " << b << "/" << b << "/" << b << " " << d << "/" << d << "/" << d << "\n";
+			out << "f " << a << "/" << a << "/" << a << " " << d << "/" << d << "/" << d << " " << c << "/" << c << "/" << c << "\n";
+		}
+	}
+	return path;
+}
+
+// the lookup the loader used before, over the same faces
+size_t dedupWithMap( const ObjLoader &loader )
+{
+	map<boost::tuple<int,int,int>,int> uniqueVerts;
+	for( vector<ObjLoader::Group>::const_iterator groupIt = loader.getGroups().begin(); groupIt != loader.getGroups().end(); ++groupIt )
+		for( vector<ObjLoader::Face>::const_iterator faceIt = groupIt->mFaces.begin(); faceIt != groupIt->mFaces.end(); ++faceIt )
+			for( int v = 0; v < faceIt->mNumVertices; ++v )
+				uniqueVerts.insert( make_pair( boost::make_tuple( faceIt->mVertexIndices[v], faceIt->mTexCoordIndices[v], faceIt->mNormalIndices[v] ), (int)uniqueVerts.size() ) );
+	return uniqueVerts.size();
+}
+
+} // anonymous namespace
+
+void* operator new( size_t size )
+{
+	size_t *block = static_cast<size_t*>( malloc( size + sizeof(size_t) * 2 ) );
+	if( ! block )
+		throw std::bad_alloc();
+	block[0] = size;
+	size_t heapBytes = sHeapBytes += size;
+	size_t peak = sPeakHeapBytes.load();
+	while( heapBytes > peak && ! sPeakHeapBytes.compare_exchange_weak( peak, heapBytes ) )
+		;
+	return block + 2;
+}
+
+void operator delete( void *p ) throw()
+{
+	if( ! p )
+		return;
+	size_t *block = static_cast<size_t*>( p ) - 2;
+	sHeapBytes -= block[0];
+	free( block );
+}
+
+void ObjLoaderBenchmarkApp::setup()
+{
+	fs::path path = writeGridObj();
+	Timer t;
+
+	size_t baseline = sHeapBytes;
+	resetPeak();
+	t.start();
+	ObjLoader loader( loadFile( path ) );
+	t.stop();
+	console() << "parse: " << t.getSeconds() << "s, peak " << peakMegabytes( baseline ) << " MB" << std::endl;
+
+	const char *modeNames[] = { "positions", "positions + normals", "positions + texCoords", "positions + normals + texCoords" };
+	for( int mode = 0; mode < 4; ++mode ) {
+		TriMesh mesh;
+		baseline = sHeapBytes;
+		resetPeak();
+		t.start();
+		loader.load( &mesh, ( mode & 1 ) != 0, ( mode & 2 ) != 0 );
+		t.stop();
+		console() << "load() " << modeNames[mode] << ": " << t.getSeconds() << "s, peak " << peakMegabytes( baseline ) << " MB, " << mesh.getNumVertices() << " vertices" << std::endl;
+	}
+
+	baseline = sHeapBytes;
+	resetPeak();
+	t.start();
+	size_t numUnique = dedupWithMap( loader );
+	t.stop();
+	console() << "std::map deduplication alone: " << t.getSeconds() << "s, peak " << peakMegabytes( baseline ) << " MB, " << numUnique << " vertices" << std::endl;
+
+	fs::remove( path );
+}
+
+void ObjLoaderBenchmarkApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( ObjLoaderBenchmarkApp, RendererGl )
@@ -0,0 +1,321 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/ObjLoader.h"
+#include "cinder/Rand.h"
+#include "cinder/Utilities.h"
+
+#include <sstream>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Checks that ObjLoader's chunked parallel parser matches a line-at-a-time serial parser on files spanning many chunks
+class ObjLoaderTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+// The serial parser ObjLoader used before it parsed in parallel chunks, kept as a reference
+struct ReferenceObj {
+	struct Face {
+		vector<int>		mVertexIndices, mTexCoordIndices, mNormalIndices;
+		string			mMaterial;
+	};
+
+	struct Group {
+		Group() : mBaseVertexOffset( 0 ), mBaseTexCoordOffset( 0 ), mBaseNormalOffset( 0 ), mHasTexCoords( false ), mHasNormals( false ) {}
+
+		string			mName;
+		int				mBaseVertexOffset, mBaseTexCoordOffset, mBaseNormalOffset;
+		vector<Face>	mFaces;
+		bool			mHasTexCoords, mHasNormals;
+	};
+
+	ReferenceObj( const string &obj, bool includeUVs );
+
+	void	parseFace( Group *group, const string &material, const string &s, bool includeUVs );
+
+	vector<Vec3f>	mVertices, mNormals;
+	vector<Vec2f>	mTexCoords;
+	vector<Group>	mGroups;
+};
+
+ReferenceObj::ReferenceObj( const string &obj, bool includeUVs )
+{
+	mGroups.push_back( Group() );
+	Group *currentGroup = &mGroups.back();
+	string currentMaterial;
+
+	for( size_t p = 0; p < obj.size(); ) {
+		size_t lineEnd = obj.find_first_of( "\r\n", p );
+		if( lineEnd == string::npos )
+			lineEnd = obj.size();
+		string line = obj.substr( p, lineEnd - p ), tag;
+		p = lineEnd + 1;
+		if( lineEnd < obj.size() && obj[lineEnd] == '\r' && p < obj.size() && obj[p] == '\n' )
+			++p;
+		if( line.empty() || line[0] == '#' )
+			continue;
+
+		stringstream ss( line );
+		ss >> tag;
+		if( tag == "v" ) {
+			Vec3f v;
+			ss >> v.x >> v.y >> v.z;
+			mVertices.push_back( v );
+		}
+		else if( tag == "vt" ) {
+			if( includeUVs ) {
+				Vec2f tex;
+				ss >> tex.x >> tex.y;
+				mTexCoords.push_back( tex );
+			}
+		}
+		else if( tag == "vn" ) {
+			Vec3f v;
+			ss >> v.x >> v.y >> v.z;
+			mNormals.push_back( v.normalized() );
+		}
+		else if( tag == "f" )
+			parseFace( currentGroup, currentMaterial, line, includeUVs );
+		else if( tag == "g" ) {
+			if( ! currentGroup->mFaces.empty() )
+				mGroups.push_back( Group() );
+			currentGroup = &mGroups.back();
+			currentGroup->mBaseVertexOffset = (int)mVertices.size();
+			currentGroup->mBaseTexCoordOffset = (int)mTexCoords.size();
+			currentGroup->mBaseNormalOffset = (int)mNormals.size();
+			currentGroup->mName = line.substr( line.find( ' ' ) + 1 );
+		}
+		else if( tag == "usemtl" ) { // an unknown material leaves the current one in place
+			string name;
+			ss >> name;
+			if( name == "red" || name == "blue" )
+				currentMaterial = name;
+		}
+	}
+}
+
+void ReferenceObj::parseFace( Group *group, const string &material, const string &s, bool includeUVs )
+{
+	Face result;
+	result.mMaterial = material;
+	size_t offset = 2;
+	while( offset < s.length() ) {
+		while( s[offset] == ' ' )
+			++offset;
+		size_t endOfTriple = s.find( ' ', offset );
+		if( endOfTriple == string::npos )
+			endOfTriple = s.length();
+		size_t firstSlash = s.find( '/', offset ), secondSlash = string::npos;
+		if( firstSlash > endOfTriple )
+			firstSlash = string::npos;
+		if( firstSlash != string::npos ) {
+			secondSlash = s.find( '/', firstSlash + 1 );
+			if( secondSlash > endOfTriple )
+				secondSlash = string::npos;
+		}
+
+		int vertexIndex = fromString<int>( s.substr( offset, ( ( firstSlash != string::npos ) ? firstSlash : endOfTriple ) - offset ) );
+		result.mVertexIndices.push_back( ( vertexIndex < 0 ) ? ( group->mBaseVertexOffset + vertexIndex ) : ( vertexIndex - 1 ) );
+
+		if( includeUVs && firstSlash != string::npos ) {
+			size_t numSize = ( ( secondSlash == string::npos ) ? endOfTriple : secondSlash ) - firstSlash - 1;
+			if( numSize > 0 ) {
+				int texCoordIndex = fromString<int>( s.substr( firstSlash + 1, numSize ) );
+				result.mTexCoordIndices.push_back( ( texCoordIndex < 0 ) ? ( group->mBaseTexCoordOffset + texCoordIndex ) : ( texCoordIndex - 1 ) );
+				if( group->mFaces.empty() )
+					group->mHasTexCoords = true;
+			}
+			else
+				group->mHasTexCoords = false;
+		}
+		else if( group->mFaces.empty() )
+			group->mHasTexCoords = false;
+
+		if( secondSlash != string::npos ) {
+			int normalIndex = fromString<int>( s.substr( secondSlash + 1, endOfTriple - secondSlash - 1 ) );
+			result.mNormalIndices.push_back( ( normalIndex < 0 ) ? ( group->mBaseNormalOffset + normalIndex ) : ( normalIndex - 1 ) );
+			group->mHasNormals = true;
+		}
+		else if( group->mFaces.empty() )
+			group->mHasNormals = false;
+
+		offset = endOfTriple + 1;
+	}
+	group->mFaces.push_back( result );
+}
+
+string makeNumber( Rand &rand )
+{
+	return toString( rand.nextInt( -100000, 100000 ) / 1000.0f );
+}
+
+// Writes about \a numGroups groups mixing every face format, relative indices, materials, comments and line endings
+string makeObj( int numGroups, uint32_t seed )
+{
+	static const char *endings[] = { "\n", "\r\n", "\r" };
+	Rand rand( seed );
+	string result = "# generated\nmtllib test.mtl\n";
+	// every "v" has a "vt" and "vn", so one count serves all three; relative indices count back from the last "g" line
+	int numVertices = 0, base = 0;
+	for( int g = 0; g < numGroups; ++g ) {
+		const char *eol = endings[rand.nextInt( 3 )];
+		if( rand.nextInt( 4 ) ) {
+			result += "g group" + toString( g ) + ( rand.nextBool() ? " with spaces" : "" ) + eol;
+			base = numVertices;
+		}
+		if( rand.nextInt( 3 ) == 0 ) {
+			result += "g empty" + toString( g ) + eol; // a group line with no faces before the next one
+			base = numVertices;
+		}
+		if( rand.nextBool() )
+			result += string( "usemtl " ) + ( rand.nextBool() ? "red" : ( rand.nextBool() ? "blue" : "missing" ) ) + eol;
+
+		int groupVertices = rand.nextInt( 3, 60 );
+		for( int v = 0; v < groupVertices; ++v ) {
+			result += "v " + makeNumber( rand ) + " " + makeNumber( rand ) + " " + makeNumber( rand ) + eol;
+			result += "vt " + makeNumber( rand ) + " " + makeNumber( rand ) + eol;
+			result += "vn " + makeNumber( rand ) + " " + makeNumber( rand ) + " " + makeNumber( rand ) + eol;
+		}
+		numVertices += groupVertices;
+		if( rand.nextInt( 5 ) == 0 )
+			result += string( "# comment" ) + eol + eol;
+
+		// the format is mostly consistent within a group, with the occasional odd face
+		int format = rand.nextInt( 4 );
+		for( int f = rand.nextInt( 1, 80 ); f > 0; --f ) {
+			int faceFormat = rand.nextInt( 10 ) ? format : rand.nextInt( 4 );
+			bool relative = base > 0 && rand.nextInt( 3 ) == 0;
+			result += "f";
+			for( int n = rand.nextInt( 3, 6 ); n > 0; --n ) {
+				string i = toString( relative ? -rand.nextInt( 1, base + 1 ) : rand.nextInt( 1, numVertices + 1 ) );
+				switch( faceFormat ) {
+					case 0: result += " " + i; break;
+					case 1: result += " " + i + "/" + i; break;
+					case 2: result += " " + i + "//" + i; break;
+					default: result += " " + i + "/" + i + "/" + i; break;
+				}
+			}
+			result += eol;
+		}
+	}
+	return result;
+}
+
+DataSourceRef makeSource( const string &s )
+{
+	Buffer buffer( s.size() );
+	memcpy( buffer.getData(), s.c_str(), s.size() );
+	return DataSourceBuffer::create( buffer );
+}
+
+bool near( const Vec3f &a, const Vec3f &b )
+{
+	return a.distance( b ) <= 1e-3f;
+}
+
+bool near( const Vec2f &a, const Vec2f &b )
+{
+	return a.distance( b ) <= 1e-3f;
+}
+
+void testMatchesReference( const string &obj, bool includeUVs )
+{
+	const string mtl = "newmtl red\nKd 1 0 0\nnewmtl blue\nKd 0 0 1\n";
+	ObjLoader loader( makeSource( obj ), makeSource( mtl ), includeUVs );
+	ReferenceObj reference( obj, includeUVs );
+
+	const vector<ObjLoader::Group> &groups = loader.getGroups();
+	assert( groups.size() == reference.mGroups.size() );
+	for( size_t g = 0; g < groups.size(); ++g ) {
+		const ObjLoader::Group &group = groups[g];
+		const ReferenceObj::Group &expected = reference.mGroups[g];
+		assert( group.mName == expected.mName );
+		assert( group.mBaseVertexOffset == expected.mBaseVertexOffset );
+		assert( group.mBaseTexCoordOffset == expected.mBaseTexCoordOffset );
+		assert( group.mBaseNormalOffset == expected.mBaseNormalOffset );
+		assert( group.mHasTexCoords == expected.mHasTexCoords );
+		assert( group.mHasNormals == expected.mHasNormals );
+		assert( group.mFaces.size() == expected.mFaces.size() );
+		for( size_t f = 0; f < group.mFaces.size(); ++f ) {
+			const ObjLoader::Face &face = group.mFaces[f];
+			assert( face.mNumVertices == (int)expected.mFaces[f].mVertexIndices.size() );
+			assert( face.mVertexIndices == expected.mFaces[f].mVertexIndices );
+			assert( face.mTexCoordIndices == expected.mFaces[f].mTexCoordIndices );
+			assert( face.mNormalIndices == expected.mFaces[f].mNormalIndices );
+			const string &material = expected.mFaces[f].mMaterial;
+			assert( material.empty() ? ( face.mMaterial == 0 ) : ( face.mMaterial && face.mMaterial->mName == material ) );
+		}
+
+		// the attributes behind the indices, by way of an unoptimized load of groups whose faces have them all
+		if( ! ( group.mHasTexCoords && group.mHasNormals ) )
+			continue;
+		bool complete = true;
+		for( size_t f = 0; f < expected.mFaces.size(); ++f )
+			complete = complete && expected.mFaces[f].mTexCoordIndices.size() == expected.mFaces[f].mVertexIndices.size()
+				&& expected.mFaces[f].mNormalIndices.size() == expected.mFaces[f].mVertexIndices.size();
+		if( ! complete )
+			continue;
+		TriMesh mesh;
+		loader.load( g, &mesh, true, true, false );
+		size_t vertex = 0;
+		for( size_t f = 0; f < expected.mFaces.size(); ++f ) {
+			for( size_t v = 0; v < expected.mFaces[f].mVertexIndices.size(); ++v, ++vertex ) {
+				assert( near( mesh.getVertices()[vertex], reference.mVertices[expected.mFaces[f].mVertexIndices[v]] ) );
+				assert( near( mesh.getNormals()[vertex], reference.mNormals[expected.mFaces[f].mNormalIndices[v]] ) );
+				Vec2f texCoord = reference.mTexCoords[expected.mFaces[f].mTexCoordIndices[v]];
+				assert( near( mesh.getTexCoords()[vertex], Vec2f( texCoord.x, 1.0f - texCoord.y ) ) );
+			}
+		}
+		assert( vertex == mesh.getNumVertices() );
+	}
+}
+
+bool throwsInvalidIndex( const string &obj, bool includeUVs )
+{
+	try {
+		ObjLoader loader( makeSource( obj ), includeUVs );
+	}
+	catch( ObjLoaderExcInvalidIndex & ) {
+		return true;
+	}
+	return false;
+}
+
+void ObjLoaderTestApp::setup()
+{
+	// a handful of groups parse as a single chunk; thousands span several chunks, splitting groups between them
+	string small = makeObj( 20, 1 ), large = makeObj( 3000, 2 );
+	assert( large.size() > 4 * 1024 * 1024 );
+	for( int includeUVs = 0; includeUVs < 2; ++includeUVs ) {
+		testMatchesReference( small, includeUVs != 0 );
+		testMatchesReference( large, includeUVs != 0 );
+	}
+
+	// a file without a trailing newline, and one without faces
+	testMatchesReference( "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3", true );
+	testMatchesReference( "v 0 0 0\ng lonely\n", true );
+	testMatchesReference( "", true );
+
+	// faces may reference vertices defined after them, but not ones which are never defined
+	testMatchesReference( "f 1 2 3\nv 0 0 0\nv 1 0 0\nv 0 1 0\n", true );
+	assert( throwsInvalidIndex( "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n", true ) );
+	assert( throwsInvalidIndex( "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 0 1 2\n", true ) );
+	assert( throwsInvalidIndex( "v 0 0 0\nv 1 0 0\nv 0 1 0\nf -1 -2 -3\n", true ) ); // relative to the start of the unnamed group
+	assert( throwsInvalidIndex( "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nf 1/1 2/1 3/2\n", true ) );
+	assert( throwsInvalidIndex( "v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf 1//1 2//1 3//9\n", true ) );
+	// texture coordinates are not parsed at all without UVs
+	assert( ! throwsInvalidIndex( "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1/7 2/8 3/9\n", false ) );
+
+	console() << "Tests passed" << std::endl;
+}
+
+void ObjLoaderTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( ObjLoaderTestApp, RendererGl )
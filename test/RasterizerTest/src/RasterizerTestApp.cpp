@@ -0,0 +1,155 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Rasterizer.h"
+#include "cinder/ip/Fill.h"
+#include "cinder/svg/Svg.h"
+#include "cinder/svg/SvgSurface.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+class RasterizerTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+struct CoverageFn {
+	CoverageFn( vector<float> *coverage, int32_t width ) : mCoverage( coverage ), mWidth( width ) {}
+	void operator()( int32_t x, int32_t y, int32_t count, const float *coverage ) const
+	{
+		for( int32_t i = 0; i < count; ++i )
+			(*mCoverage)[y * mWidth + x + i] = coverage[i];
+	}
+
+	vector<float>	*mCoverage;
+	int32_t			mWidth;
+};
+
+vector<float> rasterize( const Rasterizer &rasterizer, Triangulator::Winding winding = Triangulator::WINDING_NONZERO )
+{
+	vector<float> result( rasterizer.getWidth() * rasterizer.getHeight(), 0.0f );
+	rasterizer.rasterize( CoverageFn( &result, rasterizer.getWidth() ), winding );
+	return result;
+}
+
+bool near( float a, float b, float epsilon = 1e-4f )
+{
+	return math<float>::abs( a - b ) <= epsilon;
+}
+
+void addRect( Rasterizer *rasterizer, float x0, float y0, float x1, float y1 )
+{
+	Vec2f points[] = { Vec2f( x0, y0 ), Vec2f( x1, y0 ), Vec2f( x1, y1 ), Vec2f( x0, y1 ) };
+	rasterizer->addPolygon( points, 4 );
+}
+
+DataSourceRef makeSource( const std::string &s )
+{
+	Buffer buffer( s.size() );
+	memcpy( buffer.getData(), s.c_str(), s.size() );
+	return DataSourceBuffer::create( buffer );
+}
+
+void RasterizerTestApp::setup()
+{
+	// partial coverage of an axis-aligned rectangle is its area within each pixel
+	{
+		Rasterizer rasterizer( 6, 5 );
+		addRect( &rasterizer, 1.25f, 1, 3.5f, 3 );
+		vector<float> c = rasterize( rasterizer );
+		const float expected[] = { 0, 0.75f, 1, 0.5f, 0, 0 };
+		for( int y = 0; y < 5; ++y )
+			for( int x = 0; x < 6; ++x )
+				assert( near( c[y * 6 + x], ( y == 1 || y == 2 ) ? expected[x] : 0 ) );
+	}
+
+	// the total coverage of a polygon crossing many pixels diagonally is its area, in either orientation
+	for( int orientation = 0; orientation < 2; ++orientation ) {
+		Vec2f points[] = { Vec2f( 2.3f, 1.7f ), Vec2f( 27.1f, 5.2f ), Vec2f( 11.6f, 29.4f ) };
+		if( orientation )
+			std::swap( points[0], points[2] );
+		Rasterizer rasterizer( 32, 32 );
+		rasterizer.addPolygon( points, 3 );
+		vector<float> c = rasterize( rasterizer );
+		float sum = 0;
+		for( size_t i = 0; i < c.size(); ++i ) {
+			assert( c[i] >= 0 && c[i] <= 1 );
+			sum += c[i];
+		}
+		float area = math<float>::abs( ( points[1] - points[0] ).cross( points[2] - points[0] ) ) / 2;
+		assert( near( sum, area, 0.01f ) );
+	}
+
+	// nested squares: same orientation fills the hole only under nonzero, opposite orientation never does
+	for( int opposite = 0; opposite < 2; ++opposite ) {
+		Rasterizer rasterizer( 10, 10 );
+		addRect( &rasterizer, 1, 1, 9, 9 );
+		if( opposite )
+			addRect( &rasterizer, 7, 3, 3, 7 );
+		else
+			addRect( &rasterizer, 3, 3, 7, 7 );
+		vector<float> nonzero = rasterize( rasterizer, Triangulator::WINDING_NONZERO ), odd = rasterize( rasterizer, Triangulator::WINDING_ODD );
+		assert( near( nonzero[2 * 10 + 2], 1 ) && near( odd[2 * 10 + 2], 1 ) );
+		assert( near( nonzero[5 * 10 + 5], opposite ? 0.0f : 1.0f ) );
+		assert( near( odd[5 * 10 + 5], 0 ) );
+		assert( near( nonzero[0], 0 ) && near( odd[0], 0 ) );
+		// addRect() runs clockwise on screen, which winds negatively
+		vector<float> positive = rasterize( rasterizer, Triangulator::WINDING_POSITIVE ), negative = rasterize( rasterizer, Triangulator::WINDING_NEGATIVE );
+		vector<float> twice = rasterize( rasterizer, Triangulator::WINDING_ABS_GEQ_TWO );
+		assert( near( positive[2 * 10 + 2], 0 ) && near( negative[2 * 10 + 2], 1 ) && near( twice[2 * 10 + 2], 0 ) );
+		assert( near( positive[5 * 10 + 5], 0 ) && near( negative[5 * 10 + 5], opposite ? 0.0f : 1.0f ) && near( twice[5 * 10 + 5], opposite ? 0.0f : 1.0f ) );
+	}
+
+	// outlines beyond the bounds are clipped, and area to the left of the image still counts
+	{
+		Rasterizer rasterizer( 4, 4 );
+		addRect( &rasterizer, -10, -10, 2.5f, 20 );
+		vector<float> c = rasterize( rasterizer );
+		for( int y = 0; y < 4; ++y ) {
+			assert( near( c[y * 4 + 0], 1 ) && near( c[y * 4 + 1], 1 ) && near( c[y * 4 + 2], 0.5f ) && near( c[y * 4 + 3], 0 ) );
+		}
+	}
+
+	// fill() composites premultiplied color through the coverage
+	{
+		Surface8u surface( 4, 4, true );
+		ip::fill( &surface, ColorA8u( 0, 0, 0, 0 ) );
+		surface.setPremultiplied( true );
+		Rasterizer rasterizer( 4, 4 );
+		addRect( &rasterizer, 0, 0, 2.5f, 4 );
+		rasterizer.fill( &surface, ColorA( 1, 0, 0, 1 ) );
+		assert( surface.getPixel( Vec2i( 0, 0 ) ) == ColorA8u( 255, 0, 0, 255 ) );
+		ColorA8u half = surface.getPixel( Vec2i( 2, 1 ) );
+		assert( half.r >= 127 && half.r <= 128 && half.a == half.r && half.g == 0 );
+		assert( surface.getPixel( Vec2i( 3, 3 ) ).a == 0 );
+	}
+
+	// a group with opacity composites everything its children drew, including children far apart
+	{
+		svg::DocRef doc = svg::Doc::create( makeSource(
+			"<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"40\" height=\"20\">"
+			"<g opacity=\"0.5\"><rect x=\"0\" y=\"0\" width=\"10\" height=\"10\" fill=\"#ff0000\"/>"
+			"<rect x=\"30\" y=\"10\" width=\"10\" height=\"10\" fill=\"#0000ff\"/></g>"
+			"<rect x=\"15\" y=\"0\" width=\"10\" height=\"20\" fill=\"none\" stroke=\"#00ff00\" stroke-width=\"4\"/>"
+			"</svg>" ) );
+		Surface8u surface = svg::renderToSurface( *doc );
+		ColorA8u red = surface.getPixel( Vec2i( 5, 5 ) ), blue = surface.getPixel( Vec2i( 35, 15 ) );
+		assert( red.r >= 126 && red.r <= 129 && red.a == red.r && red.b == 0 );
+		assert( blue.b >= 126 && blue.b <= 129 && blue.a == blue.b && blue.r == 0 );
+		assert( surface.getPixel( Vec2i( 35, 5 ) ).a == 0 );
+		// the stroke straddles the outline: opaque on it, empty well inside it
+		assert( surface.getPixel( Vec2i( 15, 10 ) ) == ColorA8u( 0, 255, 0, 255 ) );
+		assert( surface.getPixel( Vec2i( 20, 10 ) ).a == 0 );
+	}
+
+	console() << "Tests passed" << std::endl;
+}
+
+void RasterizerTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( RasterizerTestApp, RendererGl )
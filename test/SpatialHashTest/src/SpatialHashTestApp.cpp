@@ -0,0 +1,145 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/SpatialHash.h"
+#include "cinder/KdTree.h"
+#include "cinder/Rand.h"
+#include "cinder/Timer.h"
+
+#include <algorithm>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Checks SpatialHash's radius and nearest neighbor queries against testing every point, as the points move between
+// rebuilds, and reports how long rebuilding a million points takes next to building a KdTree over them
+class SpatialHashTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const size_t	NUM_POINTS = 20000;
+const size_t	NUM_BENCHMARK_POINTS = 1000000;
+const float		RADIUS = 0.05f;
+const size_t	K = 10;
+
+// clusters of points, so that some cells are crowded and most are empty
+vector<Vec3f> makePoints( Rand &rand, size_t numPoints )
+{
+	vector<Vec3f> result;
+	for( size_t p = 0; p < numPoints; ++p ) {
+		const Vec3f cluster = Vec3f( (float)( p % 7 ), (float)( p % 5 ), (float)( p % 3 ) ) * 0.3f;
+		result.push_back( cluster + rand.nextVec3f() * rand.nextFloat( 0.2f ) );
+	}
+	return result;
+}
+
+void findInRadiusAll( const vector<Vec3f> &points, const Vec3f &center, float radius, vector<uint32_t> *result )
+{
+	result->clear();
+	for( size_t p = 0; p < points.size(); ++p )
+		if( points[p].distanceSquared( center ) < radius * radius )
+			result->push_back( (uint32_t)p );
+}
+
+vector<float> findKNearestAll( const vector<Vec3f> &points, const Vec3f &point, size_t k )
+{
+	vector<float> result;
+	for( size_t p = 0; p < points.size(); ++p )
+		result.push_back( points[p].distanceSquared( point ) );
+	sort( result.begin(), result.end() );
+	result.resize( min( k, result.size() ) );
+	return result;
+}
+
+void checkQueries( const SpatialHash &hash, const vector<Vec3f> &points, Rand &rand )
+{
+	vector<uint32_t> found, expected;
+	vector<float> distances;
+	for( int i = 0; i < 200; ++i ) {
+		// query around points and at random, including far outside the points
+		const Vec3f center = ( i % 2 ) ? points[rand.nextInt( (int)points.size() )] : rand.nextVec3f() * rand.nextFloat( 4 );
+		const float radius = ( i % 10 == 0 ) ? 1.5f : RADIUS;
+		hash.findInRadius( center, radius, &found );
+		findInRadiusAll( points, center, radius, &expected );
+		sort( found.begin(), found.end() );
+		assert( found == expected );
+
+		const size_t k = ( i % 20 == 0 ) ? points.size() + 1 : K;
+		hash.findKNearest( center, k, &found, &distances );
+		assert( distances == findKNearestAll( points, center, k ) );
+		assert( found.size() == distances.size() );
+		for( size_t n = 0; n < found.size(); ++n )
+			assert( points[found[n]].distanceSquared( center ) == distances[n] );
+	}
+}
+
+} // anonymous namespace
+
+void SpatialHashTestApp::setup()
+{
+	Rand rand( 1 );
+	vector<Vec3f> points = makePoints( rand, NUM_POINTS );
+	SpatialHash hash( points, RADIUS );
+	assert( hash.getNumPoints() == NUM_POINTS );
+	checkQueries( hash, points, rand );
+
+	// the same hash follows the points as they drift, and a few scatter far away
+	for( int frame = 0; frame < 3; ++frame ) {
+		for( size_t p = 0; p < points.size(); ++p )
+			points[p] += rand.nextVec3f() * 0.01f;
+		points[frame] = Vec3f( 1000.0f * ( frame + 1 ), -50, 3 );
+		hash.build( points );
+		checkQueries( hash, points, rand );
+	}
+
+	// a hash with cells far smaller than the points' spacing still finds neighbors
+	hash.setCellSize( 0.001f );
+	hash.build( points );
+	checkQueries( hash, points, rand );
+
+	hash.build( vector<Vec3f>() );
+	vector<uint32_t> found;
+	hash.findKNearest( Vec3f::zero(), K, &found );
+	assert( hash.getNumPoints() == 0 && found.empty() );
+
+	vector<Vec3f> benchmark = makePoints( rand, NUM_BENCHMARK_POINTS );
+	hash.setCellSize( 0.01f );
+	hash.build( benchmark );
+	Timer t( true );
+	for( int frame = 0; frame < 10; ++frame )
+		hash.build( benchmark );
+	console() << "SpatialHash rebuild of " << NUM_BENCHMARK_POINTS << " points: " << t.getSeconds() * 100 << "ms" << std::endl;
+	// enough points to be split into chunks across threads, whose groups still come out in order
+	vector<uint32_t> expected;
+	for( int i = 0; i < 20; ++i ) {
+		const Vec3f &center = benchmark[rand.nextInt( (int)benchmark.size() )];
+		hash.findInRadius( center, 0.02f, &found );
+		findInRadiusAll( benchmark, center, 0.02f, &expected );
+		sort( found.begin(), found.end() );
+		assert( found == expected );
+	}
+	t.start();
+	KdTree<Vec3f> kdTree( benchmark );
+	console() << "KdTree build: " << t.getSeconds() * 1000 << "ms" << std::endl;
+
+	t.start();
+	size_t numFound = 0;
+	for( size_t p = 0; p < benchmark.size(); p += 10 ) {
+		hash.findInRadius( benchmark[p], 0.01f, &found );
+		numFound += found.size();
+	}
+	console() << "Radius queries: " << benchmark.size() / 10 / t.getSeconds() / 1e6 << "M queries/s, " << numFound * 10.0 / benchmark.size() << " points each" << std::endl;
+
+	console() << "Tests passed" << std::endl;
+}
+
+void SpatialHashTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( SpatialHashTestApp, RendererGl )
@@ -0,0 +1,232 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/svg/Svg.h"
+#include "cinder/svg/SvgRenderList.h"
+#include "cinder/svg/SvgSurface.h"
+#include "cinder/svg/SvgNodeIndex.h"
+#include "cinder/Xml.h"
+#include "cinder/TaskPool.h"
+#include "cinder/Timer.h"
+#include "cinder/Rand.h"
+#include "cinder/Utilities.h"
+
+#include <fstream>
+#include <algorithm>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Times svg::Doc construction and traversal over a corpus of large SVGs. The corpus is any .svg files in the directory
+// passed on the command line, plus generated map-like documents with many top-level groups of dense path data.
+class SvgBenchmarkApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const int NUM_ITERATIONS = 5;
+
+string makeNumber( Rand &rand )
+{
+	return toString( rand.nextFloat( -1000, 1000 ) );
+}
+
+string makePathData( Rand &rand )
+{
+	string result = "M" + makeNumber( rand ) + "," + makeNumber( rand );
+	for( int i = rand.nextInt( 10, 200 ); i > 0; --i ) {
+		switch( rand.nextInt( 4 ) ) {
+			case 0: result += "L" + makeNumber( rand ) + " " + makeNumber( rand ); break;
+			case 1: result += "l" + makeNumber( rand ) + "," + makeNumber( rand ); break;
+			case 2: result += "C" + makeNumber( rand ) + " " + makeNumber( rand ) + " " + makeNumber( rand ) + " " + makeNumber( rand ) + " " + makeNumber( rand ) + " " + makeNumber( rand ); break;
+			default: result += "q" + makeNumber( rand ) + "," + makeNumber( rand ) + "," + makeNumber( rand ) + "," + makeNumber( rand ); break;
+		}
+	}
+	return result + "z";
+}
+
+fs::path writeMapSvg( int numGroups, uint32_t seed )
+{
+	fs::path path = getTemporaryDirectory() / ( "SvgBenchmark" + toString( numGroups ) + ".svg" );
+	ofstream out( path.string().c_str(), ios::binary );
+	Rand rand( seed );
+	out << "<?xml version=\"1.0\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"1000\" height=\"800\" viewBox=\"0 0 1000 800\">\n";
+	for( int g = 0; g < numGroups; ++g ) {
+		out << "<g id=\"region" << g << "\" transform=\"translate(" << makeNumber( rand ) << " " << makeNumber( rand ) << ")\">\n";
+		// a gradient renders nothing itself and should never be indexed or hit
+		out << "<linearGradient id=\"shade" << g << "\"><stop offset=\"0\" stop-color=\"#000000\"/><stop offset=\"1\" stop-color=\"#ffffff\"/></linearGradient>\n";
+		for( int n = rand.nextInt( 20, 80 ); n > 0; --n ) {
+			if( rand.nextInt( 4 ) )
+				out << "<path d=\"" << makePathData( rand ) << "\" style=\"fill:#3a6ea5;stroke:none\"/>\n";
+			else {
+				out << "<polygon fill=\"#c0c0c0\" points=\"";
+				for( int p = rand.nextInt( 10, 200 ); p > 0; --p )
+					out << makeNumber( rand ) << "," << makeNumber( rand ) << " ";
+				out << "\"/>\n";
+			}
+		}
+		out << "</g>\n";
+	}
+	out << "</svg>\n";
+	return path;
+}
+
+DataSourceRef makeSource( const std::string &s )
+{
+	Buffer buffer( s.size() );
+	memcpy( buffer.getData(), s.c_str(), s.size() );
+	return DataSourceBuffer::create( buffer );
+}
+
+// Checks that the NodeIndex leaves out Nodes which are not rendered
+void testNodeIndexVisibility()
+{
+	svg::DocRef doc = svg::Doc::create( makeSource(
+		"<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"100\" height=\"100\">"
+		"<rect id=\"shown\" x=\"0\" y=\"0\" width=\"100\" height=\"100\"/>"
+		"<linearGradient id=\"gradient\"><stop offset=\"0\" stop-color=\"#000000\"/></linearGradient>"
+		"<rect id=\"hidden\" x=\"0\" y=\"0\" width=\"50\" height=\"50\" visibility=\"hidden\"/>"
+		"<g display=\"none\"><rect id=\"undisplayed\" x=\"0\" y=\"0\" width=\"50\" height=\"50\"/></g>"
+		"<g visibility=\"hidden\"><rect id=\"revealed\" x=\"50\" y=\"50\" width=\"50\" height=\"50\" visibility=\"visible\"/></g>"
+		"</svg>" ) );
+	vector<svg::Node*> all = doc->findNodesIntersecting( Rectf( -1000, -1000, 1000, 1000 ) );
+	assert( all.size() == 2 && all[0]->getId() == "shown" && all[1]->getId() == "revealed" );
+	vector<svg::Node*> hits = doc->findNodesAt( Vec2f( 25, 25 ) );
+	assert( hits.size() == 1 && hits[0]->getId() == "shown" );
+	hits = doc->findNodesAt( Vec2f( 75, 75 ) );
+	assert( hits.size() == 2 && hits[0]->getId() == "revealed" );
+}
+
+} // anonymous namespace
+
+void SvgBenchmarkApp::setup()
+{
+	testNodeIndexVisibility();
+
+	vector<fs::path> corpus, generated;
+	if( getArgs().size() > 1 && fs::is_directory( getArgs()[1] ) ) {
+		for( fs::directory_iterator it( getArgs()[1] ); it != fs::directory_iterator(); ++it )
+			if( it->path().extension() == ".svg" )
+				corpus.push_back( it->path() );
+	}
+	generated.push_back( writeMapSvg( 100, 1 ) );
+	generated.push_back( writeMapSvg( 2000, 2 ) );
+	corpus.insert( corpus.end(), generated.begin(), generated.end() );
+
+	console() << "TaskPool threads: " << TaskPool::getDefault().getNumThreads() << std::endl;
+	for( vector<fs::path>::const_iterator pathIt = corpus.begin(); pathIt != corpus.end(); ++pathIt ) {
+		Buffer buffer( loadFile( *pathIt ) );
+		double megabytes = buffer.getDataSize() / ( 1024.0 * 1024.0 );
+		Timer t;
+
+		// XML parsing alone, to separate it from node construction
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			XmlTree xml( DataSourceBuffer::create( buffer ), XmlTree::ParseOptions().ignoreDataChildren( false ) );
+		t.stop();
+		double xmlSeconds = t.getSeconds() / NUM_ITERATIONS;
+
+		size_t numChildren = 0;
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i ) {
+			svg::DocRef doc = svg::Doc::create( DataSourceBuffer::create( buffer ), *pathIt );
+			numChildren = doc->getChildren().size();
+		}
+		t.stop();
+		double docSeconds = t.getSeconds() / NUM_ITERATIONS;
+
+		console() << pathIt->filename() << ": " << megabytes << " MB, " << numChildren << " top-level nodes" << std::endl;
+		console() << " XmlTree: " << xmlSeconds << "s (" << ( megabytes / xmlSeconds ) << " MB/s)" << std::endl;
+		console() << " svg::Doc: " << docSeconds << "s (" << ( megabytes / docSeconds ) << " MB/s), " << ( docSeconds - xmlSeconds ) << "s building nodes" << std::endl;
+
+		// per-frame traversal cost, walking the tree versus replaying a compiled svg::RenderList, into a Renderer that draws nothing
+		svg::DocRef doc = svg::Doc::create( DataSourceBuffer::create( buffer ), *pathIt );
+		svg::Renderer nullRenderer;
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			doc->render( nullRenderer );
+		t.stop();
+		double treeSeconds = t.getSeconds() / NUM_ITERATIONS;
+
+		t.start();
+		svg::RenderList renderList( *doc );
+		t.stop();
+		double compileSeconds = t.getSeconds();
+
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			renderList.render( nullRenderer );
+		t.stop();
+		double listSeconds = t.getSeconds() / NUM_ITERATIONS;
+
+		double updateSeconds = 0;
+		if( ! doc->getChildren().empty() ) {
+			svg::Node *node = doc->getChildren().back();
+			t.start();
+			for( int i = 0; i < NUM_ITERATIONS; ++i ) {
+				node->setTransform( MatrixAffine2f::makeRotate( i * 0.1f ) );
+				renderList.invalidate( *node );
+				renderList.update();
+			}
+			t.stop();
+			updateSeconds = t.getSeconds() / NUM_ITERATIONS;
+		}
+
+		console() << " render: tree " << treeSeconds << "s, RenderList " << listSeconds << "s (" << renderList.getItems().size() << " items, compiled in " << compileSeconds << "s, " << updateSeconds << "s to update one top-level node)" << std::endl;
+
+		// software rasterization into a Surface8u
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			svg::renderToSurface( *doc );
+		t.stop();
+		console() << " renderToSurface(): " << ( t.getSeconds() / NUM_ITERATIONS ) << "s at " << doc->getSize() << std::endl;
+
+		// hit testing, walking the tree versus querying the Doc's NodeIndex
+		const int NUM_HIT_TESTS = 100;
+		Rand rand( 3 );
+		vector<Vec2f> points;
+		for( int i = 0; i < NUM_HIT_TESTS; ++i )
+			points.push_back( Vec2f( rand.nextFloat( (float)doc->getWidth() ), rand.nextFloat( (float)doc->getHeight() ) ) );
+		t.start();
+		for( int i = 0; i < NUM_HIT_TESTS; ++i )
+			doc->nodeUnderPoint( points[i] );
+		t.stop();
+		double treeHitSeconds = t.getSeconds() / NUM_HIT_TESTS;
+
+		t.start();
+		doc->getNodeIndex();
+		t.stop();
+		double indexSeconds = t.getSeconds();
+
+		t.start();
+		for( int i = 0; i < NUM_HIT_TESTS; ++i )
+			doc->findNodesAt( points[i] );
+		t.stop();
+		// the generated documents have no hidden Nodes, so the index must agree with walking the tree
+		if( find( generated.begin(), generated.end(), *pathIt ) != generated.end() ) {
+			for( int i = 0; i < NUM_HIT_TESTS; ++i ) {
+				vector<svg::Node*> hits = doc->findNodesAt( points[i] );
+				assert( ( hits.empty() ? 0 : hits.front() ) == doc->nodeUnderPoint( points[i] ) );
+			}
+			vector<svg::Node*> all = doc->findNodesIntersecting( doc->getNodeIndex().getBounds() );
+			assert( all.size() == doc->getNodeIndex().getNumNodes() );
+			for( size_t n = 0; n < all.size(); ++n )
+				assert( ! dynamic_cast<svg::Gradient*>( all[n] ) );
+		}
+
+		console() << " hit test: nodeUnderPoint() " << treeHitSeconds << "s, findNodesAt() " << ( t.getSeconds() / NUM_HIT_TESTS ) << "s (" << doc->getNodeIndex().getNumNodes() << " nodes indexed in " << indexSeconds << "s)" << std::endl;
+	}
+
+	for( vector<fs::path>::const_iterator pathIt = generated.begin(); pathIt != generated.end(); ++pathIt )
+		fs::remove( *pathIt );
+}
+
+void SvgBenchmarkApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( SvgBenchmarkApp, RendererGl )
@@ -0,0 +1,278 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/svg/Svg.h"
+#include "cinder/svg/SvgRenderList.h"
+#include "cinder/Rand.h"
+
+#include <sstream>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Modifies nodes of a document, including ones instantiated by <use>, and checks that svg::RenderList::update() gives the
+// same Items, paints and geometry as compiling the document afresh, and that RenderList::render() makes the same draw
+// calls in the same state as walking the tree with Node::render()
+class SvgRenderListTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const char *DOCUMENT =
+	"<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"200\" height=\"200\">"
+	"<g id=\"template\" transform=\"translate(10,10)\" fill=\"#ff0000\">"
+		"<circle id=\"dot\" cx=\"5\" cy=\"5\" r=\"4\"/>"
+		"<path id=\"wave\" d=\"M0 0 C 10 20 20 -20 30 0 Z\" stroke=\"#0000ff\" stroke-width=\"2\"/>"
+	"</g>"
+	"<use id=\"use1\" xlink:href=\"#template\" transform=\"translate(50,0) scale(2)\"/>"
+	"<use id=\"use2\" xlink:href=\"#template\" transform=\"rotate(30)\" opacity=\"0.5\"/>"
+	"<g id=\"layer\" opacity=\"0.7\" stroke=\"#00ff00\">"
+		"<rect id=\"box\" x=\"0\" y=\"0\" width=\"20\" height=\"10\" fill-opacity=\"0.3\"/>"
+		"<g id=\"inner\" fill-rule=\"evenodd\" stroke-linecap=\"round\">"
+			"<polygon id=\"star\" points=\"50,0 61,35 98,35 68,57 79,91 50,70 21,91 32,57 2,35 39,35\"/>"
+			"<ellipse id=\"ellipse\" cx=\"30\" cy=\"40\" rx=\"20\" ry=\"8\" stroke-opacity=\"0.4\"/>"
+			"<line id=\"line\" x1=\"0\" y1=\"0\" x2=\"40\" y2=\"30\" stroke-linejoin=\"bevel\"/>"
+			"<polyline id=\"polyline\" points=\"0,0 10,20 20,5 30,25\" fill=\"none\"/>"
+		"</g>"
+		"<g id=\"hidden\" visibility=\"hidden\"><rect id=\"hiddenRect\" x=\"5\" y=\"5\" width=\"5\" height=\"5\"/></g>"
+		"<rect id=\"gone\" x=\"1\" y=\"1\" width=\"3\" height=\"3\" display=\"none\"/>"
+	"</g>"
+	"</svg>";
+
+const char *MODIFIABLE[] = { "template", "dot", "wave", "use1", "use2", "layer", "box", "inner", "star", "ellipse", "line", "polyline", "hidden", "hiddenRect", "gone" };
+
+DataSourceRef makeSource( const std::string &s )
+{
+	Buffer buffer( s.size() );
+	memcpy( buffer.getData(), s.c_str(), s.size() );
+	return DataSourceBuffer::create( buffer );
+}
+
+bool samePaint( const svg::Paint &a, const svg::Paint &b )
+{
+	if( a.mType != b.mType || a.mStops.size() != b.mStops.size() )
+		return false;
+	for( size_t s = 0; s < a.mStops.size(); ++s )
+		if( a.mStops[s].first != b.mStops[s].first || ! ( a.mStops[s].second == b.mStops[s].second ) )
+			return false;
+	return true;
+}
+
+void checkSameItems( const svg::RenderList &updated, const svg::RenderList &fresh )
+{
+	const vector<svg::RenderList::Item> &items = updated.getItems(), &freshItems = fresh.getItems();
+	assert( items.size() == freshItems.size() );
+	for( size_t i = 0; i < items.size(); ++i ) {
+		const svg::RenderList::Item &a = items[i], &b = freshItems[i];
+		assert( a.mNode == b.mNode && a.mType == b.mType && a.mSubtreeSize == b.mSubtreeSize );
+		if( a.mType == svg::RenderList::SKIPPED || a.mType == svg::RenderList::USE )
+			continue;
+		assert( a.mTransform == b.mTransform );
+		assert( samePaint( updated.getPaints()[a.mFill], fresh.getPaints()[b.mFill] ) );
+		assert( samePaint( updated.getPaints()[a.mStroke], fresh.getPaints()[b.mStroke] ) );
+		assert( a.mFillOpacity == b.mFillOpacity && a.mStrokeOpacity == b.mStrokeOpacity && a.mStrokeWidth == b.mStrokeWidth );
+		assert( a.mFillRule == b.mFillRule && a.mLineCap == b.mLineCap && a.mLineJoin == b.mLineJoin );
+		assert( a.mType != svg::RenderList::GROUP || a.mGroupOpacity == b.mGroupOpacity );
+
+		assert( a.mNumContours == b.mNumContours );
+		for( uint32_t c = 0; c < a.mNumContours; ++c ) {
+			const svg::RenderList::Contour &contourA = updated.getContours()[a.mFirstContour + c], &contourB = fresh.getContours()[b.mFirstContour + c];
+			assert( contourA.mNumPoints == contourB.mNumPoints );
+			for( uint32_t p = 0; p < contourA.mNumPoints; ++p )
+				assert( updated.getPoints()[contourA.mFirstPoint + p] == fresh.getPoints()[contourB.mFirstPoint + p] );
+		}
+		assert( a.mNumFillVertices == b.mNumFillVertices );
+		for( uint32_t v = 0; v < a.mNumFillVertices; ++v )
+			assert( updated.getFillVertices()[a.mFirstFillVertex + v] == fresh.getFillVertices()[b.mFirstFillVertex + v] );
+	}
+}
+
+// Logs each group and each draw call along with the state in effect for it
+class RecordingRenderer : public svg::Renderer {
+  public:
+	RecordingRenderer()
+	{
+		mMatrices.push_back( MatrixAffine2f::identity() );
+		mFills.push_back( svg::Style::getFillDefault() );
+		mStrokes.push_back( svg::Style::getStrokeDefault() );
+		mFillOpacities.push_back( svg::Style::getFillOpacityDefault() );
+		mStrokeOpacities.push_back( svg::Style::getStrokeOpacityDefault() );
+		mStrokeWidths.push_back( svg::Style::getStrokeWidthDefault() );
+		mFillRules.push_back( svg::Style::getFillRuleDefault() );
+		mLineCaps.push_back( svg::Style::getLineCapDefault() );
+		mLineJoins.push_back( svg::Style::getLineJoinDefault() );
+	}
+
+	struct Call {
+		string				mName;
+		const void			*mNode;
+		float				mGroupOpacity;
+		MatrixAffine2f		mMatrix;
+		svg::Paint			mFill, mStroke;
+		float				mFillOpacity, mStrokeOpacity, mStrokeWidth;
+		svg::FillRule		mFillRule;
+		svg::LineCap		mLineCap;
+		svg::LineJoin		mLineJoin;
+	};
+
+	void	pushGroup( const svg::Group &group, float opacity ) { record( "pushGroup", &group, opacity ); }
+	void	popGroup() { record( "popGroup", 0 ); }
+	void	drawPath( const svg::Path &path ) { record( "drawPath", &path ); }
+	void	drawPolyline( const svg::Polyline &polyline ) { record( "drawPolyline", &polyline ); }
+	void	drawPolygon( const svg::Polygon &polygon ) { record( "drawPolygon", &polygon ); }
+	void	drawLine( const svg::Line &line ) { record( "drawLine", &line ); }
+	void	drawRect( const svg::Rect &rect ) { record( "drawRect", &rect ); }
+	void	drawCircle( const svg::Circle &circle ) { record( "drawCircle", &circle ); }
+	void	drawEllipse( const svg::Ellipse &ellipse ) { record( "drawEllipse", &ellipse ); }
+
+	void	pushMatrix( const MatrixAffine2f &m ) { mMatrices.push_back( mMatrices.back() * m ); }
+	void	popMatrix() { mMatrices.pop_back(); }
+	void	pushFill( const svg::Paint &paint ) { mFills.push_back( paint ); }
+	void	popFill() { mFills.pop_back(); }
+	void	pushStroke( const svg::Paint &paint ) { mStrokes.push_back( paint ); }
+	void	popStroke() { mStrokes.pop_back(); }
+	void	pushFillOpacity( float opacity ) { mFillOpacities.push_back( opacity ); }
+	void	popFillOpacity() { mFillOpacities.pop_back(); }
+	void	pushStrokeOpacity( float opacity ) { mStrokeOpacities.push_back( opacity ); }
+	void	popStrokeOpacity() { mStrokeOpacities.pop_back(); }
+	void	pushStrokeWidth( float width ) { mStrokeWidths.push_back( width ); }
+	void	popStrokeWidth() { mStrokeWidths.pop_back(); }
+	void	pushFillRule( svg::FillRule rule ) { mFillRules.push_back( rule ); }
+	void	popFillRule() { mFillRules.pop_back(); }
+	void	pushLineCap( svg::LineCap lineCap ) { mLineCaps.push_back( lineCap ); }
+	void	popLineCap() { mLineCaps.pop_back(); }
+	void	pushLineJoin( svg::LineJoin lineJoin ) { mLineJoins.push_back( lineJoin ); }
+	void	popLineJoin() { mLineJoins.pop_back(); }
+
+	vector<Call>	mCalls;
+
+  private:
+	void	record( const string &name, const void *node, float groupOpacity = 0 )
+	{
+		Call call = { name, node, groupOpacity, mMatrices.back(), mFills.back(), mStrokes.back(), mFillOpacities.back(), mStrokeOpacities.back(),
+			mStrokeWidths.back(), mFillRules.back(), mLineCaps.back(), mLineJoins.back() };
+		mCalls.push_back( call );
+	}
+
+	vector<MatrixAffine2f>	mMatrices;
+	vector<svg::Paint>		mFills, mStrokes;
+	vector<float>			mFillOpacities, mStrokeOpacities, mStrokeWidths;
+	vector<svg::FillRule>	mFillRules;
+	vector<svg::LineCap>	mLineCaps;
+	vector<svg::LineJoin>	mLineJoins;
+};
+
+void checkSameCalls( const RecordingRenderer &list, const RecordingRenderer &tree )
+{
+	assert( list.mCalls.size() == tree.mCalls.size() );
+	for( size_t c = 0; c < list.mCalls.size(); ++c ) {
+		const RecordingRenderer::Call &a = list.mCalls[c], &b = tree.mCalls[c];
+		assert( a.mName == b.mName && a.mNode == b.mNode && a.mGroupOpacity == b.mGroupOpacity );
+		if( a.mName == "pushGroup" || a.mName == "popGroup" )
+			continue;
+		assert( a.mMatrix == b.mMatrix );
+		assert( samePaint( a.mFill, b.mFill ) && samePaint( a.mStroke, b.mStroke ) );
+		assert( a.mFillOpacity == b.mFillOpacity && a.mStrokeOpacity == b.mStrokeOpacity && a.mStrokeWidth == b.mStrokeWidth );
+		assert( a.mFillRule == b.mFillRule && a.mLineCap == b.mLineCap && a.mLineJoin == b.mLineJoin );
+	}
+}
+
+void checkRender( const svg::RenderList &renderList, const svg::Doc &doc )
+{
+	RecordingRenderer list, tree;
+	renderList.render( list );
+	doc.render( tree );
+	assert( ! list.mCalls.empty() );
+	checkSameCalls( list, tree );
+}
+
+svg::Node* findNode( svg::Doc &doc, const string &id )
+{
+	svg::Node *result = const_cast<svg::Node*>( doc.findNode( id ) );
+	assert( result );
+	return result;
+}
+
+} // anonymous namespace
+
+void SvgRenderListTestApp::setup()
+{
+	svg::DocRef doc = svg::Doc::create( makeSource( DOCUMENT ) );
+	svg::RenderList renderList( *doc );
+	checkSameItems( renderList, svg::RenderList( *doc ) );
+	checkRender( renderList, *doc );
+
+	// the template is drawn itself and by both uses, with its children in each
+	const svg::Node *dot = doc->findNode( "dot" );
+	size_t dotItems = 0;
+	for( size_t i = 0; i < renderList.getItems().size(); ++i )
+		if( renderList.getItems()[i].mNode == dot )
+			++dotItems;
+	assert( dotItems == 3 );
+
+	Rand rand( 1 );
+	const size_t numModifiable = sizeof(MODIFIABLE) / sizeof(MODIFIABLE[0]);
+	size_t maxPaints = 0;
+	for( int round = 0; round < 300; ++round ) {
+		// a few nodes change each round, and the change to a node under a use reaches every instance of it
+		const int numChanges = rand.nextInt( 1, 4 );
+		for( int change = 0; change < numChanges; ++change ) {
+			svg::Node *node = findNode( *doc, MODIFIABLE[rand.nextInt( (int)numModifiable )] );
+			svg::Style style = node->getStyle();
+			switch( rand.nextInt( 6 ) ) {
+				case 0:
+					node->setTransform( MatrixAffine2f::makeTranslate( rand.nextVec2f() * 10 ) * MatrixAffine2f::makeScale( Vec2f( rand.nextFloat( 0.2f, 4 ), rand.nextFloat( 0.2f, 4 ) ) ) );
+				break;
+				case 1:
+					style.setFill( svg::Paint( ColorA8u( rand.nextInt( 256 ), rand.nextInt( 256 ), rand.nextInt( 256 ), 255 ) ) );
+				break;
+				case 2:
+					style.setStrokeWidth( rand.nextFloat( 0.5f, 5 ) );
+					style.setFillRule( rand.nextBool() ? svg::FILL_RULE_NONZERO : svg::FILL_RULE_EVENODD );
+				break;
+				case 3:
+					style.setOpacity( rand.nextFloat() );
+				break;
+				case 4:
+					style.setDisplayNone( ! style.isDisplayNone() );
+				break;
+				case 5:
+					style.setVisible( ! node->isVisible() );
+				break;
+			}
+			node->setStyle( style );
+			renderList.invalidate( *node );
+		}
+
+		// reordering a group's children changes the layout of its subtree
+		if( round % 7 == 0 ) {
+			svg::Group *inner = dynamic_cast<svg::Group*>( findNode( *doc, "inner" ) );
+			list<svg::Node*> &children = inner->getChildren();
+			children.push_back( children.front() );
+			children.pop_front();
+			renderList.invalidate( *inner );
+		}
+
+		assert( renderList.isDirty() );
+		renderList.update();
+		assert( ! renderList.isDirty() );
+		checkSameItems( renderList, svg::RenderList( *doc ) );
+		checkRender( renderList, *doc );
+		maxPaints = std::max( maxPaints, renderList.getPaints().size() );
+	}
+	// the geometry and paints left behind by recompiled subtrees are reclaimed from time to time
+	assert( maxPaints < 300 );
+	console() << renderList.getItems().size() << " items, " << renderList.getPoints().size() << " points, at most " << maxPaints << " paints" << std::endl;
+
+	console() << "Tests passed" << std::endl;
+}
+
+void SvgRenderListTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( SvgRenderListTestApp, RendererGl )
@@ -0,0 +1,145 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/TriMesh.h"
+#include "cinder/Timer.h"
+#include "cinder/Utilities.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Round-trips a generated grid through both TriMesh file versions, checks that damaged version 2 files are rejected,
+// and compares reading each version against mapping with TriMeshView
+class TriMeshBinaryTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const int GRID_SIZE = 1500;
+
+TriMesh makeGrid( int size, bool colors )
+{
+	TriMesh result;
+	for( int y = 0; y < size; ++y ) {
+		for( int x = 0; x < size; ++x ) {
+			result.appendVertex( Vec3f( x * 0.01f, math<float>::sin( x * 0.1f ) * math<float>::cos( y * 0.1f ), y * 0.01f ) );
+			result.appendNormal( Vec3f( 0, 1, 0 ) );
+			result.appendTexCoord( Vec2f( x, y ) / (float)size );
+			if( colors ) {
+				result.appendColorRgb( Color( x / (float)size, y / (float)size, 0 ) );
+				result.appendColorRgba( ColorA( x / (float)size, y / (float)size, 0, 0.5f ) );
+			}
+		}
+	}
+	for( int y = 0; y < size - 1; ++y ) {
+		for( int x = 0; x < size - 1; ++x ) {
+			uint32_t a = y * size + x;
+			result.appendTriangle( a, a + 1, a + size + 1 );
+			result.appendTriangle( a, a + size + 1, a + size );
+		}
+	}
+	return result;
+}
+
+bool sameMesh( const TriMesh &a, const TriMesh &b, bool colors )
+{
+	return a.getVertices() == b.getVertices() && a.getNormals() == b.getNormals() && a.getTexCoords() == b.getTexCoords() && a.getIndices() == b.getIndices()
+		&& ( ! colors || ( a.getColorsRGB() == b.getColorsRGB() && a.getColorsRGBA() == b.getColorsRGBA() ) );
+}
+
+bool isRejected( const Buffer &file )
+{
+	try {
+		TriMesh mesh;
+		mesh.read( DataSourceBuffer::create( file ) );
+	}
+	catch( TriMeshExcInvalidFile & ) {
+		return true;
+	}
+	return false;
+}
+
+} // anonymous namespace
+
+void TriMeshBinaryTestApp::setup()
+{
+	// small meshes with colors and an index far from its neighbors, in every format
+	TriMesh small = makeGrid( 20, true );
+	small.appendTriangle( 0, 0xFFFFFFFF, 7 );
+	for( int format = 0; format < 3; ++format ) {
+		TriMesh::WriteOptions options = TriMesh::WriteOptions().version( format == 0 ? 1 : 2 ).compressIndices( format == 2 );
+		OStreamMemRef stream = OStreamMem::create();
+		small.write( DataTargetStream::createRef( stream ), options );
+		Buffer file( stream->getBuffer(), static_cast<size_t>( stream->tell() ) );
+		TriMesh result;
+		result.read( DataSourceBuffer::create( file ) );
+		assert( sameMesh( result, small, format != 0 ) );
+		if( format != 0 ) {
+			TriMeshViewRef view = TriMeshView::create( DataSourceBuffer::create( file ), true );
+			assert( view->hasColorsRGB() && view->getNumColorsRGB() == small.getColorsRGB().size() && equal( view->getColorsRGB(), view->getColorsRGB() + view->getNumColorsRGB(), small.getColorsRGB().begin() ) );
+			assert( view->hasColorsRGBA() && view->getNumColorsRGBA() == small.getColorsRGBA().size() && equal( view->getColorsRGBA(), view->getColorsRGBA() + view->getNumColorsRGBA(), small.getColorsRGBA().begin() ) );
+
+			Buffer damaged( file.getDataSize() );
+			damaged.copyFrom( file.getData(), file.getDataSize() );
+			reinterpret_cast<uint8_t*>( damaged.getData() )[file.getDataSize() / 2] ^= 0x10;
+			assert( isRejected( damaged ) );
+			damaged.copyFrom( file.getData(), file.getDataSize() );
+			damaged.setDataSize( file.getDataSize() - 64 );
+			assert( isRejected( damaged ) );
+		}
+	}
+
+	// without options, write() keeps producing version 1 files which older releases can read
+	{
+		OStreamMemRef stream = OStreamMem::create();
+		small.write( DataTargetStream::createRef( stream ) );
+		assert( stream->tell() > 0 && reinterpret_cast<const uint8_t*>( stream->getBuffer() )[0] == 1 );
+	}
+	console() << "Round trips passed" << std::endl;
+
+	TriMesh mesh = makeGrid( GRID_SIZE, false );
+	const fs::path paths[3] = { getTemporaryDirectory() / "TriMeshBinaryTest1.msh", getTemporaryDirectory() / "TriMeshBinaryTest2.msh",
+								getTemporaryDirectory() / "TriMeshBinaryTest2c.msh" };
+	const char *names[3] = { "version 1", "version 2", "version 2, compressed indices" };
+	Timer t;
+	for( int format = 0; format < 3; ++format ) {
+		t.start();
+		mesh.write( writeFile( paths[format] ), TriMesh::WriteOptions().version( format == 0 ? 1 : 2 ).compressIndices( format == 2 ) );
+		t.stop();
+		console() << names[format] << ": " << fs::file_size( paths[format] ) / ( 1024 * 1024 ) << " MB, write " << t.getSeconds() << "s";
+
+		TriMesh result;
+		t.start();
+		result.read( loadFile( paths[format] ) );
+		t.stop();
+		console() << ", read " << t.getSeconds() << "s";
+		assert( sameMesh( result, mesh, false ) );
+
+		if( format != 0 ) {
+			t.start();
+			TriMeshViewRef view = TriMeshView::create( paths[format] );
+			t.stop();
+			console() << ", view " << t.getSeconds() << "s";
+			assert( view->getNumVertices() == mesh.getNumVertices() && equal( view->getIndices(), view->getIndices() + view->getNumIndices(), mesh.getIndices().begin() ) );
+
+			t.start();
+			view = TriMeshView::create( paths[format], true );
+			t.stop();
+			console() << ", view with checksum " << t.getSeconds() << "s";
+		}
+		console() << std::endl;
+	}
+
+	for( int format = 0; format < 3; ++format )
+		fs::remove( paths[format] );
+}
+
+void TriMeshBinaryTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( TriMeshBinaryTestApp, RendererGl )
@@ -0,0 +1,197 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/TriMeshBvh.h"
+#include "cinder/Camera.h"
+#include "cinder/Rand.h"
+#include "cinder/Timer.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Checks TriMeshBvh's ray casts and overlap queries against testing every triangle of a bumpy sphere, and reports how fast
+// it builds and how many camera rays per second it traces one at a time and in packets
+class TriMeshBvhTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const int	NUM_RINGS = 500;
+const int	NUM_SEGMENTS = 1000;
+const int	IMAGE_SIZE = 512;
+const int	TILE_SIZE = 4;
+
+TriMesh makeBumpySphere()
+{
+	TriMesh result;
+	for( int ring = 0; ring <= NUM_RINGS; ++ring ) {
+		const float theta = ring * (float)M_PI / NUM_RINGS;
+		for( int segment = 0; segment < NUM_SEGMENTS; ++segment ) {
+			const float phi = segment * 2 * (float)M_PI / NUM_SEGMENTS;
+			const float radius = 1 + 0.05f * math<float>::sin( theta * 17 ) * math<float>::sin( phi * 23 );
+			result.appendVertex( radius * Vec3f( math<float>::sin( theta ) * math<float>::cos( phi ), math<float>::cos( theta ), math<float>::sin( theta ) * math<float>::sin( phi ) ) );
+		}
+	}
+	for( int ring = 0; ring < NUM_RINGS; ++ring ) {
+		for( int segment = 0; segment < NUM_SEGMENTS; ++segment ) {
+			const uint32_t a = ring * NUM_SEGMENTS + segment, b = ring * NUM_SEGMENTS + ( segment + 1 ) % NUM_SEGMENTS;
+			result.appendTriangle( a, b, b + NUM_SEGMENTS );
+			result.appendTriangle( a, b + NUM_SEGMENTS, a + NUM_SEGMENTS );
+		}
+	}
+	return result;
+}
+
+// the nearest hit in front of the ray's origin by testing every triangle, or the maximum float
+float raycastAll( const TriMesh &mesh, const Ray &ray, uint32_t *triangle )
+{
+	float result = numeric_limits<float>::max();
+	for( size_t t = 0; t < mesh.getNumTriangles(); ++t ) {
+		Vec3f a, b, c;
+		float distance;
+		mesh.getTriangleVertices( t, &a, &b, &c );
+		if( ray.calcTriangleIntersection( a, b, c, &distance ) && distance >= 0 && distance < result ) {
+			result = distance;
+			*triangle = (uint32_t)t;
+		}
+	}
+	return result;
+}
+
+Vec3f closestPointOnSegment( const Vec3f &p, const Vec3f &a, const Vec3f &b )
+{
+	const Vec3f ab = b - a;
+	const float lengthSquared = ab.lengthSquared();
+	return ( lengthSquared > 0 ) ? a + ab * constrain( ( p - a ).dot( ab ) / lengthSquared, 0.0f, 1.0f ) : a;
+}
+
+// the distance from \a p to the triangle: to its projection onto the plane when that lies inside, or else to the nearest edge
+float calcTriangleDistance( const Vec3f &p, const Vec3f &a, const Vec3f &b, const Vec3f &c )
+{
+	const Vec3f normal = ( b - a ).cross( c - a );
+	if( normal.lengthSquared() > 0 ) {
+		const Vec3f projected = p - normal * ( ( p - a ).dot( normal ) / normal.lengthSquared() );
+		if( ( b - a ).cross( projected - a ).dot( normal ) >= 0 && ( c - b ).cross( projected - b ).dot( normal ) >= 0 && ( a - c ).cross( projected - c ).dot( normal ) >= 0 )
+			return p.distance( projected );
+	}
+	return min( min( p.distance( closestPointOnSegment( p, a, b ) ), p.distance( closestPointOnSegment( p, b, c ) ) ), p.distance( closestPointOnSegment( p, c, a ) ) );
+}
+
+// whether anything is left of the triangle after clipping it to each face of \a box in turn, with \a margin added to the box
+bool clipsToBox( const Vec3f &a, const Vec3f &b, const Vec3f &c, const AxisAlignedBox3f &box, float margin )
+{
+	vector<Vec3f> polygon, clipped;
+	polygon.push_back( a ); polygon.push_back( b ); polygon.push_back( c );
+	for( int axis = 0; axis < 3; ++axis ) {
+		for( int side = 0; side < 2; ++side ) {
+			// the signed distance inside the face is positive
+			const float sign = side ? -1.0f : 1.0f, plane = side ? box.getMax()[axis] + margin : box.getMin()[axis] - margin;
+			clipped.clear();
+			for( size_t i = 0; i < polygon.size(); ++i ) {
+				const Vec3f &p = polygon[i], &q = polygon[( i + 1 ) % polygon.size()];
+				const float dp = sign * ( p[axis] - plane ), dq = sign * ( q[axis] - plane );
+				if( dp >= 0 )
+					clipped.push_back( p );
+				if( ( dp >= 0 ) != ( dq >= 0 ) )
+					clipped.push_back( p + ( q - p ) * ( dp / ( dp - dq ) ) );
+			}
+			polygon.swap( clipped );
+			if( polygon.empty() )
+				return false;
+		}
+	}
+	return true;
+}
+
+} // anonymous namespace
+
+void TriMeshBvhTestApp::setup()
+{
+	TriMesh mesh = makeBumpySphere();
+	Timer t( true );
+	TriMeshBvh bvh( mesh );
+	console() << "Built over " << bvh.getNumTriangles() << " triangles in " << t.getSeconds() << "s, " << bvh.getNumNodes() << " nodes" << std::endl;
+
+	Rand rand( 1 );
+	for( int i = 0; i < 200; ++i ) {
+		Ray ray( rand.nextVec3f() * 3, rand.nextVec3f() );
+		ray.setDirection( ( rand.nextVec3f() * 0.5f - ray.getOrigin() ).normalized() );
+		uint32_t triangle = TriMeshBvh::NO_TRIANGLE;
+		const float distance = raycastAll( mesh, ray, &triangle );
+		TriMeshBvh::Hit hit;
+		assert( bvh.raycast( ray, &hit ) == ( triangle != TriMeshBvh::NO_TRIANGLE ) );
+		assert( bvh.raycastAny( ray ) == hit.isHit() );
+		if( hit.isHit() ) {
+			assert( math<float>::abs( hit.mDistance - distance ) < 1e-5f );
+			Vec3f a, b, c;
+			mesh.getTriangleVertices( hit.mTriangle, &a, &b, &c );
+			assert( ( a + ( b - a ) * hit.mU + ( c - a ) * hit.mV ).distance( ray.calcPosition( hit.mDistance ) ) < 1e-4f );
+			assert( ! bvh.raycastAny( ray, hit.mDistance * 0.99f ) );
+		}
+	}
+
+	// overlap queries against clipping every triangle to the box and measuring every triangle's distance from the sphere's center.
+	// Triangles that only graze either shape within rounding may go either way.
+	const float EPSILON = 1e-5f;
+	AxisAlignedBox3f box( Vec3f( 0.2f, 0.5f, -0.3f ), Vec3f( 0.6f, 1.2f, 0.1f ) );
+	Sphere sphere( Vec3f( -0.7f, 0.2f, 0.5f ), 0.3f );
+	vector<uint32_t> inBox = bvh.findTriangles( box ), inSphere = bvh.findTriangles( sphere );
+	for( size_t t = 0; t < mesh.getNumTriangles(); ++t ) {
+		Vec3f a, b, c;
+		mesh.getTriangleVertices( t, &a, &b, &c );
+		const bool foundInBox = binary_search( inBox.begin(), inBox.end(), (uint32_t)t );
+		assert( foundInBox ? clipsToBox( a, b, c, box, EPSILON ) : ! clipsToBox( a, b, c, box, -EPSILON ) );
+		const float distance = calcTriangleDistance( sphere.getCenter(), a, b, c );
+		const bool foundInSphere = binary_search( inSphere.begin(), inSphere.end(), (uint32_t)t );
+		assert( foundInSphere ? distance <= sphere.getRadius() + EPSILON : distance > sphere.getRadius() - EPSILON );
+	}
+	console() << inBox.size() << " triangles in the box, " << inSphere.size() << " in the sphere" << std::endl;
+
+	// rays for each pixel in tiles, so that each packet of consecutive rays is coherent
+	CameraPersp cam( IMAGE_SIZE, IMAGE_SIZE, 60, 0.1f, 10 );
+	cam.lookAt( Vec3f( 0.3f, 0.5f, 1.6f ), Vec3f( 0.2f, 0.3f, 0.5f ) );
+	vector<Ray> rays;
+	for( int tileY = 0; tileY < IMAGE_SIZE; tileY += TILE_SIZE )
+		for( int tileX = 0; tileX < IMAGE_SIZE; tileX += TILE_SIZE )
+			for( int y = tileY; y < tileY + TILE_SIZE; ++y )
+				for( int x = tileX; x < tileX + TILE_SIZE; ++x )
+					rays.push_back( cam.generateRay( ( x + 0.5f ) / IMAGE_SIZE, 1 - ( y + 0.5f ) / IMAGE_SIZE, 1 ) );
+
+	vector<TriMeshBvh::Hit> hits( rays.size() ), packetHits;
+	t.start();
+	for( size_t r = 0; r < rays.size(); ++r )
+		bvh.raycast( rays[r], &hits[r] );
+	t.stop();
+	console() << "Single rays: " << rays.size() / t.getSeconds() / 1e6 << "M rays/s" << std::endl;
+
+	t.start();
+	size_t numHits = bvh.raycast( rays, &packetHits );
+	t.stop();
+	console() << "Packets: " << rays.size() / t.getSeconds() / 1e6 << "M rays/s, " << numHits << " hits" << std::endl;
+	// packets may intersect in a different order of operations, so distances agree only to rounding
+	for( size_t r = 0; r < rays.size(); ++r ) {
+		assert( packetHits[r].isHit() == hits[r].isHit() );
+		if( hits[r].isHit() )
+			assert( math<float>::abs( packetHits[r].mDistance - hits[r].mDistance ) <= 1e-5f * hits[r].mDistance );
+	}
+
+	// everything the camera hits is within its frustum, which sees only part of the sphere
+	vector<uint32_t> visible = bvh.findTriangles( Frustumf( cam ) );
+	assert( visible.size() < mesh.getNumTriangles() );
+	for( size_t r = 0; r < rays.size(); ++r )
+		if( hits[r].isHit() )
+			assert( binary_search( visible.begin(), visible.end(), hits[r].mTriangle ) );
+	console() << visible.size() << " triangles in the frustum" << std::endl;
+
+	console() << "Tests passed" << std::endl;
+}
+
+void TriMeshBvhTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( TriMeshBvhTestApp, RendererGl )
@@ -0,0 +1,100 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/TriMesh.h"
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <functional>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Times TriMesh::recalculateNormals() with each weighting against the serial loop it replaced, and recalculateTangents(),
+// on a generated grid of eight million triangles. The tangent frames are checked for orthonormality.
+class TriMeshNormalsBenchmarkApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const int GRID_SIZE = 2000;
+const int NUM_ITERATIONS = 5;
+
+// the previous implementation of recalculateNormals()
+void recalculateNormalsSerial( TriMesh *mesh )
+{
+	const vector<Vec3f> &vertices = mesh->getVertices();
+	const vector<uint32_t> &indices = mesh->getIndices();
+	vector<Vec3f> &normals = mesh->getNormals();
+	normals.assign( vertices.size(), Vec3f::zero() );
+	for( size_t i = 0; i < mesh->getNumTriangles(); ++i ) {
+		uint32_t index0 = indices[i * 3], index1 = indices[i * 3 + 1], index2 = indices[i * 3 + 2];
+		Vec3f normal = ( vertices[index1] - vertices[index0] ).cross( vertices[index2] - vertices[index0] ).normalized();
+		normals[index0] += normal;
+		normals[index1] += normal;
+		normals[index2] += normal;
+	}
+	std::for_each( normals.begin(), normals.end(), std::mem_fun_ref( &Vec3f::normalize ) );
+}
+
+} // anonymous namespace
+
+void TriMeshNormalsBenchmarkApp::setup()
+{
+	TriMesh mesh;
+	for( int y = 0; y < GRID_SIZE; ++y ) {
+		for( int x = 0; x < GRID_SIZE; ++x ) {
+			mesh.appendVertex( Vec3f( x * 0.01f, math<float>::sin( x * 0.1f ) * math<float>::cos( y * 0.13f ), y * 0.01f ) );
+			mesh.appendTexCoord( Vec2f( x, y ) / (float)GRID_SIZE );
+		}
+	}
+	for( int y = 0; y < GRID_SIZE - 1; ++y ) {
+		for( int x = 0; x < GRID_SIZE - 1; ++x ) {
+			uint32_t a = y * GRID_SIZE + x;
+			mesh.appendTriangle( a, a + GRID_SIZE + 1, a + 1 );
+			mesh.appendTriangle( a, a + GRID_SIZE, a + GRID_SIZE + 1 );
+		}
+	}
+	console() << mesh.getNumTriangles() << " triangles" << std::endl;
+
+	TriMesh serial = mesh;
+	Timer t( true );
+	for( int i = 0; i < NUM_ITERATIONS; ++i )
+		recalculateNormalsSerial( &serial );
+	console() << " serial: " << t.getSeconds() / NUM_ITERATIONS << "s" << std::endl;
+
+	const char *names[3] = { "uniform", "area", "angle" };
+	for( int weighting = TriMesh::WEIGHT_UNIFORM; weighting <= TriMesh::WEIGHT_ANGLE; ++weighting ) {
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			mesh.recalculateNormals( (TriMesh::NormalWeighting)weighting );
+		t.stop();
+		console() << " " << names[weighting] << ": " << t.getSeconds() / NUM_ITERATIONS << "s" << std::endl;
+		if( weighting == TriMesh::WEIGHT_UNIFORM ) {
+			for( size_t v = 0; v < mesh.getNumVertices(); ++v )
+				assert( mesh.getNormals()[v].distance( serial.getNormals()[v] ) < 1e-5f );
+		}
+	}
+
+	t.start();
+	for( int i = 0; i < NUM_ITERATIONS; ++i )
+		mesh.recalculateTangents();
+	t.stop();
+	console() << " tangents: " << t.getSeconds() / NUM_ITERATIONS << "s" << std::endl;
+	for( size_t v = 0; v < mesh.getNumVertices(); ++v ) {
+		const Vec3f &n = mesh.getNormals()[v], &tangent = mesh.getTangents()[v], &bitangent = mesh.getBitangents()[v];
+		assert( math<float>::abs( n.dot( tangent ) ) < 1e-4f && math<float>::abs( n.dot( bitangent ) ) < 1e-4f && math<float>::abs( tangent.length() - 1 ) < 1e-4f );
+		// u increases along x and v along z
+		assert( tangent.x > 0 && bitangent.z > 0 );
+	}
+}
+
+void TriMeshNormalsBenchmarkApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( TriMeshNormalsBenchmarkApp, RendererGl )
@@ -0,0 +1,137 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/TriMesh.h"
+#include "cinder/Timer.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Simplifies a terrain with a UV seam down the middle and checks that TriMesh::simplify() keeps its outline, keeps both sides
+// of the seam matching, keeps the orientation of every triangle, and honors the error limit
+class TriMeshSimplifyTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const int GRID_SIZE = 500;
+const int SEAM_X = GRID_SIZE / 2;
+
+float calcHeight( int x, int y, float amplitude )
+{
+	return amplitude * math<float>::sin( x * 0.05f ) * math<float>::cos( y * 0.07f );
+}
+
+// The vertices at SEAM_X are duplicated for the triangles to their right, which map to a different part of the texture
+TriMesh makeTerrain( float amplitude )
+{
+	TriMesh result;
+	for( int y = 0; y < GRID_SIZE; ++y ) {
+		for( int x = 0; x < GRID_SIZE; ++x ) {
+			result.appendVertex( Vec3f( x, y, calcHeight( x, y, amplitude ) ) );
+			result.appendTexCoord( Vec2f( x, y ) );
+		}
+	}
+	const uint32_t seamStart = result.getNumVertices();
+	for( int y = 0; y < GRID_SIZE; ++y ) {
+		result.appendVertex( Vec3f( SEAM_X, y, calcHeight( SEAM_X, y, amplitude ) ) );
+		result.appendTexCoord( Vec2f( SEAM_X + GRID_SIZE, y ) );
+	}
+
+	for( int y = 0; y < GRID_SIZE - 1; ++y ) {
+		for( int x = 0; x < GRID_SIZE - 1; ++x ) {
+			uint32_t a = y * GRID_SIZE + x, b = a + 1, c = a + GRID_SIZE, d = c + 1;
+			if( x == SEAM_X ) {
+				a = seamStart + y;
+				c = a + 1;
+			}
+			result.appendTriangle( a, b, d );
+			result.appendTriangle( a, d, c );
+		}
+	}
+	return result;
+}
+
+// Returns the total area of the triangles projected onto the ground, which stays the same as long as the outline does and no triangle folds over.
+// Triangles may stand on edge though, where one collapses onto a row of vertices that are kept.
+double checkProjectedArea( const TriMesh &mesh )
+{
+	double result = 0;
+	for( size_t t = 0; t < mesh.getNumTriangles(); ++t ) {
+		Vec3f a, b, c;
+		mesh.getTriangleVertices( t, &a, &b, &c );
+		const double area = ( ( b.x - a.x ) * (double)( c.y - a.y ) - ( c.x - a.x ) * (double)( b.y - a.y ) ) / 2;
+		assert( area >= 0 );
+		result += area;
+	}
+	return result;
+}
+
+// Checks that every vertex is where it started with its own texture coordinates, and that the seam still has a copy on each
+// side of every vertex along it, so that the two sides share their edges. Returns the number of positions along the seam.
+size_t checkSeam( const TriMesh &mesh, float amplitude )
+{
+	vector<int> left, right;
+	for( size_t v = 0; v < mesh.getNumVertices(); ++v ) {
+		const Vec3f &p = mesh.getVertices()[v];
+		const Vec2f &uv = mesh.getTexCoords()[v];
+		assert( p.z == calcHeight( (int)p.x, (int)p.y, amplitude ) );
+		assert( uv.y == p.y && ( uv.x == p.x || ( p.x == SEAM_X && uv.x == SEAM_X + GRID_SIZE ) ) );
+		if( p.x == SEAM_X )
+			( ( uv.x == p.x ) ? left : right ).push_back( (int)p.y );
+	}
+	std::sort( left.begin(), left.end() );
+	std::sort( right.begin(), right.end() );
+	assert( left == right );
+	// the ends of the seam are on the outline, so they stay
+	assert( left.size() >= 2 && left.front() == 0 && left.back() == GRID_SIZE - 1 );
+	return left.size();
+}
+
+} // anonymous namespace
+
+void TriMeshSimplifyTestApp::setup()
+{
+	const double area = ( GRID_SIZE - 1 ) * ( GRID_SIZE - 1 );
+
+	TriMesh terrain = makeTerrain( 8 );
+	const size_t target = terrain.getNumTriangles() / 10;
+	Timer t( true );
+	terrain.simplify( target );
+	console() << "Simplified " << ( GRID_SIZE - 1 ) * ( GRID_SIZE - 1 ) * 2 << " triangles to " << terrain.getNumTriangles() << " in " << t.getSeconds() << "s" << std::endl;
+	assert( terrain.getNumTriangles() <= target && terrain.getNumTriangles() > target * 9 / 10 );
+	assert( math<double>::abs( checkProjectedArea( terrain ) - area ) < area * 1e-5 );
+
+	// the seam coarsens along with the rest of the terrain, with both sides collapsing together, though less where it runs along
+	// a division between partitions
+	const size_t seamVertices = checkSeam( terrain, 8 );
+	console() << "Seam: " << seamVertices << " of " << GRID_SIZE << " vertices" << std::endl;
+	assert( seamVertices < GRID_SIZE * 3 / 4 );
+
+	// a flat plane collapses onto its corners and the ends of its seam at any error limit, while a bumpy one stops early
+	TriMesh flat = makeTerrain( 0 );
+	flat.simplify( 0, 0.01f );
+	console() << "Flat terrain: " << flat.getNumTriangles() << " triangles" << std::endl;
+	assert( flat.getNumTriangles() < 20 );
+	assert( math<double>::abs( checkProjectedArea( flat ) - area ) < area * 1e-5 );
+	assert( checkSeam( flat, 0 ) == 2 );
+
+	TriMesh bumpy = makeTerrain( 8 );
+	bumpy.simplify( 0, 0.01f );
+	console() << "Bumpy terrain: " << bumpy.getNumTriangles() << " triangles" << std::endl;
+	assert( bumpy.getNumTriangles() > flat.getNumTriangles() * 10 );
+	assert( math<double>::abs( checkProjectedArea( bumpy ) - area ) < area * 1e-5 );
+	checkSeam( bumpy, 8 );
+
+	console() << "Tests passed" << std::endl;
+}
+
+void TriMeshSimplifyTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( TriMeshSimplifyTestApp, RendererGl )
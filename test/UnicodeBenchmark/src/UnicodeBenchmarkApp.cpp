@@ -0,0 +1,141 @@
+#include "cinder/app/AppNative.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Unicode.h"
+#include "cinder/Timer.h"
+
+#include <vector>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Compares the bulk UTF-8 routines against the character-at-a-time approach they replace
+class UnicodeBenchmarkApp : public AppNative {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const int NUM_ITERATIONS = 20;
+
+string makeText( bool asciiOnly )
+{
+	const char *words[] = { "lorem ", "ipsum ", "dolor ", "sit ", "amet ", "\xC3\xA9t\xC3\xA9 ", "\xE2\x82\xAC" "100 ", "\xE6\x97\xA5\xE6\x9C\xAC ", "\xF0\x9F\x98\x80 " };
+	const int numWords = asciiOnly ? 5 : sizeof(words) / sizeof(words[0]);
+	string result;
+	for( int i = 0; result.size() < 8 * 1024 * 1024; ++i )
+		result += words[( i * 7 ) % numWords];
+	return result;
+}
+
+// the previous implementation of stringLengthUtf8(): one nextCharUtf8() call per character
+size_t lengthPerChar( const string &s )
+{
+	size_t result = 0, nextByte = 0;
+	while( nextCharUtf8( s.c_str(), &nextByte, s.size() ) != 0xFFFF )
+		++result;
+	return result;
+}
+
+size_t toUtf16PerChar( const string &s, vector<uint16_t> *dest )
+{
+	size_t nextByte = 0, out = 0;
+	uint32_t c;
+	while( ( c = nextCharUtf8( s.c_str(), &nextByte, s.size() ) ) != 0xFFFF ) {
+		if( c >= 0x10000 ) {
+			c -= 0x10000;
+			(*dest)[out++] = (uint16_t)( 0xD800 + ( c >> 10 ) );
+			(*dest)[out++] = (uint16_t)( 0xDC00 + ( c & 0x3FF ) );
+		}
+		else
+			(*dest)[out++] = (uint16_t)c;
+	}
+	return out;
+}
+
+void report( const char *name, double seconds, size_t bytes )
+{
+	console() << name << ": " << ( bytes * NUM_ITERATIONS / seconds / ( 1024 * 1024 ) ) << " MB/s" << std::endl;
+}
+
+} // anonymous namespace
+
+void UnicodeBenchmarkApp::setup()
+{
+	for( int pass = 0; pass < 2; ++pass ) {
+		string text = makeText( pass == 0 );
+		console() << ( ( pass == 0 ) ? "ASCII" : "Mixed" ) << " text, " << text.size() << " bytes" << std::endl;
+		vector<uint16_t> utf16( text.size() );
+		vector<uint32_t> utf32( text.size() );
+		vector<char> utf8( text.size() * 3 );
+		Timer t;
+
+		size_t perCharLength = 0, length = 0;
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			perCharLength = lengthPerChar( text );
+		t.stop();
+		report( " per-character length", t.getSeconds(), text.size() );
+
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			length = stringLengthUtf8( text.c_str(), text.size() );
+		t.stop();
+		report( " stringLengthUtf8()", t.getSeconds(), text.size() );
+		assert( length == perCharLength );
+
+		bool valid = false;
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			valid = isValidUtf8( text.c_str(), text.size() );
+		t.stop();
+		report( " isValidUtf8()", t.getSeconds(), text.size() );
+		assert( valid );
+
+		size_t perCharUnits = 0, units = 0;
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			perCharUnits = toUtf16PerChar( text, &utf16 );
+		t.stop();
+		report( " per-character UTF-8 -> UTF-16", t.getSeconds(), text.size() );
+
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			units = convertUtf8ToUtf16( text.c_str(), text.size(), &utf16[0] );
+		t.stop();
+		report( " convertUtf8ToUtf16()", t.getSeconds(), text.size() );
+		assert( units == perCharUnits );
+
+		size_t bytes = 0;
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			bytes = convertUtf16ToUtf8( &utf16[0], units, &utf8[0] );
+		t.stop();
+		report( " convertUtf16ToUtf8()", t.getSeconds(), text.size() );
+		assert( string( &utf8[0], bytes ) == text );
+
+		size_t codePoints = 0;
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			codePoints = convertUtf8ToUtf32( text.c_str(), text.size(), &utf32[0] );
+		t.stop();
+		report( " convertUtf8ToUtf32()", t.getSeconds(), text.size() );
+		assert( codePoints == length );
+
+		t.start();
+		for( int i = 0; i < NUM_ITERATIONS; ++i )
+			bytes = convertUtf32ToUtf8( &utf32[0], codePoints, &utf8[0] );
+		t.stop();
+		report( " convertUtf32ToUtf8()", t.getSeconds(), text.size() );
+		assert( string( &utf8[0], bytes ) == text );
+	}
+}
+
+void UnicodeBenchmarkApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_NATIVE( UnicodeBenchmarkApp, RendererGl )
@@ -0,0 +1,186 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/TriMesh.h"
+#include "cinder/Rand.h"
+#include "cinder/Timer.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Reports the vertex cache miss ratio of a grid with shuffled triangles before and after TriMesh::optimizeIndexOrder(),
+// and checks that neither it nor optimizeVertexOrder() changes the triangles. Then measures the overdraw of a cloud of
+// spheres with a software rasterizer before and after TriMesh::optimizeOverdraw().
+class VertexCacheTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const int GRID_SIZE = 500;
+
+// sums an order-independent hash of the triangles' positions, so that a reordered mesh sums the same. The sums are exact
+// since the coordinates are small multiples of 0.5.
+double sumTriangles( const TriMesh &mesh )
+{
+	double result = 0;
+	for( size_t t = 0; t < mesh.getNumTriangles(); ++t ) {
+		Vec3f a, b, c;
+		mesh.getTriangleVertices( t, &a, &b, &c );
+		result += a.x * b.y * c.z + b.x * c.y * a.z + c.x * a.y * b.z;
+	}
+	return result;
+}
+
+// Rasterizes \a mesh from several directions with back-face culling and a depth test, returning how many times
+// each covered pixel is shaded on average. The mesh is orthographically fit to \a resolution pixels.
+float calcOverdraw( const TriMesh &mesh, int resolution = 256 )
+{
+	const Vec3f directions[] = { Vec3f( 1, 0, 0 ), Vec3f( -1, 0, 0 ), Vec3f( 0, 1, 0 ), Vec3f( 0, -1, 0 ), Vec3f( 0, 0, 1 ), Vec3f( 0, 0, -1 ),
+		Vec3f( 1, 1, 1 ), Vec3f( -1, 1, 1 ), Vec3f( 1, -1, 1 ), Vec3f( 1, 1, -1 ), Vec3f( -1, -1, 1 ), Vec3f( -1, 1, -1 ), Vec3f( 1, -1, -1 ), Vec3f( -1, -1, -1 ) };
+	const AxisAlignedBox3f bounds = mesh.calcBoundingBox();
+	const float radius = bounds.getSize().length() / 2;
+	const float scale = ( resolution - 1 ) / ( 2 * radius );
+	size_t shaded = 0, covered = 0;
+	vector<float> depth( resolution * resolution );
+	for( size_t d = 0; d < sizeof(directions) / sizeof(directions[0]); ++d ) {
+		Vec3f w = directions[d].normalized(), u = w.getOrthogonal().normalized(), v = w.cross( u );
+		std::fill( depth.begin(), depth.end(), numeric_limits<float>::max() );
+		for( size_t t = 0; t < mesh.getNumTriangles(); ++t ) {
+			Vec3f corners[3];
+			mesh.getTriangleVertices( t, &corners[0], &corners[1], &corners[2] );
+			Vec3f p[3];
+			for( int k = 0; k < 3; ++k ) {
+				Vec3f r = corners[k] - bounds.getCenter();
+				p[k] = Vec3f( ( r.dot( u ) + radius ) * scale, ( r.dot( v ) + radius ) * scale, -r.dot( w ) );
+			}
+			float area = ( p[1].x - p[0].x ) * ( p[2].y - p[0].y ) - ( p[2].x - p[0].x ) * ( p[1].y - p[0].y );
+			if( area <= 0 )
+				continue;
+			int x0 = std::max( 0, (int)math<float>::floor( min( p[0].x, min( p[1].x, p[2].x ) ) ) ), x1 = std::min( resolution - 1, (int)math<float>::ceil( max( p[0].x, max( p[1].x, p[2].x ) ) ) );
+			int y0 = std::max( 0, (int)math<float>::floor( min( p[0].y, min( p[1].y, p[2].y ) ) ) ), y1 = std::min( resolution - 1, (int)math<float>::ceil( max( p[0].y, max( p[1].y, p[2].y ) ) ) );
+			for( int y = y0; y <= y1; ++y ) {
+				for( int x = x0; x <= x1; ++x ) {
+					float b[3];
+					for( int k = 0; k < 3; ++k ) {
+						const Vec3f &e0 = p[( k + 1 ) % 3], &e1 = p[( k + 2 ) % 3];
+						b[k] = ( ( e1.x - e0.x ) * ( y - e0.y ) - ( x - e0.x ) * ( e1.y - e0.y ) ) / area;
+					}
+					if( b[0] < 0 || b[1] < 0 || b[2] < 0 )
+						continue;
+					float z = b[0] * p[0].z + b[1] * p[1].z + b[2] * p[2].z;
+					float &pixelDepth = depth[y * resolution + x];
+					if( z < pixelDepth ) {
+						if( pixelDepth == numeric_limits<float>::max() )
+							++covered;
+						pixelDepth = z;
+						++shaded;
+					}
+				}
+			}
+		}
+	}
+	return covered ? shaded / (float)covered : 0;
+}
+
+// Appends a sphere of \a radius at \a center, wound counterclockwise seen from outside
+void appendSphere( TriMesh *mesh, const Vec3f &center, float radius, int segments )
+{
+	const uint32_t first = (uint32_t)mesh->getNumVertices();
+	for( int i = 0; i <= segments; ++i ) {
+		float theta = i * (float)M_PI / segments;
+		for( int j = 0; j < segments * 2; ++j ) {
+			float phi = j * (float)M_PI / segments;
+			mesh->appendVertex( center + radius * Vec3f( math<float>::sin( theta ) * math<float>::cos( phi ), math<float>::cos( theta ), math<float>::sin( theta ) * math<float>::sin( phi ) ) );
+		}
+	}
+	for( int i = 0; i < segments; ++i ) {
+		for( int j = 0; j < segments * 2; ++j ) {
+			uint32_t a = first + i * segments * 2 + j, b = first + i * segments * 2 + ( j + 1 ) % ( segments * 2 );
+			mesh->appendTriangle( a, b, b + segments * 2 );
+			mesh->appendTriangle( a, b + segments * 2, a + segments * 2 );
+		}
+	}
+}
+
+void shuffleTriangles( TriMesh *mesh, Rand &rand )
+{
+	vector<uint32_t> &indices = mesh->getIndices();
+	for( size_t t = mesh->getNumTriangles() - 1; t > 0; --t ) {
+		size_t other = rand.nextUint( t + 1 );
+		for( int k = 0; k < 3; ++k )
+			swap( indices[t * 3 + k], indices[other * 3 + k] );
+	}
+}
+
+} // anonymous namespace
+
+void VertexCacheTestApp::setup()
+{
+	TriMesh mesh;
+	for( int y = 0; y < GRID_SIZE; ++y ) {
+		for( int x = 0; x < GRID_SIZE; ++x ) {
+			mesh.appendVertex( Vec3f( x, y * 0.5f, y ) );
+			mesh.appendTexCoord( Vec2f( x, y ) );
+		}
+	}
+	for( int y = 0; y < GRID_SIZE - 1; ++y ) {
+		for( int x = 0; x < GRID_SIZE - 1; ++x ) {
+			uint32_t a = y * GRID_SIZE + x;
+			mesh.appendTriangle( a, a + GRID_SIZE + 1, a + 1 );
+			mesh.appendTriangle( a, a + GRID_SIZE, a + GRID_SIZE + 1 );
+		}
+	}
+	console() << "Row order ACMR: " << mesh.calcCacheMissRatio() << std::endl;
+
+	vector<uint32_t> &indices = mesh.getIndices();
+	Rand rand( 1 );
+	shuffleTriangles( &mesh, rand );
+	const double triangleSum = sumTriangles( mesh );
+	console() << "Shuffled ACMR: " << mesh.calcCacheMissRatio() << std::endl;
+	assert( mesh.calcCacheMissRatio() > 2.9f );
+
+	Timer t( true );
+	mesh.optimizeIndexOrder();
+	console() << "Optimized ACMR: " << mesh.calcCacheMissRatio() << " (16 entries), " << mesh.calcCacheMissRatio( 32 ) << " (32 entries) in " << t.getSeconds() << "s" << std::endl;
+	assert( mesh.calcCacheMissRatio() < 0.75f );
+	assert( sumTriangles( mesh ) == triangleSum );
+
+	mesh.optimizeVertexOrder();
+	uint32_t maxIndex = 0;
+	for( size_t i = 0; i < indices.size(); ++i ) {
+		assert( indices[i] <= maxIndex + 1 );
+		maxIndex = max( maxIndex, indices[i] );
+	}
+	for( size_t v = 0; v < mesh.getNumVertices(); ++v )
+		assert( mesh.getTexCoords()[v] == Vec2f( mesh.getVertices()[v].x, mesh.getVertices()[v].z ) );
+	assert( sumTriangles( mesh ) == triangleSum );
+
+	// a cloud of spheres, which hide each other from every direction
+	TriMesh spheres;
+	for( int i = 0; i < 40; ++i )
+		appendSphere( &spheres, Vec3f( rand.nextFloat( -5, 5 ), rand.nextFloat( -5, 5 ), rand.nextFloat( -5, 5 ) ), 1.5f, 16 );
+	shuffleTriangles( &spheres, rand );
+	spheres.optimizeIndexOrder();
+	const float cachedAcmr = spheres.calcCacheMissRatio(), cachedOverdraw = calcOverdraw( spheres );
+	const size_t numIndices = spheres.getIndices().size();
+	t.start();
+	spheres.optimizeOverdraw();
+	t.stop();
+	const float acmr = spheres.calcCacheMissRatio(), overdraw = calcOverdraw( spheres );
+	console() << "Spheres: ACMR " << cachedAcmr << ", overdraw " << cachedOverdraw << " after optimizeIndexOrder(); ACMR " << acmr << ", overdraw " << overdraw << " after optimizeOverdraw() in " << t.getSeconds() << "s" << std::endl;
+	assert( spheres.getIndices().size() == numIndices );
+	assert( overdraw < cachedOverdraw );
+	assert( acmr < cachedAcmr * 1.1f );
+
+	console() << "Tests passed" << std::endl;
+}
+
+void VertexCacheTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( VertexCacheTestApp, RendererGl )
@@ -1,6 +1,7 @@
 #include "cinder/app/AppBasic.h"
 #include "cinder/gl/gl.h"
 #include "cinder/Xml.h"
+#include "cinder/XmlDoc.h"
 #include "cinder/Utilities.h"
 
 //#include "rapidxml/rapidxml.hpp"
@@ -59,6 +60,44 @@ void XMLTestApp::setup()
 		leadingSeparator.push_back( track->getValue() );
 	assert( noLeadingSeparator == leadingSeparator );
 
+	// a compiled query must match the same tracks
+	XmlTree::Query trackQuery( "library/album/track" );
+	vector<string> queryTracks;
+	for( XmlTree::ConstIter track = doc.begin( trackQuery ); track != doc.end(); ++track )
+		queryTracks.push_back( track->getValue() );
+	assert( queryTracks == noLeadingSeparator );
+	assert( doc.getChild( trackQuery ).getValue() == noLeadingSeparator.front() );
+
+	// Query lookups on a node with many children go through an index, which must follow changes made through a held getChildren()
+	XmlTree crowd( "crowd", "" );
+	for( int i = 0; i < 20; ++i )
+		crowd.push_back( XmlTree( "item" + toString( i ), toString( i ) ) );
+	XmlTree::Query item3( "ITEM3" ), item7( "item7" ), item20( "item20" );
+	assert( crowd.getChild( item7 ).getValue() == "7" );
+	XmlTree::Container &crowdChildren = crowd.getChildren();
+	assert( crowd.getChild( item3 ).getValue() == "3" );
+	for( XmlTree::Container::iterator childIt = crowdChildren.begin(); childIt != crowdChildren.end(); ++childIt ) {
+		if( (*childIt)->getTag() == "item7" ) {
+			crowdChildren.erase( childIt );
+			break;
+		}
+	}
+	assert( ! crowd.hasChild( item7 ) );
+	crowdChildren.push_back( unique_ptr<XmlTree>( new XmlTree( "item20", "20" ) ) );
+	assert( crowd.getChild( item20 ).getValue() == "20" );
+	crowdChildren.clear();
+	assert( ! crowd.hasChild( item3 ) && ! crowd.hasChild( item20 ) );
+
+	// and changes to the children themselves
+	XmlTree renamed( "renamed", "" );
+	for( int i = 0; i < 20; ++i )
+		renamed.push_back( XmlTree( "item" + toString( i ), toString( i ) ) );
+	assert( renamed.getChild( item7 ).getValue() == "7" );
+	renamed.getChild( "item7" ).setTag( "seven" );
+	assert( ! renamed.hasChild( item7 ) && renamed.getChild( XmlTree::Query( "seven" ) ).getValue() == "7" );
+	renamed.getChild( "item8" ) = XmlTree( "eight", "8" );
+	assert( ! renamed.hasChild( XmlTree::Query( "item8" ) ) && renamed.getChild( XmlTree::Query( "eight" ) ).getParent().getTag() == "renamed" );
+
 	XmlTree firstAlbum = doc.getChild( "library/album" );
 	for( XmlTree::Iter child = firstAlbum.begin(); child != firstAlbum.end(); ++child ) {
 		console() << "Tag: " << child->getTag() << "  Value: " << child->getValue() << endl;
@@ -82,6 +121,15 @@ void XMLTestApp::setup()
 	XmlTree albumCopy = copyFirstAlbum( doc / "library" );
 	console() << ( albumCopy / "track" ).getPath() << std::endl; // should print 'newRoot/track'
 
+	// the in-place XmlDoc must see the same tracks as XmlTree
+	XmlDocRef inPlaceDoc = XmlDoc::create( loadFile( getAssetPath( "library.xml" ) ) );
+	vector<string> inPlaceTracks;
+	for( XmlDoc::Node album = inPlaceDoc->getRoot().getChild( "library" ).firstChild( "album" ); album; album = album.nextSibling( "album" ) )
+		for( XmlDoc::Node track = album.firstChild( "track" ); track; track = track.nextSibling( "track" ) )
+			inPlaceTracks.push_back( track.getValue().str() );
+	assert( inPlaceTracks == noLeadingSeparator );
+	assert( inPlaceDoc->getRoot().getChild( "library/album" ).getAttribute( "musician" ).getValue() == "John Coltrane" );
+
 	// This code only works in VC2010
 /*	std::for_each( doc.begin( "library/album" ), doc.end(), []( const XmlTree &child ) {
 		app::console() << child.getChild( "title" ).getValue() << std::endl;
@@ -0,0 +1,144 @@
+#include "cinder/app/AppNative.h"
+#include "cinder/gl/gl.h"
+#include "cinder/XmlReader.h"
+#include "cinder/XmlDoc.h"
+#include "cinder/Xml.h"
+#include "cinder/Timer.h"
+#include "cinder/Utilities.h"
+
+#include <fstream>
+
+#if defined( CINDER_MSW )
+	#include <windows.h>
+	#include <psapi.h>
+	#pragma comment( lib, "psapi.lib" )
+#else
+	#include <sys/resource.h>
+#endif
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Compares the streaming XmlReader against the DOM parsers on a large generated file, reporting throughput and peak RSS.
+// Peak RSS only grows over the life of the process, so the parsers run from the leanest to the most memory hungry.
+class XmlReaderBenchmarkApp : public AppNative {
+  public:
+	void setup();
+	void draw();
+};
+
+namespace {
+
+const uint64_t FILE_SIZE = 500 * 1024 * 1024;
+
+uint64_t getPeakRss()
+{
+#if defined( CINDER_MSW )
+	PROCESS_MEMORY_COUNTERS counters;
+	::GetProcessMemoryInfo( ::GetCurrentProcess(), &counters, sizeof(counters) );
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+	::getrusage( RUSAGE_SELF, &usage );
+	#if defined( CINDER_COCOA )
+		return usage.ru_maxrss;
+	#else
+		return (uint64_t)usage.ru_maxrss * 1024;
+	#endif
+#endif
+}
+
+uint64_t writeTestFile( const fs::path &path )
+{
+	ofstream out( path.string().c_str(), ios::binary );
+	out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<feed>\n";
+	uint64_t bytes = 0;
+	for( int i = 0; bytes < FILE_SIZE; ++i ) {
+		string entry = "  <entry id=\"" + toString( i ) + "\" score=\"" + toString( i * 0.25f ) + "\">\n"
+			"    <title>Entry number " + toString( i ) + " &amp; friends</title>\n"
+			"    <content type=\"text\">Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt.</content>\n"
+			"    <link href=\"http://example.com/" + toString( i ) + "\"/>\n"
+			"  </entry>\n";
+		out << entry;
+		bytes += entry.size();
+	}
+	out << "</feed>\n";
+	return bytes;
+}
+
+void report( const char *name, double seconds, uint64_t bytes, size_t entries )
+{
+	console() << name << ": " << ( bytes / seconds / ( 1024 * 1024 ) ) << " MB/s, " << entries << " entries, peak RSS " << ( getPeakRss() / ( 1024 * 1024 ) ) << " MB" << std::endl;
+}
+
+} // anonymous namespace
+
+void XmlReaderBenchmarkApp::setup()
+{
+	fs::path path = getTemporaryDirectory() / "XmlReaderBenchmark.xml";
+	uint64_t bytes = writeTestFile( path );
+	console() << "Wrote " << bytes << " bytes to " << path << std::endl;
+	console() << "Baseline peak RSS " << ( getPeakRss() / ( 1024 * 1024 ) ) << " MB" << std::endl;
+	Timer t;
+
+	// XmlReader, skipping the content of each entry
+	size_t entries = 0;
+	t.start();
+	{
+		XmlReader reader( loadFileStream( path ) );
+		while( reader.next() != XmlReader::EVENT_END_OF_DOCUMENT ) {
+			if( reader.getEvent() == XmlReader::EVENT_START_ELEMENT && reader.getDepth() == 2 ) {
+				if( reader.getAttributeValue<int>( "id", -1 ) >= 0 )
+					++entries;
+				reader.skip();
+			}
+		}
+	}
+	t.stop();
+	report( "XmlReader with skip()", t.getSeconds(), bytes, entries );
+
+	// XmlReader, visiting every event
+	entries = 0;
+	t.start();
+	{
+		XmlReader reader( loadFileStream( path ) );
+		while( reader.next() != XmlReader::EVENT_END_OF_DOCUMENT ) {
+			if( reader.getEvent() == XmlReader::EVENT_START_ELEMENT && reader.getName() == "entry" )
+				++entries;
+		}
+	}
+	t.stop();
+	report( "XmlReader", t.getSeconds(), bytes, entries );
+
+	// XmlDoc
+	entries = 0;
+	t.start();
+	{
+		XmlDocRef doc = XmlDoc::create( loadFile( path ) );
+		for( XmlDoc::Node entry = doc->getRoot().getChild( "feed" ).firstChild( "entry" ); entry; entry = entry.nextSibling( "entry" ) )
+			++entries;
+	}
+	t.stop();
+	report( "XmlDoc", t.getSeconds(), bytes, entries );
+
+	// XmlTree( DataSourceRef )
+	entries = 0;
+	t.start();
+	{
+		XmlTree tree( loadFile( path ) );
+		for( XmlTree::ConstIter entry = tree.begin( "feed/entry" ); entry != tree.end(); ++entry )
+			++entries;
+	}
+	t.stop();
+	report( "XmlTree", t.getSeconds(), bytes, entries );
+
+	fs::remove( path );
+}
+
+void XmlReaderBenchmarkApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_NATIVE( XmlReaderBenchmarkApp, RendererGl )
@@ -0,0 +1,169 @@
+#include "cinder/app/AppBasic.h"
+#include "cinder/gl/gl.h"
+#include "cinder/XmlReader.h"
+#include "cinder/Stream.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+class XmlReaderTestApp : public AppBasic {
+  public:
+	void setup();
+	void draw();
+};
+
+// Flattens every event of \a stream into a string such as "<a x=1>text</a>", reading \a bufferSize bytes at a time
+std::string readEvents( IStreamRef stream, size_t bufferSize )
+{
+	XmlReader reader( stream, bufferSize );
+	std::string result;
+	while( reader.next() != XmlReader::EVENT_END_OF_DOCUMENT ) {
+		switch( reader.getEvent() ) {
+			case XmlReader::EVENT_START_ELEMENT:
+				result += "<" + reader.getName();
+				for( size_t a = 0; a < reader.getNumAttributes(); ++a )
+					result += " " + reader.getAttributeName( a ) + "=" + reader.getAttributeValue( a );
+				result += ">";
+			break;
+			case XmlReader::EVENT_END_ELEMENT:
+				result += "</" + reader.getName() + ">";
+			break;
+			case XmlReader::EVENT_TEXT:
+				result += reader.getText();
+			break;
+			case XmlReader::EVENT_CDATA:
+				result += "[" + reader.getText() + "]";
+			break;
+			default:
+				assert( false );
+		}
+	}
+	return result;
+}
+
+std::string readEvents( const std::string &xml, size_t bufferSize )
+{
+	return readEvents( IStreamMem::create( xml.c_str(), xml.size() ), bufferSize );
+}
+
+// Checks that \a xml produces \a expected for every buffer size from the smallest up to one holding the whole document
+void testEvents( const std::string &xml, const std::string &expected )
+{
+	for( size_t bufferSize = 16; bufferSize <= xml.size() + 16; ++bufferSize )
+		assert( readEvents( xml, bufferSize ) == expected );
+}
+
+bool throwsParse( const std::string &xml )
+{
+	try {
+		readEvents( xml, 16 );
+	}
+	catch( XmlReader::ExcParse & ) {
+		return true;
+	}
+	return false;
+}
+
+void XmlReaderTestApp::setup()
+{
+	// events, attributes and empty elements
+	testEvents( "<?xml version=\"1.0\"?>\n<!-- head -->\n<root a=\"1\" b='two'>\n  <child/>\n  <child name=\"x\"></child>\n</root>\n",
+		"<root a=1 b=two><child></child><child name=x></child></root>" );
+
+	// entities in text and attribute values, including character references beyond ASCII
+	testEvents( "<root title=\"&lt;&amp;&gt;\">&quot;a&apos; &#65;&#x42;&#xe9; &#x20AC;</root>",
+		"<root title=<&>>\"a' AB\xC3\xA9 \xE2\x82\xAC</root>" );
+
+	// unrecognized and unterminated references are kept literally
+	testEvents( "<root>&bogus; & &#xZZ; &amp</root>", "<root>&bogus; & &#xZZ; &amp</root>" );
+
+	// CDATA is not decoded and may contain markup
+	testEvents( "<root>text<![CDATA[<b>&amp;]]]]><![CDATA[>]]>more</root>",
+		"<root>text[<b>&amp;]]][>]more</root>" );
+
+	// a tag name, an attribute value and a run of text each longer than the buffer
+	std::string longName( 40, 'n' ), longValue( 50, 'v' ), longText( 70, 't' );
+	testEvents( "<root><" + longName + " attr=\"" + longValue + "\">" + longText + "&amp;" + longText + "</" + longName + "></root>",
+		"<root><" + longName + " attr=" + longValue + ">" + longText + "&" + longText + "</" + longName + "></root>" );
+
+	// a leading byte order mark is skipped but still counts toward the offset
+	testEvents( "\xEF\xBB\xBF<root>x</root>", "<root>x</root>" );
+	{
+		std::string xml( "\xEF\xBB\xBF<root/>" );
+		XmlReader reader( IStreamMem::create( xml.c_str(), xml.size() ), 16 );
+		assert( reader.next() == XmlReader::EVENT_START_ELEMENT && reader.getName() == "root" && reader.isEmptyElement() );
+		assert( reader.getOffset() == xml.size() );
+	}
+
+	// typed attribute access
+	{
+		std::string xml( "<root width=\"12\" scale=\"0.5\" name=\"abc\"/>" );
+		XmlReader reader( IStreamMem::create( xml.c_str(), xml.size() ), 16 );
+		assert( reader.next() == XmlReader::EVENT_START_ELEMENT );
+		assert( reader.getAttributeValue<int>( "width", 0 ) == 12 );
+		assert( reader.getAttributeValue<float>( "scale", 0 ) == 0.5f );
+		assert( reader.getAttributeValue<int>( "name", 7 ) == 7 );
+		assert( reader.getAttributeValue<int>( "missing", 3 ) == 3 );
+		assert( reader.hasAttribute( "name" ) && ! reader.hasAttribute( "missing" ) );
+		assert( reader.getAttributeValue( "missing" ).empty() );
+	}
+
+	// skip() passes over nested elements, CDATA containing tags and comments, whatever the buffer size
+	std::string skipXml = "<root><skipped a=\"x>y\"><inner><skipped/></inner><![CDATA[</skipped>]]><!-- </skipped> -->text</skipped><after/></root>";
+	for( size_t bufferSize = 16; bufferSize <= skipXml.size() + 16; ++bufferSize ) {
+		XmlReader reader( IStreamMem::create( skipXml.c_str(), skipXml.size() ), bufferSize );
+		assert( reader.next() == XmlReader::EVENT_START_ELEMENT && reader.getName() == "root" );
+		assert( reader.next() == XmlReader::EVENT_START_ELEMENT && reader.getName() == "skipped" );
+		reader.skip();
+		assert( reader.getEvent() == XmlReader::EVENT_END_ELEMENT && reader.getName() == "skipped" );
+		assert( reader.getDepth() == 1 );
+		assert( reader.next() == XmlReader::EVENT_START_ELEMENT && reader.getName() == "after" );
+		assert( reader.next() == XmlReader::EVENT_END_ELEMENT && reader.getName() == "after" );
+		assert( reader.next() == XmlReader::EVENT_END_ELEMENT && reader.getName() == "root" );
+		assert( reader.next() == XmlReader::EVENT_END_OF_DOCUMENT );
+	}
+
+	// skip() on an empty element only consumes its end event
+	{
+		std::string xml( "<root><empty/><next/></root>" );
+		XmlReader reader( IStreamMem::create( xml.c_str(), xml.size() ), 16 );
+		reader.next();
+		assert( reader.next() == XmlReader::EVENT_START_ELEMENT && reader.getName() == "empty" );
+		reader.skip();
+		assert( reader.getEvent() == XmlReader::EVENT_END_ELEMENT && reader.getName() == "empty" );
+		assert( reader.next() == XmlReader::EVENT_START_ELEMENT && reader.getName() == "next" );
+	}
+
+	// a file read through a buffer smaller than the file stream's own ends where the file does, whatever the buffer size
+	{
+		std::string xml = "<?xml version=\"1.0\"?>\n<library>\n";
+		for( int i = 0; i < 100; ++i )
+			xml += "  <album id=\"" + toString( i ) + "\"><title>Album &amp; " + toString( i * 7 ) + "</title></album>\n";
+		xml += "</library>\n";
+		const std::string expected = readEvents( xml, xml.size() + 16 );
+		const fs::path path = getTemporaryDirectory() / "XmlReaderTest.xml";
+		writeFileStream( path )->writeData( xml.c_str(), xml.size() );
+		const size_t bufferSizes[] = { 16, 17, 510, 1000, 2048, 4096 };
+		for( size_t i = 0; i < sizeof(bufferSizes) / sizeof(bufferSizes[0]); ++i )
+			assert( readEvents( loadFileStream( path ), bufferSizes[i] ) == expected );
+		fs::remove( path );
+	}
+
+	// malformed documents
+	assert( throwsParse( "<root></other>" ) );
+	assert( throwsParse( "<root>" ) );
+	assert( throwsParse( "<root/><second/>" ) );
+	assert( throwsParse( "text<root/>" ) );
+	assert( throwsParse( "<root a=\"1></root>" ) );
+	assert( throwsParse( "\xEF\xBB<root/>" ) );
+
+	console() << "Tests passed" << std::endl;
+}
+
+void XmlReaderTestApp::draw()
+{
+	gl::clear( Color( 0, 0, 0 ) );
+}
+
+CINDER_APP_BASIC( XmlReaderTestApp, RendererGl )
@@ -43,6 +43,20 @@ void base64TestApp::setup()
 			assert( toString( b ) == test );
 		}
 	}
+
+	// streaming variants must match the in-memory versions
+	std::string big;
+	for( int t = 0; t < 1000000; ++t )
+		big += (char)( t * 7919 );
+	for( int i = 0; i < 100; i += 19 ) {
+		std::string base64 = toBase64( big, i );
+		OStreamMemRef encoded = OStreamMem::create();
+		toBase64( IStreamMem::create( big.c_str(), big.size() ), encoded, i );
+		assert( std::string( (const char*)encoded->getBuffer(), encoded->tell() ) == base64 );
+		OStreamMemRef decoded = OStreamMem::create();
+		fromBase64( IStreamMem::create( base64.c_str(), base64.size() ), decoded );
+		assert( decoded->tell() == big.size() && memcmp( decoded->getBuffer(), big.c_str(), big.size() ) == 0 );
+	}
 	app::console() << "Tests passed" << std::endl;
 }
 
@@ -0,0 +1,93 @@
+// Command-line tool which writes a directory tree of assets into a single AssetPack file.
+// usage: AssetPacker [-c] output.pack inputDirectory
+//   -c  compress entries, except formats which are already compressed
+
+#include "cinder/AssetPack.h"
+#include "cinder/Utilities.h"
+
+#include <iostream>
+#include <algorithm>
+
+using namespace ci;
+using namespace std;
+
+namespace {
+
+bool isCompressedFormat( const fs::path &path )
+{
+	static const char *extensions[] = { "png", "jpg", "jpeg", "gif", "mp3", "m4a", "aac", "ogg", "mp4", "mov", "zip", "gz", "svgz", "pvr", "pack" };
+	string ext = path.extension().string();
+	if( ! ext.empty() )
+		ext = ext.substr( 1 );
+	transform( ext.begin(), ext.end(), ext.begin(), ::tolower );
+	for( size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); ++i )
+		if( ext == extensions[i] )
+			return true;
+	return false;
+}
+
+// entry names are relative to the input directory and always use forward slashes
+string makeEntryName( const fs::path &root, const fs::path &path )
+{
+	string result;
+	fs::path::const_iterator rootIt = root.begin(), pathIt = path.begin();
+	while( rootIt != root.end() && pathIt != path.end() && *rootIt == *pathIt ) {
+		++rootIt;
+		++pathIt;
+	}
+	for( ; pathIt != path.end(); ++pathIt ) {
+		if( ! result.empty() )
+			result += '/';
+		result += pathIt->string();
+	}
+	return result;
+}
+
+int usage()
+{
+	cerr << "usage: AssetPacker [-c] output.pack inputDirectory" << endl;
+	cerr << "  -c  compress entries, except formats which are already compressed" << endl;
+	return 1;
+}
+
+} // anonymous namespace
+
+int main( int argc, char **argv )
+{
+	bool compress = false;
+	int arg = 1;
+	if( arg < argc && string( argv[arg] ) == "-c" ) {
+		compress = true;
+		++arg;
+	}
+	if( argc - arg != 2 )
+		return usage();
+
+	fs::path outputPath( argv[arg] ), inputDir( argv[arg + 1] );
+	if( ! fs::is_directory( inputDir ) ) {
+		cerr << inputDir.string() << " is not a directory" << endl;
+		return 1;
+	}
+
+	try {
+		AssetPackWriter writer;
+		uint64_t totalSize = 0;
+		for( fs::recursive_directory_iterator it( inputDir ), end; it != end; ++it ) {
+			boost::system::error_code ec;
+			if( ! fs::is_regular_file( it->path() ) || fs::equivalent( it->path(), outputPath, ec ) )
+				continue;
+			writer.addFile( makeEntryName( inputDir, it->path() ), it->path(), compress && ! isCompressedFormat( it->path() ) );
+			totalSize += fs::file_size( it->path() );
+		}
+		writer.write( outputPath );
+
+		cout << "Packed " << writer.getNumEntries() << " files (" << totalSize << " bytes) into " << outputPath.string()
+			<< " (" << fs::file_size( outputPath ) << " bytes)" << endl;
+	}
+	catch( std::exception &exc ) {
+		cerr << "Failed to write " << outputPath.string() << ": " << exc.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}